@@ -1,146 +1,540 @@
-/*
-C Image Module
-Author: Tannaz Chowdhury  
-GitHub: TannazC  
-Date: 2025  
-
-This file provides image-handling utility functions to work with a
-custom RGB image format in binary (.bin) form. Functions include:
-- Reading/writing binary image data
-- Accessing and modifying pixel values
-- Creating and destroying image structures
-- Visualizing pixel gradients for debugging
-
-Used as a backend for the seam carving project.
-*/
-
-#include "c_img.h"       // Include custom image struct and function prototypes
-#include <stdio.h>        // For file I/O
-#include <math.h>         // For mathematical operations (used elsewhere)
-
-// ----------------------------------------
-// Function: create_img
-// ----------------------------------------
-/*
-   Allocates memory for an image and initializes the height, width,
-   and RGB raster data. Each pixel contains 3 bytes (R, G, B).
-*/
-void create_img(struct rgb_img **im, size_t height, size_t width){
-    *im = (struct rgb_img *)malloc(sizeof(struct rgb_img));     // Allocate memory for image struct
-    (*im)->height = height;                                     // Set height
-    (*im)->width = width;                                       // Set width
-    (*im)->raster = (uint8_t *)malloc(3 * height * width);      // Allocate memory for RGB data (3 bytes per pixel)
-}
-
-// ----------------------------------------
-// Function: read_2bytes
-// ----------------------------------------
-/*
-   Reads 2 bytes from a binary file and combines them into a 16-bit integer.
-   Used to decode image width and height stored in .bin format.
-*/
-int read_2bytes(FILE *fp){
-    uint8_t bytes[2];
-    fread(bytes, sizeof(uint8_t), 1, fp);       // Read first byte
-    fread(bytes+1, sizeof(uint8_t), 1, fp);     // Read second byte
-    return (((int)bytes[0]) << 8) + (int)bytes[1]; // Combine as big-endian integer
-}
-
-// ----------------------------------------
-// Function: write_2bytes
-// ----------------------------------------
-/*
-   Splits a 16-bit integer into two bytes and writes them to a binary file.
-   Used to encode image width and height.
-*/
-void write_2bytes(FILE *fp, int num){
-    uint8_t bytes[2];
-    bytes[0] = (uint8_t)((num & 0xFFFF) >> 8);   // Higher byte (most significant)
-    bytes[1] = (uint8_t)(num & 0xFF);            // Lower byte (least significant)
-    fwrite(bytes, 1, 1, fp);                     // Write first byte
-    fwrite(bytes+1, 1, 1, fp);                   // Write second byte
-}
-
-// ----------------------------------------
-// Function: read_in_img
-// ----------------------------------------
-/*
-   Reads a binary image file and loads it into memory. The image format
-   includes 2 bytes each for height and width, followed by RGB pixel data.
-*/
-void read_in_img(struct rgb_img **im, char *filename){
-    FILE *fp = fopen(filename, "rb");                      // Open binary file for reading
-    size_t height = read_2bytes(fp);                        // Read image height
-    size_t width = read_2bytes(fp);                         // Read image width
-    create_img(im, height, width);                          // Allocate image struct and raster
-    fread((*im)->raster, 1, 3 * width * height, fp);        // Read all RGB data into raster
-    fclose(fp);                                             // Close file
-}
-
-// ----------------------------------------
-// Function: write_img
-// ----------------------------------------
-/*
-   Writes an image to a binary file in the expected output format:
-   [2 bytes height][2 bytes width][3 * H * W RGB values]
-*/
-void write_img(struct rgb_img *im, char *filename){
-    FILE *fp = fopen(filename, "wb");                      // Open file for binary writing
-    write_2bytes(fp, im->height);                          // Write height
-    write_2bytes(fp, im->width);                           // Write width
-    fwrite(im->raster, 1, im->height * im->width * 3, fp); // Write all RGB data
-    fclose(fp);                                            // Close file
-}
-
-// ----------------------------------------
-// Function: get_pixel
-// ----------------------------------------
-/*
-   Returns the value (0-255) of the specified color channel at pixel (y, x).
-   Channels: 0 = Red, 1 = Green, 2 = Blue
-*/
-uint8_t get_pixel(struct rgb_img *im, int y, int x, int colour){
-    return im->raster[3 * (y * im->width + x) + colour];  // Compute index and return value
-}
-
-// ----------------------------------------
-// Function: set_pixel
-// ----------------------------------------
-/*
-   Sets the RGB values of the pixel at (y, x) to the specified values.
-*/
-void set_pixel(struct rgb_img *im, int y, int x, int r, int g, int b){
-    im->raster[3 * (y * im->width + x) + 0] = r;  // Set Red
-    im->raster[3 * (y * im->width + x) + 1] = g;  // Set Green
-    im->raster[3 * (y * im->width + x) + 2] = b;  // Set Blue
-}
-
-// ----------------------------------------
-// Function: destroy_image
-// ----------------------------------------
-/*
-   Frees all memory used by the image struct.
-   Order matters: free raster first, then the struct.
-*/
-void destroy_image(struct rgb_img *im){
-    free(im->raster);   // Free RGB data
-    free(im);           // Free image struct
-}
-
-// ----------------------------------------
-// Function: print_grad
-// ----------------------------------------
-/*
-   Prints the grayscale energy (gradient) values of the image,
-   assuming values are stored in the red channel.
-*/
-void print_grad(struct rgb_img *grad){
-    int height = grad->height;
-    int width = grad->width;
-    for(int i = 0; i < height; i++) {              // For each row
-        for(int j = 0; j < width; j++) {           // For each column
-            printf("%d\t", get_pixel(grad, i, j, 0)); // Print red channel value
-        }
-        printf("\n");                              // Newline after each row
-    }
-}
+/*
+C Image Module
+Author: Tannaz Chowdhury  
+GitHub: TannazC  
+Date: 2025  
+
+This file provides image-handling utility functions to work with a
+custom RGB image format in binary (.bin) form. Functions include:
+- Reading/writing binary image data (the v1 and v2 layouts of c_img.h)
+- Accessing and modifying pixel values
+- Creating and destroying image structures
+- Visualizing pixel gradients for debugging
+
+Used as a backend for the seam carving project.
+*/
+
+#define _POSIX_C_SOURCE 200809L  // For mmap, fstat and fileno under -std=c99
+
+#include "c_img.h"       // Include custom image struct and function prototypes
+#include <stdio.h>        // For file I/O
+#include <string.h>       // For memcpy, memcmp
+#include <math.h>         // For mathematical operations (used elsewhere)
+#include <sys/mman.h>     // For mmap, munmap
+#include <sys/stat.h>     // For fstat
+#include "carve_stats.h"  // For the allocation and I/O counters
+
+#define IMG_HEADER 4                   // Bytes before a v1 raster: height and width
+#define IMG_IO_BUFFER (1 << 20)        // stdio buffer for reading and writing images
+
+static const uint8_t img_magic[4] = {0, 0, 'S', 'C'};  // First bytes of a v2 file
+static const uint8_t img_zeros[IMG_PAGE];              // Padding written after rows and bands
+
+// ----------------------------------------
+// Function: create_img
+// ----------------------------------------
+/*
+   Allocates memory for an image and initializes the height, width,
+   and RGB raster data. Each pixel contains 3 bytes (R, G, B).
+   *im is NULL if the memory cannot be allocated.
+*/
+void create_img(struct rgb_img **im, size_t height, size_t width){
+    *im = (struct rgb_img *)malloc(sizeof(struct rgb_img));     // Allocate memory for image struct
+    uint8_t *raster = (uint8_t *)malloc(3 * height * width > 0 ? 3 * height * width : 1);  // 3 bytes per pixel
+    if (*im == NULL || raster == NULL) {
+        free(*im);
+        free(raster);
+        *im = NULL;
+        return;
+    }
+    init_img(*im, raster, height, width);
+    STATS_ADD(bytes_allocated, 3 * height * width);
+}
+
+// ----------------------------------------
+// Function: create_img_strided
+// ----------------------------------------
+/*
+   Like create_img, but with rows `stride` pixels apart (stride >= width)
+   and the raster 64-byte aligned, so a stride that is a multiple of 64
+   pixels (IMG_V2_ALIGN) starts every row on a cache line. Freed by
+   destroy_image like any other image; *im is NULL if the memory cannot
+   be allocated.
+*/
+void create_img_strided(struct rgb_img **im, size_t height, size_t width, size_t stride){
+    void *raster = NULL;
+    size_t size = 3 * height * stride;
+    if (posix_memalign(&raster, 64, size > 0 ? size : 64) != 0) raster = NULL;
+    *im = (struct rgb_img *)malloc(sizeof(struct rgb_img));
+    if (*im == NULL || raster == NULL) {
+        free(*im);
+        free(raster);
+        *im = NULL;
+        return;
+    }
+    init_img(*im, (uint8_t *)raster, height, width);
+    (*im)->stride = stride;
+    STATS_ADD(bytes_allocated, size);
+}
+
+// ----------------------------------------
+// Function: copy_img
+// ----------------------------------------
+/*
+   Allocates a packed (stride == width) copy of an image of any stride.
+*/
+struct rgb_img *copy_img(const struct rgb_img *im){
+    struct rgb_img *copy;
+    create_img(&copy, im->height, im->width);
+    for (size_t y = 0; y < im->height; y++) {
+        memcpy(copy->raster + 3 * y * im->width, im->raster + 3 * y * im->stride, 3 * im->width);
+    }
+    return copy;
+}
+
+// ----------------------------------------
+// Function: init_img
+// ----------------------------------------
+/*
+   Sets up an image around a raster the caller provides (at least
+   3 * height * width bytes). Nothing is allocated, so the image must not
+   be passed to destroy_image; the caller frees the raster.
+*/
+void init_img(struct rgb_img *im, uint8_t *raster, size_t height, size_t width){
+    im->raster = raster;
+    im->height = height;                                        // Set height
+    im->width = width;                                          // Set width
+    im->stride = width;                                         // Rows are packed back to back
+    im->map = NULL;                                             // Raster is not a mapping
+    im->map_len = 0;
+}
+
+// ----------------------------------------
+// Function: read_2bytes
+// ----------------------------------------
+/*
+   Reads 2 bytes from a binary file and combines them into a 16-bit integer.
+   Used to decode image width and height stored in .bin format.
+   Returns -1 if the file ends first.
+*/
+int read_2bytes(FILE *fp){
+    uint8_t bytes[2];
+    if (fread(bytes, 1, 2, fp) != 2) return -1; // Read both bytes at once
+    return (((int)bytes[0]) << 8) + (int)bytes[1]; // Combine as big-endian integer
+}
+
+// ----------------------------------------
+// Function: write_2bytes
+// ----------------------------------------
+/*
+   Splits a 16-bit integer into two bytes and writes them to a binary file.
+   Used to encode image width and height. Returns 0, or -1 on a write error.
+*/
+int write_2bytes(FILE *fp, int num){
+    uint8_t bytes[2];
+    bytes[0] = (uint8_t)((num & 0xFFFF) >> 8);   // Higher byte (most significant)
+    bytes[1] = (uint8_t)(num & 0xFF);            // Lower byte (least significant)
+    return (fwrite(bytes, 1, 2, fp) == 2) ? 0 : -1; // Write both bytes at once
+}
+
+// ----------------------------------------
+// Helper: get_be / put_be
+// ----------------------------------------
+/*
+   Big-endian numbers of `bytes` bytes, as the header fields are stored.
+*/
+static size_t get_be(const uint8_t *p, int bytes){
+    size_t value = 0;
+    for (int i = 0; i < bytes; i++) value = (value << 8) | p[i];
+    return value;
+}
+
+static void put_be(uint8_t *p, int bytes, size_t value){
+    for (int i = bytes - 1; i >= 0; i--) {
+        p[i] = (uint8_t)(value & 0xFF);
+        value >>= 8;
+    }
+}
+
+// ----------------------------------------
+// Helper: round_up
+// ----------------------------------------
+static size_t round_up(size_t n, size_t to){
+    return (n + to - 1) / to * to;
+}
+
+// ----------------------------------------
+// Helper: img_data_end
+// ----------------------------------------
+/*
+   File offset just past the last row of a layout (the last band is not
+   padded), which is how long a file of that layout must be.
+*/
+static size_t img_data_end(const struct img_header *hdr){
+    if (hdr->height == 0) return hdr->data;
+    return img_row_offset(hdr, hdr->height - 1) + 3 * hdr->stride;
+}
+
+// ----------------------------------------
+// Helper: fits_file
+// ----------------------------------------
+/*
+   Whether a regular file is long enough for its header's layout. Pipes
+   and other streams cannot tell in advance and pass; their reads fail
+   at the end instead.
+*/
+static int fits_file(FILE *fp, const struct img_header *hdr){
+    struct stat st;
+    if (fstat(fileno(fp), &st) != 0 || !S_ISREG(st.st_mode)) return 1;
+    return (uint64_t)st.st_size >= (uint64_t)img_data_end(hdr);
+}
+
+// ----------------------------------------
+// Function: read_img_header
+// ----------------------------------------
+/*
+   Reads the header of a v1 or v2 file (see c_img.h) and works out its
+   layout. Leaves fp just after the header bytes it read (4 for v1, 64
+   for v2), which is row 0 for v1 and unchunked v2 files with the usual
+   64-byte header. Returns 0, or -1 if the file ends first, a v2 header
+   is malformed (unknown version, a stride under the width or not a
+   multiple of IMG_V2_ALIGN, or sides whose raster or band size does not
+   fit a size_t) or a regular file is shorter than its layout.
+*/
+int read_img_header(FILE *fp, struct img_header *hdr){
+    uint8_t bytes[IMG_V2_HEADER];
+
+    if (fread(bytes, 1, IMG_HEADER, fp) != IMG_HEADER) return -1;
+    memset(hdr, 0, sizeof(*hdr));
+    if (memcmp(bytes, img_magic, sizeof(img_magic)) != 0) {     // v1: height and width
+        hdr->version = 1;
+        hdr->height = get_be(bytes, 2);
+        hdr->width = get_be(bytes + 2, 2);
+        hdr->stride = hdr->width;
+        hdr->data = IMG_HEADER;
+        return fits_file(fp, hdr) ? 0 : -1;
+    }
+
+    if (fread(bytes + IMG_HEADER, 1, IMG_V2_HEADER - IMG_HEADER, fp) != IMG_V2_HEADER - IMG_HEADER) return -1;
+    hdr->version = (int)get_be(bytes + 4, 2);
+    size_t header = get_be(bytes + 6, 2);
+    hdr->height = get_be(bytes + 8, 4);
+    hdr->width = get_be(bytes + 12, 4);
+    hdr->stride = get_be(bytes + 16, 4);
+    hdr->band_rows = get_be(bytes + 20, 4);
+    if (hdr->version != 2 || header < IMG_V2_HEADER) return -1;
+    if (hdr->stride < hdr->width || hdr->stride % IMG_V2_ALIGN != 0) return -1;
+    if (hdr->stride > 0 && (hdr->height > SIZE_MAX / 4 / hdr->stride || hdr->band_rows > SIZE_MAX / 4 / hdr->stride)) {
+        return -1;                                               // Raster or band would overflow
+    }
+    if (hdr->band_rows > 0) {
+        hdr->data = round_up(header, IMG_PAGE);
+        hdr->band_bytes = round_up(hdr->band_rows * 3 * hdr->stride, IMG_PAGE);
+    } else {
+        hdr->data = header;
+    }
+    return fits_file(fp, hdr) ? 0 : -1;
+}
+
+// ----------------------------------------
+// Function: img_v2_header / write_img_header
+// ----------------------------------------
+/*
+   img_v2_header sets up the layout of a v2 file for a height x width
+   image: the stride rounded up to IMG_V2_ALIGN pixels, and bands of
+   band_rows rows (0 = not chunked). write_img_header writes a header
+   (either version) and the padding up to row 0. Returns 0, or -1 on a
+   write error or if a v1 header cannot hold the size.
+*/
+void img_v2_header(struct img_header *hdr, size_t height, size_t width, size_t band_rows){
+    memset(hdr, 0, sizeof(*hdr));
+    hdr->version = 2;
+    hdr->height = height;
+    hdr->width = width;
+    hdr->stride = round_up(width > 0 ? width : 1, IMG_V2_ALIGN);
+    hdr->band_rows = band_rows;
+    hdr->data = (band_rows > 0) ? IMG_PAGE : IMG_V2_HEADER;
+    hdr->band_bytes = (band_rows > 0) ? round_up(band_rows * 3 * hdr->stride, IMG_PAGE) : 0;
+}
+
+int write_img_header(FILE *fp, const struct img_header *hdr){
+    uint8_t bytes[IMG_V2_HEADER] = {0};
+
+    if (hdr->version == 1) {
+        if (hdr->height > IMG_V1_MAX || hdr->width > IMG_V1_MAX) return -1;
+        return write_2bytes(fp, (int)hdr->height) | write_2bytes(fp, (int)hdr->width);
+    }
+    memcpy(bytes, img_magic, sizeof(img_magic));
+    put_be(bytes + 4, 2, 2);
+    put_be(bytes + 6, 2, IMG_V2_HEADER);
+    put_be(bytes + 8, 4, hdr->height);
+    put_be(bytes + 12, 4, hdr->width);
+    put_be(bytes + 16, 4, hdr->stride);
+    put_be(bytes + 20, 4, hdr->band_rows);
+    if (fwrite(bytes, 1, IMG_V2_HEADER, fp) != IMG_V2_HEADER) return -1;
+    size_t pad = hdr->data - IMG_V2_HEADER;
+    return (fwrite(img_zeros, 1, pad, fp) == pad) ? 0 : -1;
+}
+
+// ----------------------------------------
+// Function: img_row_offset
+// ----------------------------------------
+/*
+   File offset of row y. Rows of a band (or of an unchunked file) are
+   3 * stride bytes apart.
+*/
+size_t img_row_offset(const struct img_header *hdr, size_t y){
+    if (hdr->band_rows == 0) return hdr->data + 3 * y * hdr->stride;
+    return hdr->data + (y / hdr->band_rows) * hdr->band_bytes + 3 * (y % hdr->band_rows) * hdr->stride;
+}
+
+// ----------------------------------------
+// Helper: skip_bytes
+// ----------------------------------------
+/*
+   Moves fp `count` bytes forward, by reading them where it cannot seek
+   (pipes). Returns 0, or -1 if the file ends first.
+*/
+static int skip_bytes(FILE *fp, size_t count){
+    uint8_t buffer[IMG_PAGE];
+    if (count == 0 || fseeko(fp, (off_t)count, SEEK_CUR) == 0) return 0;
+    while (count > 0) {
+        size_t chunk = count < sizeof(buffer) ? count : sizeof(buffer);
+        if (fread(buffer, 1, chunk, fp) != chunk) return -1;
+        count -= chunk;
+    }
+    return 0;
+}
+
+// ----------------------------------------
+// Function: map_img
+// ----------------------------------------
+/*
+   Maps a regular .bin file into memory and points the raster straight at
+   row 0, so loading costs no copy at all. Works for v1 and unchunked v2
+   files (a v2 file's rows keep their padded stride, and start 64-byte
+   aligned since the mapping is page aligned). The mapping is private and
+   writable: pages the program never writes are shared with the page
+   cache, and carving in place gets a private copy of each page only when
+   it first writes to it (copy-on-write). The file itself is never
+   modified. Returns 1 with *im set, 0 if the file cannot be mapped (it is
+   then read instead), or -1 if it is shorter than its header says or
+   memory runs out.
+*/
+static int map_img(FILE *fp, const struct img_header *hdr, struct rgb_img **out){
+    struct stat st;
+    size_t len = img_data_end(hdr);
+
+    *out = NULL;
+    if (hdr->band_rows > 0 || hdr->height == 0 || hdr->width == 0) return 0;
+    if (fstat(fileno(fp), &st) != 0 || !S_ISREG(st.st_mode)) return 0;  // Pipes etc.
+    if ((uint64_t)st.st_size < (uint64_t)len) return -1;
+
+    void *map = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE, fileno(fp), 0);
+    if (map == MAP_FAILED) return 0;
+
+    struct rgb_img *im = (struct rgb_img *)malloc(sizeof(struct rgb_img));
+    if (im == NULL) {
+        munmap(map, len);
+        return -1;
+    }
+    im->height = hdr->height;
+    im->width = hdr->width;
+    im->stride = hdr->stride;
+    im->raster = (uint8_t *)map + hdr->data;    // Pixels start right after the header
+    im->map = map;
+    im->map_len = len;
+    *out = im;
+    return 1;
+}
+
+// ----------------------------------------
+// Helper: load_rows
+// ----------------------------------------
+/*
+   Reads the rows of a file whose header was just read into an image of
+   the file's stride: one read for the whole raster, or one per band of a
+   chunked file (skipping the band padding). Returns 0, or -1 if the file
+   is truncated.
+*/
+static int load_rows(FILE *fp, const struct img_header *hdr, struct rgb_img *im){
+    size_t at = (hdr->version == 1) ? IMG_HEADER : IMG_V2_HEADER;  // Bytes read so far
+    size_t band = (hdr->band_rows > 0) ? hdr->band_rows : hdr->height;
+
+    for (size_t y = 0; y < hdr->height; y += band) {
+        size_t rows = (hdr->height - y < band) ? hdr->height - y : band;
+        size_t offset = img_row_offset(hdr, y);
+        size_t size = 3 * rows * hdr->stride;
+        if (skip_bytes(fp, offset - at) != 0) return -1;
+        if (fread(im->raster + 3 * y * im->stride, 1, size, fp) != size) return -1;
+        at = offset + size;
+    }
+    return 0;
+}
+
+// ----------------------------------------
+// Function: read_in_img
+// ----------------------------------------
+/*
+   Reads a binary image file (v1 or v2, see c_img.h) and loads it into
+   memory. Regular unchunked files are memory-mapped (see map_img);
+   anything else is read through a large stdio buffer into a raster of
+   the file's stride. Returns 0, or -1 (with *im set to NULL) if the file
+   cannot be opened, has a bad header, is truncated or needs more memory
+   than there is.
+*/
+int read_in_img(struct rgb_img **im, char *filename){
+    struct img_header hdr;
+    STATS_START(timer);
+    *im = NULL;
+    FILE *fp = fopen(filename, "rb");                      // Open binary file for reading
+    if (fp == NULL) return -1;
+    setvbuf(fp, NULL, _IOFBF, IMG_IO_BUFFER);              // Few large reads when not mapped
+
+    if (read_img_header(fp, &hdr) != 0) {                  // Read image height and width
+        fclose(fp);
+        return -1;
+    }
+
+    int mapped = map_img(fp, &hdr, im);                     // Zero-copy when possible
+    if (mapped > 0) {
+        STATS_ADD(bytes_mapped, 3 * hdr.width * hdr.height);
+    } else if (mapped == 0) {
+        if (hdr.version == 1) create_img(im, hdr.height, hdr.width);  // Allocate image struct and raster
+        else create_img_strided(im, hdr.height, hdr.width, hdr.stride);
+        if (*im != NULL && load_rows(fp, &hdr, *im) != 0) {  // Read all RGB data into raster
+            destroy_image(*im);
+            *im = NULL;
+        }
+        STATS_ADD(bytes_read, 3 * hdr.width * hdr.height);
+    }
+    fclose(fp);                                             // Close file (a mapping stays valid)
+    STATS_STOP(timer, STAGE_READ, hdr.width * hdr.height);
+    return (*im == NULL) ? -1 : 0;
+}
+
+// ----------------------------------------
+// Function: write_img_rows
+// ----------------------------------------
+/*
+   Writes `count` rows (3 * stride bytes apart in memory) as rows y to
+   y + count - 1 of a file laid out by hdr, which fp must be positioned
+   at. Each v2 row is padded to the file stride, and each full band to
+   band_bytes, so rows can be written a few at a time in order. Returns
+   0, or -1 on a write error.
+*/
+int write_img_rows(FILE *fp, const struct img_header *hdr, size_t y, const uint8_t *rows, size_t count,
+                   size_t stride){
+    size_t used = 3 * hdr->width, pad = 3 * (hdr->stride - hdr->width);
+    size_t band_pad = (hdr->band_rows > 0) ? hdr->band_bytes - 3 * hdr->band_rows * hdr->stride : 0;
+
+    if (pad == 0 && stride == hdr->width && hdr->band_rows == 0) {  // Packed rows: one write
+        return (fwrite(rows, 1, used * count, fp) == used * count) ? 0 : -1;
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (fwrite(rows + 3 * i * stride, 1, used, fp) != used) return -1;
+        if (fwrite(img_zeros, 1, pad, fp) != pad) return -1;
+        size_t row = y + i + 1;
+        if (band_pad > 0 && row % hdr->band_rows == 0 && row < hdr->height) {  // End of a full band
+            if (fwrite(img_zeros, 1, band_pad, fp) != band_pad) return -1;
+        }
+    }
+    return 0;
+}
+
+// ----------------------------------------
+// Function: write_img / write_img_v2
+// ----------------------------------------
+/*
+   write_img writes an image in the v1 format:
+   [2 bytes height][2 bytes width][3 * H * W RGB values]
+   or, when a side is over 65535 pixels, as an unchunked v2 file.
+   write_img_v2 always writes v2, in bands of band_rows rows (0 = not
+   chunked). Rows of a strided image are written one at a time, dropping
+   the unused pixels at the end of each row; a large stdio buffer turns
+   them into a few big writes. Returns 0, or -1 if the file could not be
+   written.
+*/
+static int write_layout(struct rgb_img *im, char *filename, const struct img_header *hdr){
+    STATS_START(timer);
+    FILE *fp = fopen(filename, "wb");                      // Open file for binary writing
+    if (fp == NULL) return -1;
+    setvbuf(fp, NULL, _IOFBF, IMG_IO_BUFFER);
+
+    int failed = write_img_header(fp, hdr);                // Write height and width
+    failed |= write_img_rows(fp, hdr, 0, im->raster, im->height, im->stride);  // Write all RGB data
+    failed |= (fclose(fp) != 0) ? -1 : 0;                  // Close file (flushes the buffer)
+    STATS_ADD(bytes_written, img_data_end(hdr));
+    STATS_STOP(timer, STAGE_WRITE, im->height * im->width);
+    return failed ? -1 : 0;
+}
+
+int write_img(struct rgb_img *im, char *filename){
+    struct img_header hdr = {1, im->height, im->width, im->width, 0, IMG_HEADER, 0};
+    if (im->height > IMG_V1_MAX || im->width > IMG_V1_MAX) return write_img_v2(im, filename, 0);
+    return write_layout(im, filename, &hdr);
+}
+
+int write_img_v2(struct rgb_img *im, char *filename, size_t band_rows){
+    struct img_header hdr;
+    img_v2_header(&hdr, im->height, im->width, band_rows);
+    return write_layout(im, filename, &hdr);
+}
+
+// ----------------------------------------
+// Function: get_pixel
+// ----------------------------------------
+/*
+   Returns the value (0-255) of the specified color channel at pixel (y, x).
+   Channels: 0 = Red, 1 = Green, 2 = Blue
+*/
+uint8_t get_pixel(struct rgb_img *im, int y, int x, int colour){
+    return im->raster[3 * (y * im->stride + x) + colour];  // Compute index and return value
+}
+
+// ----------------------------------------
+// Function: set_pixel
+// ----------------------------------------
+/*
+   Sets the RGB values of the pixel at (y, x) to the specified values.
+*/
+void set_pixel(struct rgb_img *im, int y, int x, int r, int g, int b){
+    im->raster[3 * (y * im->stride + x) + 0] = r;  // Set Red
+    im->raster[3 * (y * im->stride + x) + 1] = g;  // Set Green
+    im->raster[3 * (y * im->stride + x) + 2] = b;  // Set Blue
+}
+
+// ----------------------------------------
+// Function: destroy_image
+// ----------------------------------------
+/*
+   Frees all memory used by the image struct.
+   Order matters: free raster first, then the struct.
+   A memory-mapped raster is unmapped instead of freed.
+*/
+void destroy_image(struct rgb_img *im){
+    if (im->map != NULL) {
+        munmap(im->map, im->map_len);   // Unmap file and private pages
+    } else {
+        free(im->raster);   // Free RGB data
+    }
+    free(im);           // Free image struct
+}
+
+// ----------------------------------------
+// Function: print_grad
+// ----------------------------------------
+/*
+   Prints the grayscale energy (gradient) values of the image,
+   assuming values are stored in the red channel.
+*/
+void print_grad(struct rgb_img *grad){
+    int height = grad->height;
+    int width = grad->width;
+    for(int i = 0; i < height; i++) {              // For each row
+        for(int j = 0; j < width; j++) {           // For each column
+            printf("%d\t", get_pixel(grad, i, j, 0)); // Print red channel value
+        }
+        printf("\n");                              // Newline after each row
+    }
+}
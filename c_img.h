@@ -1,146 +1,113 @@
-/*
-C Image Module
-Author: Tannaz Chowdhury  
-GitHub: TannazC  
-Date: 2025  
-
-This file provides image-handling utility functions to work with a
-custom RGB image format in binary (.bin) form. Functions include:
-- Reading/writing binary image data
-- Accessing and modifying pixel values
-- Creating and destroying image structures
-- Visualizing pixel gradients for debugging
-
-Used as a backend for the seam carving project.
-*/
-
-#include "c_img.h"       // Include custom image struct and function prototypes
-#include <stdio.h>        // For file I/O
-#include <math.h>         // For mathematical operations (used elsewhere)
-
-// ----------------------------------------
-// Function: create_img
-// ----------------------------------------
-/*
-   Allocates memory for an image and initializes the height, width,
-   and RGB raster data. Each pixel contains 3 bytes (R, G, B).
-*/
-void create_img(struct rgb_img **im, size_t height, size_t width){
-    *im = (struct rgb_img *)malloc(sizeof(struct rgb_img));     // Allocate memory for image struct
-    (*im)->height = height;                                     // Set height
-    (*im)->width = width;                                       // Set width
-    (*im)->raster = (uint8_t *)malloc(3 * height * width);      // Allocate memory for RGB data (3 bytes per pixel)
-}
-
-// ----------------------------------------
-// Function: read_2bytes
-// ----------------------------------------
-/*
-   Reads 2 bytes from a binary file and combines them into a 16-bit integer.
-   Used to decode image width and height stored in .bin format.
-*/
-int read_2bytes(FILE *fp){
-    uint8_t bytes[2];
-    fread(bytes, sizeof(uint8_t), 1, fp);       // Read first byte
-    fread(bytes+1, sizeof(uint8_t), 1, fp);     // Read second byte
-    return (((int)bytes[0]) << 8) + (int)bytes[1]; // Combine as big-endian integer
-}
-
-// ----------------------------------------
-// Function: write_2bytes
-// ----------------------------------------
-/*
-   Splits a 16-bit integer into two bytes and writes them to a binary file.
-   Used to encode image width and height.
-*/
-void write_2bytes(FILE *fp, int num){
-    uint8_t bytes[2];
-    bytes[0] = (uint8_t)((num & 0xFFFF) >> 8);   // Higher byte (most significant)
-    bytes[1] = (uint8_t)(num & 0xFF);            // Lower byte (least significant)
-    fwrite(bytes, 1, 1, fp);                     // Write first byte
-    fwrite(bytes+1, 1, 1, fp);                   // Write second byte
-}
-
-// ----------------------------------------
-// Function: read_in_img
-// ----------------------------------------
-/*
-   Reads a binary image file and loads it into memory. The image format
-   includes 2 bytes each for height and width, followed by RGB pixel data.
-*/
-void read_in_img(struct rgb_img **im, char *filename){
-    FILE *fp = fopen(filename, "rb");                      // Open binary file for reading
-    size_t height = read_2bytes(fp);                        // Read image height
-    size_t width = read_2bytes(fp);                         // Read image width
-    create_img(im, height, width);                          // Allocate image struct and raster
-    fread((*im)->raster, 1, 3 * width * height, fp);        // Read all RGB data into raster
-    fclose(fp);                                             // Close file
-}
-
-// ----------------------------------------
-// Function: write_img
-// ----------------------------------------
-/*
-   Writes an image to a binary file in the expected output format:
-   [2 bytes height][2 bytes width][3 * H * W RGB values]
-*/
-void write_img(struct rgb_img *im, char *filename){
-    FILE *fp = fopen(filename, "wb");                      // Open file for binary writing
-    write_2bytes(fp, im->height);                          // Write height
-    write_2bytes(fp, im->width);                           // Write width
-    fwrite(im->raster, 1, im->height * im->width * 3, fp); // Write all RGB data
-    fclose(fp);                                            // Close file
-}
-
-// ----------------------------------------
-// Function: get_pixel
-// ----------------------------------------
-/*
-   Returns the value (0-255) of the specified color channel at pixel (y, x).
-   Channels: 0 = Red, 1 = Green, 2 = Blue
-*/
-uint8_t get_pixel(struct rgb_img *im, int y, int x, int colour){
-    return im->raster[3 * (y * im->width + x) + colour];  // Compute index and return value
-}
-
-// ----------------------------------------
-// Function: set_pixel
-// ----------------------------------------
-/*
-   Sets the RGB values of the pixel at (y, x) to the specified values.
-*/
-void set_pixel(struct rgb_img *im, int y, int x, int r, int g, int b){
-    im->raster[3 * (y * im->width + x) + 0] = r;  // Set Red
-    im->raster[3 * (y * im->width + x) + 1] = g;  // Set Green
-    im->raster[3 * (y * im->width + x) + 2] = b;  // Set Blue
-}
-
-// ----------------------------------------
-// Function: destroy_image
-// ----------------------------------------
-/*
-   Frees all memory used by the image struct.
-   Order matters: free raster first, then the struct.
-*/
-void destroy_image(struct rgb_img *im){
-    free(im->raster);   // Free RGB data
-    free(im);           // Free image struct
-}
-
-// ----------------------------------------
-// Function: print_grad
-// ----------------------------------------
-/*
-   Prints the grayscale energy (gradient) values of the image,
-   assuming values are stored in the red channel.
-*/
-void print_grad(struct rgb_img *grad){
-    int height = grad->height;
-    int width = grad->width;
-    for(int i = 0; i < height; i++) {              // For each row
-        for(int j = 0; j < width; j++) {           // For each column
-            printf("%d\t", get_pixel(grad, i, j, 0)); // Print red channel value
-        }
-        printf("\n");                              // Newline after each row
-    }
-}
+/*
+C Image Module Header File
+Author: Tannaz Chowdhury
+GitHub: TannazC
+Date: 2025
+
+This header defines the rgb_img structure and declares the image-handling
+utility functions implemented in c_img.c: reading/writing .bin files,
+accessing pixels, and creating/destroying images.
+
+Two .bin layouts are read (all numbers big-endian):
+  v1: [2B height][2B width][3 * H * W RGB values], rows packed
+  v2: a 64-byte header, then rows of 3 * stride bytes:
+        0  4  magic 00 00 'S' 'C' (a v1 image 0 rows high is empty, so
+              no real v1 file starts like this)
+        4  2  version (2)
+        6  2  header bytes (64)
+        8  4  height
+       12  4  width
+       16  4  stride, pixels per row in the file (a multiple of 64, so
+              every row starts 64-byte aligned)
+       20  4  band rows (0 = not chunked)
+       24 40  reserved, zero
+      Unchunked, the rows follow the header back to back, so a mapped
+      file's raster is used as is. Chunked, the rows come in bands of
+      `band rows` rows, the first at IMG_PAGE and each padded to a
+      multiple of IMG_PAGE, so one band can be read or mapped on its own.
+write_img keeps writing v1 unless a side is over 65535 pixels.
+*/
+
+#ifndef C_IMG_H                 // Include guard - prevents multiple includes
+#define C_IMG_H
+
+#include <stdio.h>              // For FILE
+#include <stdint.h>             // For uint8_t
+#include <stdlib.h>             // For size_t, malloc, free
+
+// ----------------------------------------
+// Struct: rgb_img
+// ----------------------------------------
+/*
+   An RGB image stored row by row, 3 bytes (R, G, B) per pixel.
+
+   Fields:
+     raster - pixel data
+     height - number of rows
+     width  - number of columns in use
+     stride - number of pixels between the starts of consecutive rows.
+              create_img sets it to width; in-place carving keeps it fixed
+              while width shrinks, leaving unused pixels at the end of rows.
+     map    - start of the file mapping the raster lives in (read_in_img),
+              or NULL when the raster was malloc'd
+     map_len - length of that mapping
+*/
+struct rgb_img{
+    uint8_t *raster;
+    size_t height;
+    size_t width;
+    size_t stride;
+    void *map;
+    size_t map_len;
+};
+
+#define IMG_V1_MAX 0xFFFF       // Largest side a v1 header can hold
+#define IMG_V2_HEADER 64        // Bytes of a v2 header
+#define IMG_V2_ALIGN 64         // A v2 stride is a multiple of this many pixels
+#define IMG_PAGE 4096           // Alignment of the bands of a chunked v2 file
+
+// ----------------------------------------
+// Struct: img_header
+// ----------------------------------------
+/*
+   Layout of a .bin file, from its header (read_img_header).
+
+   Fields:
+     version       - 1 or 2
+     height, width - image size
+     stride        - pixels per row in the file (width for v1)
+     band_rows     - rows per band (0 = not chunked)
+     data          - file offset of row 0
+     band_bytes    - file bytes per band, padding included (chunked only)
+*/
+struct img_header {
+    int version;
+    size_t height;
+    size_t width;
+    size_t stride;
+    size_t band_rows;
+    size_t data;
+    size_t band_bytes;
+};
+
+void create_img(struct rgb_img **im, size_t height, size_t width);
+void create_img_strided(struct rgb_img **im, size_t height, size_t width, size_t stride);
+void init_img(struct rgb_img *im, uint8_t *raster, size_t height, size_t width);
+struct rgb_img *copy_img(const struct rgb_img *im);
+int read_2bytes(FILE *fp);
+int write_2bytes(FILE *fp, int num);
+int read_img_header(FILE *fp, struct img_header *hdr);
+void img_v2_header(struct img_header *hdr, size_t height, size_t width, size_t band_rows);
+int write_img_header(FILE *fp, const struct img_header *hdr);
+size_t img_row_offset(const struct img_header *hdr, size_t y);
+int write_img_rows(FILE *fp, const struct img_header *hdr, size_t y, const uint8_t *rows, size_t count,
+                   size_t stride);
+int read_in_img(struct rgb_img **im, char *filename);
+int write_img(struct rgb_img *im, char *filename);
+int write_img_v2(struct rgb_img *im, char *filename, size_t band_rows);
+uint8_t get_pixel(struct rgb_img *im, int y, int x, int colour);
+void set_pixel(struct rgb_img *im, int y, int x, int r, int g, int b);
+void destroy_image(struct rgb_img *im);
+void print_grad(struct rgb_img *grad);
+
+#endif  // End of include guard for C_IMG_H
@@ -0,0 +1,87 @@
+/*
+Carving Statistics Implementation
+Author: Tannaz Chowdhury
+GitHub: TannazC
+Date: 2025
+
+Clock, reset and report functions for the counters in carve_stats.h.
+The counters themselves are updated inline by the instrumented code.
+*/
+
+#define _POSIX_C_SOURCE 200809L  // For clock_gettime under -std=c99
+
+#include <stdio.h>            // Required for fprintf
+#include <string.h>           // Required for memset
+#include <time.h>             // Required for clock_gettime
+#include "carve_stats.h"      // Header for the statistics declarations
+
+__thread struct carve_stats carve_stats;
+static __thread uint64_t run_start;      // stats_now() at stats_reset
+
+static const char *stage_names[STAGE_COUNT] = {"energy", "dp", "trace", "remove", "read", "write"};
+
+// ----------------------------------------
+// Function: stats_now
+// ----------------------------------------
+uint64_t stats_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+// ----------------------------------------
+// Function: stats_reset
+// ----------------------------------------
+void stats_reset(void) {
+    memset(&carve_stats, 0, sizeof(carve_stats));
+    run_start = stats_now();
+}
+
+// ----------------------------------------
+// Function: stats_write_json
+// ----------------------------------------
+void stats_write_json(FILE *fp, const char *label) {
+    double seconds = (stats_now() - run_start) / 1e9;
+
+    fprintf(fp, "{\n  \"label\": \"%s\",\n  \"enabled\": %s,\n", label, SEAM_STATS ? "true" : "false");
+    fprintf(fp, "  \"seconds\": %.6f,\n  \"seams\": %llu,\n  \"seams_per_second\": %.2f,\n", seconds,
+            (unsigned long long)carve_stats.seams, seconds > 0 ? carve_stats.seams / seconds : 0.0);
+    fprintf(fp, "  \"bytes_allocated\": %llu,\n  \"bytes_copied\": %llu,\n",
+            (unsigned long long)carve_stats.bytes_allocated, (unsigned long long)carve_stats.bytes_copied);
+    fprintf(fp, "  \"bytes_read\": %llu,\n  \"bytes_written\": %llu,\n  \"bytes_mapped\": %llu,\n",
+            (unsigned long long)carve_stats.bytes_read, (unsigned long long)carve_stats.bytes_written,
+            (unsigned long long)carve_stats.bytes_mapped);
+
+    fprintf(fp, "  \"stages\": {\n");
+    for (int s = 0; s < STAGE_COUNT; s++) {
+        const struct stage_stats *st = &carve_stats.stage[s];
+        double ms = st->ns / 1e6;
+        fprintf(fp, "    \"%s\": {\"calls\": %llu, \"ms\": %.3f, \"pixels\": %llu, \"mpix_per_s\": %.2f}%s\n",
+                stage_names[s], (unsigned long long)st->calls, ms, (unsigned long long)st->pixels,
+                st->ns ? st->pixels * 1e3 / st->ns : 0.0, (s + 1 < STAGE_COUNT) ? "," : "");
+    }
+    fprintf(fp, "  }\n}\n");
+}
+
+// ----------------------------------------
+// Function: stats_csv_header
+// ----------------------------------------
+void stats_csv_header(FILE *fp) {
+    fprintf(fp, "step,seams,width,height");
+    for (int s = 0; s < STAGE_COUNT; s++) fprintf(fp, ",%s_ns,%s_pixels", stage_names[s], stage_names[s]);
+    fprintf(fp, ",bytes_copied,bytes_written\n");
+}
+
+// ----------------------------------------
+// Function: stats_csv_row
+// ----------------------------------------
+void stats_csv_row(FILE *fp, int step, size_t width, size_t height, struct carve_stats *prev) {
+    fprintf(fp, "%d,%llu,%zu,%zu", step, (unsigned long long)(carve_stats.seams - prev->seams), width, height);
+    for (int s = 0; s < STAGE_COUNT; s++) {
+        fprintf(fp, ",%llu,%llu", (unsigned long long)(carve_stats.stage[s].ns - prev->stage[s].ns),
+                (unsigned long long)(carve_stats.stage[s].pixels - prev->stage[s].pixels));
+    }
+    fprintf(fp, ",%llu,%llu\n", (unsigned long long)(carve_stats.bytes_copied - prev->bytes_copied),
+            (unsigned long long)(carve_stats.bytes_written - prev->bytes_written));
+    *prev = carve_stats;
+}
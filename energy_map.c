@@ -0,0 +1,58 @@
+/*
+Energy Map Implementation
+Author: Tannaz Chowdhury
+GitHub: TannazC
+Date: 2025
+
+Allocation of single-plane energy maps and their conversion to grayscale
+images for debugging.
+*/
+
+#include <stdlib.h>           // Required for malloc, free
+#include "energy_map.h"       // Header for the energy map declarations
+#include "energy_simd.h"      // ENERGY_DUAL
+#include "carve_stats.h"      // Allocation counter
+
+// ----------------------------------------
+// Function: create_energy_map
+// ----------------------------------------
+void create_energy_map(struct energy_map **map, size_t height, size_t width) {
+    *map = (struct energy_map *)malloc(sizeof(struct energy_map));
+    init_energy_map(*map, (uint8_t *)malloc(height * width), height, width);  // 1 byte per pixel
+    STATS_ADD(bytes_allocated, height * width);
+}
+
+// ----------------------------------------
+// Function: init_energy_map
+// ----------------------------------------
+void init_energy_map(struct energy_map *map, uint8_t *data, size_t height, size_t width) {
+    map->data = data;
+    map->height = height;
+    map->width = width;
+    map->stride = width;   // Rows are packed back to back
+    map->energy = ENERGY_DUAL;
+}
+
+// ----------------------------------------
+// Function: destroy_energy_map
+// ----------------------------------------
+void destroy_energy_map(struct energy_map *map) {
+    free(map->data);
+    free(map);
+}
+
+// ----------------------------------------
+// Function: energy_map_to_img
+// ----------------------------------------
+void energy_map_to_img(const struct energy_map *map, struct rgb_img **im) {
+    create_img(im, map->height, map->width);
+    for (size_t y = 0; y < map->height; y++) {
+        const uint8_t *from = energy_row(map, y);
+        uint8_t *to = (*im)->raster + 3 * y * (*im)->stride;
+        for (size_t x = 0; x < map->width; x++) {  // Same value in R, G and B
+            to[3 * x + 0] = from[x];
+            to[3 * x + 1] = from[x];
+            to[3 * x + 2] = from[x];
+        }
+    }
+}
@@ -0,0 +1,81 @@
+/*
+Energy Map Header File
+Author: Tannaz Chowdhury
+GitHub: TannazC
+Date: 2025
+
+Declares the single-plane energy map produced by calc_energy and read by
+the DPs: one byte per pixel, row by row. The original code stored each
+value three times in a grayscale rgb_img, of which only channel 0 was
+ever read; one plane cuts the energy pass's writes (and the DP's reads)
+to a third. energy_map_to_img turns a map back into a grayscale image for
+debug dumps (print_grad, write_img).
+*/
+
+#ifndef ENERGY_MAP_H            // Include guard - prevents multiple includes
+#define ENERGY_MAP_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "c_img.h"              // Required for struct rgb_img definitions
+
+// ----------------------------------------
+// Struct: energy_map
+// ----------------------------------------
+/*
+   Fields:
+     data   - energy values, one byte per pixel
+     height - number of rows
+     width  - number of columns in use
+     stride - bytes between the starts of consecutive rows; stays fixed
+              while the map is carved along with its image
+     energy - energy function the values hold (ENERGY_* in energy_simd.h);
+              refill_energy and update_energy keep to it. An
+              ENERGY_FORWARD map only tracks the image's size: forward
+              costs are computed inside the DP
+*/
+struct energy_map {
+    uint8_t *data;
+    size_t height;
+    size_t width;
+    size_t stride;
+    int energy;
+};
+
+// ----------------------------------------
+// Function: create_energy_map / init_energy_map / destroy_energy_map
+// ----------------------------------------
+/*
+   create_energy_map allocates a height x width map; destroy_energy_map
+   frees it. init_energy_map sets up a map around a caller's buffer of at
+   least height * width bytes (do not destroy it). Both maps hold the
+   dual-gradient energy until their energy field is changed.
+*/
+void create_energy_map(struct energy_map **map, size_t height, size_t width);
+void init_energy_map(struct energy_map *map, uint8_t *data, size_t height, size_t width);
+void destroy_energy_map(struct energy_map *map);
+
+// ----------------------------------------
+// Function: energy_row / get_energy
+// ----------------------------------------
+/*
+   Start of row y, and the energy of pixel (y, x).
+*/
+static inline uint8_t *energy_row(const struct energy_map *map, size_t y) {
+    return map->data + y * map->stride;
+}
+
+static inline uint8_t get_energy(const struct energy_map *map, int y, int x) {
+    return map->data[(size_t)y * map->stride + x];
+}
+
+// ----------------------------------------
+// Function: energy_map_to_img
+// ----------------------------------------
+/*
+   Allocates a grayscale rgb_img with every energy value in all three
+   channels (the layout calc_energy used to produce), for debug output.
+*/
+void energy_map_to_img(const struct energy_map *map, struct rgb_img **im);
+
+#endif  // End of include guard for ENERGY_MAP_H
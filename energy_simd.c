@@ -0,0 +1,580 @@
+/*
+SIMD Energy Kernel Implementation
+Author: Tannaz Chowdhury
+GitHub: TannazC
+Date: 2025
+
+Row kernels for the dual-gradient and L1 gradient energies:
+- scalar: one pixel at a time, direct raster access (no get_pixel)
+- SSE4.1: 16 pixels per step
+- AVX2:   32 pixels per step
+each for interleaved rows and for planar rows (planar_img.h), where the
+channel vectors are plain loads and no shuffles are needed.
+
+The SIMD kernels split 48-byte runs of interleaved RGB into R, G and B
+vectors with byte shuffles, compute dx^2 + dy^2 per channel in 32-bit lanes
+and take a float square root. The float result can land one off the exact
+value near multiples of 10, so it is corrected with two integer compares
+against (10 * s)^2, which makes every kernel bit-identical to the scalar
+(uint8_t)(sqrt(energy) / 10). Columns 0 and width - 1 wrap around and are
+always computed with the scalar code. The L1 kernels take |a - b| of
+bytes with two saturating subtractions and add the six differences in
+16-bit lanes; a shift does the scaling.
+*/
+
+#include <math.h>             // Required for sqrt
+#include <stdlib.h>           // Required for abs
+#include <string.h>           // Required for strcmp
+#include <pthread.h>          // Required for pthread_once
+#include "energy_simd.h"      // Header for the energy kernel declarations
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define ENERGY_X86 1          // Build the SSE4.1 / AVX2 kernels
+#include <immintrin.h>
+#endif
+
+#ifdef __GNUC__
+#define ENERGY_INLINE static inline __attribute__((always_inline))  // Folded into every caller
+#else
+#define ENERGY_INLINE static inline
+#endif
+
+// ----------------------------------------
+// Helper: combine_pixel
+// ----------------------------------------
+/*
+   Scaled energy of one pixel from its per-channel differences. `energy`
+   is a constant in every caller, so only one branch is compiled in.
+*/
+ENERGY_INLINE uint8_t combine_pixel(const int dx[3], const int dy[3], int energy) {
+    if (energy == ENERGY_L1) {
+        int sum = 0;
+        for (int c = 0; c < 3; c++) {
+            sum += abs(dx[c]) + abs(dy[c]);
+        }
+        return (uint8_t)(sum >> 4);             // At most 6 * 255 / 16
+    }
+
+    int delta_x = 0;
+    int delta_y = 0;
+    for (int c = 0; c < 3; c++) {
+        delta_x += dx[c] * dx[c];
+        delta_y += dy[c] * dy[c];
+    }
+    double total = sqrt(delta_x + delta_y);  // Total energy using Euclidean distance
+    return (uint8_t)(total / 10);            // Scale down to fit into uint8_t
+}
+
+// Energy of pixel x of an interleaved row
+ENERGY_INLINE uint8_t pixel_rgb(const uint8_t *up, const uint8_t *mid, const uint8_t *down, int width, int x,
+                                int energy) {
+    int left = (x == 0) ? width - 1 : x - 1;          // Wrap to last column if x == 0
+    int right = (x == width - 1) ? 0 : x + 1;         // Wrap to first column if x is last
+    int dx[3], dy[3];
+
+    for (int c = 0; c < 3; c++) {
+        dx[c] = mid[3 * right + c] - mid[3 * left + c];
+        dy[c] = down[3 * x + c] - up[3 * x + c];
+    }
+    return combine_pixel(dx, dy, energy);
+}
+
+// Energy of pixel x of a planar row
+ENERGY_INLINE uint8_t pixel_planar(const uint8_t *const up[3], const uint8_t *const mid[3],
+                                   const uint8_t *const down[3], int width, int x, int energy) {
+    int left = (x == 0) ? width - 1 : x - 1;
+    int right = (x == width - 1) ? 0 : x + 1;
+    int dx[3], dy[3];
+
+    for (int c = 0; c < 3; c++) {
+        dx[c] = mid[c][right] - mid[c][left];
+        dy[c] = down[c][x] - up[c][x];
+    }
+    return combine_pixel(dx, dy, energy);
+}
+
+// ----------------------------------------
+// Function: energy_pixel / energy_pixel_as
+// ----------------------------------------
+/*
+   Computes one pixel's scaled energy from the three rows around it.
+*/
+uint8_t energy_pixel(const uint8_t *up, const uint8_t *mid, const uint8_t *down, int width, int x) {
+    return pixel_rgb(up, mid, down, width, x, ENERGY_DUAL);
+}
+
+uint8_t energy_pixel_as(const uint8_t *up, const uint8_t *mid, const uint8_t *down, int width, int x,
+                        int energy) {
+    if (energy == ENERGY_L1) return pixel_rgb(up, mid, down, width, x, ENERGY_L1);
+    return pixel_rgb(up, mid, down, width, x, ENERGY_DUAL);
+}
+
+// ----------------------------------------
+// Function: energy_pixel_planar / energy_pixel_planar_as
+// ----------------------------------------
+uint8_t energy_pixel_planar(const uint8_t *const up[3], const uint8_t *const mid[3],
+                            const uint8_t *const down[3], int width, int x) {
+    return pixel_planar(up, mid, down, width, x, ENERGY_DUAL);
+}
+
+uint8_t energy_pixel_planar_as(const uint8_t *const up[3], const uint8_t *const mid[3],
+                               const uint8_t *const down[3], int width, int x, int energy) {
+    if (energy == ENERGY_L1) return pixel_planar(up, mid, down, width, x, ENERGY_L1);
+    return pixel_planar(up, mid, down, width, x, ENERGY_DUAL);
+}
+
+// ----------------------------------------
+// Kernel: scalar
+// ----------------------------------------
+ENERGY_INLINE void row_scalar(const uint8_t *up, const uint8_t *mid, const uint8_t *down, int width,
+                              uint8_t *out, int energy) {
+    for (int x = 0; x < width; x++) {
+        out[x] = pixel_rgb(up, mid, down, width, x, energy);
+    }
+}
+
+ENERGY_INLINE void planar_scalar(const uint8_t *const up[3], const uint8_t *const mid[3],
+                                 const uint8_t *const down[3], int width, uint8_t *out, int energy) {
+    for (int x = 0; x < width; x++) {
+        out[x] = pixel_planar(up, mid, down, width, x, energy);
+    }
+}
+
+#ifdef ENERGY_X86
+
+// ----------------------------------------
+// Helper: Deinterleave 16 RGB pixels
+// ----------------------------------------
+/*
+   Splits the 48 bytes at p (16 RGB pixels) into one vector per channel.
+   Each output byte is gathered from one of the three input vectors with a
+   shuffle; the masks zero the lanes that come from another input.
+*/
+__attribute__((target("sse4.1"), always_inline))
+static inline void deinterleave16(const uint8_t *p, __m128i *r, __m128i *g, __m128i *b) {
+    __m128i a0 = _mm_loadu_si128((const __m128i *)p);
+    __m128i a1 = _mm_loadu_si128((const __m128i *)(p + 16));
+    __m128i a2 = _mm_loadu_si128((const __m128i *)(p + 32));
+
+    *r = _mm_or_si128(_mm_or_si128(
+        _mm_shuffle_epi8(a0, _mm_setr_epi8(0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+        _mm_shuffle_epi8(a1, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14, -1, -1, -1, -1, -1))),
+        _mm_shuffle_epi8(a2, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 4, 7, 10, 13)));
+    *g = _mm_or_si128(_mm_or_si128(
+        _mm_shuffle_epi8(a0, _mm_setr_epi8(1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+        _mm_shuffle_epi8(a1, _mm_setr_epi8(-1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1))),
+        _mm_shuffle_epi8(a2, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14)));
+    *b = _mm_or_si128(_mm_or_si128(
+        _mm_shuffle_epi8(a0, _mm_setr_epi8(2, 5, 8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+        _mm_shuffle_epi8(a1, _mm_setr_epi8(-1, -1, -1, -1, -1, 1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1))),
+        _mm_shuffle_epi8(a2, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15)));
+}
+
+// ----------------------------------------
+// Kernel: SSE4.1 (16 pixels per step)
+// ----------------------------------------
+
+// floor(sqrt(e) / 10) for four 32-bit energies
+__attribute__((target("sse4.1"), always_inline))
+static inline __m128i scale_sse(__m128i e) {
+    __m128i s = _mm_cvttps_epi32(_mm_mul_ps(_mm_sqrt_ps(_mm_cvtepi32_ps(e)), _mm_set1_ps(0.1f)));
+    __m128i hundred = _mm_set1_epi32(100);
+
+    __m128i t = _mm_add_epi32(s, _mm_set1_epi32(1));        // s + 1 fits if (10(s+1))^2 <= e
+    __m128i too_big = _mm_cmpgt_epi32(_mm_mullo_epi32(_mm_mullo_epi32(t, t), hundred), e);
+    s = _mm_sub_epi32(s, _mm_andnot_si128(too_big, _mm_set1_epi32(-1)));
+    too_big = _mm_cmpgt_epi32(_mm_mullo_epi32(_mm_mullo_epi32(s, s), hundred), e);
+    return _mm_add_epi32(s, too_big);                       // s - 1 if (10s)^2 > e
+}
+
+// Adds dx^2 + dy^2 of one channel (16 pixels) to the four accumulators
+__attribute__((target("sse4.1"), always_inline))
+static inline void accumulate_sse(__m128i left, __m128i right, __m128i up, __m128i down, __m128i acc[4]) {
+    __m128i zero = _mm_setzero_si128();
+    __m128i dx_lo = _mm_sub_epi16(_mm_cvtepu8_epi16(right), _mm_cvtepu8_epi16(left));
+    __m128i dx_hi = _mm_sub_epi16(_mm_unpackhi_epi8(right, zero), _mm_unpackhi_epi8(left, zero));
+    __m128i dy_lo = _mm_sub_epi16(_mm_cvtepu8_epi16(down), _mm_cvtepu8_epi16(up));
+    __m128i dy_hi = _mm_sub_epi16(_mm_unpackhi_epi8(down, zero), _mm_unpackhi_epi8(up, zero));
+
+    // Pair each dx with its dy so one multiply-add gives dx*dx + dy*dy
+    __m128i p;
+    p = _mm_unpacklo_epi16(dx_lo, dy_lo); acc[0] = _mm_add_epi32(acc[0], _mm_madd_epi16(p, p));
+    p = _mm_unpackhi_epi16(dx_lo, dy_lo); acc[1] = _mm_add_epi32(acc[1], _mm_madd_epi16(p, p));
+    p = _mm_unpacklo_epi16(dx_hi, dy_hi); acc[2] = _mm_add_epi32(acc[2], _mm_madd_epi16(p, p));
+    p = _mm_unpackhi_epi16(dx_hi, dy_hi); acc[3] = _mm_add_epi32(acc[3], _mm_madd_epi16(p, p));
+}
+
+// |a - b| of 16 bytes
+__attribute__((target("sse4.1"), always_inline))
+static inline __m128i absdiff_sse(__m128i a, __m128i b) {
+    return _mm_or_si128(_mm_subs_epu8(a, b), _mm_subs_epu8(b, a));
+}
+
+/*
+   Energy of 16 pixels from the channel vectors of their left, right, up
+   and down neighbours. The L1 sums fit 16-bit lanes; the dual-gradient
+   squares go through the 32-bit accumulators and scale_sse.
+*/
+__attribute__((target("sse4.1"), always_inline))
+static inline __m128i energy16(const __m128i l[3], const __m128i r[3], const __m128i u[3], const __m128i d[3],
+                               int energy) {
+    __m128i zero = _mm_setzero_si128();
+    if (energy == ENERGY_L1) {
+        __m128i lo = zero, hi = zero;
+        for (int c = 0; c < 3; c++) {
+            __m128i dx = absdiff_sse(r[c], l[c]);
+            __m128i dy = absdiff_sse(d[c], u[c]);
+            lo = _mm_add_epi16(lo, _mm_add_epi16(_mm_cvtepu8_epi16(dx), _mm_cvtepu8_epi16(dy)));
+            hi = _mm_add_epi16(hi, _mm_add_epi16(_mm_unpackhi_epi8(dx, zero), _mm_unpackhi_epi8(dy, zero)));
+        }
+        return _mm_packus_epi16(_mm_srli_epi16(lo, 4), _mm_srli_epi16(hi, 4));
+    }
+
+    __m128i acc[4] = {zero, zero, zero, zero};
+    for (int c = 0; c < 3; c++) {
+        accumulate_sse(l[c], r[c], u[c], d[c], acc);
+    }
+    __m128i lo = _mm_packs_epi32(scale_sse(acc[0]), scale_sse(acc[1]));
+    __m128i hi = _mm_packs_epi32(scale_sse(acc[2]), scale_sse(acc[3]));
+    return _mm_packus_epi16(lo, hi);
+}
+
+__attribute__((target("sse4.1"), always_inline))
+static inline void row_sse41(const uint8_t *up, const uint8_t *mid, const uint8_t *down, int width,
+                             uint8_t *out, int energy) {
+    if (width < 3) {
+        row_scalar(up, mid, down, width, out, energy);
+        return;
+    }
+
+    out[0] = pixel_rgb(up, mid, down, width, 0, energy);
+    int x = 1;
+    for (; x + 16 <= width - 1; x += 16) {  // Pixels x .. x+15 and their right neighbours exist
+        __m128i l[3], r[3], u[3], d[3];
+        deinterleave16(mid + 3 * (x - 1), &l[0], &l[1], &l[2]);
+        deinterleave16(mid + 3 * (x + 1), &r[0], &r[1], &r[2]);
+        deinterleave16(up + 3 * x, &u[0], &u[1], &u[2]);
+        deinterleave16(down + 3 * x, &d[0], &d[1], &d[2]);
+        _mm_storeu_si128((__m128i *)(out + x), energy16(l, r, u, d, energy));
+    }
+    for (; x < width; x++) {  // Leftover pixels and the wrapped last column
+        out[x] = pixel_rgb(up, mid, down, width, x, energy);
+    }
+}
+
+// Planar rows: every neighbour is one unaligned load per channel
+__attribute__((target("sse4.1"), always_inline))
+static inline void planar_sse41(const uint8_t *const up[3], const uint8_t *const mid[3],
+                                const uint8_t *const down[3], int width, uint8_t *out, int energy) {
+    if (width < 3) {
+        planar_scalar(up, mid, down, width, out, energy);
+        return;
+    }
+
+    out[0] = pixel_planar(up, mid, down, width, 0, energy);
+    int x = 1;
+    for (; x + 16 <= width - 1; x += 16) {
+        __m128i l[3], r[3], u[3], d[3];
+        for (int c = 0; c < 3; c++) {
+            l[c] = _mm_loadu_si128((const __m128i *)(mid[c] + x - 1));
+            r[c] = _mm_loadu_si128((const __m128i *)(mid[c] + x + 1));
+            u[c] = _mm_loadu_si128((const __m128i *)(up[c] + x));
+            d[c] = _mm_loadu_si128((const __m128i *)(down[c] + x));
+        }
+        _mm_storeu_si128((__m128i *)(out + x), energy16(l, r, u, d, energy));
+    }
+    for (; x < width; x++) {
+        out[x] = pixel_planar(up, mid, down, width, x, energy);
+    }
+}
+
+// ----------------------------------------
+// Kernel: AVX2 (32 pixels per step)
+// ----------------------------------------
+
+// floor(sqrt(e) / 10) for eight 32-bit energies
+__attribute__((target("avx2"), always_inline))
+static inline __m256i scale_avx2(__m256i e) {
+    __m256i s = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_sqrt_ps(_mm256_cvtepi32_ps(e)), _mm256_set1_ps(0.1f)));
+    __m256i hundred = _mm256_set1_epi32(100);
+
+    __m256i t = _mm256_add_epi32(s, _mm256_set1_epi32(1));  // s + 1 fits if (10(s+1))^2 <= e
+    __m256i too_big = _mm256_cmpgt_epi32(_mm256_mullo_epi32(_mm256_mullo_epi32(t, t), hundred), e);
+    s = _mm256_sub_epi32(s, _mm256_andnot_si256(too_big, _mm256_set1_epi32(-1)));
+    too_big = _mm256_cmpgt_epi32(_mm256_mullo_epi32(_mm256_mullo_epi32(s, s), hundred), e);
+    return _mm256_add_epi32(s, too_big);                    // s - 1 if (10s)^2 > e
+}
+
+// Splits 32 RGB pixels into channel vectors (two 16-pixel halves per vector)
+__attribute__((target("avx2"), always_inline))
+static inline void deinterleave32(const uint8_t *p, __m256i *r, __m256i *g, __m256i *b) {
+    __m128i r0, g0, b0, r1, g1, b1;
+    deinterleave16(p, &r0, &g0, &b0);
+    deinterleave16(p + 48, &r1, &g1, &b1);
+    *r = _mm256_inserti128_si256(_mm256_castsi128_si256(r0), r1, 1);
+    *g = _mm256_inserti128_si256(_mm256_castsi128_si256(g0), g1, 1);
+    *b = _mm256_inserti128_si256(_mm256_castsi128_si256(b0), b1, 1);
+}
+
+/*
+   Adds dx^2 + dy^2 of one channel (32 pixels) to the accumulators. The
+   unpacks work within 128-bit lanes, so acc[0..3] hold pixels
+   {0-3, 16-19}, {4-7, 20-23}, {8-11, 24-27} and {12-15, 28-31}; the packs
+   at the end of the kernel undo that order.
+*/
+__attribute__((target("avx2"), always_inline))
+static inline void accumulate_avx2(__m256i left, __m256i right, __m256i up, __m256i down, __m256i acc[4]) {
+    __m256i zero = _mm256_setzero_si256();
+    __m256i dx_lo = _mm256_sub_epi16(_mm256_unpacklo_epi8(right, zero), _mm256_unpacklo_epi8(left, zero));
+    __m256i dx_hi = _mm256_sub_epi16(_mm256_unpackhi_epi8(right, zero), _mm256_unpackhi_epi8(left, zero));
+    __m256i dy_lo = _mm256_sub_epi16(_mm256_unpacklo_epi8(down, zero), _mm256_unpacklo_epi8(up, zero));
+    __m256i dy_hi = _mm256_sub_epi16(_mm256_unpackhi_epi8(down, zero), _mm256_unpackhi_epi8(up, zero));
+
+    __m256i p;
+    p = _mm256_unpacklo_epi16(dx_lo, dy_lo); acc[0] = _mm256_add_epi32(acc[0], _mm256_madd_epi16(p, p));
+    p = _mm256_unpackhi_epi16(dx_lo, dy_lo); acc[1] = _mm256_add_epi32(acc[1], _mm256_madd_epi16(p, p));
+    p = _mm256_unpacklo_epi16(dx_hi, dy_hi); acc[2] = _mm256_add_epi32(acc[2], _mm256_madd_epi16(p, p));
+    p = _mm256_unpackhi_epi16(dx_hi, dy_hi); acc[3] = _mm256_add_epi32(acc[3], _mm256_madd_epi16(p, p));
+}
+
+// |a - b| of 32 bytes
+__attribute__((target("avx2"), always_inline))
+static inline __m256i absdiff_avx2(__m256i a, __m256i b) {
+    return _mm256_or_si256(_mm256_subs_epu8(a, b), _mm256_subs_epu8(b, a));
+}
+
+/*
+   energy16 for 32 pixels. Both energies widen within 128-bit lanes, and
+   the final packs put the pixels back in order.
+*/
+__attribute__((target("avx2"), always_inline))
+static inline __m256i energy32(const __m256i l[3], const __m256i r[3], const __m256i u[3], const __m256i d[3],
+                               int energy) {
+    __m256i zero = _mm256_setzero_si256();
+    if (energy == ENERGY_L1) {
+        __m256i lo = zero, hi = zero;  // Pixels {0-7, 16-23} and {8-15, 24-31}
+        for (int c = 0; c < 3; c++) {
+            __m256i dx = absdiff_avx2(r[c], l[c]);
+            __m256i dy = absdiff_avx2(d[c], u[c]);
+            lo = _mm256_add_epi16(lo, _mm256_add_epi16(_mm256_unpacklo_epi8(dx, zero),
+                                                       _mm256_unpacklo_epi8(dy, zero)));
+            hi = _mm256_add_epi16(hi, _mm256_add_epi16(_mm256_unpackhi_epi8(dx, zero),
+                                                       _mm256_unpackhi_epi8(dy, zero)));
+        }
+        return _mm256_packus_epi16(_mm256_srli_epi16(lo, 4), _mm256_srli_epi16(hi, 4));
+    }
+
+    __m256i acc[4] = {zero, zero, zero, zero};
+    for (int c = 0; c < 3; c++) {
+        accumulate_avx2(l[c], r[c], u[c], d[c], acc);
+    }
+    __m256i lo = _mm256_packs_epi32(scale_avx2(acc[0]), scale_avx2(acc[1]));  // {0-7, 16-23}
+    __m256i hi = _mm256_packs_epi32(scale_avx2(acc[2]), scale_avx2(acc[3]));  // {8-15, 24-31}
+    return _mm256_packus_epi16(lo, hi);
+}
+
+__attribute__((target("avx2"), always_inline))
+static inline void row_avx2(const uint8_t *up, const uint8_t *mid, const uint8_t *down, int width,
+                            uint8_t *out, int energy) {
+    if (width < 3) {
+        row_scalar(up, mid, down, width, out, energy);
+        return;
+    }
+
+    out[0] = pixel_rgb(up, mid, down, width, 0, energy);
+    int x = 1;
+    for (; x + 32 <= width - 1; x += 32) {  // Pixels x .. x+31 and their right neighbours exist
+        __m256i l[3], r[3], u[3], d[3];
+        deinterleave32(mid + 3 * (x - 1), &l[0], &l[1], &l[2]);
+        deinterleave32(mid + 3 * (x + 1), &r[0], &r[1], &r[2]);
+        deinterleave32(up + 3 * x, &u[0], &u[1], &u[2]);
+        deinterleave32(down + 3 * x, &d[0], &d[1], &d[2]);
+        _mm256_storeu_si256((__m256i *)(out + x), energy32(l, r, u, d, energy));
+    }
+    for (; x < width; x++) {  // Leftover pixels and the wrapped last column
+        out[x] = pixel_rgb(up, mid, down, width, x, energy);
+    }
+}
+
+__attribute__((target("avx2"), always_inline))
+static inline void planar_avx2(const uint8_t *const up[3], const uint8_t *const mid[3],
+                               const uint8_t *const down[3], int width, uint8_t *out, int energy) {
+    if (width < 3) {
+        planar_scalar(up, mid, down, width, out, energy);
+        return;
+    }
+
+    out[0] = pixel_planar(up, mid, down, width, 0, energy);
+    int x = 1;
+    for (; x + 32 <= width - 1; x += 32) {
+        __m256i l[3], r[3], u[3], d[3];
+        for (int c = 0; c < 3; c++) {
+            l[c] = _mm256_loadu_si256((const __m256i *)(mid[c] + x - 1));
+            r[c] = _mm256_loadu_si256((const __m256i *)(mid[c] + x + 1));
+            u[c] = _mm256_loadu_si256((const __m256i *)(up[c] + x));
+            d[c] = _mm256_loadu_si256((const __m256i *)(down[c] + x));
+        }
+        _mm256_storeu_si256((__m256i *)(out + x), energy32(l, r, u, d, energy));
+    }
+    for (; x < width; x++) {
+        out[x] = pixel_planar(up, mid, down, width, x, energy);
+    }
+}
+
+#endif  // ENERGY_X86
+
+// ----------------------------------------
+// Kernel instances
+// ----------------------------------------
+/*
+   Each kernel body above takes the energy as an argument and is always
+   inlined; these macros stamp out one real function per (instruction
+   set, energy) pair with the energy as a constant, so the choice is
+   folded away at compile time and every pixel runs straight-line code.
+   The only runtime dispatch is one call per row through the table below.
+*/
+#define SCALAR_KERNELS(energy, suffix)                                                               \
+    static void energy_row_scalar_##suffix(const uint8_t *up, const uint8_t *mid, const uint8_t *down, \
+                                           int width, uint8_t *out) {                                \
+        row_scalar(up, mid, down, width, out, energy);                                               \
+    }                                                                                                \
+    static void energy_planar_scalar_##suffix(const uint8_t *const up[3], const uint8_t *const mid[3], \
+                                              const uint8_t *const down[3], int width, uint8_t *out) { \
+        planar_scalar(up, mid, down, width, out, energy);                                            \
+    }
+
+#define SIMD_KERNELS(isa, target_name, energy, suffix)                                                \
+    __attribute__((target(target_name)))                                                             \
+    static void energy_row_##isa##_##suffix(const uint8_t *up, const uint8_t *mid, const uint8_t *down, \
+                                            int width, uint8_t *out) {                               \
+        row_##isa(up, mid, down, width, out, energy);                                                \
+    }                                                                                                \
+    __attribute__((target(target_name)))                                                             \
+    static void energy_planar_##isa##_##suffix(const uint8_t *const up[3], const uint8_t *const mid[3], \
+                                               const uint8_t *const down[3], int width, uint8_t *out) { \
+        planar_##isa(up, mid, down, width, out, energy);                                             \
+    }
+
+SCALAR_KERNELS(ENERGY_DUAL, dual)
+SCALAR_KERNELS(ENERGY_L1, l1)
+#ifdef ENERGY_X86
+SIMD_KERNELS(sse41, "sse4.1", ENERGY_DUAL, dual)
+SIMD_KERNELS(sse41, "sse4.1", ENERGY_L1, l1)
+SIMD_KERNELS(avx2, "avx2", ENERGY_DUAL, dual)
+SIMD_KERNELS(avx2, "avx2", ENERGY_L1, l1)
+#endif
+
+// ----------------------------------------
+// Kernel selection
+// ----------------------------------------
+
+static int cpu_has_sse41(void) {
+#ifdef ENERGY_X86
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse4.1");
+#else
+    return 0;
+#endif
+}
+
+static int cpu_has_avx2(void) {
+#ifdef ENERGY_X86
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#else
+    return 0;
+#endif
+}
+
+static int cpu_has_nothing_special(void) {
+    return 1;
+}
+
+// Kernels from fastest to slowest; auto-selection takes the first supported one.
+// row and planar are indexed by energy (ENERGY_DUAL, ENERGY_L1)
+static const struct {
+    const char *name;
+    energy_row_fn row[ENERGY_MAP_KINDS];
+    energy_planar_fn planar[ENERGY_MAP_KINDS];
+    int (*supported)(void);
+} kernels[] = {
+#ifdef ENERGY_X86
+    {"avx2", {energy_row_avx2_dual, energy_row_avx2_l1},
+     {energy_planar_avx2_dual, energy_planar_avx2_l1}, cpu_has_avx2},
+    {"sse4.1", {energy_row_sse41_dual, energy_row_sse41_l1},
+     {energy_planar_sse41_dual, energy_planar_sse41_l1}, cpu_has_sse41},
+#endif
+    {"scalar", {energy_row_scalar_dual, energy_row_scalar_l1},
+     {energy_planar_scalar_dual, energy_planar_scalar_l1}, cpu_has_nothing_special},
+};
+
+static int selected = -1;  // Index into kernels, -1 until chosen
+static pthread_once_t auto_once = PTHREAD_ONCE_INIT;  // Guards the first-use choice
+
+/*
+   The first lookup picks "auto" unless energy_use_kernel already chose,
+   exactly once even when several threads ask together; every lookup
+   after pthread_once returns sees the choice.
+*/
+static void select_auto(void) {
+    if (selected < 0) energy_use_kernel("auto");
+}
+
+static int kernel_index(void) {
+    pthread_once(&auto_once, select_auto);
+    return selected;
+}
+
+// Row of the table for a map energy (anything else gets the dual-gradient)
+static int map_kind(int energy) {
+    return (energy == ENERGY_L1) ? ENERGY_L1 : ENERGY_DUAL;
+}
+
+energy_row_fn energy_kernel(void) {
+    return energy_kernel_as(ENERGY_DUAL);
+}
+
+energy_planar_fn energy_kernel_planar(void) {
+    return energy_kernel_planar_as(ENERGY_DUAL);
+}
+
+energy_row_fn energy_kernel_as(int energy) {
+    return kernels[kernel_index()].row[map_kind(energy)];
+}
+
+energy_planar_fn energy_kernel_planar_as(int energy) {
+    return kernels[kernel_index()].planar[map_kind(energy)];
+}
+
+const char *energy_kernel_name(void) {
+    return kernels[kernel_index()].name;
+}
+
+int energy_use_kernel(const char *name) {
+    int count = sizeof(kernels) / sizeof(kernels[0]);
+    for (int i = 0; i < count; i++) {
+        int wanted = strcmp(name, "auto") == 0 || strcmp(name, kernels[i].name) == 0;
+        if (wanted && kernels[i].supported()) {
+            selected = i;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+// ----------------------------------------
+// Function: energy_parse / energy_name
+// ----------------------------------------
+static const char *const energy_names[] = {"dual", "l1", "forward"};  // Indexed by ENERGY_*
+
+int energy_parse(const char *name) {
+    for (int i = 0; i < (int)(sizeof(energy_names) / sizeof(energy_names[0])); i++) {
+        if (strcmp(name, energy_names[i]) == 0) return i;
+    }
+    return -1;
+}
+
+const char *energy_name(int energy) {
+    if (energy < 0 || energy > ENERGY_FORWARD) return "unknown";
+    return energy_names[energy];
+}
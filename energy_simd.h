@@ -0,0 +1,109 @@
+/*
+SIMD Energy Kernel Header File
+Author: Tannaz Chowdhury
+GitHub: TannazC
+Date: 2025
+
+Declares the row kernels used by calc_energy to compute the scaled
+energy of one image row at a time, straight from the interleaved RGB
+raster. A scalar kernel is always available; on x86-64 SSE4.1 and AVX2
+kernels are compiled in as well and the fastest one the CPU supports is
+picked at runtime. There is a separate set of kernels for each energy
+that has a per-pixel map:
+  - dual-gradient: (uint8_t)(sqrt(delta_x + delta_y) / 10), the default;
+  - L1 gradient: (|dx| + |dy| summed over R, G and B) / 16, which needs
+    no multiplies or square root.
+Every kernel of an energy produces exactly the same bytes as its scalar
+reference. Forward energy has no map: its costs depend on which parent a
+seam comes from, so the DP computes them from the pixels (seam_dp.h).
+*/
+
+#ifndef ENERGY_SIMD_H           // Include guard - prevents multiple includes
+#define ENERGY_SIMD_H
+
+#include <stdint.h>
+
+// Energy functions (carve_opts.energy, energy_map.energy)
+#define ENERGY_DUAL       0     // Dual-gradient, sqrt(dx^2 + dy^2) / 10
+#define ENERGY_L1         1     // L1 gradient, (|dx| + |dy|) / 16
+#define ENERGY_FORWARD    2     // Forward energy, computed inside the DP
+#define ENERGY_MAP_KINDS  2     // Energies with a per-pixel map and row kernels
+
+// ----------------------------------------
+// Type: energy_row_fn
+// ----------------------------------------
+/*
+   Computes the energy of every pixel of one row.
+
+   Parameters:
+     up, mid, down - RGB rows above, at and below the row (already wrapped
+                     around at the top and bottom of the image)
+     width         - pixels in the row (columns wrap around at both ends)
+     out           - output: width energy values
+*/
+typedef void (*energy_row_fn)(const uint8_t *up, const uint8_t *mid, const uint8_t *down,
+                              int width, uint8_t *out);
+
+// ----------------------------------------
+// Type: energy_planar_fn
+// ----------------------------------------
+/*
+   A row kernel for planar images: up, mid and down hold the R, G and B
+   rows above, at and below the row. Results are identical to the
+   interleaved kernels.
+*/
+typedef void (*energy_planar_fn)(const uint8_t *const up[3], const uint8_t *const mid[3],
+                                 const uint8_t *const down[3], int width, uint8_t *out);
+
+// ----------------------------------------
+// Function: energy_pixel
+// ----------------------------------------
+/*
+   Scalar dual-gradient energy of pixel x of a row, with the same
+   arguments as a row kernel. Used for the wrapped border columns and as
+   the reference. The _as versions compute the given map energy
+   (ENERGY_DUAL or ENERGY_L1).
+*/
+uint8_t energy_pixel(const uint8_t *up, const uint8_t *mid, const uint8_t *down, int width, int x);
+uint8_t energy_pixel_planar(const uint8_t *const up[3], const uint8_t *const mid[3],
+                            const uint8_t *const down[3], int width, int x);
+uint8_t energy_pixel_as(const uint8_t *up, const uint8_t *mid, const uint8_t *down, int width, int x,
+                        int energy);
+uint8_t energy_pixel_planar_as(const uint8_t *const up[3], const uint8_t *const mid[3],
+                               const uint8_t *const down[3], int width, int x, int energy);
+
+// ----------------------------------------
+// Function: energy_kernel / energy_kernel_name / energy_use_kernel
+// ----------------------------------------
+/*
+   energy_kernel returns the selected row kernel for the dual-gradient
+   energy (energy_kernel_planar its planar counterpart); on first use it
+   picks the best one supported by the CPU, once (pthread_once), so
+   threads may look kernels up concurrently. energy_kernel_as and
+   energy_kernel_planar_as return the same kernel for another map energy
+   (ENERGY_DUAL or ENERGY_L1), so a pass looks its kernel up once and
+   makes one call per row. energy_kernel_name names the instruction set.
+   energy_use_kernel forces a kernel by name ("auto", "scalar", "sse4.1",
+   "avx2"); it returns 0, or -1 if the kernel is unknown or the CPU (or the
+   build) does not support it. It is an explicit setter: call it while no
+   other thread is computing energy (e.g. at startup, or between
+   passes), and the choice holds until the next call.
+*/
+energy_row_fn energy_kernel(void);
+energy_planar_fn energy_kernel_planar(void);
+energy_row_fn energy_kernel_as(int energy);
+energy_planar_fn energy_kernel_planar_as(int energy);
+const char *energy_kernel_name(void);
+int energy_use_kernel(const char *name);
+
+// ----------------------------------------
+// Function: energy_parse / energy_name
+// ----------------------------------------
+/*
+   Converts between ENERGY_* values and their names ("dual", "l1",
+   "forward"). energy_parse returns -1 for an unknown name.
+*/
+int energy_parse(const char *name);
+const char *energy_name(int energy);
+
+#endif  // End of include guard for ENERGY_SIMD_H
@@ -0,0 +1,199 @@
+/*
+Image Streaming Implementation
+Author: Tannaz Chowdhury
+GitHub: TannazC
+Date: 2025
+
+Band-at-a-time reading and writing of .bin files, and the streamed energy
+pass. Rows are located with img_row_offset, so v1, unchunked v2 and
+chunked v2 files all go through the same code; a chunked file's band is
+one contiguous read.
+*/
+
+#define _POSIX_C_SOURCE 200809L  // For fseeko under -std=c99
+
+#include <stdio.h>            // Required for file IO
+#include <stdlib.h>           // Required for malloc, free
+#include <string.h>           // Required for memcpy, memmove
+#include <sys/types.h>        // For off_t
+#include "img_stream.h"       // Header for the streaming declarations
+#include "energy_simd.h"      // Row kernel for the energy pass
+#include "carve_stats.h"      // Read and energy timers
+
+#define STREAM_IO_BUFFER (1 << 20)  // stdio buffer of readers and writers
+
+// ----------------------------------------
+// Function: img_reader_open / img_reader_close
+// ----------------------------------------
+int img_reader_open(struct img_reader *reader, const char *filename) {
+    reader->fp = fopen(filename, "rb");
+    if (reader->fp == NULL) return -1;
+    setvbuf(reader->fp, NULL, _IOFBF, STREAM_IO_BUFFER);
+    if (read_img_header(reader->fp, &reader->hdr) != 0) {
+        fclose(reader->fp);
+        reader->fp = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+void img_reader_close(struct img_reader *reader) {
+    if (reader->fp != NULL) fclose(reader->fp);
+    reader->fp = NULL;
+}
+
+// ----------------------------------------
+// Function: img_reader_rows
+// ----------------------------------------
+/*
+   Splits the rows at band boundaries; each run of one band is a single
+   read when the strides match, or one read per row otherwise.
+*/
+int img_reader_rows(struct img_reader *reader, size_t y, size_t count, uint8_t *rows, size_t stride) {
+    const struct img_header *hdr = &reader->hdr;
+    size_t band = (hdr->band_rows > 0) ? hdr->band_rows : hdr->height;
+    size_t row_bytes = 3 * hdr->stride, used = 3 * hdr->width;
+
+    if (y > hdr->height || count > hdr->height - y) return -1;
+    STATS_START(timer);
+    for (size_t done = 0; done < count;) {
+        size_t row = y + done;
+        size_t run = band - row % band;                     // Rows left in this band
+        if (run > count - done) run = count - done;
+        uint8_t *to = rows + 3 * done * stride;
+        if (fseeko(reader->fp, (off_t)img_row_offset(hdr, row), SEEK_SET) != 0) return -1;
+        if (stride == hdr->stride) {
+            if (fread(to, 1, run * row_bytes, reader->fp) != run * row_bytes) return -1;
+        } else {
+            for (size_t i = 0; i < run; i++) {
+                if (fread(to + 3 * i * stride, 1, used, reader->fp) != used) return -1;
+                if (i + 1 < run && fseeko(reader->fp, (off_t)(row_bytes - used), SEEK_CUR) != 0) return -1;
+            }
+        }
+        done += run;
+    }
+    STATS_ADD(bytes_read, count * used);
+    STATS_STOP(timer, STAGE_READ, count * hdr->width);
+    return 0;
+}
+
+// ----------------------------------------
+// Function: img_writer_open / img_writer_rows / img_writer_close
+// ----------------------------------------
+int img_writer_open(struct img_writer *writer, const char *filename, size_t height, size_t width,
+                    size_t band_rows) {
+    img_v2_header(&writer->hdr, height, width, band_rows);
+    writer->next = 0;
+    writer->failed = 0;
+    writer->fp = fopen(filename, "wb");
+    if (writer->fp == NULL) return -1;
+    setvbuf(writer->fp, NULL, _IOFBF, STREAM_IO_BUFFER);
+    writer->failed = write_img_header(writer->fp, &writer->hdr);
+    return writer->failed;
+}
+
+int img_writer_rows(struct img_writer *writer, const uint8_t *rows, size_t count, size_t stride) {
+    if (count > writer->hdr.height - writer->next) return -1;
+    STATS_START(timer);
+    writer->failed |= write_img_rows(writer->fp, &writer->hdr, writer->next, rows, count, stride);
+    writer->next += count;
+    STATS_ADD(bytes_written, 3 * count * writer->hdr.stride);
+    STATS_STOP(timer, STAGE_WRITE, count * writer->hdr.width);
+    return writer->failed;
+}
+
+int img_writer_close(struct img_writer *writer) {
+    int failed = writer->failed || writer->next != writer->hdr.height;
+    if (writer->fp != NULL) failed |= (fclose(writer->fp) != 0);
+    writer->fp = NULL;
+    return failed ? -1 : 0;
+}
+
+// ----------------------------------------
+// Helper: read_wrapped
+// ----------------------------------------
+/*
+   Reads `count` rows starting at row y, wrapping past the last row to
+   row 0 (so row height is row 0 again), into consecutive window rows.
+*/
+static int read_wrapped(struct img_reader *reader, size_t y, size_t count, uint8_t *rows) {
+    size_t height = reader->hdr.height, row_bytes = 3 * reader->hdr.stride;
+    while (count > 0) {
+        y %= height;
+        size_t run = (height - y < count) ? height - y : count;
+        if (img_reader_rows(reader, y, run, rows, reader->hdr.stride) != 0) return -1;
+        rows += run * row_bytes;
+        y += run;
+        count -= run;
+    }
+    return 0;
+}
+
+// ----------------------------------------
+// Function: stream_energy_bytes
+// ----------------------------------------
+static size_t pick_band(const struct img_header *hdr, size_t band_rows) {
+    if (band_rows == 0) band_rows = (hdr->band_rows > 0) ? hdr->band_rows : IMG_STREAM_BAND;
+    return (band_rows > hdr->height) ? hdr->height : band_rows;
+}
+
+size_t stream_energy_bytes(const struct img_header *hdr, size_t band_rows) {
+    size_t band = pick_band(hdr, band_rows);
+    return (band + 2) * 3 * hdr->stride + band * hdr->width;
+}
+
+// ----------------------------------------
+// Function: stream_energy
+// ----------------------------------------
+/*
+   The window holds rows y - 1 to y + band of the current band. Moving to
+   the next band keeps its last two rows (the new band's upper halo and
+   first row) and reads the rest, so every row is read once, plus the
+   last row at the start for the first band's upper halo and row 0 again
+   at the end for the last band's lower one.
+*/
+int stream_energy(const char *filename, size_t band_rows, energy_band_fn fn, void *arg) {
+    struct img_reader reader;
+    if (img_reader_open(&reader, filename) != 0) return -1;
+
+    const struct img_header *hdr = &reader.hdr;
+    size_t height = hdr->height, width = hdr->width, row_bytes = 3 * hdr->stride;
+    size_t band = pick_band(hdr, band_rows);
+    energy_row_fn kernel = energy_kernel();
+    int result = 0;
+
+    if (height == 0 || width == 0) {
+        img_reader_close(&reader);
+        return 0;
+    }
+    uint8_t *window = (uint8_t *)malloc((band + 2) * row_bytes);
+    uint8_t *energy = (uint8_t *)malloc(band * width);
+    STATS_ADD(bytes_allocated, (band + 2) * row_bytes + band * width);
+
+    size_t count = band;
+    if (read_wrapped(&reader, height - 1, 1, window) != 0 ||       // Upper halo of row 0
+        read_wrapped(&reader, 0, count + 1, window + row_bytes) != 0) {
+        result = -1;
+    }
+    for (size_t y = 0; y < height && result == 0;) {
+        STATS_START(timer);
+        for (size_t i = 0; i < count; i++) {
+            kernel(window + i * row_bytes, window + (i + 1) * row_bytes, window + (i + 2) * row_bytes,
+                   (int)width, energy + i * width);
+        }
+        STATS_STOP(timer, STAGE_ENERGY, count * width);
+        result = fn(arg, y, count, energy, width);
+
+        y += count;
+        if (y >= height || result != 0) break;
+        size_t next = (height - y < band) ? height - y : band;
+        memmove(window, window + count * row_bytes, 2 * row_bytes);  // Rows y - 1 and y
+        if (read_wrapped(&reader, y + 1, next, window + 2 * row_bytes) != 0) result = -1;
+        count = next;
+    }
+
+    free(energy);
+    free(window);
+    img_reader_close(&reader);
+    return result;
+}
@@ -0,0 +1,101 @@
+/*
+Image Streaming Header File
+Author: Tannaz Chowdhury
+GitHub: TannazC
+Date: 2025
+
+Declares row-band access to .bin files (v1 or v2, see c_img.h) for images
+too large to hold whole: a reader that fetches any run of rows, a writer
+that emits a v2 file a few rows at a time, and an energy pass that walks
+a file band by band. The energy of a row needs the rows above and below
+it (wrapped at the top and bottom, as calc_energy does), so each band is
+held together with a one-row halo on either side; only that window and
+one band of energy values are in memory at any time.
+*/
+
+#ifndef IMG_STREAM_H            // Include guard - prevents multiple includes
+#define IMG_STREAM_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "c_img.h"              // File layouts (struct img_header)
+
+#define IMG_STREAM_BAND 64      // Rows per band when neither caller nor file picks one
+
+// ----------------------------------------
+// Struct: img_reader / img_writer
+// ----------------------------------------
+/*
+   Fields:
+     fp   - the open file
+     hdr  - its layout
+     next - (writer) next row to write
+     failed - (writer) a write has failed
+*/
+struct img_reader {
+    FILE *fp;
+    struct img_header hdr;
+};
+
+struct img_writer {
+    FILE *fp;
+    struct img_header hdr;
+    size_t next;
+    int failed;
+};
+
+// ----------------------------------------
+// Function: img_reader_open / img_reader_rows / img_reader_close
+// ----------------------------------------
+/*
+   img_reader_open opens a file and reads its header (0, or -1 if it
+   cannot be opened or the header is bad). img_reader_rows copies rows y
+   to y + count - 1 into `rows`, whose rows are 3 * stride bytes apart;
+   with stride equal to the file's (hdr.stride), each band's rows arrive
+   in one read. Returns 0, or -1 if the rows are out of range or the file
+   is truncated.
+*/
+int img_reader_open(struct img_reader *reader, const char *filename);
+int img_reader_rows(struct img_reader *reader, size_t y, size_t count, uint8_t *rows, size_t stride);
+void img_reader_close(struct img_reader *reader);
+
+// ----------------------------------------
+// Function: img_writer_open / img_writer_rows / img_writer_close
+// ----------------------------------------
+/*
+   img_writer_open creates a v2 file for a height x width image in bands
+   of band_rows rows (0 = not chunked) and writes its header.
+   img_writer_rows appends the next `count` rows (3 * stride bytes apart).
+   img_writer_close closes the file. Each returns 0, or -1 on an error;
+   img_writer_close also fails if any write failed or fewer than height
+   rows were written.
+*/
+int img_writer_open(struct img_writer *writer, const char *filename, size_t height, size_t width,
+                    size_t band_rows);
+int img_writer_rows(struct img_writer *writer, const uint8_t *rows, size_t count, size_t stride);
+int img_writer_close(struct img_writer *writer);
+
+// ----------------------------------------
+// Type: energy_band_fn
+// ----------------------------------------
+/*
+   Receives the energy of rows y to y + count - 1 (width values per row,
+   `stride` bytes apart). The buffer is reused for the next band.
+*/
+typedef int (*energy_band_fn)(void *arg, size_t y, size_t count, const uint8_t *energy, size_t stride);
+
+// ----------------------------------------
+// Function: stream_energy
+// ----------------------------------------
+/*
+   Computes the energy of every row of a file, band_rows rows at a time
+   (0: the file's band size if it is chunked, else IMG_STREAM_BAND), and
+   hands each band to fn. The values equal calc_energy's for the whole
+   image. Memory held is (band + 2) rows of the file plus band * width
+   energy values (stream_energy_bytes). Returns 0, -1 if the file cannot
+   be read, or fn's return value if it is not 0 (which stops the pass).
+*/
+int stream_energy(const char *filename, size_t band_rows, energy_band_fn fn, void *arg);
+size_t stream_energy_bytes(const struct img_header *hdr, size_t band_rows);
+
+#endif  // End of include guard for IMG_STREAM_H
@@ -0,0 +1,77 @@
+/*
+Planar Image Header File
+Author: Tannaz Chowdhury
+GitHub: TannazC
+Date: 2025
+
+Declares a planar (structure-of-arrays) RGB image: one plane per channel,
+each row padded to a multiple of PLANAR_ALIGN bytes. The energy kernels
+then load each neighbour of 16 or 32 pixels with one unaligned vector
+load per channel instead of shuffling interleaved triples apart, and seam
+removal moves bytes instead of 3-byte groups. Images are converted from
+and to the interleaved .bin raster once per carve.
+*/
+
+#ifndef PLANAR_IMG_H            // Include guard - prevents multiple includes
+#define PLANAR_IMG_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "c_img.h"              // Required for struct rgb_img definitions
+
+#define PLANAR_ALIGN 64         // Plane rows start on cache lines
+
+// ----------------------------------------
+// Struct: planar_img
+// ----------------------------------------
+/*
+   Fields:
+     plane  - R, G and B planes (plane[0] is the start of the block)
+     height - number of rows
+     width  - number of columns in use
+     stride - bytes between the starts of consecutive rows of a plane; a
+              multiple of PLANAR_ALIGN, fixed while the image is carved
+*/
+struct planar_img {
+    uint8_t *plane[3];
+    size_t height;
+    size_t width;
+    size_t stride;
+};
+
+// ----------------------------------------
+// Function: planar_row
+// ----------------------------------------
+static inline uint8_t *planar_row(const struct planar_img *pl, int channel, size_t y) {
+    return pl->plane[channel] + y * pl->stride;
+}
+
+// ----------------------------------------
+// Function: planar_bytes / init_planar
+// ----------------------------------------
+/*
+   planar_bytes is the size of the three planes of a height x width image.
+   init_planar sets up an image on a caller's block of that size (aligned
+   to PLANAR_ALIGN, e.g. from a seam_arena); do not destroy it.
+*/
+size_t planar_bytes(size_t height, size_t width);
+void init_planar(struct planar_img *pl, uint8_t *data, size_t height, size_t width);
+
+// ----------------------------------------
+// Function: create_planar / destroy_planar
+// ----------------------------------------
+void create_planar(struct planar_img **pl, size_t height, size_t width);
+void destroy_planar(struct planar_img *pl);
+
+// ----------------------------------------
+// Function: planar_from_rgb / planar_to_rgb
+// ----------------------------------------
+/*
+   Convert between layouts into an existing image that is large enough
+   (at least as many rows, stride at least the width); the destination's
+   height and width are set, its stride kept.
+*/
+void planar_from_rgb(const struct rgb_img *im, struct planar_img *pl);
+void planar_to_rgb(const struct planar_img *pl, struct rgb_img *im);
+
+#endif  // End of include guard for PLANAR_IMG_H
@@ -8,33 +8,44 @@ This script defines utility functions to convert standard RGB PNG images into
 custom .bin format and back. The binary format stores image dimensions followed
 by RGB pixel data row-wise. It also includes a testing block to demonstrate
 functionality using sample files.
+
+Pixels are moved as whole buffers, never one at a time. With the native
+`seamcarving` module built (setup.py), files are read memory-mapped and the
+PIL image shares the raster (v1 and v2 files alike); without it, v1 files
+are read and written with plain Python I/O.
 '''
 
 from PIL import Image  # Import PIL for image reading and manipulation
 
+try:
+    import seamcarving   # Native module (python3 setup.py build_ext --inplace)
+except ImportError:
+    seamcarving = None
+
 # ----------------------------------------
 # Function: write_image
 # ----------------------------------------
 '''
 Writes a PIL image to a binary file in the following format:
 [2 bytes height][2 bytes width][3 * height * width RGB values row-wise]
+(the v2 layout when a side is over 65535 pixels, which needs the native module).
 '''
 def write_image(image, filename):
+    image = image.convert("RGB")                   # Drop alpha, expand palettes
     height = image.height                          # Get image height
     width = image.width                            # Get image width
+    data = image.tobytes()                         # All RGB bytes, row by row
 
-    f = open(filename, "wb")                        # Open file in binary write mode
-
-    f.write(height.to_bytes(2, byteorder='big'))   # Write height as 2-byte big-endian
-    f.write(width.to_bytes(2, byteorder='big'))    # Write width as 2-byte big-endian
+    if seamcarving is not None:                    # Written straight from data
+        seamcarving.write(memoryview(data).cast("B", (height, width, 3)), filename)
+        return
+    if height > 0xFFFF or width > 0xFFFF:
+        raise ValueError("images over 65535 pixels need the seamcarving module")
 
-    img_raster = []                                # Prepare list for pixel data
-    for i in range(height):                        # For every row
-        for j in range(width):                     # For every column
-            img_raster.extend(image.getpixel((j, i))[:3])  # Append RGB values
-
-    f.write(bytearray(img_raster))                 # Write all RGB bytes at once
-    f.close()                                      # Close the file
+    with open(filename, "wb") as f:                # Open file in binary write mode
+        f.write(height.to_bytes(2, byteorder='big'))   # Write height as 2-byte big-endian
+        f.write(width.to_bytes(2, byteorder='big'))    # Write width as 2-byte big-endian
+        f.write(data)                              # Write all RGB bytes at once
 
 # ----------------------------------------
 # Function: read_2bytes
@@ -52,25 +63,22 @@ def read_2bytes(f):
 # ----------------------------------------
 '''
 Reads a .bin file and reconstructs a PIL RGB image.
-Assumes format: [2 bytes height][2 bytes width][RGB RGB RGB ...]
+Assumes format: [2 bytes height][2 bytes width][RGB RGB RGB ...], or v2
+with the native module.
 '''
 def read_image(filename):
-    f = open(filename, "rb")                       # Open file in binary read mode
-    height = read_2bytes(f)                        # Read height
-    width = read_2bytes(f)                         # Read width
-
-    image = Image.new("RGB", (width, height))      # Create empty image with given dimensions
-    bytes = f.read()                               # Read remaining pixel data
+    if seamcarving is not None:                    # Mapped file, shared with PIL
+        im = seamcarving.read(filename)
+        return Image.frombuffer("RGB", (im.width, im.height), im, "raw", "RGB", 3 * im.stride, 1)
 
-    for i in range(height):                        # Loop through each row
-        for j in range(width):                     # Loop through each column
-            image.putpixel((j, i), (               # Set pixel value at (j, i)
-                bytes[3*(i*width + j) + 0],        # Red
-                bytes[3*(i*width + j) + 1],        # Green
-                bytes[3*(i*width + j) + 2]         # Blue
-            ))
+    with open(filename, "rb") as f:                # Open file in binary read mode
+        height = read_2bytes(f)                    # Read height
+        width = read_2bytes(f)                     # Read width
+        if height == 0 and width == 0x5343:        # 00 00 'S' 'C': a v2 file
+            raise ValueError("v2 files need the seamcarving module")
+        data = f.read(3 * height * width)          # Read all pixel data
 
-    return image                                   # Return reconstructed image
+    return Image.frombytes("RGB", (width, height), data)  # Rebuild the image in one call
 
 # ----------------------------------------
 # Main (test and conversion block)
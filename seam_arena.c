@@ -0,0 +1,55 @@
+/*
+Scratch Arena Implementation
+Author: Tannaz Chowdhury
+GitHub: TannazC
+Date: 2025
+
+One aligned block and a bump pointer. Nothing is freed individually.
+*/
+
+#define _POSIX_C_SOURCE 200112L  // For posix_memalign under -std=c99
+
+#include <stdlib.h>           // Required for posix_memalign, free
+#include "seam_arena.h"       // Header for the arena declarations
+#include "carve_stats.h"      // Allocation counter
+
+// ----------------------------------------
+// Function: arena_init
+// ----------------------------------------
+void arena_init(struct seam_arena *arena, size_t size) {
+    void *block = NULL;
+    if (posix_memalign(&block, ARENA_ALIGN, size > 0 ? size : ARENA_ALIGN) != 0) block = NULL;
+    arena->base = (uint8_t *)block;
+    arena->size = (block != NULL) ? size : 0;
+    arena->used = 0;
+    STATS_ADD(bytes_allocated, arena->size);
+}
+
+// ----------------------------------------
+// Function: arena_alloc
+// ----------------------------------------
+void *arena_alloc(struct seam_arena *arena, size_t bytes) {
+    size_t need = arena_size(bytes);
+    if (need > arena->size - arena->used) return NULL;   // Sized too small
+
+    void *p = arena->base + arena->used;
+    arena->used += need;
+    return p;
+}
+
+// ----------------------------------------
+// Function: arena_reset
+// ----------------------------------------
+void arena_reset(struct seam_arena *arena) {
+    arena->used = 0;
+}
+
+// ----------------------------------------
+// Function: arena_free
+// ----------------------------------------
+void arena_free(struct seam_arena *arena) {
+    free(arena->base);
+    arena->base = NULL;
+    arena->size = 0;
+    arena->used = 0;
+}
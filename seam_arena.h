@@ -0,0 +1,69 @@
+/*
+Scratch Arena Header File
+Author: Tannaz Chowdhury
+GitHub: TannazC
+Date: 2025
+
+Declares a bump allocator for carve-scoped scratch memory. One block is
+allocated up front for the starting dimensions; energy maps, DP tables
+and seam paths are then carved out of it and reused while the image
+shrinks, so carving makes no heap calls after setup and its working
+memory is known from H x W before a job starts (see carve_bytes).
+*/
+
+#ifndef SEAM_ARENA_H            // Include guard - prevents multiple includes
+#define SEAM_ARENA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define ARENA_ALIGN 64          // Every allocation starts on a cache line
+
+// ----------------------------------------
+// Struct: seam_arena
+// ----------------------------------------
+/*
+   Fields:
+     base - the block (ARENA_ALIGN-aligned)
+     size - bytes in the block
+     used - bytes handed out so far
+*/
+struct seam_arena {
+    uint8_t *base;
+    size_t size;
+    size_t used;
+};
+
+// ----------------------------------------
+// Function: arena_size
+// ----------------------------------------
+/*
+   Bytes an allocation of `bytes` takes in an arena (rounded up to
+   ARENA_ALIGN). Size calculations add these up to get the block size.
+*/
+static inline size_t arena_size(size_t bytes) {
+    return (bytes + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+}
+
+// ----------------------------------------
+// Function: arena_init / arena_free
+// ----------------------------------------
+/*
+   arena_init allocates a block of `size` bytes; arena_free releases it
+   and everything allocated from it.
+*/
+void arena_init(struct seam_arena *arena, size_t size);
+void arena_free(struct seam_arena *arena);
+
+// ----------------------------------------
+// Function: arena_alloc / arena_reset
+// ----------------------------------------
+/*
+   arena_alloc hands out the next arena_size(bytes) bytes of the block, or
+   NULL when they do not fit. arena_reset makes the whole block available
+   again (everything allocated before is invalid).
+*/
+void *arena_alloc(struct seam_arena *arena, size_t bytes);
+void arena_reset(struct seam_arena *arena);
+
+#endif  // End of include guard for SEAM_ARENA_H
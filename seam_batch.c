@@ -0,0 +1,213 @@
+/*
+Multi-Seam Batch Implementation
+Author: Tannaz Chowdhury
+GitHub: TannazC
+Date: 2025
+
+Greedy extraction of several disjoint seams from one DP pass, and their
+removal in a single compaction pass. Removing k seams this way costs one
+energy pass, one DP and one copy of the raster instead of k of each. The
+seams are not exactly the ones k separate passes would find (later seams
+are routed around earlier ones on the old cost map), so callers that care
+can compare the total energy removed against exact carving.
+*/
+
+#include <stdlib.h>           // Required for malloc, free, qsort
+#include <string.h>           // Required for memset, memmove
+#include "seam_batch.h"       // Header for the batch declarations
+#include "carve_stats.h"      // Stage timers and counters
+#include "seam_arena.h"       // Arena-backed working memory
+
+// ----------------------------------------
+// Function: seam_batch_init
+// ----------------------------------------
+void seam_batch_init(struct seam_batch *batch, size_t height, size_t width, int max_seams) {
+    batch->max_seams = max_seams;
+    batch->candidates = (uint64_t *)malloc(sizeof(uint64_t) * width);
+    batch->taken_pitch = (width + 7) / 8;                          // One bit per pixel
+    batch->taken = (uint8_t *)malloc(batch->taken_pitch * height);
+    batch->cols = (int *)malloc(sizeof(int) * max_seams);
+}
+
+// ----------------------------------------
+// Function: seam_batch_bytes / seam_batch_init_arena
+// ----------------------------------------
+size_t seam_batch_bytes(size_t height, size_t width, int max_seams) {
+    return arena_size(sizeof(uint64_t) * width) + arena_size((width + 7) / 8 * height) +
+           arena_size(sizeof(int) * max_seams);
+}
+
+void seam_batch_init_arena(struct seam_batch *batch, size_t height, size_t width, int max_seams,
+                           struct seam_arena *arena) {
+    batch->max_seams = max_seams;
+    batch->candidates = (uint64_t *)arena_alloc(arena, sizeof(uint64_t) * width);
+    batch->taken_pitch = (width + 7) / 8;
+    batch->taken = (uint8_t *)arena_alloc(arena, batch->taken_pitch * height);
+    batch->cols = (int *)arena_alloc(arena, sizeof(int) * max_seams);
+}
+
+// ----------------------------------------
+// Function: seam_batch_free
+// ----------------------------------------
+void seam_batch_free(struct seam_batch *batch) {
+    free(batch->candidates);
+    free(batch->taken);
+    free(batch->cols);
+}
+
+// ----------------------------------------
+// Helpers: taken bitmap
+// ----------------------------------------
+static inline int is_taken(const struct seam_batch *batch, int y, int x) {
+    return (batch->taken[y * batch->taken_pitch + (x >> 3)] >> (x & 7)) & 1;
+}
+
+static inline void set_taken(struct seam_batch *batch, int y, int x, int on) {
+    uint8_t *byte = &batch->taken[y * batch->taken_pitch + (x >> 3)];
+    if (on) *byte |= (uint8_t)(1 << (x & 7));
+    else *byte &= (uint8_t)~(1 << (x & 7));
+}
+
+static int compare_keys(const void *a, const void *b) {
+    uint64_t ka = *(const uint64_t *)a;
+    uint64_t kb = *(const uint64_t *)b;
+    return (ka > kb) - (ka < kb);
+}
+
+// ----------------------------------------
+// Helper: Reroute
+// ----------------------------------------
+/*
+   Picks the parent of (y, x) in row y - 1 when the DP's choice is taken:
+   the free neighbour with the lowest energy, preferring directly above,
+   then left, then right on ties. Returns -1 if all of them are taken.
+*/
+static int reroute(const struct seam_batch *batch, struct energy_map *grad, int y, int x) {
+    static const int offsets[3] = {0, -1, 1};
+    int width = grad->width;
+    int best = -1;
+    int best_energy = 256;
+
+    for (int i = 0; i < 3; i++) {
+        int col = x + offsets[i];
+        if (col < 0 || col >= width || is_taken(batch, y - 1, col)) continue;
+        int e = get_energy(grad, y - 1, col);
+        if (e < best_energy) {
+            best_energy = e;
+            best = col;
+        }
+    }
+    return best;
+}
+
+// ----------------------------------------
+// Function: seam_batch_find
+// ----------------------------------------
+int seam_batch_find(struct seam_batch *batch, struct seam_dp *dp, const uint32_t *last,
+                    struct energy_map *grad, int k, int *paths, uint64_t *energy) {
+    STATS_START(timer);
+    int height = grad->height;
+    int width = grad->width;
+    int found = 0;
+    uint64_t total = 0;
+
+    if (k > batch->max_seams) k = batch->max_seams;
+    if (k > width - 1) k = width - 1;   // Always leave at least one column
+
+    // Candidates: bottom-row pixels, cheapest first, leftmost on ties
+    for (int x = 0; x < width; x++) {
+        batch->candidates[x] = ((uint64_t)last[x] << 32) | (uint32_t)x;
+    }
+    qsort(batch->candidates, width, sizeof(uint64_t), compare_keys);
+    memset(batch->taken, 0, batch->taken_pitch * height);
+
+    for (int c = 0; c < width && found < k; c++) {
+        int *path = paths + (size_t)found * height;
+        int col = (int)(batch->candidates[c] & 0xFFFFFFFFu);
+        int y = height - 1;
+        uint64_t seam_energy = get_energy(grad, y, col);
+
+        if (is_taken(batch, y, col)) continue;
+        path[y] = col;
+        set_taken(batch, y, col, 1);
+
+        for (; y > 0; y--) {  // Trace upward, routing around earlier seams
+            int parent = col + seam_dp_parent(dp, y, col);
+            if (is_taken(batch, y - 1, parent)) parent = reroute(batch, grad, y, col);
+            if (parent < 0) break;  // Boxed in
+            col = parent;
+            path[y - 1] = col;
+            set_taken(batch, y - 1, col, 1);
+            seam_energy += get_energy(grad, y - 1, col);
+        }
+
+        if (y > 0) {  // Dropped: release the rows this candidate claimed
+            for (int r = y; r < height; r++) set_taken(batch, r, path[r], 0);
+            continue;
+        }
+        total += seam_energy;
+        found++;
+    }
+
+    if (energy != NULL) *energy = total;
+    STATS_STOP(timer, STAGE_TRACE, (size_t)found * height);
+    return found;
+}
+
+// ----------------------------------------
+// Function: remove_columns
+// ----------------------------------------
+/*
+   For each row, sorts the removed columns and slides every run of kept
+   elements left over the gaps.
+*/
+void remove_columns(uint8_t *base, size_t pitch, size_t elem, int height, int width,
+                    const int *paths, int count, int *cols) {
+    if (count <= 0) return;
+    for (int y = 0; y < height; y++) {
+        uint8_t *row = base + (size_t)y * pitch;
+
+        for (int s = 0; s < count; s++) {  // Insertion sort: count is small
+            int col = paths[(size_t)s * height + y];
+            int i = s;
+            while (i > 0 && cols[i - 1] > col) {
+                cols[i] = cols[i - 1];
+                i--;
+            }
+            cols[i] = col;
+        }
+
+        int write = cols[0];           // Everything left of the first gap stays put
+        for (int s = 0; s < count; s++) {
+            int from = cols[s] + 1;
+            int to = (s + 1 < count) ? cols[s + 1] : width;
+            memmove(row + elem * write, row + elem * from, elem * (size_t)(to - from));
+            STATS_ADD(bytes_copied, elem * (size_t)(to - from));
+            write += to - from;
+        }
+    }
+}
+
+// ----------------------------------------
+// Function: seam_batch_remove
+// ----------------------------------------
+void seam_batch_remove(struct seam_batch *batch, struct rgb_img *im, const int *paths, int count) {
+    if (count <= 0) return;
+    STATS_START(timer);
+    remove_columns(im->raster, 3 * im->stride, 3, im->height, im->width, paths, count, batch->cols);
+    im->width -= count;
+    STATS_STOP(timer, STAGE_REMOVE, (size_t)count * im->height);
+}
+
+// ----------------------------------------
+// Function: seam_batch_remove_planar
+// ----------------------------------------
+void seam_batch_remove_planar(struct seam_batch *batch, struct planar_img *pl, const int *paths, int count) {
+    if (count <= 0) return;
+    STATS_START(timer);
+    for (int c = 0; c < 3; c++) {
+        remove_columns(pl->plane[c], pl->stride, 1, pl->height, pl->width, paths, count, batch->cols);
+    }
+    pl->width -= count;
+    STATS_STOP(timer, STAGE_REMOVE, (size_t)count * pl->height);
+}
@@ -0,0 +1,120 @@
+/*
+Multi-Seam Batch Header File
+Author: Tannaz Chowdhury
+GitHub: TannazC
+Date: 2025
+
+Declares the batch mode used to take k seams out of an image per DP pass
+instead of one. The seams are chosen greedily from a single cost map so
+that no two of them share a pixel, and are then removed from the raster
+in a single compaction pass.
+*/
+
+#ifndef SEAM_BATCH_H            // Include guard - prevents multiple includes
+#define SEAM_BATCH_H
+
+#include <stdint.h>
+#include "c_img.h"              // Required for struct rgb_img definitions
+#include "seam_dp.h"            // DP tables the seams are extracted from
+#include "planar_img.h"         // Planar images for seam_batch_remove_planar
+
+// ----------------------------------------
+// Struct: seam_batch
+// ----------------------------------------
+/*
+   Working memory for batch extraction, sized once for the starting
+   dimensions and the largest batch.
+
+   Fields:
+     max_seams  - largest k the buffers can hold
+     candidates - bottom-row (cost, column) keys, sorted cheapest first
+     taken      - one bit per pixel: already part of a chosen seam
+     taken_pitch- bytes per row of taken
+     cols       - scratch for one row's removed columns
+*/
+struct seam_batch {
+    int max_seams;
+    uint64_t *candidates;
+    uint8_t *taken;
+    size_t taken_pitch;
+    int *cols;
+};
+
+// ----------------------------------------
+// Function: seam_batch_init / seam_batch_free
+// ----------------------------------------
+void seam_batch_init(struct seam_batch *batch, size_t height, size_t width, int max_seams);
+void seam_batch_free(struct seam_batch *batch);
+
+// ----------------------------------------
+// Function: seam_batch_bytes / seam_batch_init_arena
+// ----------------------------------------
+/*
+   seam_batch_init with the buffers taken from an arena (no
+   seam_batch_free), and the arena space that takes.
+*/
+size_t seam_batch_bytes(size_t height, size_t width, int max_seams);
+void seam_batch_init_arena(struct seam_batch *batch, size_t height, size_t width, int max_seams,
+                           struct seam_arena *arena);
+
+// ----------------------------------------
+// Function: seam_batch_find
+// ----------------------------------------
+/*
+   Extracts up to k pixel-disjoint vertical seams from one DP pass.
+   Bottom-row pixels are tried from cheapest to most expensive (leftmost
+   first on ties, so the first seam is the one seam_dp_trace would pick).
+   Each is traced upward along its DP parents; where the parent is already
+   used by an earlier seam, the free parent with the lowest energy is taken
+   instead. A candidate that gets boxed in is dropped.
+
+   Parameters:
+     batch  - working memory
+     dp     - DP tables filled for grad (seam_dp_fill)
+     last   - bottom row of costs returned by the fill
+     grad   - energy map the DP was run on
+     k      - seams wanted (at most batch->max_seams)
+     paths  - output: seam s is paths[s * height .. s * height + height - 1]
+     energy - output (may be NULL): total energy of the chosen pixels
+
+   Returns the number of seams found (between 1 and k for a non-empty map).
+*/
+int seam_batch_find(struct seam_batch *batch, struct seam_dp *dp, const uint32_t *last,
+                    struct energy_map *grad, int k, int *paths, uint64_t *energy);
+
+// ----------------------------------------
+// Function: seam_batch_remove
+// ----------------------------------------
+/*
+   Removes `count` pixel-disjoint seams from an image in place with one
+   pass over each row (one memmove per surviving run of pixels). The width
+   shrinks by count and the stride is unchanged.
+*/
+void seam_batch_remove(struct seam_batch *batch, struct rgb_img *im, const int *paths, int count);
+
+// ----------------------------------------
+// Function: seam_batch_remove_planar
+// ----------------------------------------
+/*
+   seam_batch_remove on a planar image: the same compaction on each plane.
+*/
+void seam_batch_remove_planar(struct seam_batch *batch, struct planar_img *pl, const int *paths, int count);
+
+// ----------------------------------------
+// Function: remove_columns
+// ----------------------------------------
+/*
+   The compaction behind seam_batch_remove, for any per-pixel plane.
+
+   Parameters:
+     base   - first row of the plane
+     pitch  - bytes between rows
+     elem   - bytes per element (3 for RGB, 2 for uint16_t, ...)
+     height, width - rows and current elements per row
+     paths  - count disjoint seams, height entries each
+     cols   - scratch for count ints
+*/
+void remove_columns(uint8_t *base, size_t pitch, size_t elem, int height, int width,
+                    const int *paths, int count, int *cols);
+
+#endif  // End of include guard for SEAM_BATCH_H
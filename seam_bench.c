@@ -0,0 +1,631 @@
+/*
+Seam Carving Benchmark
+Author: Tannaz Chowdhury
+GitHub: TannazC
+Date: 2025
+
+Times each stage of the original pipeline (calc_energy, dynamic_seam,
+recover_path, remove_seam), the whole pipeline (allocating per seam, and
+on arena buffers sized once), and the carving context that replaces it
+(interleaved, planar, with the pyramid search and with the L1 and forward
+energies; the compact DP also with a protect / remove mask), over image sizes from the 3x4 and 6x5 samples up to a
+generated 8K image. Every stage is repeated and reported as the minimum,
+median and 90th percentile time plus the median throughput. The carving
+context is also timed on 1 to N threads (--threads, default 4), followed
+by a line with each count's speedup over one thread (median against
+median).
+
+Before anything is timed, both the original pipeline and the carving
+context are run on a fixed set of inputs and their seams and output
+images are checked against golden hashes recorded from the original
+implementation. A benchmark of code that computes a different result is
+not reported; the program exits with status 1 instead.
+
+Usage: seam_bench [--reps N] [--seams N] [--sizes a,b,...] [--threads N]
+                  [--verify-only] [--print-golden]
+Sizes: 3x4, 6x5, ocean (HJoceanSmall.bin), 720p, 1080p, 4k, 8k. Sample
+files are looked up in the current directory.
+*/
+
+#define _POSIX_C_SOURCE 200809L  // For clock_gettime
+
+#include <stdio.h>            // Required for printf
+#include <stdlib.h>           // Required for malloc, free, qsort, atoi
+#include <string.h>           // Required for memcpy, strcmp, strstr
+#include <time.h>             // Required for clock_gettime
+#include "c_img.h"            // Image structs and .bin loading
+#include "seamcarving.h"      // Carving library under test
+#include "energy_simd.h"      // Name of the energy kernel in use
+#include "seam_arena.h"       // Buffers for the allocation-free pipeline
+#include "planar_img.h"       // Planar layout timings
+#include "seam_insert.h"      // Enlargement timing
+
+#define BENCH_MAX_REPS 1000   // Upper bound for --reps
+#define BENCH_MAX_THREADS 64  // Upper bound for --threads
+
+// ----------------------------------------
+// Struct: bench_size
+// ----------------------------------------
+/*
+   One benchmark input: a sample file, or a generated image of the given
+   dimensions when file is NULL.
+*/
+struct bench_size {
+    const char *name;
+    const char *file;
+    size_t height;
+    size_t width;
+};
+
+static const struct bench_size bench_sizes[] = {
+    {"3x4", "3x4 (1).bin", 0, 0},
+    {"6x5", "6x5 (1).bin", 0, 0},
+    {"ocean", "HJoceanSmall.bin", 0, 0},
+    {"720p", NULL, 720, 1280},
+    {"1080p", NULL, 1080, 1920},
+    {"4k", NULL, 2160, 3840},
+    {"8k", NULL, 4320, 7680},
+};
+#define BENCH_SIZES (int)(sizeof(bench_sizes) / sizeof(bench_sizes[0]))
+
+// ----------------------------------------
+// Struct: golden
+// ----------------------------------------
+/*
+   Expected results of carving `seams` seams from an input: FNV-1a hashes
+   of all seam paths (each column as 2 big-endian bytes, seam after seam)
+   and of the final image (header and packed raster, as write_img stores
+   it). Recorded from the original dynamic_seam / recover_path /
+   remove_seam pipeline.
+*/
+struct golden {
+    const char *name;           // bench_size name
+    int seams;
+    uint64_t paths;
+    uint64_t image;
+};
+
+static const struct golden goldens[] = {
+    {"3x4", 2, 0x88201fb960ff6465ULL, 0x67b712644795ceb8ULL},
+    {"6x5", 5, 0x867c14c0d51f5331ULL, 0x57e5a0e960c94448ULL},
+    {"ocean", 50, 0xa5f660a0911cc95eULL, 0xfbd4281ee7147e2eULL},
+    {"gen96x128", 40, 0xee47408b6d45418eULL, 0x493ec8d10ab05efaULL},
+};
+#define GOLDENS (int)(sizeof(goldens) / sizeof(goldens[0]))
+
+// ----------------------------------------
+// Helper: generate_img
+// ----------------------------------------
+/*
+   Deterministic test image: smooth colour gradients with a few bright
+   blobs and xorshift noise, so the energy map has both flat areas and
+   edges. The same dimensions always give the same pixels.
+*/
+static struct rgb_img *generate_img(size_t height, size_t width) {
+    struct rgb_img *im;
+    uint32_t state = 2463534242u;  // xorshift32 seed
+
+    create_img(&im, height, width);
+    for (size_t y = 0; y < height; y++) {
+        for (size_t x = 0; x < width; x++) {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            int noise = (int)(state & 15);
+            int r = (int)(255 * x / width);
+            int g = (int)(255 * y / height);
+            int b = ((x / 64 + y / 64) & 1) ? 200 : 40;   // Checkerboard edges
+            size_t cx = x % 256, cy = y % 256;
+            if ((cx - 128) * (cx - 128) + (cy - 128) * (cy - 128) < 40 * 40) r = g = 250;  // Blobs
+            set_pixel(im, y, x, (r + noise) & 255, (g + noise) & 255, (b + noise) & 255);
+        }
+    }
+    return im;
+}
+
+// Loads or generates a benchmark input; NULL if its sample file is missing
+static struct rgb_img *load_size(const struct bench_size *size) {
+    struct rgb_img *im;
+    if (size->file == NULL) return generate_img(size->height, size->width);
+    return (read_in_img(&im, (char *)size->file) == 0) ? im : NULL;
+}
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+// ----------------------------------------
+// Helper: FNV-1a hashing
+// ----------------------------------------
+static uint64_t fnv_bytes(uint64_t hash, const uint8_t *bytes, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+static uint64_t fnv_path(uint64_t hash, const int *path, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        uint8_t bytes[2] = {(uint8_t)(path[i] >> 8), (uint8_t)(path[i] & 0xFF)};
+        hash = fnv_bytes(hash, bytes, 2);
+    }
+    return hash;
+}
+
+static uint64_t fnv_image(struct rgb_img *im) {
+    uint8_t header[4] = {(uint8_t)(im->height >> 8), (uint8_t)im->height,
+                         (uint8_t)(im->width >> 8), (uint8_t)im->width};
+    uint64_t hash = fnv_bytes(0xcbf29ce484222325ULL, header, 4);
+    for (size_t y = 0; y < im->height; y++) {
+        hash = fnv_bytes(hash, im->raster + 3 * y * im->stride, 3 * im->width);
+    }
+    return hash;
+}
+
+// ----------------------------------------
+// Helper: arena_pipeline
+// ----------------------------------------
+/*
+   The original pipeline on caller-provided buffers: one arena holds the
+   energy map, the H x W cost table, the path and two images that are
+   used in turn as source and destination. Removes `seams` seams from a
+   copy of im without any further allocation; returns the hash of the
+   result and adds the seams to *paths.
+*/
+static uint64_t arena_pipeline(struct rgb_img *im, int seams, uint64_t *paths) {
+    size_t height = im->height, width = im->width;
+    struct seam_arena arena;
+    struct energy_map grad;
+    struct rgb_img images[2];
+
+    arena_init(&arena, arena_size(height * width) + 2 * arena_size(3 * height * width) +
+                           arena_size(sizeof(double) * height * width) + arena_size(sizeof(int) * height));
+    init_energy_map(&grad, (uint8_t *)arena_alloc(&arena, height * width), height, width);
+    init_img(&images[0], (uint8_t *)arena_alloc(&arena, 3 * height * width), height, width);
+    init_img(&images[1], (uint8_t *)arena_alloc(&arena, 3 * height * width), height, width);
+    double *best = (double *)arena_alloc(&arena, sizeof(double) * height * width);
+    int *path = (int *)arena_alloc(&arena, sizeof(int) * height);
+
+    for (size_t y = 0; y < height; y++) {
+        memcpy(images[0].raster + 3 * y * width, im->raster + 3 * y * im->stride, 3 * width);
+    }
+    int cur = 0;
+    for (int i = 0; i < seams; i++) {
+        refill_energy(&images[cur], &grad, NULL);
+        dynamic_seam_into(&grad, best);
+        recover_path_into(best, height, images[cur].width, path);
+        remove_seam_into(&images[cur], &images[1 - cur], path);
+        *paths = fnv_path(*paths, path, height);
+        cur = 1 - cur;
+    }
+
+    uint64_t image = fnv_image(&images[cur]);
+    arena_free(&arena);
+    return image;
+}
+
+// ----------------------------------------
+// Function: verify_golden
+// ----------------------------------------
+/*
+   Carves every golden input with the original pipeline (allocating and on
+   arena buffers) and with the carving context (interleaved and planar),
+   and compares them against
+   the recorded hashes (or prints them, with print set). Returns the
+   number of mismatches.
+*/
+static struct rgb_img *golden_input(const char *name) {
+    if (strcmp(name, "gen96x128") == 0) return generate_img(96, 128);
+    for (int s = 0; s < BENCH_SIZES; s++) {
+        if (strcmp(bench_sizes[s].name, name) == 0) return load_size(&bench_sizes[s]);
+    }
+    return NULL;
+}
+
+static int verify_golden(int print) {
+    int failures = 0;
+
+    for (int g = 0; g < GOLDENS; g++) {
+        const struct golden *gold = &goldens[g];
+        struct rgb_img *im = golden_input(gold->name);
+        if (im == NULL) {
+            printf("golden %-10s missing input, skipped\n", gold->name);
+            continue;
+        }
+
+        // Original pipeline: fresh energy map, full DP table, new image per seam
+        struct rgb_img *cur = copy_img(im);
+        uint64_t paths = 0xcbf29ce484222325ULL;
+        for (int i = 0; i < gold->seams; i++) {
+            struct energy_map *grad;
+            struct rgb_img *next;
+            double *best;
+            int *path;
+            calc_energy(cur, &grad);
+            dynamic_seam(grad, &best);
+            recover_path(best, grad->height, grad->width, &path);
+            remove_seam(cur, &next, path);
+            paths = fnv_path(paths, path, cur->height);
+            destroy_energy_map(grad);
+            destroy_image(cur);
+            free(best);
+            free(path);
+            cur = next;
+        }
+        uint64_t image = fnv_image(cur);
+        destroy_image(cur);
+
+        // Same pipeline on buffers sized once
+        uint64_t arena_paths = 0xcbf29ce484222325ULL;
+        uint64_t arena_image = arena_pipeline(im, gold->seams, &arena_paths);
+
+        // Carving context: compact DP, in-place removal, incremental energy
+        struct carve_ctx ctx;
+        uint64_t ctx_paths = 0xcbf29ce484222325ULL;
+        carve_init(&ctx, copy_img(im));
+        for (int i = 0; i < gold->seams && carve_seam(&ctx) == 0; i++) {
+            ctx_paths = fnv_path(ctx_paths, ctx.path, ctx.im->height);
+        }
+        uint64_t ctx_image = fnv_image(ctx.im);
+        carve_free(&ctx);
+
+        // Same context carving a planar copy
+        struct carve_opts opts;
+        uint64_t planar_paths = 0xcbf29ce484222325ULL;
+        carve_opts_default(&opts);
+        opts.planar = 1;
+        carve_init_opts(&ctx, copy_img(im), &opts);
+        for (int i = 0; i < gold->seams && carve_seam(&ctx) == 0; i++) {
+            planar_paths = fnv_path(planar_paths, ctx.path, ctx.im->height);
+        }
+        uint64_t planar_image = fnv_image(carve_image(&ctx));
+        carve_free(&ctx);
+        destroy_image(im);
+
+        if (print) {
+            printf("    {\"%s\", %d, 0x%016llxULL, 0x%016llxULL},\n", gold->name, gold->seams,
+                   (unsigned long long)paths, (unsigned long long)image);
+            continue;
+        }
+        int bad_orig = (paths != gold->paths || image != gold->image);
+        int bad_arena = (arena_paths != gold->paths || arena_image != gold->image);
+        int bad_ctx = (ctx_paths != gold->paths || ctx_image != gold->image);
+        int bad_planar = (planar_paths != gold->paths || planar_image != gold->image);
+        printf("golden %-10s %3d seams: pipeline %s, arena pipeline %s, carve context %s, planar %s\n",
+               gold->name, gold->seams, bad_orig ? "FAIL" : "ok", bad_arena ? "FAIL" : "ok",
+               bad_ctx ? "FAIL" : "ok", bad_planar ? "FAIL" : "ok");
+        failures += bad_orig + bad_arena + bad_ctx + bad_planar;
+    }
+    return failures;
+}
+
+// ----------------------------------------
+// Helper: timing statistics
+// ----------------------------------------
+static int compare_doubles(const void *a, const void *b) {
+    double da = *(const double *)a, db = *(const double *)b;
+    return (da > db) - (da < db);
+}
+
+// Prints min / median / p90 of reps samples and the median throughput
+static void report(const char *size, const char *stage, double *ms, int reps, double pixels) {
+    qsort(ms, reps, sizeof(double), compare_doubles);
+    double median = ms[reps / 2];
+    double p90 = ms[(reps * 9 + 9) / 10 - 1];  // Nearest rank
+    printf("%-6s %-14s %10.3f %10.3f %10.3f %10.1f\n", size, stage, ms[0], median, p90,
+           median > 0 ? pixels / (median * 1e3) : 0.0);
+}
+
+// ----------------------------------------
+// Function: run_size
+// ----------------------------------------
+/*
+   Times the four stages on the full image (inputs for each stage are
+   prepared outside the timed region), then `seams` seams through the
+   original pipeline and through the carving context, per seam, and the
+   context on 1 .. threads threads.
+*/
+static void run_size(const struct bench_size *size, int reps, int seams, int threads) {
+    double ms[BENCH_MAX_REPS];
+    struct rgb_img *im = load_size(size);
+    if (im == NULL) {
+        printf("%-6s missing %s, skipped\n", size->name, size->file);
+        return;
+    }
+    double pixels = (double)im->height * im->width;
+    if (seams > (int)im->width - 1) seams = im->width - 1;
+
+    struct energy_map *grad;
+    double *best;
+    int *path;
+
+    for (int r = 0; r < reps; r++) {
+        double start = now_ms();
+        calc_energy(im, &grad);
+        ms[r] = now_ms() - start;
+        if (r + 1 < reps) destroy_energy_map(grad);
+    }
+    report(size->name, "calc_energy", ms, reps, pixels);
+
+    grad->energy = ENERGY_L1;  // The same pass with the L1 kernels
+    for (int r = 0; r < reps; r++) {
+        double start = now_ms();
+        refill_energy(im, grad, NULL);
+        ms[r] = now_ms() - start;
+    }
+    report(size->name, "energy/l1", ms, reps, pixels);
+    grad->energy = ENERGY_DUAL;
+    refill_energy(im, grad, NULL);
+
+    struct planar_img *pl;  // Same pass over the planar layout (conversion not timed)
+    create_planar(&pl, im->height, im->width);
+    planar_from_rgb(im, pl);
+    for (int r = 0; r < reps; r++) {
+        double start = now_ms();
+        refill_energy_planar(pl, grad, NULL);
+        ms[r] = now_ms() - start;
+    }
+    report(size->name, "energy/planar", ms, reps, pixels);
+
+    for (int r = 0; r < reps; r++) {
+        double start = now_ms();
+        planar_from_rgb(im, pl);
+        ms[r] = now_ms() - start;
+    }
+    report(size->name, "to_planar", ms, reps, pixels);
+
+    for (int r = 0; r < reps; r++) {
+        double start = now_ms();
+        dynamic_seam(grad, &best);
+        ms[r] = now_ms() - start;
+        if (r + 1 < reps) free(best);
+    }
+    report(size->name, "dynamic_seam", ms, reps, pixels);
+
+    for (int r = 0; r < reps; r++) {
+        double start = now_ms();
+        recover_path(best, grad->height, grad->width, &path);
+        ms[r] = now_ms() - start;
+        if (r + 1 < reps) free(path);
+    }
+    report(size->name, "recover_path", ms, reps, im->height);
+
+    struct seam_dp dp;  // Compact DP on the map, and forward energy straight from the pixels
+    struct seam_pixels px;
+    seam_dp_init(&dp, im->height, im->width);
+    for (int r = 0; r < reps; r++) {
+        double start = now_ms();
+        seam_dp_find(&dp, grad, path);
+        ms[r] = now_ms() - start;
+    }
+    report(size->name, "dp/compact", ms, reps, pixels);
+
+    seam_pixels_rgb(&px, im);
+    for (int r = 0; r < reps; r++) {
+        double start = now_ms();
+        seam_dp_find_forward(&dp, &px, path);
+        ms[r] = now_ms() - start;
+    }
+    report(size->name, "dp/forward", ms, reps, pixels);
+
+    struct seam_mask *mask;                   // A protected band and an object to remove
+    create_mask(&mask, im->height, im->width);
+    for (size_t y = im->height / 4; y < im->height / 2; y++) {
+        for (size_t x = im->width / 8; x < im->width / 4; x++) set_mask(mask, (int)y, (int)x, MASK_PROTECT);
+        for (size_t x = im->width / 2; x < im->width / 2 + im->width / 16; x++) {
+            set_mask(mask, (int)y, (int)x, MASK_REMOVE);
+        }
+    }
+    dp.mask = mask;
+    for (int r = 0; r < reps; r++) {
+        double start = now_ms();
+        seam_dp_find(&dp, grad, path);
+        ms[r] = now_ms() - start;
+    }
+    report(size->name, "dp/mask", ms, reps, pixels);
+    dp.mask = NULL;
+    destroy_mask(mask);
+    seam_dp_free(&dp);
+
+    if (im->width > 1) {
+        for (int r = 0; r < reps; r++) {
+            struct rgb_img *out;
+            double start = now_ms();
+            remove_seam(im, &out, path);
+            ms[r] = now_ms() - start;
+            destroy_image(out);
+        }
+        report(size->name, "remove_seam", ms, reps, pixels);
+
+        for (int r = 0; r < reps; r++) {  // In place on the planes; the width is put back each time
+            double start = now_ms();
+            remove_seam_planar(pl, path);
+            ms[r] = now_ms() - start;
+            pl->width = im->width;
+        }
+        report(size->name, "remove/planar", ms, reps, pixels);
+    }
+    destroy_planar(pl);
+
+    for (int r = 0; r < reps; r++) {  // Widen by 30% in one selection and one copy
+        struct rgb_img *wide;
+        double start = now_ms();
+        seam_insert(im, (int)(im->width * 3 / 10), NULL, &wide);
+        ms[r] = now_ms() - start;
+        destroy_image(wide);
+    }
+    report(size->name, "insert/30%", ms, reps, pixels);
+    destroy_energy_map(grad);
+    free(best);
+    free(path);
+
+    if (seams > 0) {
+        for (int r = 0; r < reps; r++) {  // Original pipeline, per seam
+            struct rgb_img *cur = copy_img(im);
+            double start = now_ms();
+            for (int i = 0; i < seams; i++) {
+                struct rgb_img *next;
+                calc_energy(cur, &grad);
+                dynamic_seam(grad, &best);
+                recover_path(best, grad->height, grad->width, &path);
+                remove_seam(cur, &next, path);
+                destroy_energy_map(grad);
+                destroy_image(cur);
+                free(best);
+                free(path);
+                cur = next;
+            }
+            ms[r] = (now_ms() - start) / seams;
+            destroy_image(cur);
+        }
+        report(size->name, "pipeline/seam", ms, reps, pixels);
+
+        for (int r = 0; r < reps; r++) {  // Original pipeline on arena buffers (setup included)
+            uint64_t paths = 0;
+            double start = now_ms();
+            arena_pipeline(im, seams, &paths);
+            ms[r] = (now_ms() - start) / seams;
+        }
+        report(size->name, "arena/seam", ms, reps, pixels);
+
+        for (int r = 0; r < reps; r++) {  // Carving context, per seam (setup included)
+            struct carve_ctx ctx;
+            struct rgb_img *cur = copy_img(im);
+            double start = now_ms();
+            carve_init(&ctx, cur);
+            for (int i = 0; i < seams; i++) carve_seam(&ctx);
+            ms[r] = (now_ms() - start) / seams;
+            carve_free(&ctx);
+        }
+        report(size->name, "carve/seam", ms, reps, pixels);
+
+        for (int r = 0; r < reps; r++) {  // Planar context, conversions included
+            struct carve_ctx ctx;
+            struct carve_opts opts;
+            carve_opts_default(&opts);
+            opts.planar = 1;
+            struct rgb_img *cur = copy_img(im);
+            double start = now_ms();
+            carve_init_opts(&ctx, cur, &opts);
+            for (int i = 0; i < seams; i++) carve_seam(&ctx);
+            carve_image(&ctx);
+            ms[r] = (now_ms() - start) / seams;
+            carve_free(&ctx);
+        }
+        report(size->name, "carve/planar", ms, reps, pixels);
+
+        for (int r = 0; r < reps; r++) {  // Pyramid search, band 8 (not exact, so not in the goldens)
+            struct carve_ctx ctx;
+            struct carve_opts opts;
+            carve_opts_default(&opts);
+            opts.pyramid = 8;
+            struct rgb_img *cur = copy_img(im);
+            double start = now_ms();
+            carve_init_opts(&ctx, cur, &opts);
+            for (int i = 0; i < seams; i++) carve_seam(&ctx);
+            ms[r] = (now_ms() - start) / seams;
+            carve_free(&ctx);
+        }
+        report(size->name, "carve/pyramid", ms, reps, pixels);
+
+        for (int kind = ENERGY_L1; kind <= ENERGY_FORWARD; kind++) {  // Other energies (not in the goldens)
+            for (int r = 0; r < reps; r++) {
+                struct carve_ctx ctx;
+                struct carve_opts opts;
+                carve_opts_default(&opts);
+                opts.energy = kind;
+                struct rgb_img *cur = copy_img(im);
+                double start = now_ms();
+                carve_init_opts(&ctx, cur, &opts);
+                for (int i = 0; i < seams; i++) carve_seam(&ctx);
+                ms[r] = (now_ms() - start) / seams;
+                carve_free(&ctx);
+            }
+            report(size->name, (kind == ENERGY_L1) ? "carve/l1" : "carve/forward", ms, reps, pixels);
+        }
+
+        double median[BENCH_MAX_THREADS + 1];
+        for (int t = 1; t <= threads; t++) {  // Thread scaling (the pool is created in the timed region)
+            char stage[16];
+            for (int r = 0; r < reps; r++) {
+                struct carve_ctx ctx;
+                struct carve_opts opts;
+                carve_opts_default(&opts);
+                opts.threads = t;
+                struct rgb_img *cur = copy_img(im);
+                double start = now_ms();
+                carve_init_opts(&ctx, cur, &opts);
+                for (int i = 0; i < seams; i++) carve_seam(&ctx);
+                ms[r] = (now_ms() - start) / seams;
+                carve_free(&ctx);
+            }
+            snprintf(stage, sizeof(stage), "carve/%dt", t);
+            report(size->name, stage, ms, reps, pixels);   // Sorts ms
+            median[t] = ms[reps / 2];
+        }
+        printf("%-6s %-14s", size->name, "speedup");
+        for (int t = 1; t <= threads; t++) {
+            printf(" %dt %.2fx", t, median[t] > 0 ? median[1] / median[t] : 0.0);
+        }
+        printf("\n");
+    }
+
+    destroy_image(im);
+}
+
+// ----------------------------------------
+// Main Function: Benchmark Driver
+// ----------------------------------------
+int main(int argc, char **argv) {
+    int reps = 7;               // Samples per stage
+    int seams = 5;              // Seams per pipeline sample
+    const char *only = NULL;    // Comma-separated size names (NULL = all)
+    int verify_only = 0;
+    int threads = 4;            // Largest thread count of the scaling runs
+
+    for (int arg = 1; arg < argc; arg++) {
+        if (strcmp(argv[arg], "--reps") == 0 && arg + 1 < argc) {
+            reps = atoi(argv[++arg]);
+        } else if (strcmp(argv[arg], "--seams") == 0 && arg + 1 < argc) {
+            seams = atoi(argv[++arg]);
+        } else if (strcmp(argv[arg], "--sizes") == 0 && arg + 1 < argc) {
+            only = argv[++arg];
+        } else if (strcmp(argv[arg], "--threads") == 0 && arg + 1 < argc) {
+            threads = atoi(argv[++arg]);
+        } else if (strcmp(argv[arg], "--verify-only") == 0) {
+            verify_only = 1;
+        } else if (strcmp(argv[arg], "--print-golden") == 0) {
+            verify_golden(1);
+            return 0;
+        } else {
+            fprintf(stderr, "unknown option %s\n", argv[arg]);
+            return 1;
+        }
+    }
+    if (reps < 1) reps = 1;
+    if (reps > BENCH_MAX_REPS) reps = BENCH_MAX_REPS;
+    if (threads < 1) threads = 1;
+    if (threads > BENCH_MAX_THREADS) threads = BENCH_MAX_THREADS;
+
+    int failures = verify_golden(0);
+    if (failures) {
+        printf("FAIL: %d golden mismatches, not benchmarking\n", failures);
+        return 1;
+    }
+    if (verify_only) return 0;
+
+    printf("\nenergy kernel %s, %d reps, %d seams per pipeline sample\n", energy_kernel_name(), reps, seams);
+    printf("%-6s %-14s %10s %10s %10s %10s\n", "size", "stage", "min ms", "median ms", "p90 ms", "Mpix/s");
+    for (int s = 0; s < BENCH_SIZES; s++) {
+        if (only != NULL) {  // Match a whole comma-separated name
+            const char *hit = strstr(only, bench_sizes[s].name);
+            size_t len = strlen(bench_sizes[s].name);
+            if (hit == NULL || (hit != only && hit[-1] != ',') || (hit[len] != '\0' && hit[len] != ',')) continue;
+        }
+        run_size(&bench_sizes[s], reps, seams, threads);
+    }
+    return 0;
+}
@@ -0,0 +1,832 @@
+/*
+Compact Seam DP Implementation
+Author: Tannaz Chowdhury
+GitHub: TannazC
+Date: 2025
+
+A drop-in alternative to dynamic_seam + recover_path that needs about a
+quarter of a byte per pixel instead of eight:
+- cumulative costs are uint32_t and only the previous and current rows
+  are kept,
+- each pixel's choice of parent is stored as a 2-bit code, four per byte,
+- the seam is recovered by following the codes from the bottom row up.
+
+seam_dp_find_parallel splits the same DP across a thread pool. Each block
+of rows is done in two phases separated by barriers: every thread first
+fills a trapezoid of its column strip that shrinks by one column per row
+on each side (those cells only depend on the strip itself), then the
+triangles left between neighbouring strips are filled. That needs two
+barriers per block instead of one per row, and computes exactly the same
+cells with exactly the same comparisons as the serial version.
+
+With a mask, each cell's cost gains the weight of its mask code, looked
+up from the packed mask row in the same loop. The serial fills are
+compiled with and without a mask, so carving without one pays nothing.
+
+The forward-energy fills are the same loops with the cost of each of the
+three moves computed from the pixel rows instead of read from an energy
+map. Their per-cell code is written once, always inlined, and compiled
+for interleaved and for planar pixels with the pixel step as a constant.
+*/
+
+#include <stdlib.h>           // Required for malloc, free
+#include "seam_dp.h"          // Header for the compact DP declarations
+#include "thread_pool.h"      // Thread pool for seam_dp_find_parallel
+#include "carve_stats.h"      // Stage timers and counters
+#include "seam_arena.h"       // Arena-backed working memory
+#include "planar_img.h"       // Planar pixels for the forward-energy DP
+
+#ifdef __GNUC__
+#define DP_INLINE static inline __attribute__((always_inline))  // Specialised in every caller
+#else
+#define DP_INLINE static inline
+#endif
+
+#define DP_MAX_BLOCK 64       // Rows per parallel block (bounds the cost ring)
+#define DP_MIN_STRIP 32       // Narrowest column strip worth a thread
+#define DP_TILE_COLS 64       // Columns gathered per tile by the horizontal DP
+#define DP_BLOCKED 0x80000000u  // Least cost of a pinned seam through a ruled-out pixel
+
+// ----------------------------------------
+// Helper: dp_layout
+// ----------------------------------------
+/*
+   Sets the capacity and pitches for images up to height x width and
+   returns the size of the parent-code table. Lines and the code table are
+   sized so that they fit both a vertical DP (rows of width) and a
+   horizontal DP (columns of height).
+*/
+static size_t dp_layout(struct seam_dp *dp, size_t height, size_t width) {
+    dp->max_height = height;
+    dp->max_width = width;
+    dp->cost_pitch = (width > height) ? width : height;            // Longest line either way
+    dp->back_pitch = (width + 3) / 4;                              // Four 2-bit codes per byte
+    dp->back_h_pitch = (height + 3) / 4;
+    size_t rows_bytes = dp->back_pitch * height;
+    size_t cols_bytes = dp->back_h_pitch * width;
+    return (rows_bytes > cols_bytes) ? rows_bytes : cols_bytes;
+}
+
+// ----------------------------------------
+// Function: seam_dp_init
+// ----------------------------------------
+/*
+   Allocates the two cost lines, the packed parent-code table and the
+   horizontal DP's tile.
+*/
+void seam_dp_init(struct seam_dp *dp, size_t height, size_t width) {
+    size_t back_bytes = dp_layout(dp, height, width);
+    dp->cost_rows = 2;                                             // Previous and current line
+    dp->cost = (uint32_t *)malloc(sizeof(uint32_t) * 2 * dp->cost_pitch);
+    dp->back = (uint8_t *)malloc(back_bytes);
+    dp->tile = (uint8_t *)malloc(DP_TILE_COLS * height);
+    dp->mask = NULL;
+    dp->pin = -1;
+    STATS_ADD(bytes_allocated, sizeof(uint32_t) * 2 * dp->cost_pitch + DP_TILE_COLS * height + back_bytes);
+}
+
+// ----------------------------------------
+// Function: seam_dp_bytes / seam_dp_init_arena
+// ----------------------------------------
+/*
+   seam_dp_init with the buffers (and a cost ring of `rows` lines) taken
+   from an arena; seam_dp_bytes is the arena space that needs.
+*/
+size_t seam_dp_bytes(size_t height, size_t width, int rows) {
+    struct seam_dp dp;
+    size_t back_bytes = dp_layout(&dp, height, width);
+    return arena_size(sizeof(uint32_t) * rows * dp.cost_pitch) + arena_size(back_bytes) +
+           arena_size(DP_TILE_COLS * height);
+}
+
+void seam_dp_init_arena(struct seam_dp *dp, size_t height, size_t width, int rows, struct seam_arena *arena) {
+    size_t back_bytes = dp_layout(dp, height, width);
+    dp->cost_rows = rows;
+    dp->cost = (uint32_t *)arena_alloc(arena, sizeof(uint32_t) * rows * dp->cost_pitch);
+    dp->back = (uint8_t *)arena_alloc(arena, back_bytes);
+    dp->tile = (uint8_t *)arena_alloc(arena, DP_TILE_COLS * height);
+    dp->mask = NULL;
+    dp->pin = -1;
+}
+
+// ----------------------------------------
+// Function: seam_dp_reserve_rows
+// ----------------------------------------
+/*
+   Grows the cost ring to hold at least `rows` rows.
+*/
+void seam_dp_reserve_rows(struct seam_dp *dp, int rows) {
+    if (rows <= dp->cost_rows) return;
+    free(dp->cost);
+    dp->cost = (uint32_t *)malloc(sizeof(uint32_t) * rows * dp->cost_pitch);
+    dp->cost_rows = rows;
+    STATS_ADD(bytes_allocated, sizeof(uint32_t) * rows * dp->cost_pitch);
+}
+
+// ----------------------------------------
+// Function: seam_dp_free
+// ----------------------------------------
+/*
+   Frees the DP working memory.
+*/
+void seam_dp_free(struct seam_dp *dp) {
+    free(dp->cost);
+    free(dp->back);
+    free(dp->tile);
+}
+
+// ----------------------------------------
+// Helper: Pick Parent
+// ----------------------------------------
+/*
+   Chooses the cheapest of the (up to) three parents of column x in the
+   previous row. The order of the comparisons matches find_best_neighbor
+   in seamcarving.c: directly above wins ties, then up-left, then up-right.
+*/
+static inline uint32_t pick_parent(const uint32_t *prev, int x, int width, int *code) {
+    uint32_t best = prev[x];
+    *code = SEAM_UP;
+    if (x > 0 && prev[x - 1] < best) {
+        best = prev[x - 1];
+        *code = SEAM_UP_LEFT;
+    }
+    if (x < width - 1 && prev[x + 1] < best) {
+        best = prev[x + 1];
+        *code = SEAM_UP_RIGHT;
+    }
+    return best;
+}
+
+/*
+   pick_parent for 0 < x < width - 1, as selects: which parent wins is
+   hard to predict, and the compiler turns these into conditional moves.
+*/
+static inline uint32_t pick_inner(const uint32_t *prev, int x, int *code) {
+    uint32_t best = prev[x];
+    uint32_t left = prev[x - 1];
+    uint32_t right = prev[x + 1];
+    int pick = SEAM_UP;
+
+    pick = (left < best) ? SEAM_UP_LEFT : pick;
+    best = (left < best) ? left : best;
+    pick = (right < best) ? SEAM_UP_RIGHT : pick;
+    best = (right < best) ? right : best;
+    *code = pick;
+    return best;
+}
+
+// ----------------------------------------
+// Helper: Mask Weights
+// ----------------------------------------
+/*
+   fill_mask sets the weights for seams of `length` pixels and returns the
+   mask (NULL without one); mask_bias is the weight of pixel x of a packed
+   mask row. A pinned fill sizes the weights for seams twice as long, so
+   every seam costs less than DP_BLOCKED.
+*/
+static const struct seam_mask *fill_mask(struct seam_dp *dp, size_t length, uint32_t max_cost) {
+    if (dp->mask != NULL) mask_weights((dp->pin >= 0) ? 2 * length : length, max_cost, dp->mask_weight);
+    return dp->mask;
+}
+
+DP_INLINE uint32_t mask_bias(const uint64_t *codes, const uint32_t *weight, int x) {
+    return weight[(codes[x >> 5] >> (2 * (x & 31))) & 3];
+}
+
+// ----------------------------------------
+// Helper: pin_line
+// ----------------------------------------
+/*
+   Raises the cumulative cost of every ruled-out cell of a finished line
+   (row `line` of a vertical DP, column `line` of a horizontal one) to at
+   least DP_BLOCKED: protected pixels, and on the pinned line every pixel
+   not marked for removal. Costs never fall along a seam, so a seam
+   through a ruled-out cell ends at DP_BLOCKED or more, and one without
+   ends below it; raising (not adding) keeps either within 32 bits.
+*/
+static void pin_line(const struct seam_dp *dp, uint32_t *cost, int line, int count, int horizontal) {
+    for (int i = 0; i < count; i++) {
+        int code = horizontal ? get_mask(dp->mask, i, line) : get_mask(dp->mask, line, i);
+        int blocked = (code == MASK_PROTECT) || (line == dp->pin && code != MASK_REMOVE);
+        if (blocked && cost[i] < DP_BLOCKED) cost[i] = DP_BLOCKED;
+    }
+}
+
+// ----------------------------------------
+// Function: seam_dp_trace
+// ----------------------------------------
+/*
+   Picks the leftmost minimum of the bottom row's costs (like recover_path)
+   and follows the parent codes back up to the top row. Returns the cost of
+   the seam.
+*/
+uint32_t seam_dp_trace(struct seam_dp *dp, const uint32_t *last, int height, int width, int *path) {
+    STATS_START(timer);
+    int col = 0;
+    for (int x = 1; x < width; x++) {
+        if (last[x] < last[col]) col = x;
+    }
+    uint32_t total = last[col];
+
+    path[height - 1] = col;
+    for (int y = height - 1; y > 0; y--) {
+        col += seam_dp_parent(dp, y, col);
+        path[y - 1] = col;
+    }
+    STATS_STOP(timer, STAGE_TRACE, height);
+    return total;
+}
+
+// ----------------------------------------
+// Function: seam_dp_fill
+// ----------------------------------------
+/*
+   Runs the DP one row at a time, writing each row's parent codes into
+   the packed table. Returns the bottom row of cumulative costs.
+*/
+DP_INLINE const uint32_t *map_fill(struct seam_dp *dp, struct energy_map *grad, const struct seam_mask *mask) {
+    int height = grad->height;
+    int width = grad->width;
+    uint32_t *prev = dp->cost;                   // Costs of the row above
+    uint32_t *cur = dp->cost + dp->cost_pitch;   // Costs of the row being filled
+    const uint32_t *weight = dp->mask_weight;
+
+    // Top row: the cost is just the energy
+    const uint8_t *top = energy_row(grad, 0);
+    for (int x = 0; x < width; x++) {
+        prev[x] = top[x] + ((mask != NULL) ? mask_bias(mask_row(mask, 0), weight, x) : 0);
+    }
+    if (mask != NULL && dp->pin >= 0) pin_line(dp, prev, 0, width, 0);
+
+    for (int y = 1; y < height; y++) {
+        const uint8_t *energy = energy_row(grad, y);
+        const uint64_t *codes = (mask != NULL) ? mask_row(mask, y) : NULL;
+        uint8_t *back = dp->back + y * dp->back_pitch;
+        uint8_t packed = 0;  // Codes for the current group of four columns
+
+        for (int x = 0; x < width; x++) {
+            int code;
+            uint32_t cost = energy[x] + ((mask != NULL) ? mask_bias(codes, weight, x) : 0);
+            if (x > 0 && x < width - 1) cur[x] = pick_inner(prev, x, &code) + cost;
+            else cur[x] = pick_parent(prev, x, width, &code) + cost;
+
+            packed |= (uint8_t)(code << (2 * (x & 3)));
+            if ((x & 3) == 3 || x == width - 1) {   // Group full (or row done): store it
+                back[x >> 2] = packed;
+                packed = 0;
+            }
+        }
+        if (mask != NULL && dp->pin >= 0) pin_line(dp, cur, y, width, 0);
+
+        uint32_t *tmp = prev;  // The row just filled becomes the previous row
+        prev = cur;
+        cur = tmp;
+    }
+    return prev;
+}
+
+const uint32_t *seam_dp_fill(struct seam_dp *dp, struct energy_map *grad) {
+    STATS_START(timer);
+    const struct seam_mask *mask = fill_mask(dp, grad->height, MASK_MAX_ENERGY);
+    const uint32_t *last = (mask != NULL) ? map_fill(dp, grad, mask) : map_fill(dp, grad, NULL);
+    STATS_STOP(timer, STAGE_DP, grad->height * grad->width);
+    return last;
+}
+
+// ----------------------------------------
+// Function: seam_dp_find
+// ----------------------------------------
+/*
+   Fills the DP and backtracks from the cheapest bottom-row pixel.
+*/
+uint32_t seam_dp_find(struct seam_dp *dp, struct energy_map *grad, int *path) {
+    const uint32_t *last = seam_dp_fill(dp, grad);
+    return seam_dp_trace(dp, last, grad->height, grad->width, path);
+}
+
+// ----------------------------------------
+// Function: seam_dp_fill_h
+// ----------------------------------------
+/*
+   Horizontal DP: the same recurrence walking the columns left to right.
+   Reading one energy per row for every column would touch a new cache
+   line per pixel, so the energy of DP_TILE_COLS columns at a time is
+   first gathered into a small column-major tile (one contiguous pass over
+   each row's segment); the DP then reads the tile column by column. The
+   tile is DP_TILE_COLS * height bytes, small enough to stay in cache, and
+   nothing the size of the image is ever transposed.
+   Parent codes are stored per column: a "left" code means row y - 1.
+*/
+DP_INLINE const uint32_t *map_fill_h(struct seam_dp *dp, struct energy_map *grad, const struct seam_mask *mask) {
+    int height = grad->height;
+    int width = grad->width;
+    uint32_t *prev = dp->cost;                   // Costs of the column to the left
+    uint32_t *cur = dp->cost + dp->cost_pitch;   // Costs of the column being filled
+    const uint32_t *weight = dp->mask_weight;
+
+    for (int x0 = 0; x0 < width; x0 += DP_TILE_COLS) {
+        int cols = (width - x0 < DP_TILE_COLS) ? width - x0 : DP_TILE_COLS;
+
+        // Gather columns x0 .. x0 + cols - 1, row by row
+        for (int y = 0; y < height; y++) {
+            const uint8_t *src = energy_row(grad, y) + x0;
+            for (int c = 0; c < cols; c++) {
+                dp->tile[(size_t)c * height + y] = src[c];
+            }
+        }
+
+        for (int c = 0; c < cols; c++) {
+            const uint8_t *energy = dp->tile + (size_t)c * height;
+            int x = x0 + c;
+
+            if (x == 0) {  // Left column: the cost is just the energy
+                for (int y = 0; y < height; y++) {
+                    prev[y] = energy[y] + ((mask != NULL) ? mask_bias(mask_row(mask, y), weight, 0) : 0);
+                }
+                if (mask != NULL && dp->pin >= 0) pin_line(dp, prev, 0, height, 1);
+                continue;
+            }
+
+            uint8_t *back = dp->back + x * dp->back_h_pitch;
+            uint8_t packed = 0;
+            for (int y = 0; y < height; y++) {
+                int code;
+                uint32_t cost = energy[y] + ((mask != NULL) ? mask_bias(mask_row(mask, y), weight, x) : 0);
+                cur[y] = pick_parent(prev, y, height, &code) + cost;
+
+                packed |= (uint8_t)(code << (2 * (y & 3)));
+                if ((y & 3) == 3 || y == height - 1) {
+                    back[y >> 2] = packed;
+                    packed = 0;
+                }
+            }
+            if (mask != NULL && dp->pin >= 0) pin_line(dp, cur, x, height, 1);
+
+            uint32_t *tmp = prev;  // The column just filled becomes the previous one
+            prev = cur;
+            cur = tmp;
+        }
+    }
+    return prev;
+}
+
+const uint32_t *seam_dp_fill_h(struct seam_dp *dp, struct energy_map *grad) {
+    STATS_START(timer);
+    const struct seam_mask *mask = fill_mask(dp, grad->width, MASK_MAX_ENERGY);
+    const uint32_t *last = (mask != NULL) ? map_fill_h(dp, grad, mask) : map_fill_h(dp, grad, NULL);
+    STATS_STOP(timer, STAGE_DP, grad->height * grad->width);
+    return last;
+}
+
+// ----------------------------------------
+// Function: seam_dp_trace_h
+// ----------------------------------------
+/*
+   Picks the topmost minimum of the right column's costs and follows the
+   parent codes back to the left column.
+*/
+uint32_t seam_dp_trace_h(struct seam_dp *dp, const uint32_t *last, int height, int width, int *path) {
+    STATS_START(timer);
+    int row = 0;
+    for (int y = 1; y < height; y++) {
+        if (last[y] < last[row]) row = y;
+    }
+    uint32_t total = last[row];
+
+    path[width - 1] = row;
+    for (int x = width - 1; x > 0; x--) {
+        row += seam_dp_parent_h(dp, x, row);
+        path[x - 1] = row;
+    }
+    STATS_STOP(timer, STAGE_TRACE, width);
+    return total;
+}
+
+// ----------------------------------------
+// Function: seam_dp_find_h
+// ----------------------------------------
+uint32_t seam_dp_find_h(struct seam_dp *dp, struct energy_map *grad, int *path) {
+    const uint32_t *last = seam_dp_fill_h(dp, grad);
+    return seam_dp_trace_h(dp, last, grad->height, grad->width, path);
+}
+
+// ----------------------------------------
+// Function: seam_pixels_rgb / seam_pixels_planar
+// ----------------------------------------
+void seam_pixels_rgb(struct seam_pixels *px, const struct rgb_img *im) {
+    for (int c = 0; c < 3; c++) px->chan[c] = im->raster + c;   // R, G, B of a pixel are adjacent
+    px->pitch = 3 * im->stride;
+    px->step = 3;
+    px->height = im->height;
+    px->width = im->width;
+}
+
+void seam_pixels_planar(struct seam_pixels *px, const struct planar_img *pl) {
+    for (int c = 0; c < 3; c++) px->chan[c] = pl->plane[c];
+    px->pitch = pl->stride;
+    px->step = 1;
+    px->height = pl->height;
+    px->width = pl->width;
+}
+
+// ----------------------------------------
+// Helper: Forward Energy Costs
+// ----------------------------------------
+/*
+   pixel_diff is D(p, q) for pixel offsets (step * x) in two rows.
+   forward_join is C_U of column x; forward_cell picks the cheapest move
+   into (y, x) from the costs of row y - 1, with the tie order of
+   pick_parent.
+*/
+DP_INLINE uint32_t pixel_diff(const uint8_t *const a[3], size_t ia, const uint8_t *const b[3], size_t ib) {
+    return (uint32_t)(abs(a[0][ia] - b[0][ib]) + abs(a[1][ia] - b[1][ib]) + abs(a[2][ia] - b[2][ib]));
+}
+
+DP_INLINE uint32_t forward_join(const uint8_t *const mid[3], int x, int width, int step) {
+    if (x == 0 || x == width - 1) return 0;     // Nothing is joined at the edges
+    return pixel_diff(mid, (size_t)step * (x - 1), mid, (size_t)step * (x + 1));
+}
+
+DP_INLINE uint32_t forward_cell(const uint32_t *prev, const uint8_t *const up[3], const uint8_t *const mid[3],
+                                int x, int width, int step, int *code) {
+    uint32_t join = forward_join(mid, x, width, step);
+    uint32_t best = prev[x] + join;
+    *code = SEAM_UP;
+    if (x > 0) {
+        uint32_t cost = prev[x - 1] + join + pixel_diff(up, (size_t)step * x, mid, (size_t)step * (x - 1));
+        if (cost < best) {
+            best = cost;
+            *code = SEAM_UP_LEFT;
+        }
+    }
+    if (x < width - 1) {
+        uint32_t cost = prev[x + 1] + join + pixel_diff(up, (size_t)step * x, mid, (size_t)step * (x + 1));
+        if (cost < best) {
+            best = cost;
+            *code = SEAM_UP_RIGHT;
+        }
+    }
+    return best;
+}
+
+/*
+   forward_cell for 0 < x < width - 1, where all three parents exist.
+   Written as selects rather than branches: which move wins depends on
+   the image and is hard to predict, and the compiler turns these into
+   conditional moves.
+*/
+DP_INLINE uint32_t forward_inner(const uint32_t *prev, const uint8_t *const up[3], const uint8_t *const mid[3],
+                                 int x, int step, int *code) {
+    size_t here = (size_t)step * x, left = here - step, right = here + step;
+    uint32_t join = pixel_diff(mid, left, mid, right);
+    uint32_t best = prev[x];
+    uint32_t from_left = prev[x - 1] + pixel_diff(up, here, mid, left);
+    uint32_t from_right = prev[x + 1] + pixel_diff(up, here, mid, right);
+    int pick = SEAM_UP;
+
+    pick = (from_left < best) ? SEAM_UP_LEFT : pick;
+    best = (from_left < best) ? from_left : best;
+    pick = (from_right < best) ? SEAM_UP_RIGHT : pick;
+    best = (from_right < best) ? from_right : best;
+    *code = pick;
+    return best + join;
+}
+
+// Points rows[c] at channel c of row y
+static inline void pixel_rows(const struct seam_pixels *px, int y, const uint8_t *rows[3]) {
+    for (int c = 0; c < 3; c++) rows[c] = px->chan[c] + (size_t)y * px->pitch;
+}
+
+// ----------------------------------------
+// Function: seam_dp_fill_forward
+// ----------------------------------------
+/*
+   seam_dp_fill's loop with forward_cell in place of pick_parent + energy.
+*/
+DP_INLINE const uint32_t *forward_fill(struct seam_dp *dp, const struct seam_pixels *px, int step,
+                                       const struct seam_mask *mask) {
+    int height = px->height;
+    int width = px->width;
+    uint32_t *prev = dp->cost;
+    uint32_t *cur = dp->cost + dp->cost_pitch;
+    const uint32_t *weight = dp->mask_weight;
+    const uint8_t *up[3], *mid[3];
+
+    pixel_rows(px, 0, mid);
+    for (int x = 0; x < width; x++) {   // Top row: only the join
+        prev[x] = forward_join(mid, x, width, step) +
+                  ((mask != NULL) ? mask_bias(mask_row(mask, 0), weight, x) : 0);
+    }
+    if (mask != NULL && dp->pin >= 0) pin_line(dp, prev, 0, width, 0);
+
+    for (int y = 1; y < height; y++) {
+        for (int c = 0; c < 3; c++) up[c] = mid[c];
+        pixel_rows(px, y, mid);
+        const uint64_t *codes = (mask != NULL) ? mask_row(mask, y) : NULL;
+        uint8_t *back = dp->back + y * dp->back_pitch;
+        uint8_t packed = 0;
+
+        for (int x = 0; x < width; x++) {
+            int code;
+            uint32_t bias = (mask != NULL) ? mask_bias(codes, weight, x) : 0;
+            if (x > 0 && x < width - 1) cur[x] = forward_inner(prev, up, mid, x, step, &code) + bias;
+            else cur[x] = forward_cell(prev, up, mid, x, width, step, &code) + bias;
+
+            packed |= (uint8_t)(code << (2 * (x & 3)));
+            if ((x & 3) == 3 || x == width - 1) {
+                back[x >> 2] = packed;
+                packed = 0;
+            }
+        }
+        if (mask != NULL && dp->pin >= 0) pin_line(dp, cur, y, width, 0);
+
+        uint32_t *tmp = prev;
+        prev = cur;
+        cur = tmp;
+    }
+    return prev;
+}
+
+const uint32_t *seam_dp_fill_forward(struct seam_dp *dp, const struct seam_pixels *px) {
+    STATS_START(timer);
+    const struct seam_mask *mask = fill_mask(dp, px->height, MASK_MAX_FORWARD);
+    const uint32_t *last;
+    if (mask != NULL) last = (px->step == 3) ? forward_fill(dp, px, 3, mask) : forward_fill(dp, px, 1, mask);
+    else last = (px->step == 3) ? forward_fill(dp, px, 3, NULL) : forward_fill(dp, px, 1, NULL);
+    STATS_STOP(timer, STAGE_DP, (size_t)px->height * px->width);
+    return last;
+}
+
+uint32_t seam_dp_find_forward(struct seam_dp *dp, const struct seam_pixels *px, int *path) {
+    const uint32_t *last = seam_dp_fill_forward(dp, px);
+    return seam_dp_trace(dp, last, px->height, px->width, path);
+}
+
+// ----------------------------------------
+// Function: seam_dp_fill_forward_h
+// ----------------------------------------
+/*
+   Column x of the horizontal DP reads column x (rows y - 1 and y + 1) and
+   column x - 1 (row y). The walk goes down each column of the row-major
+   pixels: a strided read, but each cache line it touches serves the next
+   several columns too, so the lines of one column pair stay in cache.
+*/
+DP_INLINE uint32_t column_diff(const struct seam_pixels *px, int y1, int x1, int y2, int x2, int step) {
+    size_t a = (size_t)y1 * px->pitch + (size_t)step * x1;
+    size_t b = (size_t)y2 * px->pitch + (size_t)step * x2;
+    return pixel_diff(px->chan, a, px->chan, b);
+}
+
+DP_INLINE const uint32_t *forward_fill_h(struct seam_dp *dp, const struct seam_pixels *px, int step,
+                                         const struct seam_mask *mask) {
+    int height = px->height;
+    int width = px->width;
+    uint32_t *prev = dp->cost;
+    uint32_t *cur = dp->cost + dp->cost_pitch;
+    const uint32_t *weight = dp->mask_weight;
+
+    for (int y = 0; y < height; y++) {   // Left column: only the join
+        prev[y] = ((y == 0 || y == height - 1) ? 0 : column_diff(px, y - 1, 0, y + 1, 0, step)) +
+                  ((mask != NULL) ? mask_bias(mask_row(mask, y), weight, 0) : 0);
+    }
+    if (mask != NULL && dp->pin >= 0) pin_line(dp, prev, 0, height, 1);
+
+    for (int x = 1; x < width; x++) {
+        uint8_t *back = dp->back + x * dp->back_h_pitch;
+        uint8_t packed = 0;
+        for (int y = 0; y < height; y++) {
+            uint32_t join = (y == 0 || y == height - 1) ? 0 : column_diff(px, y - 1, x, y + 1, x, step);
+            uint32_t best = prev[y] + join;
+            int code = SEAM_UP;
+            if (y > 0) {
+                uint32_t cost = prev[y - 1] + join + column_diff(px, y, x - 1, y - 1, x, step);
+                if (cost < best) {
+                    best = cost;
+                    code = SEAM_UP_LEFT;
+                }
+            }
+            if (y < height - 1) {
+                uint32_t cost = prev[y + 1] + join + column_diff(px, y, x - 1, y + 1, x, step);
+                if (cost < best) {
+                    best = cost;
+                    code = SEAM_UP_RIGHT;
+                }
+            }
+            cur[y] = best + ((mask != NULL) ? mask_bias(mask_row(mask, y), weight, x) : 0);
+
+            packed |= (uint8_t)(code << (2 * (y & 3)));
+            if ((y & 3) == 3 || y == height - 1) {
+                back[y >> 2] = packed;
+                packed = 0;
+            }
+        }
+        if (mask != NULL && dp->pin >= 0) pin_line(dp, cur, x, height, 1);
+
+        uint32_t *tmp = prev;
+        prev = cur;
+        cur = tmp;
+    }
+    return prev;
+}
+
+const uint32_t *seam_dp_fill_forward_h(struct seam_dp *dp, const struct seam_pixels *px) {
+    STATS_START(timer);
+    const struct seam_mask *mask = fill_mask(dp, px->width, MASK_MAX_FORWARD);
+    const uint32_t *last;
+    if (mask != NULL) last = (px->step == 3) ? forward_fill_h(dp, px, 3, mask) : forward_fill_h(dp, px, 1, mask);
+    else last = (px->step == 3) ? forward_fill_h(dp, px, 3, NULL) : forward_fill_h(dp, px, 1, NULL);
+    STATS_STOP(timer, STAGE_DP, (size_t)px->height * px->width);
+    return last;
+}
+
+uint32_t seam_dp_find_forward_h(struct seam_dp *dp, const struct seam_pixels *px, int *path) {
+    const uint32_t *last = seam_dp_fill_forward_h(dp, px);
+    return seam_dp_trace_h(dp, last, px->height, px->width, path);
+}
+
+// ----------------------------------------
+// Parallel DP
+// ----------------------------------------
+
+struct dp_job {
+    struct seam_dp *dp;
+    struct thread_pool *pool;
+    const uint8_t *energy;    // Energy map, one byte per pixel
+    size_t pitch;             // Bytes between energy rows
+    const struct seam_pixels *px;  // Pixels for forward energy (energy is then NULL)
+    int height;
+    int width;
+    int block;                // Rows per block
+};
+
+// Column where strip t of count starts; inner boundaries are multiples of 4
+// so that no two strips share a byte of parent codes
+static int strip_start(int t, int count, int width) {
+    if (t == 0) return 0;
+    if (t == count) return width;
+    return (int)(((long long)width * t / count) & ~3LL);
+}
+
+// dp_segment for forward energy with a constant pixel step
+DP_INLINE void forward_segment(struct dp_job *job, const uint32_t *prev, uint32_t *cur, uint8_t *back,
+                               const uint64_t *codes, int y, int x0, int x1, int step) {
+    const uint32_t *weight = job->dp->mask_weight;
+    const uint8_t *up[3], *mid[3];
+    pixel_rows(job->px, y - 1, up);
+    pixel_rows(job->px, y, mid);
+    for (int x = x0; x < x1; x++) {
+        int code;
+        int shift = 2 * (x & 3);
+        uint32_t bias = (codes != NULL) ? mask_bias(codes, weight, x) : 0;
+        if (x > 0 && x < job->width - 1) cur[x] = forward_inner(prev, up, mid, x, step, &code) + bias;
+        else cur[x] = forward_cell(prev, up, mid, x, job->width, step, &code) + bias;
+        back[x >> 2] = (uint8_t)((back[x >> 2] & ~(3 << shift)) | (code << shift));
+    }
+}
+
+// Fills columns [x0, x1) of row y from row y - 1 of the cost ring
+static void dp_segment(struct dp_job *job, int y, int x0, int x1) {
+    struct seam_dp *dp = job->dp;
+    const uint32_t *prev = dp->cost + (size_t)((y - 1) % dp->cost_rows) * dp->cost_pitch;
+    uint32_t *cur = dp->cost + (size_t)(y % dp->cost_rows) * dp->cost_pitch;
+    uint8_t *back = dp->back + y * dp->back_pitch;
+    const uint64_t *codes = (dp->mask != NULL) ? mask_row(dp->mask, y) : NULL;
+
+    if (job->px != NULL) {   // One test per segment; the cell loops are specialised
+        if (job->px->step == 3) forward_segment(job, prev, cur, back, codes, y, x0, x1, 3);
+        else forward_segment(job, prev, cur, back, codes, y, x0, x1, 1);
+        return;
+    }
+    const uint8_t *energy = job->energy + y * job->pitch;
+    for (int x = x0; x < x1; x++) {
+        int code;
+        int shift = 2 * (x & 3);
+        uint32_t bias = (codes != NULL) ? mask_bias(codes, dp->mask_weight, x) : 0;
+        cur[x] = pick_parent(prev, x, job->width, &code) + energy[x] + bias;
+        back[x >> 2] = (uint8_t)((back[x >> 2] & ~(3 << shift)) | (code << shift));
+    }
+}
+
+/*
+   Work for thread id: for every block of rows, the trapezoid of its own
+   strip, a barrier, the triangle around the boundary with the next strip,
+   and another barrier. Strips at the image edges do not shrink on the
+   edge side since there is no neighbour there.
+*/
+static void dp_worker(void *arg, int id, int count) {
+    struct dp_job *job = (struct dp_job *)arg;
+    int a = strip_start(id, count, job->width);
+    int b = strip_start(id + 1, count, job->width);
+
+    for (int r0 = 1; r0 < job->height; r0 += job->block) {
+        int rows = job->height - r0;
+        if (rows > job->block) rows = job->block;
+
+        for (int i = 0; i < rows; i++) {              // Phase 1: trapezoid
+            int lo = (id == 0) ? a : a + i;
+            int hi = (id == count - 1) ? b : b - i;
+            dp_segment(job, r0 + i, lo, hi);
+        }
+        pool_barrier(job->pool);
+
+        if (id < count - 1) {                          // Phase 2: triangle at b
+            for (int i = 1; i < rows; i++) {
+                dp_segment(job, r0 + i, b - i, b + i);
+            }
+        }
+        pool_barrier(job->pool);
+    }
+}
+
+// ----------------------------------------
+// Function: seam_dp_fill_parallel
+// ----------------------------------------
+/*
+   Same result as seam_dp_fill, with the rows split into column strips
+   across the pool. Falls back to seam_dp_fill when the pool has a single
+   thread, the image is too narrow to give every thread a strip or the
+   fill is pinned.
+   fill_parallel does the work for an energy map or, with px set, for
+   forward energy.
+*/
+static const uint32_t *fill_parallel(struct seam_dp *dp, struct energy_map *grad, const struct seam_pixels *px,
+                                     struct thread_pool *pool) {
+    int height = (px != NULL) ? px->height : (int)grad->height;
+    int width = (px != NULL) ? px->width : (int)grad->width;
+    int threads = pool_size(pool);
+
+    if (threads < 2 || width < threads * DP_MIN_STRIP || height < 2 || dp->cost_rows < 3 ||
+        (dp->mask != NULL && dp->pin >= 0)) {
+        return (px != NULL) ? seam_dp_fill_forward(dp, px) : seam_dp_fill(dp, grad);
+    }
+    STATS_START(timer);
+
+    // Triangles of neighbouring strips must not meet (or share a byte of
+    // parent codes), so blocks are at most (narrowest strip - 4) / 2 rows
+    int narrowest = width;
+    for (int t = 0; t < threads; t++) {
+        int w = strip_start(t + 1, threads, width) - strip_start(t, threads, width);
+        if (w < narrowest) narrowest = w;
+    }
+    int block = (narrowest - 4) / 2;
+    if (block > dp->cost_rows - 1) block = dp->cost_rows - 1;
+
+    // Top row: the cost is just the energy (or the join), plus the mask
+    const struct seam_mask *mask = fill_mask(dp, height, (px != NULL) ? MASK_MAX_FORWARD : MASK_MAX_ENERGY);
+    if (px != NULL) {
+        const uint8_t *top[3];
+        pixel_rows(px, 0, top);
+        for (int x = 0; x < width; x++) {
+            dp->cost[x] = (px->step == 3) ? forward_join(top, x, width, 3) : forward_join(top, x, width, 1);
+        }
+    } else {
+        const uint8_t *top = energy_row(grad, 0);
+        for (int x = 0; x < width; x++) {
+            dp->cost[x] = top[x];
+        }
+    }
+    if (mask != NULL) {
+        for (int x = 0; x < width; x++) dp->cost[x] += mask_bias(mask_row(mask, 0), dp->mask_weight, x);
+    }
+
+    struct dp_job job = {dp, pool, (px != NULL) ? NULL : grad->data, (px != NULL) ? 0 : grad->stride, px,
+                         height, width, block};
+    pool_run(pool, dp_worker, &job);
+    STATS_STOP(timer, STAGE_DP, (size_t)height * width);
+
+    return dp->cost + (size_t)((height - 1) % dp->cost_rows) * dp->cost_pitch;
+}
+
+const uint32_t *seam_dp_fill_parallel(struct seam_dp *dp, struct energy_map *grad, struct thread_pool *pool) {
+    return fill_parallel(dp, grad, NULL, pool);
+}
+
+const uint32_t *seam_dp_fill_forward_parallel(struct seam_dp *dp, const struct seam_pixels *px,
+                                              struct thread_pool *pool) {
+    return fill_parallel(dp, NULL, px, pool);
+}
+
+// ----------------------------------------
+// Function: seam_dp_find_parallel
+// ----------------------------------------
+uint32_t seam_dp_find_parallel(struct seam_dp *dp, struct energy_map *grad, int *path,
+                               struct thread_pool *pool) {
+    const uint32_t *last = seam_dp_fill_parallel(dp, grad, pool);
+    return seam_dp_trace(dp, last, grad->height, grad->width, path);
+}
+
+uint32_t seam_dp_find_forward_parallel(struct seam_dp *dp, const struct seam_pixels *px, int *path,
+                                       struct thread_pool *pool) {
+    const uint32_t *last = seam_dp_fill_forward_parallel(dp, px, pool);
+    return seam_dp_trace(dp, last, px->height, px->width, path);
+}
+
+// ----------------------------------------
+// Function: seam_dp_parallel_rows
+// ----------------------------------------
+/*
+   Number of cost rows seam_dp_find_parallel can use to its advantage.
+*/
+int seam_dp_parallel_rows(void) {
+    return DP_MAX_BLOCK + 1;
+}
@@ -0,0 +1,260 @@
+/*
+Compact Seam DP Header File
+Author: Tannaz Chowdhury
+GitHub: TannazC
+Date: 2025
+
+Declares a memory-compact alternative to dynamic_seam/recover_path.
+Instead of an H x W table of doubles, it accumulates costs in uint32_t,
+keeps only two cost rows, and records each pixel's parent as a 2-bit
+direction code (four codes per byte). Seams found are identical to the
+ones found by dynamic_seam + recover_path, including tie-breaking.
+
+The same DP also runs on forward energy (Rubinstein et al.): instead of
+the energy of the pixel a seam removes, each step costs the new edges its
+removal creates, which depend on whether the seam came from up-left, up
+or up-right. Those three costs are computed from the pixels inside the
+recurrence, so forward energy needs no energy map and no separate pass.
+
+A seam mask (seam_mask.h) set on the working memory is applied the same
+way: every fill adds each pixel's mask weight to its cost as it goes.
+Pinned, the fills rule out pixels instead of weighing them, for the seams
+the weights alone cannot force.
+*/
+
+#ifndef SEAM_DP_H               // Include guard - prevents multiple includes
+#define SEAM_DP_H
+
+#include <stdint.h>
+#include "energy_map.h"         // Energy maps the DP runs on
+#include "seam_mask.h"          // Protect / remove masks
+
+struct thread_pool;             // From thread_pool.h
+struct seam_arena;              // From seam_arena.h
+struct planar_img;              // From planar_img.h
+
+// Parent direction codes stored in seam_dp.back
+#define SEAM_UP        0        // Parent is directly above
+#define SEAM_UP_LEFT   1        // Parent is above and one column left
+#define SEAM_UP_RIGHT  2        // Parent is above and one column right
+
+// ----------------------------------------
+// Struct: seam_dp
+// ----------------------------------------
+/*
+   Working memory for the compact DP, sized once for the largest image it
+   will see. Any image up to max_height x max_width can reuse it, for
+   vertical as well as horizontal seams.
+
+   Fields:
+     max_height, max_width - capacity
+     cost         - ring of cumulative cost lines (cost_rows * cost_pitch entries)
+     cost_pitch   - entries per line (the larger of max_width and max_height)
+     cost_rows    - lines in the ring: 2 for the serial DP, more for the parallel one
+     back         - parent codes: back_pitch bytes per row (vertical seams)
+                    or back_h_pitch bytes per column (horizontal seams)
+     back_pitch   - (max_width + 3) / 4
+     back_h_pitch - (max_height + 3) / 4
+     tile         - energy of a strip of columns, column-major (horizontal DP)
+     mask         - mask the fills apply (NULL = none); it must have the
+                    size of the image the DP runs on. Set it directly
+     mask_weight  - the mask weights of the last masked fill (mask_weights)
+     pin          - with a mask, makes removal a rule rather than a weight:
+                    the seam must cross a removal pixel on line `pin` (a row
+                    for vertical seams, a column for horizontal ones) and
+                    may not cross a protected pixel anywhere. -1 (the
+                    default) turns it off. Seams that cannot keep the rule
+                    still come out, breaking it. Only the serial fills pin;
+                    the parallel ones fall back to them
+*/
+struct seam_dp {
+    size_t max_height;
+    size_t max_width;
+    uint32_t *cost;
+    size_t cost_pitch;
+    int cost_rows;
+    uint8_t *back;
+    size_t back_pitch;
+    size_t back_h_pitch;
+    uint8_t *tile;
+    const struct seam_mask *mask;
+    uint32_t mask_weight[MASK_CODES];
+    int pin;
+};
+
+// ----------------------------------------
+// Function: seam_dp_init / seam_dp_free
+// ----------------------------------------
+/*
+   Allocates (and frees) the DP working memory for images up to
+   height x width pixels: two cost lines of max(width, height) entries,
+   about height * width / 4 bytes of parent codes, and a 64 x height
+   tile for the horizontal DP.
+*/
+void seam_dp_init(struct seam_dp *dp, size_t height, size_t width);
+void seam_dp_free(struct seam_dp *dp);
+
+// ----------------------------------------
+// Function: seam_dp_bytes / seam_dp_init_arena
+// ----------------------------------------
+/*
+   seam_dp_init_arena sets up the same working memory inside an arena,
+   with a cost ring of `rows` lines (2 for the serial DP,
+   seam_dp_parallel_rows() for the parallel one). seam_dp_bytes is the
+   arena space it takes. The memory goes away with the arena: do not call
+   seam_dp_free or seam_dp_reserve_rows on it.
+*/
+size_t seam_dp_bytes(size_t height, size_t width, int rows);
+void seam_dp_init_arena(struct seam_dp *dp, size_t height, size_t width, int rows, struct seam_arena *arena);
+
+// ----------------------------------------
+// Function: seam_dp_find
+// ----------------------------------------
+/*
+   Finds the lowest-energy vertical seam of an energy map (as produced by
+   calc_energy).
+
+   Parameters:
+     dp   - working memory, at least grad->height x grad->width
+     grad - energy map
+     path - output: one column index per row (grad->height entries)
+
+   Returns the total energy of the seam.
+*/
+uint32_t seam_dp_find(struct seam_dp *dp, struct energy_map *grad, int *path);
+
+// ----------------------------------------
+// Function: seam_dp_fill / seam_dp_trace
+// ----------------------------------------
+/*
+   The two halves of seam_dp_find, for callers that need the DP results
+   themselves (e.g. to extract several seams from one pass).
+   seam_dp_fill runs the DP over grad and returns the bottom row of
+   cumulative costs (valid until the next fill). seam_dp_trace backtracks
+   the cheapest seam from that row into path and returns its cost.
+*/
+const uint32_t *seam_dp_fill(struct seam_dp *dp, struct energy_map *grad);
+uint32_t seam_dp_trace(struct seam_dp *dp, const uint32_t *last, int height, int width, int *path);
+
+// ----------------------------------------
+// Function: seam_dp_parent
+// ----------------------------------------
+/*
+   Column offset (-1, 0 or +1) from pixel (y, x) to its parent in row y - 1,
+   as recorded by the last fill.
+*/
+static inline int seam_dp_parent(const struct seam_dp *dp, int y, int x) {
+    int code = (dp->back[y * dp->back_pitch + (x >> 2)] >> (2 * (x & 3))) & 3;
+    return (code == SEAM_UP_LEFT) ? -1 : (code == SEAM_UP_RIGHT) ? 1 : 0;
+}
+
+// ----------------------------------------
+// Function: seam_dp_find_h / seam_dp_fill_h / seam_dp_trace_h
+// ----------------------------------------
+/*
+   Horizontal counterparts of seam_dp_find / fill / trace: path gets one
+   row index per column (grad->width entries). The DP walks the columns
+   left to right on the row-major map, gathering the energy of a strip of
+   columns at a time into a small cache-resident tile. Seams are the ones a
+   vertical DP would find on the transposed map (ties: same row, then the
+   row above, then the row below; topmost minimum in the last column).
+*/
+uint32_t seam_dp_find_h(struct seam_dp *dp, struct energy_map *grad, int *path);
+const uint32_t *seam_dp_fill_h(struct seam_dp *dp, struct energy_map *grad);
+uint32_t seam_dp_trace_h(struct seam_dp *dp, const uint32_t *last, int height, int width, int *path);
+
+// ----------------------------------------
+// Function: seam_dp_parent_h
+// ----------------------------------------
+/*
+   Row offset (-1, 0 or +1) from pixel (y, x) to its parent in column
+   x - 1, as recorded by the last horizontal fill.
+*/
+static inline int seam_dp_parent_h(const struct seam_dp *dp, int x, int y) {
+    int code = (dp->back[x * dp->back_h_pitch + (y >> 2)] >> (2 * (y & 3))) & 3;
+    return (code == SEAM_UP_LEFT) ? -1 : (code == SEAM_UP_RIGHT) ? 1 : 0;
+}
+
+// ----------------------------------------
+// Function: seam_dp_find_parallel
+// ----------------------------------------
+/*
+   Same as seam_dp_find (identical seam and cost), but the DP is split into
+   column strips processed by every thread of the pool. Rows are handled in
+   blocks with two barriers per block; blocks are limited by the size of the
+   cost ring, so call seam_dp_reserve_rows(dp, seam_dp_parallel_rows())
+   first. Falls back to the serial DP for narrow images or single threads.
+   seam_dp_fill_parallel is the matching parallel seam_dp_fill.
+*/
+uint32_t seam_dp_find_parallel(struct seam_dp *dp, struct energy_map *grad, int *path,
+                               struct thread_pool *pool);
+const uint32_t *seam_dp_fill_parallel(struct seam_dp *dp, struct energy_map *grad, struct thread_pool *pool);
+
+// ----------------------------------------
+// Function: seam_dp_reserve_rows / seam_dp_parallel_rows
+// ----------------------------------------
+/*
+   seam_dp_reserve_rows grows the cost ring to at least `rows` rows.
+   seam_dp_parallel_rows is the ring size the parallel DP makes full use of.
+*/
+void seam_dp_reserve_rows(struct seam_dp *dp, int rows);
+int seam_dp_parallel_rows(void);
+
+// ----------------------------------------
+// Struct: seam_pixels
+// ----------------------------------------
+/*
+   The image a forward-energy DP reads, interleaved or planar: channel c
+   of pixel (y, x) is at chan[c][y * pitch + step * x]. The DP is
+   compiled separately for step 3 (interleaved) and step 1 (planar).
+*/
+struct seam_pixels {
+    const uint8_t *chan[3];
+    size_t pitch;
+    int step;
+    int height;
+    int width;
+};
+
+// ----------------------------------------
+// Function: seam_pixels_rgb / seam_pixels_planar
+// ----------------------------------------
+/*
+   Describe an image's current pixels for the forward-energy DP.
+*/
+void seam_pixels_rgb(struct seam_pixels *px, const struct rgb_img *im);
+void seam_pixels_planar(struct seam_pixels *px, const struct planar_img *pl);
+
+// ----------------------------------------
+// Function: seam_dp_fill_forward / seam_dp_find_forward
+// ----------------------------------------
+/*
+   seam_dp_fill and seam_dp_find with forward energy. With D(p, q) the sum
+   over R, G and B of |p - q|, removing pixel (y, x) costs
+     up:       C_U = D(y,x-1 ; y,x+1)
+     up-left:  C_U + D(y-1,x ; y,x-1)
+     up-right: C_U + D(y-1,x ; y,x+1)
+   (C_U is 0 in the first and last columns, where nothing is joined), and
+   row 0 costs C_U. Ties and the trace are those of seam_dp_fill, so the
+   parent codes work with seam_dp_trace and seam_dp_parent.
+   The parallel versions split the rows like seam_dp_fill_parallel.
+*/
+const uint32_t *seam_dp_fill_forward(struct seam_dp *dp, const struct seam_pixels *px);
+uint32_t seam_dp_find_forward(struct seam_dp *dp, const struct seam_pixels *px, int *path);
+const uint32_t *seam_dp_fill_forward_parallel(struct seam_dp *dp, const struct seam_pixels *px,
+                                              struct thread_pool *pool);
+uint32_t seam_dp_find_forward_parallel(struct seam_dp *dp, const struct seam_pixels *px, int *path,
+                                       struct thread_pool *pool);
+
+// ----------------------------------------
+// Function: seam_dp_fill_forward_h / seam_dp_find_forward_h
+// ----------------------------------------
+/*
+   Forward energy for horizontal seams: the vertical recurrence on the
+   transposed image, walked column by column on the row-major pixels.
+   Works with seam_dp_trace_h and seam_dp_parent_h.
+*/
+const uint32_t *seam_dp_fill_forward_h(struct seam_dp *dp, const struct seam_pixels *px);
+uint32_t seam_dp_find_forward_h(struct seam_dp *dp, const struct seam_pixels *px, int *path);
+
+#endif  // End of include guard for SEAM_DP_H
@@ -0,0 +1,207 @@
+/*
+Seam Insertion Implementation
+Author: Tannaz Chowdhury
+GitHub: TannazC
+Date: 2025
+
+Enlarges an image by duplicating its cheapest seams. Selection reuses the
+carving machinery (calc_energy and the compact DP's parent codes); the
+widening copies each row's runs of pixels between seams with memcpy and
+writes one averaged pixel after every seam pixel.
+*/
+
+#include <stdlib.h>           // Required for malloc, free
+#include <string.h>           // Required for memcpy
+#include "seam_insert.h"      // Header for the seam insertion declarations
+#include "seamcarving.h"      // calc_energy_threads
+#include "seam_dp.h"          // Compact DP the seams are picked from
+#include "energy_map.h"       // Energy maps
+#include "carve_stats.h"      // Stage timers and counters
+
+// ----------------------------------------
+// Helper: sort_order
+// ----------------------------------------
+/*
+   Loads row y's column of every seam into cols, in the previous row's
+   order, and insertion-sorts the (order, cols) pairs by column. That
+   order is almost always still sorted, so this is a single pass in the
+   common case, and each seam's path is read once per row.
+*/
+static void sort_order(int *order, int *cols, int count, const int *paths, int height, int y) {
+    for (int i = 0; i < count; i++) cols[i] = paths[(size_t)order[i] * height + y];
+    for (int i = 1; i < count; i++) {
+        int s = order[i];
+        int col = cols[i];
+        int j = i;
+        while (j > 0 && cols[j - 1] > col) {
+            order[j] = order[j - 1];
+            cols[j] = cols[j - 1];
+            j--;
+        }
+        order[j] = s;
+        cols[j] = col;
+    }
+}
+
+// ----------------------------------------
+// Function: widen_img
+// ----------------------------------------
+/*
+   For each row: copy the pixels up to and including the next seam pixel,
+   then the average of that pixel and the one to its right (itself at the
+   right edge), and carry on from the pixel after the seam.
+*/
+void widen_img(const struct rgb_img *src, const int *paths, int count, int *order, struct rgb_img *dst) {
+    STATS_START(timer);
+    int height = src->height;
+    int width = src->width;
+
+    dst->height = height;
+    dst->width = width + count;
+    int *cols = order + count;                 // Row y's columns, sorted
+    for (int s = 0; s < count; s++) order[s] = s;
+
+    for (int y = 0; y < height; y++) {
+        const uint8_t *from = src->raster + 3 * (size_t)y * src->stride;
+        uint8_t *to = dst->raster + 3 * (size_t)y * dst->stride;
+        int next = 0;                          // First source column not yet copied
+
+        sort_order(order, cols, count, paths, height, y);
+        for (int i = 0; i < count; i++) {
+            int col = cols[i];
+            const uint8_t *left = from + 3 * col;
+            const uint8_t *right = (col + 1 < width) ? left + 3 : left;
+
+            size_t run = 3 * (size_t)(col + 1 - next);
+            memcpy(to, from + 3 * next, run);
+            to += run;
+            for (int c = 0; c < 3; c++) {      // The inserted pixel
+                to[c] = (uint8_t)((left[c] + right[c] + 1) >> 1);
+            }
+            to += 3;
+            next = col + 1;
+        }
+        memcpy(to, from + 3 * next, 3 * (size_t)(width - next));
+    }
+    STATS_ADD(bytes_copied, 3 * (size_t)height * (width + count));
+    STATS_STOP(timer, STAGE_REMOVE, (size_t)height * count);  // The same kind of raster pass as removal
+}
+
+// ----------------------------------------
+// Helper: compare_keys
+// ----------------------------------------
+static int compare_keys(const void *a, const void *b) {
+    uint64_t ka = *(const uint64_t *)a, kb = *(const uint64_t *)b;
+    return (ka > kb) - (ka < kb);
+}
+
+// ----------------------------------------
+// Function: seam_insert_select
+// ----------------------------------------
+/*
+   Seam j (counting from the left) starts at the j-th of the chosen bottom
+   columns and follows the DP's parent codes upward, but is kept between
+   seam j - 1 + 1 and width - (n - j), leaving a column for each seam still
+   to its right. Both bounds move by at most one column per row and never
+   cross, so the clamped step is always one of the three parents: every
+   seam is traced to the top, and one DP gives all n.
+*/
+int seam_insert_select(struct seam_dp *dp, const uint32_t *last, struct energy_map *grad, int n,
+                       uint64_t *keys, int *paths) {
+    STATS_START(timer);
+    int height = grad->height;
+    int width = grad->width;
+
+    if (n > width) n = width;
+    for (int x = 0; x < width; x++) {  // Cheapest bottom pixels first, leftmost on ties
+        keys[x] = ((uint64_t)last[x] << 32) | (uint32_t)x;
+    }
+    qsort(keys, width, sizeof(uint64_t), compare_keys);
+
+    for (int j = 0; j < n; j++) keys[j] &= 0xFFFFFFFFu;  // The chosen columns, left to right
+    qsort(keys, n, sizeof(uint64_t), compare_keys);
+
+    for (int j = 0; j < n; j++) {
+        paths[(size_t)j * height + height - 1] = (int)keys[j];
+    }
+    for (int y = height - 1; y > 0; y--) {  // All seams one row up at a time: one row of codes in cache
+        int left = -1;                      // Seam j - 1's column in row y - 1
+        for (int j = 0; j < n; j++) {
+            int *path = paths + (size_t)j * height;
+            int high = width - (n - j);     // Room for the seams to the right
+            int col = path[y] + seam_dp_parent(dp, y, path[y]);
+            if (col <= left) col = left + 1;
+            if (col > high) col = high;
+            path[y - 1] = col;
+            left = col;
+        }
+    }
+    STATS_STOP(timer, STAGE_TRACE, (size_t)n * height);
+    return n;
+}
+
+// ----------------------------------------
+// Function: seam_insert
+// ----------------------------------------
+/*
+   Each round: one energy map, one DP fill, seam_insert_select for up to
+   `want` seams, and one widening pass into a new image. A second round
+   only runs when n exceeds the width. An empty image has no seams (and an
+   empty energy map the DP cannot read), so it fails up front.
+*/
+int seam_insert(struct rgb_img *src, int n, struct thread_pool *pool, struct rgb_img **out) {
+    struct rgb_img *cur = src;
+    int added = 0;
+
+    *out = NULL;
+    if (src->height == 0 || src->width == 0) return -1;
+    while (added < n) {
+        size_t height = cur->height;
+        size_t width = cur->width;
+        int want = n - added;
+        if (want > (int)width) want = width;
+
+        struct energy_map *grad;
+        struct seam_dp dp;
+        int *paths = (int *)malloc(sizeof(int) * height * want);
+        uint64_t *keys = (uint64_t *)malloc(sizeof(uint64_t) * width);
+        int *order = (int *)malloc(sizeof(int) * 2 * want);
+
+        calc_energy_threads(cur, &grad, pool);
+        seam_dp_init(&dp, height, width);
+        const uint32_t *last;
+        if (pool != NULL) {
+            seam_dp_reserve_rows(&dp, seam_dp_parallel_rows());
+            last = seam_dp_fill_parallel(&dp, grad, pool);
+        } else {
+            last = seam_dp_fill(&dp, grad);
+        }
+        int found = seam_insert_select(&dp, last, grad, want, keys, paths);
+
+        struct rgb_img *wide = NULL;
+        if (found > 0) {
+            create_img(&wide, height, width + found);
+            widen_img(cur, paths, found, order, wide);
+        }
+
+        free(order);
+        free(keys);
+        free(paths);
+        seam_dp_free(&dp);
+        destroy_energy_map(grad);
+        if (cur != src) destroy_image(cur);
+        if (wide == NULL) return -1;       // No seam found: the round would repeat forever
+        cur = wide;
+        added += found;
+        STATS_ADD(seams, found);
+    }
+
+    if (cur == src) {  // Nothing inserted: still hand back a copy
+        create_img(&cur, src->height, src->width);
+        for (size_t y = 0; y < src->height; y++) {
+            memcpy(cur->raster + 3 * y * cur->stride, src->raster + 3 * y * src->stride, 3 * src->width);
+        }
+    }
+    *out = cur;
+    return added;
+}
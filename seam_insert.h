@@ -0,0 +1,85 @@
+/*
+Seam Insertion Header File
+Author: Tannaz Chowdhury
+GitHub: TannazC
+Date: 2025
+
+Declares content-aware enlargement. The n seams to duplicate are chosen
+together from one energy pass and one DP (the n cheapest bottom-row
+pixels, each traced up its DP path and kept clear of its neighbours), and
+the widened image is then written in a single pass over the raster: after
+every seam pixel a new pixel, the average of it and its right neighbour,
+is inserted. The image is allocated once at its final width instead of
+growing a column at a time.
+
+On the command line, --insert N widens an image by N columns, and
+--target WxH with W above the image's width widens it this way before
+removing rows. There is no separate width option.
+*/
+
+#ifndef SEAM_INSERT_H           // Include guard - prevents multiple includes
+#define SEAM_INSERT_H
+
+#include <stdint.h>
+#include "c_img.h"              // Required for struct rgb_img definitions
+#include "seam_dp.h"            // DP the seams are picked from
+
+struct thread_pool;             // From thread_pool.h
+
+// ----------------------------------------
+// Function: seam_insert
+// ----------------------------------------
+/*
+   Widens src by n columns into a new image.
+
+   One round selects up to n disjoint seams of the current image (at most
+   its width) and inserts them all, so widening by up to 2x takes a single
+   energy pass, DP and copy. Larger factors repeat on the widened image.
+
+   Parameters:
+     src  - image to widen (unchanged)
+     n    - columns to add
+     pool - threads for the energy and DP passes (NULL = calling thread)
+     out  - pointer to the address of the widened image to allocate
+
+   Returns the number of columns added (n), or -1 with *out NULL when src
+   has no rows or no columns, or a round finds no seam.
+*/
+int seam_insert(struct rgb_img *src, int n, struct thread_pool *pool, struct rgb_img **out);
+
+// ----------------------------------------
+// Function: seam_insert_select
+// ----------------------------------------
+/*
+   Picks n pixel-disjoint seams (n at most grad->width) from one DP fill:
+   the n cheapest bottom-row pixels of `last`, traced upward along the
+   parent codes in dp. A seam that would touch or cross its left
+   neighbour, or leave too little room for the seams to its right, is
+   moved one column right or left instead; with that, every candidate
+   reaches the top row.
+
+   Parameters:
+     dp, last - a seam_dp_fill (or _parallel) of grad, and its bottom row
+     keys     - scratch for grad->width uint64_t
+     paths    - output: seam j, left to right, at paths[j * height ..]
+
+   Returns the number of seams (min(n, width)).
+*/
+int seam_insert_select(struct seam_dp *dp, const uint32_t *last, struct energy_map *grad, int n,
+                       uint64_t *keys, int *paths);
+
+// ----------------------------------------
+// Function: widen_img
+// ----------------------------------------
+/*
+   The single widening pass behind seam_insert. count disjoint seams
+   (paths in src's coordinates, src->height entries each, as from
+   seam_insert_select) are duplicated into dst, which must be at least
+   src->width + count pixels wide; its height and width are set, its
+   stride kept. order is scratch for 2 * count ints: it keeps the seams sorted
+   by column from one row to the next, so each row costs O(count) unless
+   seams cross (those of seam_insert_select never do).
+*/
+void widen_img(const struct rgb_img *src, const int *paths, int count, int *order, struct rgb_img *dst);
+
+#endif  // End of include guard for SEAM_INSERT_H
@@ -0,0 +1,155 @@
+/*
+Seam Log Implementation
+Author: Tannaz Chowdhury
+GitHub: TannazC
+Date: 2025
+
+Writes and replays seam logs. A seam costs 2 bytes per row in the log
+instead of a whole image per step, so a run of hundreds of seams writes
+the final image plus a log a few percent of its size; any intermediate
+image is rebuilt from the original by replaying the log up to that step.
+*/
+
+#include <stdio.h>            // Required for file IO
+#include <stdlib.h>           // Required for malloc, free
+#include "seam_log.h"         // Header for the seam log declarations
+#include "seamcarving.h"      // In-place seam removal for replay
+
+// ----------------------------------------
+// Function: seam_log_begin
+// ----------------------------------------
+int seam_log_begin(struct seam_log *log, FILE *fp, size_t height, size_t width) {
+    size_t longest = (height > width) ? height : width;
+
+    log->fp = fp;
+    log->height = height;
+    log->width = width;
+    log->buf = (uint8_t *)malloc(1 + 2 * longest);   // Direction byte + indices
+    log->cols = (int *)malloc(sizeof(int) * height);
+    log->failed = (height > IMG_V1_MAX || width > IMG_V1_MAX) ? -1 : 0;  // Indices are 2 bytes
+    log->failed |= write_2bytes(fp, height);
+    log->failed |= write_2bytes(fp, width);
+    return log->failed;
+}
+
+// ----------------------------------------
+// Function: seam_log_end
+// ----------------------------------------
+int seam_log_end(struct seam_log *log) {
+    if (fflush(log->fp) != 0) log->failed = -1;
+    free(log->buf);
+    free(log->cols);
+    return log->failed ? -1 : 0;
+}
+
+// ----------------------------------------
+// Helper: append_record
+// ----------------------------------------
+/*
+   Encodes one record (direction byte, then count big-endian indices) and
+   writes it with a single fwrite.
+*/
+static int append_record(struct seam_log *log, int direction, const int *path, size_t count) {
+    log->buf[0] = (uint8_t)direction;
+    for (size_t i = 0; i < count; i++) {
+        log->buf[1 + 2 * i] = (uint8_t)(path[i] >> 8);    // Higher byte first
+        log->buf[2 + 2 * i] = (uint8_t)(path[i] & 0xFF);
+    }
+    if (fwrite(log->buf, 1, 1 + 2 * count, log->fp) != 1 + 2 * count) log->failed = -1;
+    return log->failed ? -1 : 0;
+}
+
+// ----------------------------------------
+// Function: seam_log_vertical
+// ----------------------------------------
+int seam_log_vertical(struct seam_log *log, const int *path) {
+    int failed = append_record(log, SEAM_LOG_VERTICAL, path, log->height);
+    log->width--;
+    return failed;
+}
+
+// ----------------------------------------
+// Function: seam_log_horizontal
+// ----------------------------------------
+int seam_log_horizontal(struct seam_log *log, const int *path) {
+    int failed = append_record(log, SEAM_LOG_HORIZONTAL, path, log->width);
+    log->height--;
+    return failed;
+}
+
+// ----------------------------------------
+// Function: seam_log_batch
+// ----------------------------------------
+/*
+   Seam s of a batch is logged after seams 0 .. s - 1 are gone, so in each
+   row its column moves left by the number of earlier seams of the batch
+   left of it.
+*/
+int seam_log_batch(struct seam_log *log, const int *paths, int count) {
+    int height = log->height;
+    int failed = 0;
+
+    for (int s = 0; s < count; s++) {
+        const int *path = paths + (size_t)s * height;
+        for (int y = 0; y < height; y++) {
+            int shift = 0;
+            for (int t = 0; t < s; t++) {
+                if (paths[(size_t)t * height + y] < path[y]) shift++;
+            }
+            log->cols[y] = path[y] - shift;
+        }
+        failed |= seam_log_vertical(log, log->cols);
+    }
+    return failed;
+}
+
+// ----------------------------------------
+// Function: seam_log_replay
+// ----------------------------------------
+/*
+   Reads one record at a time and removes it with remove_seam_inplace or
+   remove_hseam_inplace; indices outside the current image mean the log is
+   corrupt.
+*/
+int seam_log_replay(struct rgb_img *im, FILE *fp, int seams) {
+    int height = read_2bytes(fp);
+    int width = read_2bytes(fp);
+    if (height != (int)im->height || width != (int)im->width) return -1;
+
+    size_t longest = (im->height > im->width) ? im->height : im->width;
+    uint8_t *buf = (uint8_t *)malloc(2 * longest);
+    int *path = (int *)malloc(sizeof(int) * longest);
+    int replayed = 0;
+
+    while (seams < 0 || replayed < seams) {
+        int direction = fgetc(fp);
+        if (direction == EOF) break;                     // End of the log
+
+        int vertical = (direction == SEAM_LOG_VERTICAL);
+        size_t count = vertical ? im->height : im->width;   // Entries in this record
+        size_t limit = vertical ? im->width : im->height;   // Valid index range
+        if ((direction != SEAM_LOG_VERTICAL && direction != SEAM_LOG_HORIZONTAL) || limit <= 1 ||
+            fread(buf, 2, count, fp) != count) {
+            replayed = -1;
+            break;
+        }
+
+        size_t i = 0;
+        for (; i < count; i++) {
+            path[i] = (buf[2 * i] << 8) | buf[2 * i + 1];
+            if ((size_t)path[i] >= limit) break;
+        }
+        if (i < count) {
+            replayed = -1;
+            break;
+        }
+
+        if (vertical) remove_seam_inplace(im, path);
+        else remove_hseam_inplace(im, path);
+        replayed++;
+    }
+
+    free(buf);
+    free(path);
+    return replayed;
+}
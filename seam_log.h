@@ -0,0 +1,90 @@
+/*
+Seam Log Header File
+Author: Tannaz Chowdhury
+GitHub: TannazC
+Date: 2025
+
+Declares the seam log: a compact record of every seam removed from an
+image, written instead of a full image after each step. Together with the
+original image, the log rebuilds the image after any number of seams.
+
+Log files store the starting dimensions and then one record per seam:
+[2 bytes height][2 bytes width]
+then, per seam, [1 byte direction][one 2-byte index per row or column]
+all big-endian like the .bin format. A vertical record holds the removed
+column of each row (height entries), a horizontal record the removed row
+of each column (width entries), both in the coordinates of the image just
+before that seam.
+*/
+
+#ifndef SEAM_LOG_H              // Include guard - prevents multiple includes
+#define SEAM_LOG_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "c_img.h"              // Required for struct rgb_img definitions
+
+#define SEAM_LOG_VERTICAL   0   // Record direction: one column per row
+#define SEAM_LOG_HORIZONTAL 1   // Record direction: one row per column
+
+// ----------------------------------------
+// Struct: seam_log
+// ----------------------------------------
+/*
+   A log being written.
+
+   Fields:
+     fp     - output file (owned by the caller)
+     height, width - dimensions of the image before the next seam
+     buf    - one encoded record
+     cols   - scratch for converting batch seams
+     failed - set once any write fails
+*/
+struct seam_log {
+    FILE *fp;
+    size_t height;
+    size_t width;
+    uint8_t *buf;
+    int *cols;
+    int failed;
+};
+
+// ----------------------------------------
+// Function: seam_log_begin / seam_log_end
+// ----------------------------------------
+/*
+   seam_log_begin writes the header for an image of height x width to fp.
+   seam_log_end flushes fp and frees the log's buffers (fp stays open).
+   Both return 0, or -1 if a write failed. Indices are 16-bit, so a side
+   over IMG_V1_MAX pixels cannot be logged (the log fails).
+*/
+int seam_log_begin(struct seam_log *log, FILE *fp, size_t height, size_t width);
+int seam_log_end(struct seam_log *log);
+
+// ----------------------------------------
+// Function: seam_log_vertical / seam_log_horizontal / seam_log_batch
+// ----------------------------------------
+/*
+   Append one removed seam: a vertical seam (column per row), a horizontal
+   seam (row per column), or `count` disjoint vertical seams removed
+   together by carve_seams (paths in the coordinates before the batch).
+   A batch is logged as `count` vertical records, each converted to the
+   coordinates left by the records before it, so replaying them one at a
+   time gives the same image.
+*/
+int seam_log_vertical(struct seam_log *log, const int *path);
+int seam_log_horizontal(struct seam_log *log, const int *path);
+int seam_log_batch(struct seam_log *log, const int *paths, int count);
+
+// ----------------------------------------
+// Function: seam_log_replay
+// ----------------------------------------
+/*
+   Removes the first `seams` logged seams (all of them if seams < 0) from
+   im, which must be the image the log was started for, in place.
+   Returns the number of seams replayed, or -1 if the log does not belong
+   to an image of im's size or is corrupt.
+*/
+int seam_log_replay(struct rgb_img *im, FILE *fp, int seams);
+
+#endif  // End of include guard for SEAM_LOG_H
@@ -0,0 +1,269 @@
+/*
+Batch Manifest Implementation
+Author: Tannaz Chowdhury
+GitHub: TannazC
+Date: 2025
+
+Parses manifests and runs them on the thread pool. Every pool thread is a
+worker: it takes the next unclaimed entry under a mutex, loads the image
+into its own carving context, carves it to the target size with
+carve_step, writes it, and records the latency. Workers never share
+scratch memory, so the only synchronisation is claiming entries and
+printing results.
+*/
+
+#define _POSIX_C_SOURCE 200809L  // For clock_gettime under -std=c99
+
+#include <stdio.h>            // Required for file IO
+#include <stdlib.h>           // Required for malloc, free, qsort, strtoul
+#include <string.h>           // Required for strchr, strspn
+#include <time.h>             // Required for clock_gettime
+#include <pthread.h>          // Required for the claim/report mutex
+#include "seam_manifest.h"    // Header for the manifest declarations
+#include "seamcarving.h"      // Carving contexts
+#include "thread_pool.h"      // Worker threads
+
+// ----------------------------------------
+// Helper: next_field
+// ----------------------------------------
+/*
+   Cuts the next field off *cursor: up to the next tab, or the next run of
+   spaces when the line has no tabs. Returns NULL at the end of the line.
+*/
+static char *next_field(char **cursor, int tabs) {
+    char *start = *cursor;
+    const char *separators = tabs ? "\t" : " ";
+
+    start += strspn(start, separators);   // Skip leading separators
+    if (*start == '\0') return NULL;
+
+    char *end = start + strcspn(start, separators);
+    *cursor = (*end == '\0') ? end : end + 1;
+    *end = '\0';
+    return start;
+}
+
+// ----------------------------------------
+// Function: manifest_read
+// ----------------------------------------
+int manifest_read(struct manifest *m, const char *filename) {
+    FILE *fp = fopen(filename, "rb");
+    m->entries = NULL;
+    m->count = 0;
+    m->text = NULL;
+    if (fp == NULL) return -1;
+
+    // Read the whole file; entries point into the text
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    rewind(fp);
+    if (size < 0) {
+        fclose(fp);
+        return -1;
+    }
+    m->text = (char *)malloc(size + 1);
+    size_t got = fread(m->text, 1, size, fp);
+    fclose(fp);
+    if (got != (size_t)size) {
+        manifest_free(m);
+        return -1;
+    }
+    m->text[size] = '\0';
+
+    int lines = 1;
+    for (long i = 0; i < size; i++) lines += (m->text[i] == '\n');
+    m->entries = (struct manifest_entry *)malloc(sizeof(struct manifest_entry) * lines);
+
+    char *line = m->text;
+    for (int number = 1; line != NULL; number++) {
+        char *newline = strchr(line, '\n');
+        if (newline != NULL) *newline = '\0';
+        size_t len = strlen(line);
+        if (len > 0 && line[len - 1] == '\r') line[len - 1] = '\0';  // CRLF manifests
+
+        char *cursor = line;
+        int tabs = (strchr(line, '\t') != NULL);
+        char *input = next_field(&cursor, tabs);
+        if (input != NULL && input[0] != '#') {
+            char *size_field = next_field(&cursor, tabs);
+            char *output = next_field(&cursor, tabs);
+            struct manifest_entry *e = &m->entries[m->count];
+            char *x = (size_field != NULL) ? strchr(size_field, 'x') : NULL;
+            if (output == NULL || x == NULL || next_field(&cursor, tabs) != NULL) {
+                fprintf(stderr, "%s:%d: expected 'input WxH output'\n", filename, number);
+                manifest_free(m);
+                return -1;
+            }
+            e->input = input;
+            e->output = output;
+            e->width = strtoul(size_field, NULL, 10);
+            e->height = strtoul(x + 1, NULL, 10);
+            e->line = number;
+            m->count++;
+        }
+        line = (newline != NULL) ? newline + 1 : NULL;
+    }
+    return 0;
+}
+
+// ----------------------------------------
+// Function: manifest_free
+// ----------------------------------------
+void manifest_free(struct manifest *m) {
+    free(m->entries);
+    free(m->text);
+    m->entries = NULL;
+    m->text = NULL;
+    m->count = 0;
+}
+
+// ----------------------------------------
+// Struct: manifest_job
+// ----------------------------------------
+/*
+   State shared by the workers of one manifest_run.
+
+   Fields:
+     m         - the manifest
+     next      - index of the next unclaimed entry (under lock)
+     latency   - per-entry latency in ms (-1 for failed entries)
+     pixels    - input pixels of the images carved
+     failures  - entries that failed
+     report    - where results are printed (under lock)
+     opts      - options every worker's carving context is made with
+*/
+struct manifest_job {
+    const struct manifest *m;
+    struct carve_opts opts;
+    int next;
+    double *latency;
+    double pixels;
+    int failures;
+    FILE *report;
+    pthread_mutex_t lock;
+};
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+// ----------------------------------------
+// Helper: manifest_worker
+// ----------------------------------------
+/*
+   One worker: claims entries until none are left. The carving context is
+   created on the first image and reset for each following one. Columns
+   go in batches (carve_seams) while the height is kept; otherwise
+   carve_step picks the direction of every seam.
+*/
+static void manifest_worker(void *arg, int id, int count) {
+    struct manifest_job *job = (struct manifest_job *)arg;
+    struct carve_ctx ctx;
+    int have_ctx = 0;
+    (void)id;
+    (void)count;
+
+    for (;;) {
+        pthread_mutex_lock(&job->lock);
+        int index = job->next++;
+        pthread_mutex_unlock(&job->lock);
+        if (index >= job->m->count) break;
+
+        const struct manifest_entry *e = &job->m->entries[index];
+        struct rgb_img *im;
+        double start = now_ms();
+        const char *error = NULL;
+        size_t in_width = 0, in_height = 0;
+
+        if (read_in_img(&im, e->input) != 0) {
+            error = "cannot read input";
+        } else {
+            in_width = im->width;
+            in_height = im->height;
+            if (have_ctx) {
+                carve_reset(&ctx, im);
+            } else {
+                carve_init_opts(&ctx, im, &job->opts);
+                have_ctx = 1;
+            }
+            size_t width = (e->width > 0) ? e->width : in_width;
+            size_t height = (e->height > 0) ? e->height : in_height;
+            if (height >= in_height) {
+                while (ctx.im->width > width && carve_seams(&ctx, (int)(ctx.im->width - width)) > 0) {
+                }
+            }
+            while (carve_step(&ctx, width, height) != CARVE_DONE) {
+            }
+            if (write_img(carve_image(&ctx), e->output) != 0) error = "cannot write output";
+        }
+        double ms = now_ms() - start;
+
+        pthread_mutex_lock(&job->lock);
+        if (error != NULL) {
+            fprintf(job->report, "FAIL %s (line %d): %s\n", e->input, e->line, error);
+            job->latency[index] = -1;
+            job->failures++;
+        } else {
+            fprintf(job->report, "%s -> %s  %zux%zu -> %zux%zu  %.2f ms\n", e->input, e->output, in_width,
+                    in_height, ctx.im->width, ctx.im->height, ms);
+            job->latency[index] = ms;
+            job->pixels += (double)in_width * in_height;
+        }
+        pthread_mutex_unlock(&job->lock);
+    }
+
+    if (have_ctx) carve_free(&ctx);
+}
+
+static int compare_doubles(const void *a, const void *b) {
+    double da = *(const double *)a, db = *(const double *)b;
+    return (da > db) - (da < db);
+}
+
+// ----------------------------------------
+// Function: manifest_run
+// ----------------------------------------
+int manifest_run(const struct manifest *m, int workers, const struct carve_opts *opts, FILE *report) {
+    struct manifest_job job;
+    struct thread_pool *pool = (workers > 1) ? pool_create(workers) : NULL;
+
+    job.m = m;
+    if (opts != NULL) job.opts = *opts;
+    else carve_opts_default(&job.opts);
+    job.next = 0;
+    job.latency = (double *)malloc(sizeof(double) * (m->count > 0 ? m->count : 1));
+    job.pixels = 0;
+    job.failures = 0;
+    job.report = report;
+    pthread_mutex_init(&job.lock, NULL);
+
+    double start = now_ms();
+    if (pool == NULL) {
+        manifest_worker(&job, 0, 1);
+    } else {
+        pool_run(pool, manifest_worker, &job);
+    }
+    double seconds = (now_ms() - start) / 1e3;
+
+    // Latency percentiles over the images that succeeded
+    int done = 0;
+    for (int i = 0; i < m->count; i++) {
+        if (job.latency[i] >= 0) job.latency[done++] = job.latency[i];
+    }
+    qsort(job.latency, done, sizeof(double), compare_doubles);
+
+    fprintf(report, "%d images (%d failed) on %d workers in %.3f s: %.2f images/s, %.2f Mpix/s\n", m->count,
+            job.failures, pool_size(pool), seconds, seconds > 0 ? done / seconds : 0.0,
+            seconds > 0 ? job.pixels / seconds / 1e6 : 0.0);
+    if (done > 0) {
+        fprintf(report, "latency ms: p50 %.2f  p90 %.2f  max %.2f\n", job.latency[done / 2],
+                job.latency[(done * 9 + 9) / 10 - 1], job.latency[done - 1]);
+    }
+
+    pthread_mutex_destroy(&job.lock);
+    free(job.latency);
+    pool_destroy(pool);
+    return job.failures;
+}
@@ -0,0 +1,78 @@
+/*
+Batch Manifest Header File
+Author: Tannaz Chowdhury
+GitHub: TannazC
+Date: 2025
+
+Declares the batch runner: carving many images listed in a manifest in
+one process, on a fixed number of worker threads. Each worker keeps one
+carving context and moves it from image to image with carve_reset, so
+its energy map, DP tables and seam paths are allocated once (growing only
+for a larger image) and memory is bounded by the number of workers times
+the largest image.
+
+Manifest files hold one job per line:
+    input.bin  WxH  output.bin
+separated by tabs (so file names may contain spaces) or, when a line has
+no tab, by spaces. W or H may be 0 to keep that dimension. Blank lines
+and lines starting with '#' are ignored.
+*/
+
+#ifndef SEAM_MANIFEST_H         // Include guard - prevents multiple includes
+#define SEAM_MANIFEST_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+struct carve_opts;              // From seamcarving.h
+
+// ----------------------------------------
+// Struct: manifest / manifest_entry
+// ----------------------------------------
+/*
+   A parsed manifest. Entry strings point into text.
+
+   Fields:
+     input, output - file names
+     width, height - target size (0 keeps the input's size)
+     line          - line number in the manifest, for messages
+*/
+struct manifest_entry {
+    char *input;
+    char *output;
+    size_t width;
+    size_t height;
+    int line;
+};
+
+struct manifest {
+    struct manifest_entry *entries;
+    int count;
+    char *text;
+};
+
+// ----------------------------------------
+// Function: manifest_read / manifest_free
+// ----------------------------------------
+/*
+   manifest_read loads and parses a manifest. Returns 0, or -1 if the file
+   cannot be read or a line is malformed (reported on stderr).
+*/
+int manifest_read(struct manifest *m, const char *filename);
+void manifest_free(struct manifest *m);
+
+// ----------------------------------------
+// Function: manifest_run
+// ----------------------------------------
+/*
+   Carves every entry with `workers` threads, printing one line per image
+   with its latency to report as it finishes, then a summary with
+   throughput and latency percentiles. Every worker's context is made
+   with opts (NULL for the defaults): energy, planar and pyramid apply to
+   every image, opts->threads threads carve each one (so up to workers x
+   threads run at once), and batch applies while only columns are
+   removed. Returns the number of entries that failed.
+*/
+int manifest_run(const struct manifest *m, int workers, const struct carve_opts *opts, FILE *report);
+
+#endif  // End of include guard for SEAM_MANIFEST_H
@@ -0,0 +1,188 @@
+/*
+Seam Mask Implementation
+Author: Tannaz Chowdhury
+GitHub: TannazC
+Date: 2025
+
+Allocation, painting and carving of 2-bit seam masks, and the weights the
+DP gives their codes.
+*/
+
+#include <stdlib.h>           // Required for malloc, calloc, free
+#include <string.h>           // Required for memset
+#include "seam_mask.h"        // Header for the mask declarations
+#include "carve_stats.h"      // Allocation counter and removal timer
+
+#define MASK_PER_WORD 32      // 2-bit codes per 64-bit word
+
+// ----------------------------------------
+// Function: create_mask / destroy_mask
+// ----------------------------------------
+void create_mask(struct seam_mask **mask, size_t height, size_t width) {
+    struct seam_mask *m = (struct seam_mask *)malloc(sizeof(struct seam_mask));
+    m->height = height;
+    m->width = width;
+    m->words = (width + MASK_PER_WORD - 1) / MASK_PER_WORD;
+    m->bits = (uint64_t *)calloc(height * m->words + 1, sizeof(uint64_t));  // All neutral
+    memset(m->count, 0, sizeof(m->count));
+    m->count[MASK_NEUTRAL] = height * width;
+    STATS_ADD(bytes_allocated, sizeof(uint64_t) * height * m->words);
+    *mask = m;
+}
+
+void destroy_mask(struct seam_mask *mask) {
+    if (mask == NULL) return;
+    free(mask->bits);
+    free(mask);
+}
+
+// ----------------------------------------
+// Function: set_mask
+// ----------------------------------------
+void set_mask(struct seam_mask *mask, int y, int x, int code) {
+    uint64_t *word = mask->bits + (size_t)y * mask->words + (x >> 5);
+    int shift = 2 * (x & 31);
+    mask->count[(*word >> shift) & 3]--;
+    *word = (*word & ~(3ULL << shift)) | ((uint64_t)code << shift);
+    mask->count[code]++;
+}
+
+// ----------------------------------------
+// Function: mask_from_img
+// ----------------------------------------
+void mask_from_img(const struct rgb_img *im, struct seam_mask **mask) {
+    create_mask(mask, im->height, im->width);
+    for (size_t y = 0; y < im->height; y++) {
+        const uint8_t *row = im->raster + 3 * y * im->stride;
+        for (size_t x = 0; x < im->width; x++) {
+            int red = row[3 * x] >= 128, green = row[3 * x + 1] >= 128, blue = row[3 * x + 2] >= 128;
+            if (red && !green && !blue) set_mask(*mask, (int)y, (int)x, MASK_REMOVE);
+            else if (green && !red && !blue) set_mask(*mask, (int)y, (int)x, MASK_PROTECT);
+        }
+    }
+}
+
+// ----------------------------------------
+// Function: mask_remove_seam
+// ----------------------------------------
+/*
+   In the seam's word, the codes above it move down one place and the
+   lowest code of the next word comes in at the top; every later word in
+   use then shifts down by one code, taking its top from the word after.
+*/
+void mask_remove_seam(struct seam_mask *mask, const int *path) {
+    STATS_START(timer);
+    size_t used = (mask->width + MASK_PER_WORD - 1) / MASK_PER_WORD;  // Words holding codes
+
+    for (size_t y = 0; y < mask->height; y++) {
+        uint64_t *row = mask->bits + y * mask->words;
+        int x = path[y];
+        size_t w = (size_t)x >> 5;
+        int shift = 2 * (x & 31);
+        uint64_t word = row[w];
+
+        mask->count[(word >> shift) & 3]--;
+        uint64_t low = word & ((1ULL << shift) - 1);               // Codes left of the seam
+        uint64_t high = (shift == 62) ? 0 : (word >> (shift + 2)) << shift;
+        uint64_t next = (w + 1 < used) ? row[w + 1] : 0;
+        row[w] = low | high | (next << 62);
+        for (size_t i = w + 1; i < used; i++) {
+            uint64_t after = (i + 1 < used) ? row[i + 1] : 0;
+            row[i] = (row[i] >> 2) | (after << 62);
+        }
+    }
+    mask->width--;
+    STATS_STOP(timer, STAGE_REMOVE, mask->height);
+}
+
+// ----------------------------------------
+// Function: mask_remove_hseam
+// ----------------------------------------
+/*
+   Row y takes row y + 1's code in every column whose seam is at or above
+   y. The columns that move are gathered into a select mask of the row's
+   words, so each row is merged a word at a time.
+*/
+void mask_remove_hseam(struct seam_mask *mask, const int *path) {
+    STATS_START(timer);
+    size_t used = (mask->width + MASK_PER_WORD - 1) / MASK_PER_WORD;
+    int top = (int)mask->height;                         // Highest row the seam reaches
+
+    for (size_t x = 0; x < mask->width; x++) {
+        mask->count[get_mask(mask, path[x], (int)x)]--;
+        if (path[x] < top) top = path[x];
+    }
+    for (size_t y = (size_t)top; y + 1 < mask->height; y++) {
+        uint64_t *row = mask->bits + y * mask->words;
+        const uint64_t *below = row + mask->words;
+        for (size_t i = 0; i < used; i++) {
+            uint64_t select = 0;
+            size_t end = (i + 1) * MASK_PER_WORD;
+            if (end > mask->width) end = mask->width;
+            for (size_t x = i * MASK_PER_WORD; x < end; x++) {
+                if ((size_t)path[x] <= y) select |= 3ULL << (2 * (x & 31));
+            }
+            row[i] = (row[i] & ~select) | (below[i] & select);
+        }
+    }
+    mask->height--;
+    STATS_STOP(timer, STAGE_REMOVE, mask->width);
+}
+
+// ----------------------------------------
+// Function: mask_tally
+// ----------------------------------------
+void mask_tally(const struct seam_mask *mask, const int *path, int horizontal, size_t count[MASK_CODES]) {
+    memset(count, 0, sizeof(size_t) * MASK_CODES);
+    if (horizontal) {
+        for (size_t x = 0; x < mask->width; x++) count[get_mask(mask, path[x], (int)x)]++;
+    } else {
+        for (size_t y = 0; y < mask->height; y++) count[get_mask(mask, (int)y, path[y])]++;
+    }
+}
+
+// ----------------------------------------
+// Function: mask_extent
+// ----------------------------------------
+void mask_extent(const struct seam_mask *mask, int code, size_t *rows, size_t *columns) {
+    uint8_t *seen = (uint8_t *)calloc(mask->width + 1, 1);   // Columns holding the code
+    *rows = 0;
+    *columns = 0;
+    for (size_t y = 0; y < mask->height; y++) {
+        int found = 0;
+        for (size_t x = 0; x < mask->width; x++) {
+            if (get_mask(mask, (int)y, (int)x) != code) continue;
+            found = 1;
+            if (!seen[x]) (*columns)++;
+            seen[x] = 1;
+        }
+        *rows += found;
+    }
+    free(seen);
+}
+
+// ----------------------------------------
+// Function: mask_weights
+// ----------------------------------------
+/*
+   limit is the largest cost of one pixel that keeps a whole seam within
+   32 bits. P is strict when a pixel costing R + max_cost, summed over
+   length + 1 pixels, stays within limit, which bounds R by `room`.
+*/
+void mask_weights(size_t length, uint32_t max_cost, uint32_t weight[MASK_CODES]) {
+    uint64_t cells = (length > 0) ? length : 1;
+    uint64_t limit = UINT32_MAX / cells;
+    uint64_t room = limit / (cells + 1);
+    uint64_t strict = cells * max_cost + 1;             // More than a whole seam's energy
+    uint64_t neutral;
+
+    if (room >= strict + max_cost) neutral = strict;        // Both strict
+    else if (room > 2 * (uint64_t)max_cost) neutral = room - max_cost;  // Protection strict
+    else neutral = max_cost + 1;                            // Tall images: preferences only
+    uint64_t protect = (limit > neutral + max_cost) ? limit - max_cost : neutral;
+
+    weight[MASK_NEUTRAL] = (uint32_t)neutral;
+    weight[MASK_PROTECT] = (uint32_t)protect;
+    weight[MASK_REMOVE] = 0;
+    weight[3] = (uint32_t)neutral;
+}
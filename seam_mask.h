@@ -0,0 +1,147 @@
+/*
+Seam Mask Header File
+Author: Tannaz Chowdhury
+GitHub: TannazC
+Date: 2025
+
+Declares a per-pixel mask that steers the seams: protected pixels (faces,
+logos) are avoided and pixels marked for removal (an object) are sought
+out. Each pixel takes 2 bits, 32 pixels to a 64-bit word, so a mask is a
+quarter of a byte per pixel, like the DP's parent codes. The mask is
+carved together with its image, one seam at a time, and keeps a count of
+each kind of pixel, so an object removal knows when the object is gone.
+
+The mask is not a pass over the energy map: the compact DP (seam_dp.h)
+adds each pixel's mask weight to its cost inside the recurrence. The
+weights (mask_weights) rank seams first by the protected pixels they
+cross (fewer wins), then by the pixels marked for removal (more wins),
+then by energy, as far as 32-bit seam costs have room for.
+*/
+
+#ifndef SEAM_MASK_H             // Include guard - prevents multiple includes
+#define SEAM_MASK_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "c_img.h"              // Required for struct rgb_img definitions
+
+// Mask codes, one per pixel
+#define MASK_NEUTRAL  0         // Plain pixel
+#define MASK_PROTECT  1         // Keep: seams avoid it
+#define MASK_REMOVE   2         // Remove: seams seek it out
+#define MASK_CODES    4         // Codes a 2-bit entry can hold (3 counts as neutral)
+
+#define MASK_MAX_ENERGY  255    // Largest cost of one pixel in an energy map
+#define MASK_MAX_FORWARD 1530   // Largest forward-energy cost of one move (2 * 3 * 255)
+
+// ----------------------------------------
+// Struct: seam_mask
+// ----------------------------------------
+/*
+   Fields:
+     bits   - the codes: row y starts at bits + y * words, pixel x is bits
+              2x mod 64 of its word x / 32
+     height - number of rows
+     width  - number of columns in use
+     words  - 64-bit words per row; fixed while the mask is carved
+     count  - pixels of each code in the mask's current area
+*/
+struct seam_mask {
+    uint64_t *bits;
+    size_t height;
+    size_t width;
+    size_t words;
+    size_t count[MASK_CODES];
+};
+
+// ----------------------------------------
+// Function: create_mask / destroy_mask
+// ----------------------------------------
+/*
+   create_mask allocates a height x width mask of neutral pixels;
+   destroy_mask frees it.
+*/
+void create_mask(struct seam_mask **mask, size_t height, size_t width);
+void destroy_mask(struct seam_mask *mask);
+
+// ----------------------------------------
+// Function: mask_from_img
+// ----------------------------------------
+/*
+   Makes a mask from a painted image of the same size: mostly red pixels
+   (red at least 128, green and blue below) are marked for removal, mostly
+   green ones (green at least 128, red and blue below) are protected and
+   everything else is neutral. Any .bin image can serve as a mask file.
+*/
+void mask_from_img(const struct rgb_img *im, struct seam_mask **mask);
+
+// ----------------------------------------
+// Function: mask_row / get_mask / set_mask
+// ----------------------------------------
+/*
+   Start of row y, and the code of pixel (y, x). set_mask keeps the
+   counts up to date.
+*/
+static inline const uint64_t *mask_row(const struct seam_mask *mask, size_t y) {
+    return mask->bits + y * mask->words;
+}
+
+static inline int get_mask(const struct seam_mask *mask, int y, int x) {
+    return (int)((mask_row(mask, y)[x >> 5] >> (2 * (x & 31))) & 3);
+}
+
+void set_mask(struct seam_mask *mask, int y, int x, int code);
+
+// ----------------------------------------
+// Function: mask_remove_seam / mask_remove_hseam
+// ----------------------------------------
+/*
+   Remove a vertical seam (one column per row) or a horizontal seam (one
+   row per column) from the mask, as remove_seam_inplace and
+   remove_hseam_inplace do from the image, and take its pixels off the
+   counts. A vertical seam shifts the words right of it by 2 bits, so a
+   row costs width / 32 word operations.
+*/
+void mask_remove_seam(struct seam_mask *mask, const int *path);
+void mask_remove_hseam(struct seam_mask *mask, const int *path);
+
+// ----------------------------------------
+// Function: mask_tally
+// ----------------------------------------
+/*
+   Counts the codes a seam crosses: path holds a column per row
+   (horizontal 0, height entries) or a row per column (horizontal 1,
+   width entries). count gets MASK_CODES entries.
+*/
+void mask_tally(const struct seam_mask *mask, const int *path, int horizontal, size_t count[MASK_CODES]);
+
+// ----------------------------------------
+// Function: mask_extent
+// ----------------------------------------
+/*
+   The number of rows and of columns holding at least one pixel of the
+   given code (the sides of its bounding box, for a solid region). Zero
+   for both when there is none.
+*/
+void mask_extent(const struct seam_mask *mask, int code, size_t *rows, size_t *columns);
+
+// ----------------------------------------
+// Function: mask_weights
+// ----------------------------------------
+/*
+   The cost the DP adds to a pixel of each code, for seams of `length`
+   pixels whose cost per pixel is at most max_cost (MASK_MAX_ENERGY or
+   MASK_MAX_FORWARD). A removal pixel adds nothing, a neutral one R and a
+   protected one R + P, with a seam of all-protected pixels still within
+   32 bits. Where 32 bits leave room, R is larger than the energy of a
+   whole seam (a seam through more removal pixels always wins; seams of
+   up to about 250 pixels) and P larger than the cost of any seam without
+   protected pixels (a seam crosses one only when every seam must; about
+   2900 pixels for an energy map, 1200 for forward energy). Past that
+   they are as large as the room allows: a strong preference, not a rule.
+   Every seam of an all-neutral mask gains length * R, so it finds the
+   same seams as no mask at all.
+*/
+void mask_weights(size_t length, uint32_t max_cost, uint32_t weight[MASK_CODES]);
+
+#endif  // End of include guard for SEAM_MASK_H
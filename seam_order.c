@@ -0,0 +1,230 @@
+/*
+Seam Order Index Implementation
+Author: Tannaz Chowdhury
+GitHub: TannazC
+Date: 2025
+
+Builds the per-pixel removal order by carving a copy of the image while
+carrying a plane of original column indices along with it (the index
+plane is compacted exactly like the raster), and turns an order map back
+into a carved image of any width with one pass over the original raster.
+*/
+
+#include <stdio.h>            // Required for file IO
+#include <stdlib.h>           // Required for malloc, free
+#include <string.h>           // Required for memcpy, memset, strlen
+#include "seam_order.h"       // Header for the seam order declarations
+#include "seamcarving.h"      // Carving context used to build the order
+#include "seam_batch.h"       // remove_columns for the index plane
+
+// ----------------------------------------
+// Function: seam_order_build
+// ----------------------------------------
+/*
+   Carves down to min_width, one carve_seams call at a time. After each
+   call every removed pixel is looked up in the index plane (to get its
+   original column), stamped with its iteration, and dropped from the
+   index plane.
+*/
+int seam_order_build(struct rgb_img *im, size_t min_width, const struct carve_opts *opts,
+                     struct seam_order *order) {
+    size_t height = im->height;
+    size_t width = im->width;
+    struct rgb_img *copy;
+    struct carve_ctx ctx;
+
+    if (width > SEAM_ORDER_KEPT) return -1;   // Iterations must fit in 16 bits
+    if (min_width < 1) min_width = 1;
+    if (min_width > width) min_width = width;
+
+    order->height = height;
+    order->width = width;
+    order->min_width = min_width;
+    order->order = (uint16_t *)malloc(sizeof(uint16_t) * height * width);
+
+    // Original column of every pixel of the (shrinking) working image
+    uint16_t *index = (uint16_t *)malloc(sizeof(uint16_t) * height * width);
+    for (size_t y = 0; y < height; y++) {
+        for (size_t x = 0; x < width; x++) {
+            index[y * width + x] = (uint16_t)x;
+            order->order[y * width + x] = SEAM_ORDER_KEPT;
+        }
+    }
+
+    create_img(&copy, height, width);
+    for (size_t y = 0; y < height; y++) {
+        memcpy(copy->raster + 3 * y * width, im->raster + 3 * y * im->stride, 3 * width);
+    }
+    carve_init_opts(&ctx, copy, opts);
+    int *cols = (int *)malloc(sizeof(int) * ctx.batch_size);
+
+    size_t current = width;       // Width of the working image
+    int iteration = 0;            // Seams removed so far
+    while (current > min_width) {
+        int removed = carve_seams(&ctx, (int)(current - min_width));
+        if (removed == 0) break;
+
+        for (int s = 0; s < removed; s++) {
+            const int *path = ctx.paths + (size_t)s * height;
+            for (size_t y = 0; y < height; y++) {
+                uint16_t original = index[y * width + path[y]];
+                order->order[y * width + original] = (uint16_t)(iteration + s);
+            }
+        }
+        remove_columns((uint8_t *)index, sizeof(uint16_t) * width, sizeof(uint16_t), height, current,
+                       ctx.paths, removed, cols);
+
+        iteration += removed;
+        current -= removed;
+    }
+
+    free(cols);
+    free(index);
+    carve_free(&ctx);
+    return 0;
+}
+
+// ----------------------------------------
+// Function: seam_order_retarget
+// ----------------------------------------
+/*
+   Keeps the pixels whose seam had not been removed yet after
+   (width - target_width) iterations, copying runs of kept pixels with
+   memcpy.
+*/
+int seam_order_retarget(struct rgb_img *src, const struct seam_order *order, size_t target_width,
+                        struct rgb_img **out) {
+    size_t height = order->height;
+    size_t width = order->width;
+
+    if (target_width < order->min_width || target_width > width) return -1;
+    uint16_t removed = (uint16_t)(width - target_width);  // Keep order >= removed
+
+    create_img(out, height, target_width);
+    for (size_t y = 0; y < height; y++) {
+        const uint16_t *row_order = order->order + y * width;
+        const uint8_t *from = src->raster + 3 * y * src->stride;
+        uint8_t *to = (*out)->raster + 3 * y * (*out)->stride;
+
+        size_t x = 0;
+        while (x < width) {
+            while (x < width && row_order[x] < removed) x++;   // Skip removed pixels
+            size_t run = x;
+            while (x < width && row_order[x] >= removed) x++;  // Extend the kept run
+            memcpy(to, from + 3 * run, 3 * (x - run));
+            to += 3 * (x - run);
+        }
+    }
+    return 0;
+}
+
+// ----------------------------------------
+// Function: seam_order_write
+// ----------------------------------------
+/*
+   Writes the header and then the orders row by row, big-endian.
+*/
+int seam_order_write(const struct seam_order *order, const char *filename) {
+    FILE *fp = fopen(filename, "wb");
+    if (fp == NULL) return -1;
+
+    int failed = write_2bytes(fp, order->height);
+    failed |= write_2bytes(fp, order->width);
+    failed |= write_2bytes(fp, order->min_width);
+
+    uint8_t *row = (uint8_t *)malloc(2 * order->width);
+    for (size_t y = 0; y < order->height; y++) {
+        for (size_t x = 0; x < order->width; x++) {
+            uint16_t v = order->order[y * order->width + x];
+            row[2 * x] = (uint8_t)(v >> 8);       // Higher byte first
+            row[2 * x + 1] = (uint8_t)(v & 0xFF);
+        }
+        if (fwrite(row, 2, order->width, fp) != order->width) failed = -1;
+    }
+    free(row);
+
+    if (fclose(fp) != 0) failed = -1;
+    return failed ? -1 : 0;
+}
+
+// ----------------------------------------
+// Function: valid_order
+// ----------------------------------------
+/*
+   An order map as seam_order_build makes it: min_width <= width, and each
+   row holds every iteration 0 .. width - min_width - 1 exactly once, the
+   rest of its pixels SEAM_ORDER_KEPT. Retargeting then keeps exactly
+   target_width pixels in every row, so a damaged file cannot overrun the
+   output image.
+*/
+static int valid_order(const struct seam_order *order) {
+    if (order->min_width > order->width) return 0;
+    size_t seams = order->width - order->min_width;
+    uint8_t *seen = (uint8_t *)malloc(seams + 1);  // Iterations met in the current row
+    int ok = 1;
+
+    for (size_t y = 0; y < order->height && ok; y++) {
+        const uint16_t *row = order->order + y * order->width;
+        memset(seen, 0, seams + 1);
+        for (size_t x = 0; x < order->width && ok; x++) {
+            if (row[x] == SEAM_ORDER_KEPT) continue;
+            if (row[x] >= seams || seen[row[x]]) ok = 0;  // Out of range or removed twice
+            else seen[row[x]] = 1;
+        }
+        for (size_t i = 0; i < seams && ok; i++) ok = seen[i];  // Every seam took one pixel
+    }
+    free(seen);
+    return ok;
+}
+
+// ----------------------------------------
+// Function: seam_order_read
+// ----------------------------------------
+int seam_order_read(struct seam_order *order, const char *filename) {
+    FILE *fp = fopen(filename, "rb");
+    if (fp == NULL) return -1;
+
+    int height = read_2bytes(fp);
+    int width = read_2bytes(fp);
+    int min_width = read_2bytes(fp);
+    if (height < 0 || width < 0 || min_width < 0) {  // Truncated header
+        fclose(fp);
+        return -1;
+    }
+    order->height = height;
+    order->width = width;
+    order->min_width = min_width;
+    size_t count = order->height * order->width;
+    order->order = (uint16_t *)malloc(sizeof(uint16_t) * count);
+
+    uint8_t *bytes = (uint8_t *)malloc(2 * count);
+    size_t got = fread(bytes, 2, count, fp);
+    for (size_t i = 0; i < count; i++) {
+        order->order[i] = (uint16_t)((bytes[2 * i] << 8) | bytes[2 * i + 1]);
+    }
+    free(bytes);
+    fclose(fp);
+
+    if (got != count || !valid_order(order)) {  // Truncated or damaged file
+        seam_order_free(order);
+        return -1;
+    }
+    return 0;
+}
+
+// ----------------------------------------
+// Function: seam_order_free
+// ----------------------------------------
+void seam_order_free(struct seam_order *order) {
+    free(order->order);
+    order->order = NULL;
+}
+
+// ----------------------------------------
+// Function: seam_order_filename
+// ----------------------------------------
+void seam_order_filename(const char *image, char *name, size_t size) {
+    size_t len = strlen(image);
+    if (len >= 4 && strcmp(image + len - 4, ".bin") == 0) len -= 4;
+    snprintf(name, size, "%.*s.order", (int)len, image);
+}
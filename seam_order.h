@@ -0,0 +1,83 @@
+/*
+Seam Order Index Header File
+Author: Tannaz Chowdhury
+GitHub: TannazC
+Date: 2025
+
+Declares the "carve once, retarget anywhere" index. An image is carved
+down once while recording, for every original pixel, the iteration in
+which its seam was removed. Since every seam takes exactly one pixel from
+each row, keeping the pixels removed at iteration >= n (or never removed)
+gives the image after n seams, for any n, in one linear pass.
+
+Order files (.order) are stored next to the image:
+[2 bytes height][2 bytes width][2 bytes min width][height * width uint16]
+all big-endian like the .bin format.
+*/
+
+#ifndef SEAM_ORDER_H            // Include guard - prevents multiple includes
+#define SEAM_ORDER_H
+
+#include <stdint.h>
+#include "c_img.h"              // Required for struct rgb_img definitions
+
+struct carve_opts;              // From seamcarving.h
+
+#define SEAM_ORDER_KEPT 0xFFFF  // Order of pixels that were never removed
+
+// ----------------------------------------
+// Struct: seam_order
+// ----------------------------------------
+/*
+   Removal order of every pixel of an image.
+
+   Fields:
+     height, width - dimensions of the original image
+     min_width     - width the image was carved down to; retargeting works
+                     for any width from min_width to width
+     order         - height * width removal iterations, row by row
+*/
+struct seam_order {
+    size_t height;
+    size_t width;
+    size_t min_width;
+    uint16_t *order;
+};
+
+// ----------------------------------------
+// Function: seam_order_build
+// ----------------------------------------
+/*
+   Carves a copy of im down to min_width columns and records the removal
+   order of every pixel. opts (may be NULL) selects threads and batch size.
+   Returns 0, or -1 if the image is too wide for 16-bit orders.
+*/
+int seam_order_build(struct rgb_img *im, size_t min_width, const struct carve_opts *opts,
+                     struct seam_order *order);
+
+// ----------------------------------------
+// Function: seam_order_retarget
+// ----------------------------------------
+/*
+   Produces the image carved to target_width (min_width .. width) from the
+   original image and its order map, with one pass over the raster.
+   Returns 0, or -1 if target_width is out of range.
+*/
+int seam_order_retarget(struct rgb_img *src, const struct seam_order *order, size_t target_width,
+                        struct rgb_img **out);
+
+// ----------------------------------------
+// Function: seam_order_write / seam_order_read / seam_order_free
+// ----------------------------------------
+/*
+   Save and load an order map (returns 0, or -1 on I/O or format errors),
+   and free one. seam_order_read rejects a map whose rows do not each hold
+   every iteration below width - min_width once, the other pixels kept. seam_order_filename writes "<image minus .bin>.order"
+   into name (at most size bytes).
+*/
+int seam_order_write(const struct seam_order *order, const char *filename);
+int seam_order_read(struct seam_order *order, const char *filename);
+void seam_order_free(struct seam_order *order);
+void seam_order_filename(const char *image, char *name, size_t size);
+
+#endif  // End of include guard for SEAM_ORDER_H
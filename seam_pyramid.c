@@ -0,0 +1,259 @@
+/*
+Pyramid Seam Search Implementation
+Author: Tannaz Chowdhury
+GitHub: TannazC
+Date: 2025
+
+Coarse-to-fine seam search. Each level is the 2x2 average of the one
+below it (edge rows and columns are repeated when a dimension is odd).
+The coarsest level gets the exact compact DP; every finer level runs the
+DP on a band of columns around twice the coarser seam's column, storing
+costs and parent offsets per band cell only. Comparisons and ties follow
+pick_parent in seam_dp.c (directly above, then up-left, then up-right;
+leftmost minimum in the bottom row), so with a band covering the whole
+image the seam is the exact DP's seam.
+*/
+
+#include <stdint.h>           // Required for UINT32_MAX
+#include "seam_pyramid.h"     // Header for the pyramid search declarations
+#include "seam_arena.h"       // Arena-backed working memory
+#include "carve_stats.h"      // Stage timers and counters
+
+#define BAND_NONE UINT32_MAX  // Cost of a band cell no seam can reach
+
+// ----------------------------------------
+// Function: seam_pyramid_levels
+// ----------------------------------------
+int seam_pyramid_levels(size_t height, size_t width) {
+    int levels = 1;
+    while (levels < PYRAMID_MAX_LEVELS && (width + 1) / 2 >= PYRAMID_MIN_WIDTH &&
+           (height + 1) / 2 >= PYRAMID_MIN_HEIGHT) {
+        height = (height + 1) / 2;
+        width = (width + 1) / 2;
+        levels++;
+    }
+    return levels;
+}
+
+// ----------------------------------------
+// Function: seam_pyramid_bytes / seam_pyramid_init_arena
+// ----------------------------------------
+/*
+   Levels are only set up as far as the capacity itself would use them;
+   a smaller image never needs more.
+*/
+size_t seam_pyramid_bytes(size_t height, size_t width, int band) {
+    size_t bytes = seam_band_bytes(height, band);
+    bytes += 2 * arena_size(sizeof(int) * ((height + 1) / 2));                              // paths
+    int levels = seam_pyramid_levels(height, width);
+    for (int k = 1; k < levels; k++) {
+        height = (height + 1) / 2;
+        width = (width + 1) / 2;
+        bytes += arena_size(height * width);
+    }
+    return bytes;
+}
+
+void seam_pyramid_init_arena(struct seam_pyramid *pyr, size_t height, size_t width, int band,
+                             struct seam_arena *arena) {
+    seam_band_init_arena(pyr, height, band, arena);
+    pyr->max_width = width;
+    pyr->paths[0] = (int *)arena_alloc(arena, sizeof(int) * ((height + 1) / 2));
+    pyr->paths[1] = (int *)arena_alloc(arena, sizeof(int) * ((height + 1) / 2));
+
+    int levels = seam_pyramid_levels(height, width);
+    for (int k = 1; k < levels; k++) {
+        height = (height + 1) / 2;
+        width = (width + 1) / 2;
+        init_energy_map(&pyr->maps[k], (uint8_t *)arena_alloc(arena, height * width), height, width);
+    }
+}
+
+// ----------------------------------------
+// Function: seam_band_bytes / seam_band_init_arena
+// ----------------------------------------
+size_t seam_band_bytes(size_t height, int band) {
+    size_t pitch = 2 * (size_t)band + 2;
+    size_t bytes = arena_size(sizeof(uint32_t) * 2 * pitch) + arena_size(pitch * height);  // cost, back
+    bytes += 2 * arena_size(sizeof(int) * height);                                          // lo, hi
+    return bytes;
+}
+
+void seam_band_init_arena(struct seam_pyramid *pyr, size_t height, int band, struct seam_arena *arena) {
+    pyr->band = band;
+    pyr->max_height = height;
+    pyr->max_width = 0;
+    pyr->band_pitch = 2 * (size_t)band + 2;
+    pyr->cost = (uint32_t *)arena_alloc(arena, sizeof(uint32_t) * 2 * pyr->band_pitch);
+    pyr->back = (int8_t *)arena_alloc(arena, pyr->band_pitch * height);
+    pyr->lo = (int *)arena_alloc(arena, sizeof(int) * height);
+    pyr->hi = (int *)arena_alloc(arena, sizeof(int) * height);
+    pyr->paths[0] = NULL;
+    pyr->paths[1] = NULL;
+}
+
+// ----------------------------------------
+// Helper: downsample
+// ----------------------------------------
+/*
+   dst = 2x2 average of src, rounded; dst's height and width are set to
+   half of src's (rounded up), its stride kept.
+*/
+static void downsample(const struct energy_map *src, struct energy_map *dst) {
+    int height = src->height;
+    int width = src->width;
+    int pairs = width / 2;   // Columns with both neighbours present
+
+    dst->height = (height + 1) / 2;
+    dst->width = (width + 1) / 2;
+    for (int y = 0; y < (int)dst->height; y++) {
+        const uint8_t *r0 = energy_row(src, 2 * y);
+        const uint8_t *r1 = energy_row(src, (2 * y + 1 < height) ? 2 * y + 1 : 2 * y);
+        uint8_t *out = energy_row(dst, y);
+
+        for (int x = 0; x < pairs; x++) {
+            out[x] = (uint8_t)((r0[2 * x] + r0[2 * x + 1] + r1[2 * x] + r1[2 * x + 1] + 2) >> 2);
+        }
+        if (width & 1) {     // Last column on its own
+            out[pairs] = (uint8_t)((2 * r0[width - 1] + 2 * r1[width - 1] + 2) >> 2);
+        }
+    }
+}
+
+// ----------------------------------------
+// Helper: band_dp
+// ----------------------------------------
+/*
+   The DP restricted to columns pyr->lo[y] .. pyr->hi[y] of each row y.
+   The caller makes consecutive bands overlap, so the bottom row has a
+   reachable cell. Writes the seam to path and returns its cost.
+*/
+static uint32_t band_dp(struct seam_pyramid *pyr, const struct energy_map *grad, int *path) {
+    int height = grad->height;
+    size_t pitch = pyr->band_pitch;
+    uint32_t *prev = pyr->cost;          // Costs of the previous row's band
+    uint32_t *cur = pyr->cost + pitch;   // Costs of the band being filled
+
+    const uint8_t *top = energy_row(grad, 0);
+    for (int x = pyr->lo[0]; x <= pyr->hi[0]; x++) {
+        prev[x - pyr->lo[0]] = top[x];
+    }
+
+    for (int y = 1; y < height; y++) {
+        const uint8_t *energy = energy_row(grad, y);
+        int8_t *back = pyr->back + y * pitch;
+        int lo = pyr->lo[y], hi = pyr->hi[y];
+        int plo = pyr->lo[y - 1], phi = pyr->hi[y - 1];
+
+        for (int x = lo; x <= hi; x++) {
+            uint32_t best = (x >= plo && x <= phi) ? prev[x - plo] : BAND_NONE;
+            int offset = 0;
+            if (x - 1 >= plo && x - 1 <= phi && prev[x - 1 - plo] < best) {
+                best = prev[x - 1 - plo];
+                offset = -1;
+            }
+            if (x + 1 >= plo && x + 1 <= phi && prev[x + 1 - plo] < best) {
+                best = prev[x + 1 - plo];
+                offset = 1;
+            }
+            cur[x - lo] = (best == BAND_NONE) ? BAND_NONE : best + energy[x];
+            back[x - lo] = (int8_t)offset;
+        }
+
+        uint32_t *tmp = prev;  // The band just filled becomes the previous one
+        prev = cur;
+        cur = tmp;
+    }
+
+    int lo = pyr->lo[height - 1];
+    int col = lo;
+    for (int x = lo + 1; x <= pyr->hi[height - 1]; x++) {
+        if (prev[x - lo] < prev[col - lo]) col = x;
+    }
+    uint32_t total = prev[col - lo];
+
+    path[height - 1] = col;
+    for (int y = height - 1; y > 0; y--) {
+        col += pyr->back[y * pitch + (col - pyr->lo[y])];
+        path[y - 1] = col;
+    }
+    return total;
+}
+
+// ----------------------------------------
+// Helper: refine
+// ----------------------------------------
+/*
+   Banded DP on grad around the seam `coarse` found on the level above:
+   row y searches columns 2 * coarse[y / 2] - band .. 2 * coarse[y / 2] +
+   band + 1, so consecutive bands always overlap.
+*/
+static uint32_t refine(struct seam_pyramid *pyr, const struct energy_map *grad, const int *coarse, int *path) {
+    int width = grad->width;
+
+    for (int y = 0; y < (int)grad->height; y++) {  // Bands, clipped to the image
+        int centre = 2 * coarse[y / 2];
+        int lo = centre - pyr->band;
+        int hi = centre + 1 + pyr->band;
+        pyr->lo[y] = (lo < 0) ? 0 : lo;
+        pyr->hi[y] = (hi > width - 1) ? width - 1 : hi;
+    }
+    return band_dp(pyr, grad, path);
+}
+
+// ----------------------------------------
+// Function: seam_band_find
+// ----------------------------------------
+/*
+   Row y searches guide[y] - band .. guide[y] + band. A guide that is
+   itself a seam moves at most one column per row, so with band >= 1
+   consecutive bands overlap.
+*/
+uint32_t seam_band_find(struct seam_pyramid *pyr, const struct energy_map *grad, const int *guide, int *path) {
+    STATS_START(timer);
+    int width = grad->width;
+
+    for (int y = 0; y < (int)grad->height; y++) {
+        int lo = guide[y] - pyr->band;
+        int hi = guide[y] + pyr->band;
+        pyr->lo[y] = (lo < 0) ? 0 : lo;
+        pyr->hi[y] = (hi > width - 1) ? width - 1 : hi;
+    }
+    uint32_t cost = band_dp(pyr, grad, path);
+    STATS_STOP(timer, STAGE_DP, grad->height * (2 * (size_t)pyr->band + 1));
+    return cost;
+}
+
+// ----------------------------------------
+// Function: seam_pyramid_find
+// ----------------------------------------
+/*
+   Builds the levels the map's size calls for, runs the exact DP on the
+   coarsest, and refines level by level. Seams of the levels above 0 go to
+   pyr->paths, alternating, so each refinement reads the other buffer.
+*/
+uint32_t seam_pyramid_find(struct seam_pyramid *pyr, struct seam_dp *dp, struct energy_map *grad, int *path) {
+    int levels = seam_pyramid_levels(grad->height, grad->width);
+    if (levels == 1) return seam_dp_find(dp, grad, path);
+
+    STATS_START(build);
+    const struct energy_map *level[PYRAMID_MAX_LEVELS];
+    level[0] = grad;
+    for (int k = 1; k < levels; k++) {
+        downsample(level[k - 1], &pyr->maps[k]);
+        level[k] = &pyr->maps[k];
+    }
+    STATS_STOP(build, STAGE_DP, grad->height * grad->width);
+
+    seam_dp_find(dp, &pyr->maps[levels - 1], pyr->paths[(levels - 1) & 1]);
+
+    STATS_START(timer);
+    uint32_t cost = 0;
+    for (int k = levels - 2; k >= 0; k--) {
+        int *fine = (k == 0) ? path : pyr->paths[k & 1];
+        cost = refine(pyr, level[k], pyr->paths[(k + 1) & 1], fine);
+        STATS_PIXELS(STAGE_DP, level[k]->height * pyr->band_pitch);
+    }
+    STATS_STOP(timer, STAGE_DP, 0);
+    return cost;
+}
@@ -0,0 +1,135 @@
+/*
+Pyramid Seam Search Header File
+Author: Tannaz Chowdhury
+GitHub: TannazC
+Date: 2025
+
+Declares a coarse-to-fine seam search for large images. The energy map is
+averaged down 2x2 into a pyramid of smaller maps; the exact DP runs on the
+smallest one only, and each finer level then runs the same DP restricted
+to a band of columns around the seam found one level up. Work per seam
+drops from a full DP to one pass that builds the pyramid plus
+height * (2 * band + 2) cells per level. The seam is exact inside the band
+but can differ from the full DP's seam; its cost is never lower.
+
+The banded DP is also available on its own (seam_band_find), to follow a
+seam of the previous frame of a sequence (seam_sequence.h).
+*/
+
+#ifndef SEAM_PYRAMID_H          // Include guard - prevents multiple includes
+#define SEAM_PYRAMID_H
+
+#include <stdint.h>
+#include "energy_map.h"         // Energy maps the pyramid is built from
+#include "seam_dp.h"            // Exact DP for the coarsest level
+
+struct seam_arena;              // From seam_arena.h
+
+#define PYRAMID_MAX_LEVELS 4    // Full map plus at most three halvings
+#define PYRAMID_MIN_WIDTH  64   // Coarsest level is at least this wide...
+#define PYRAMID_MIN_HEIGHT 16   // ...and this high
+
+// ----------------------------------------
+// Struct: seam_pyramid
+// ----------------------------------------
+/*
+   Working memory for the pyramid search, sized once for the largest image.
+
+   Fields:
+     band        - columns searched on each side of the upsampled seam
+     max_height, max_width - capacity of level 0 (the caller's map)
+     maps        - levels 1 .. PYRAMID_MAX_LEVELS - 1, each half the size
+                   (rounded up) of the one before; maps[0] is unused
+     cost        - two band rows of cumulative costs (band_pitch entries)
+     back        - parent offset (-1, 0, +1) of every band cell, band_pitch per row
+     lo, hi      - first and last column of each row's band
+     band_pitch  - 2 * band + 2: widest band (the seam moves up to two
+                   columns between rows when upsampled)
+     paths       - two seams of max_height entries, used in turn as the
+                   coarse and the fine seam
+*/
+struct seam_pyramid {
+    int band;
+    size_t max_height;
+    size_t max_width;
+    struct energy_map maps[PYRAMID_MAX_LEVELS];
+    uint32_t *cost;
+    int8_t *back;
+    int *lo;
+    int *hi;
+    size_t band_pitch;
+    int *paths[2];
+};
+
+// ----------------------------------------
+// Function: seam_pyramid_bytes / seam_pyramid_init_arena
+// ----------------------------------------
+/*
+   Sets up the working memory for images up to height x width and the
+   given band inside an arena (there is no free; it goes with the arena),
+   and the arena space that takes: about height * width / 3 bytes for the
+   levels plus height * (2 * band + 2) bytes of parent offsets.
+*/
+size_t seam_pyramid_bytes(size_t height, size_t width, int band);
+void seam_pyramid_init_arena(struct seam_pyramid *pyr, size_t height, size_t width, int band,
+                             struct seam_arena *arena);
+
+// ----------------------------------------
+// Function: seam_band_bytes / seam_band_init_arena
+// ----------------------------------------
+/*
+   The working memory of seam_band_find alone (no pyramid levels), for
+   maps up to height rows and the given band, and the arena space it
+   takes: height * (2 * band + 2) bytes of parent offsets plus a few rows.
+*/
+size_t seam_band_bytes(size_t height, int band);
+void seam_band_init_arena(struct seam_pyramid *pyr, size_t height, int band, struct seam_arena *arena);
+
+// ----------------------------------------
+// Function: seam_band_find
+// ----------------------------------------
+/*
+   Finds the cheapest vertical seam of grad that stays within pyr->band
+   columns of guide (another seam of a map of the same size; band at
+   least 1). The seam is exact inside the band, with seam_dp_find's tie
+   order, so a band as wide as the map gives seam_dp_find's seam.
+
+   Parameters:
+     pyr   - working memory from seam_band_init_arena or seam_pyramid_init_arena
+     grad  - energy map
+     guide - one column per row to search around
+     path  - output: one column index per row (may not alias guide)
+
+   Returns the total energy of the seam, in the units of seam_dp_find.
+*/
+uint32_t seam_band_find(struct seam_pyramid *pyr, const struct energy_map *grad, const int *guide, int *path);
+
+// ----------------------------------------
+// Function: seam_pyramid_levels
+// ----------------------------------------
+/*
+   Number of levels (1 = the full map only) the search uses for a
+   height x width map: halvings continue while the next level is at least
+   PYRAMID_MIN_WIDTH wide and PYRAMID_MIN_HEIGHT high.
+*/
+int seam_pyramid_levels(size_t height, size_t width);
+
+// ----------------------------------------
+// Function: seam_pyramid_find
+// ----------------------------------------
+/*
+   Finds a vertical seam of grad coarse to fine.
+
+   Parameters:
+     pyr  - pyramid working memory, at least grad->height x grad->width
+     dp   - exact DP working memory, at least grad->height x grad->width
+            (used for the coarsest level, or the whole map when it is too
+            small for a pyramid)
+     grad - energy map
+     path - output: one column index per row (grad->height entries)
+
+   Returns the total energy of the seam, in the units of seam_dp_find.
+*/
+uint32_t seam_pyramid_find(struct seam_pyramid *pyr, struct seam_dp *dp, struct energy_map *grad, int *path);
+
+#endif  // End of include guard for SEAM_PYRAMID_H
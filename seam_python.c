@@ -0,0 +1,361 @@
+/*
+Python Binding
+Author: Tannaz Chowdhury
+GitHub: TannazC
+Date: 2025
+
+The `seamcarving` extension module (built by setup.py, or `make python`):
+
+    read(path) -> Image
+    write(image, path, version=1, band_rows=0)
+    carve(image, width=0, height=0, *, inplace=False, threads=1, batch=1,
+          planar=False, pyramid=0, energy="dual") -> Image
+
+`image` is anything exporting a 3-D uint8 buffer of shape (height, width,
+3) with pixels 3 bytes apart: an Image, a NumPy array, a PIL image's
+bytes as memoryview(data).cast("B", (h, w, 3)), and so on. Image exports
+its raster the same way, so numpy.asarray(image) shares its memory.
+
+No pixels are copied on the way in or out. read maps the file (see
+read_in_img), and write writes straight from the caller's buffer. carve
+copies its input once into the image it carves. With inplace=True it
+carves the caller's writable buffer itself and returns a view of it, with
+the row stride kept. The GIL is released while reading, writing and
+carving, so Python threads can carve concurrently.
+*/
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>           // Must come first: sets the feature macros
+#include "c_img.h"            // Images and .bin files
+#include "seamcarving.h"      // Carving context
+#include "seam_insert.h"      // Widening for targets above the width
+
+// ----------------------------------------
+// Type: Image
+// ----------------------------------------
+/*
+   Fields:
+     im      - the image; owned, or borrowed from source
+     source  - the buffer im's raster lives in (inplace carve), or
+               source.obj NULL when im owns its raster
+     shape, strides - buffer layout exported to Python
+*/
+typedef struct {
+    PyObject_HEAD
+    struct rgb_img *im;
+    Py_buffer source;
+    Py_ssize_t shape[3];
+    Py_ssize_t strides[3];
+} ImageObject;
+
+static PyTypeObject ImageType;
+
+// ----------------------------------------
+// Helper: wrap_image
+// ----------------------------------------
+/*
+   New Image around im, taking ownership of it (and of source, if given).
+   On failure im is freed and source released.
+*/
+static PyObject *wrap_image(struct rgb_img *im, Py_buffer *source) {
+    ImageObject *self = PyObject_New(ImageObject, &ImageType);
+    if (self == NULL) {
+        if (source != NULL) {
+            PyBuffer_Release(source);
+            free(im);
+        } else {
+            destroy_image(im);
+        }
+        return NULL;
+    }
+    self->im = im;
+    if (source != NULL) self->source = *source;
+    else self->source.obj = NULL;
+    self->shape[0] = (Py_ssize_t)im->height;
+    self->shape[1] = (Py_ssize_t)im->width;
+    self->shape[2] = 3;
+    self->strides[0] = (Py_ssize_t)(3 * im->stride);
+    self->strides[1] = 3;
+    self->strides[2] = 1;
+    return (PyObject *)self;
+}
+
+static void image_dealloc(ImageObject *self) {
+    if (self->source.obj != NULL) {
+        PyBuffer_Release(&self->source);    // The raster was the caller's
+        free(self->im);
+    } else {
+        destroy_image(self->im);
+    }
+    PyObject_Free(self);
+}
+
+// ----------------------------------------
+// Helper: image_getbuffer
+// ----------------------------------------
+/*
+   Exports the raster as (height, width, 3) bytes. A consumer that asks
+   for plain bytes (PyBUF_SIMPLE, e.g. PIL's frombuffer) gets the rows
+   3 * stride bytes apart, padding included, which is exactly the pixels
+   when the rows are packed (a borrowed raster ends at the last pixel,
+   as the caller's buffer may). A shaped request without strides needs
+   packed rows.
+*/
+static int image_getbuffer(ImageObject *self, Py_buffer *view, int flags) {
+    struct rgb_img *im = self->im;
+    int strided = (flags & PyBUF_STRIDES) == PyBUF_STRIDES;
+    int shaped = (flags & PyBUF_ND) == PyBUF_ND;
+
+    if (shaped && !strided && im->stride != im->width) {
+        PyErr_SetString(PyExc_BufferError, "image rows are padded; a strided buffer is needed");
+        view->obj = NULL;
+        return -1;
+    }
+    view->buf = im->raster;
+    view->obj = (PyObject *)self;
+    Py_INCREF(self);
+    size_t pixels = im->height * (shaped ? im->width : im->stride);
+    if (!shaped && self->source.obj != NULL && im->height > 0) pixels -= im->stride - im->width;
+    view->len = (Py_ssize_t)(3 * pixels);
+    view->readonly = 0;
+    view->itemsize = 1;
+    view->format = (flags & PyBUF_FORMAT) ? "B" : NULL;
+    view->ndim = shaped ? 3 : 1;
+    view->shape = shaped ? self->shape : NULL;
+    view->strides = strided ? self->strides : NULL;
+    view->suboffsets = NULL;
+    view->internal = NULL;
+    return 0;
+}
+
+static PyBufferProcs image_as_buffer = {(getbufferproc)image_getbuffer, NULL};
+
+static PyObject *image_get(ImageObject *self, void *field) {
+    size_t value = (field == (void *)0) ? self->im->height : (field == (void *)1) ? self->im->width : self->im->stride;
+    return PyLong_FromSize_t(value);
+}
+
+static PyGetSetDef image_getset[] = {
+    {"height", (getter)image_get, NULL, "rows", (void *)0},
+    {"width", (getter)image_get, NULL, "columns", (void *)1},
+    {"stride", (getter)image_get, NULL, "pixels between the starts of rows", (void *)2},
+    {NULL, NULL, NULL, NULL, NULL}
+};
+
+static PyObject *image_repr(ImageObject *self) {
+    return PyUnicode_FromFormat("<seamcarving.Image %zux%zu, stride %zu>", self->im->width, self->im->height,
+                                self->im->stride);
+}
+
+static PyTypeObject ImageType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = "seamcarving.Image",
+    .tp_basicsize = sizeof(ImageObject),
+    .tp_dealloc = (destructor)image_dealloc,
+    .tp_repr = (reprfunc)image_repr,
+    .tp_as_buffer = &image_as_buffer,
+    .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_doc = "An RGB image carved by the library, exporting its raster as a (height, width, 3) buffer.",
+    .tp_getset = image_getset,
+};
+
+// ----------------------------------------
+// Helper: get_rgb
+// ----------------------------------------
+/*
+   Gets the buffer of obj and sets up im around it, without copying. The
+   buffer must be 3-D uint8 of shape (height, width, 3), with pixels 3
+   bytes apart and rows a whole number of pixels apart. Returns 0, or -1
+   with an exception set (and nothing to release).
+*/
+static int get_rgb(PyObject *obj, Py_buffer *view, struct rgb_img *im, int writable) {
+    if (PyObject_GetBuffer(obj, view, PyBUF_STRIDES | PyBUF_FORMAT | (writable ? PyBUF_WRITABLE : 0)) != 0) {
+        return -1;
+    }
+    int ok = view->ndim == 3 && view->itemsize == 1 && view->shape[2] == 3 &&
+             (view->format == NULL || strcmp(view->format, "B") == 0 || strcmp(view->format, "=B") == 0) &&
+             view->strides[2] == 1 && view->strides[1] == 3 && view->strides[0] >= 3 * view->shape[1] &&
+             view->strides[0] % 3 == 0;
+    if (!ok) {
+        PyErr_SetString(PyExc_ValueError, "expected uint8 pixels of shape (height, width, 3), rows in order");
+        PyBuffer_Release(view);
+        return -1;
+    }
+    init_img(im, (uint8_t *)view->buf, (size_t)view->shape[0], (size_t)view->shape[1]);
+    im->stride = (size_t)view->strides[0] / 3;
+    return 0;
+}
+
+// ----------------------------------------
+// Function: read
+// ----------------------------------------
+static PyObject *py_read(PyObject *module, PyObject *args) {
+    PyObject *path;
+    struct rgb_img *im;
+    int failed;
+    (void)module;
+
+    if (!PyArg_ParseTuple(args, "O&:read", PyUnicode_FSConverter, &path)) return NULL;
+    Py_BEGIN_ALLOW_THREADS
+    failed = read_in_img(&im, PyBytes_AS_STRING(path));
+    Py_END_ALLOW_THREADS
+    if (failed) {
+        PyErr_Format(PyExc_OSError, "cannot read %s", PyBytes_AS_STRING(path));
+        Py_DECREF(path);
+        return NULL;
+    }
+    Py_DECREF(path);
+    return wrap_image(im, NULL);
+}
+
+// ----------------------------------------
+// Function: write
+// ----------------------------------------
+static PyObject *py_write(PyObject *module, PyObject *args, PyObject *kwargs) {
+    static char *keywords[] = {"image", "path", "version", "band_rows", NULL};
+    PyObject *obj, *path;
+    Py_buffer view;
+    struct rgb_img im;
+    int version = 1, failed;
+    Py_ssize_t band_rows = 0;
+    (void)module;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OO&|in:write", keywords, &obj, PyUnicode_FSConverter, &path,
+                                     &version, &band_rows)) {
+        return NULL;
+    }
+    if ((version != 1 && version != 2) || band_rows < 0 || (version == 1 && band_rows > 0)) {
+        PyErr_SetString(PyExc_ValueError, "version must be 1 or 2, and only v2 has bands");
+        Py_DECREF(path);
+        return NULL;
+    }
+    if (get_rgb(obj, &view, &im, 0) != 0) {
+        Py_DECREF(path);
+        return NULL;
+    }
+    Py_BEGIN_ALLOW_THREADS
+    if (version == 1) failed = write_img(&im, PyBytes_AS_STRING(path));  // v2 anyway past 65535
+    else failed = write_img_v2(&im, PyBytes_AS_STRING(path), (size_t)band_rows);
+    Py_END_ALLOW_THREADS
+    PyBuffer_Release(&view);
+    if (failed) {
+        PyErr_Format(PyExc_OSError, "cannot write %s", PyBytes_AS_STRING(path));
+        Py_DECREF(path);
+        return NULL;
+    }
+    Py_DECREF(path);
+    Py_RETURN_NONE;
+}
+
+// ----------------------------------------
+// Function: carve
+// ----------------------------------------
+/*
+   Carves to width x height (0 keeps a side) as --target does: a width
+   above the image's is reached by seam insertion, then carve_step
+   removes the cheaper seam per pixel until the image fits. With only
+   columns to remove, carve_seams honours the batch option.
+*/
+static PyObject *py_carve(PyObject *module, PyObject *args, PyObject *kwargs) {
+    static char *keywords[] = {"image", "width", "height", "inplace", "threads", "batch", "planar", "pyramid",
+                               "energy", NULL};
+    PyObject *obj;
+    Py_buffer view;
+    struct rgb_img source, *im;
+    struct carve_opts opts;
+    struct carve_ctx ctx;
+    Py_ssize_t width = 0, height = 0;
+    int inplace = 0, planar = 0;
+    const char *energy = "dual";
+    (void)module;
+
+    carve_opts_default(&opts);
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|nn$piipis:carve", keywords, &obj, &width, &height, &inplace,
+                                     &opts.threads, &opts.batch, &planar, &opts.pyramid, &energy)) {
+        return NULL;
+    }
+    opts.planar = planar;
+    opts.energy = energy_parse(energy);
+    if (opts.energy < 0) {
+        PyErr_Format(PyExc_ValueError, "unknown energy '%s' (dual, l1 or forward)", energy);
+        return NULL;
+    }
+    if (get_rgb(obj, &view, &source, inplace) != 0) return NULL;
+
+    size_t target_width = (width > 0) ? (size_t)width : source.width;
+    size_t target_height = (height > 0) ? (size_t)height : source.height;
+    const char *error = NULL;
+    if (width < 0 || height < 0) error = "width and height must not be negative";
+    else if (target_height > source.height) error = "rows can only be removed";
+    else if (inplace && target_width > source.width) error = "an image cannot be widened in place";
+    else if (source.width == 0 || source.height == 0) error = "the image is empty";
+    if (error != NULL) {
+        PyErr_SetString(PyExc_ValueError, error);
+        PyBuffer_Release(&view);
+        return NULL;
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    if (inplace) {
+        im = (struct rgb_img *)malloc(sizeof(struct rgb_img));  // Borrows the caller's raster
+        *im = source;
+    } else {
+        im = copy_img(&source);
+    }
+    if (target_width > im->width) {                             // Widen first, in one pass
+        struct rgb_img *wide;
+        seam_insert(im, (int)(target_width - im->width), NULL, &wide);
+        destroy_image(im);
+        im = wide;
+    }
+    carve_init_opts(&ctx, im, &opts);
+    if (target_height == ctx.im->height) {
+        while (ctx.im->width > target_width && carve_seams(&ctx, (int)(ctx.im->width - target_width)) > 0) {
+        }
+    } else {
+        while (carve_step(&ctx, target_width, target_height) != CARVE_DONE) {
+        }
+    }
+    im = carve_detach(&ctx);
+    Py_END_ALLOW_THREADS
+
+    if (inplace) return wrap_image(im, &view);  // The view keeps the caller's buffer alive
+    PyBuffer_Release(&view);
+    return wrap_image(im, NULL);
+}
+
+// ----------------------------------------
+// Module definition
+// ----------------------------------------
+static PyMethodDef seam_methods[] = {
+    {"read", (PyCFunction)py_read, METH_VARARGS,
+     "read(path) -> Image\nReads a .bin file (v1 or v2); regular files are memory-mapped."},
+    {"write", (PyCFunction)(void (*)(void))py_write, METH_VARARGS | METH_KEYWORDS,
+     "write(image, path, version=1, band_rows=0)\nWrites an RGB buffer as a .bin file; version 2 "
+     "pads rows to 64 bytes and can store bands of band_rows rows (version 1 switches to 2 past 65535 pixels)."},
+    {"carve", (PyCFunction)(void (*)(void))py_carve, METH_VARARGS | METH_KEYWORDS,
+     "carve(image, width=0, height=0, *, inplace=False, threads=1, batch=1, planar=False, pyramid=0, "
+     "energy=\"dual\") -> Image\n"
+     "Carves an RGB buffer to width x height (0 keeps a side; a larger width inserts seams). inplace=True "
+     "carves the caller's writable buffer and returns a view of it. energy is \"dual\", \"l1\" (cheaper) "
+     "or \"forward\" (forward energy)."},
+    {NULL, NULL, 0, NULL}
+};
+
+static struct PyModuleDef seam_module = {
+    PyModuleDef_HEAD_INIT, "seamcarving", "Seam carving on RGB buffers, without copies.", -1, seam_methods,
+    NULL, NULL, NULL, NULL
+};
+
+PyMODINIT_FUNC PyInit_seamcarving(void) {
+    if (PyType_Ready(&ImageType) < 0) return NULL;
+    PyObject *module = PyModule_Create(&seam_module);
+    if (module == NULL) return NULL;
+    Py_INCREF(&ImageType);
+    if (PyModule_AddObject(module, "Image", (PyObject *)&ImageType) < 0) {
+        Py_DECREF(&ImageType);
+        Py_DECREF(module);
+        return NULL;
+    }
+    return module;
+}
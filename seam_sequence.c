@@ -0,0 +1,397 @@
+/*
+Frame Sequence Implementation
+Author: Tannaz Chowdhury
+GitHub: TannazC
+Date: 2025
+
+Carries the energy map and the seams of one frame over to the next. The
+reference frame only takes a new pixel value where the frame changed
+beyond the threshold, and the energy of exactly the pixels around those
+is recomputed from it, so the kept map is always calc_energy of the
+reference (sub-threshold drift adds up until it crosses the threshold).
+The carve itself reads the real frame's pixels.
+*/
+
+#define _POSIX_C_SOURCE 200809L  // For clock_gettime under -std=c99
+
+#include <stdio.h>            // Required for file IO
+#include <stdlib.h>           // Required for malloc, free, abs
+#include <string.h>           // Required for memcpy
+#include <time.h>             // Required for clock_gettime
+#include <pthread.h>          // Required for the read and write threads
+#include "seam_sequence.h"    // Header for the sequence declarations
+#include "energy_simd.h"      // Row kernels and single-pixel energy
+#include "energy_map.h"       // Energy maps
+
+// ----------------------------------------
+// Function: seam_sequence_init / seam_sequence_free
+// ----------------------------------------
+void seam_sequence_init(struct seam_sequence *seq, size_t height, size_t width, int seams, int band,
+                        int threshold, int keyframe, const struct carve_opts *opts) {
+    memset(seq, 0, sizeof(*seq));
+    seq->height = height;
+    seq->width = width;
+    seq->seams = (seams > (int)width - 1) ? (int)width - 1 : seams;
+    seq->band = (band < 1) ? 1 : band;
+    seq->threshold = threshold;
+    seq->keyframe = keyframe;
+    if (opts != NULL) seq->opts = *opts;
+    else carve_opts_default(&seq->opts);
+    if (seq->opts.energy == ENERGY_FORWARD) seq->opts.energy = ENERGY_DUAL;  // Tracking needs a map
+
+    create_img(&seq->ref, height, width);
+    create_energy_map(&seq->base, height, width);
+    seq->base->energy = seq->opts.energy;
+    seq->changed = (uint8_t *)malloc(height * width);
+    seq->paths = (int *)malloc(sizeof(int) * height * (seq->seams > 0 ? seq->seams : 1));
+    arena_init(&seq->arena, seam_band_bytes(height, seq->band));
+    seam_band_init_arena(&seq->near, height, seq->band, &seq->arena);
+}
+
+void seam_sequence_free(struct seam_sequence *seq) {
+    if (seq->started) carve_free(&seq->ctx);
+    arena_free(&seq->arena);
+    free(seq->paths);
+    free(seq->changed);
+    destroy_energy_map(seq->base);
+    destroy_image(seq->ref);
+}
+
+// ----------------------------------------
+// Helper: mark_changes
+// ----------------------------------------
+/*
+   Flags every pixel of frame that differs from the reference by more than
+   the threshold in some channel, and copies those pixels into the
+   reference. Returns the number flagged.
+*/
+static size_t mark_changes(struct seam_sequence *seq, const struct rgb_img *frame) {
+    size_t count = 0;
+    int threshold = seq->threshold;
+
+    for (size_t y = 0; y < seq->height; y++) {
+        const uint8_t *from = frame->raster + 3 * y * frame->stride;
+        uint8_t *ref = seq->ref->raster + 3 * y * seq->ref->stride;
+        uint8_t *flags = seq->changed + y * seq->width;
+        for (size_t x = 0; x < seq->width; x++) {
+            int d0 = abs(from[3 * x] - ref[3 * x]);
+            int d1 = abs(from[3 * x + 1] - ref[3 * x + 1]);
+            int d2 = abs(from[3 * x + 2] - ref[3 * x + 2]);
+            flags[x] = (d0 > threshold) | (d1 > threshold) | (d2 > threshold);
+            if (flags[x]) {
+                memcpy(ref + 3 * x, from + 3 * x, 3);
+                count++;
+            }
+        }
+    }
+    return count;
+}
+
+// ----------------------------------------
+// Helper: update_base
+// ----------------------------------------
+/*
+   Recomputes the energy of every pixel whose own value or one of its four
+   (wrapped) neighbours was flagged by mark_changes. A row with many such
+   pixels is recomputed whole with the row kernel; otherwise pixel by
+   pixel. Rows with nothing flagged at or next to them are skipped.
+   Returns the number of energy values recomputed.
+*/
+static size_t update_base(struct seam_sequence *seq) {
+    int height = seq->height, width = seq->width;
+    energy_row_fn kernel = energy_kernel_as(seq->base->energy);
+    size_t recomputed = 0;
+
+    for (int y = 0; y < height; y++) {
+        int above = (y == 0) ? height - 1 : y - 1;
+        int below = (y == height - 1) ? 0 : y + 1;
+        const uint8_t *up = seq->changed + (size_t)above * width;
+        const uint8_t *mid = seq->changed + (size_t)y * width;
+        const uint8_t *down = seq->changed + (size_t)below * width;
+        const uint8_t *rows[3] = {seq->ref->raster + 3 * (size_t)above * seq->ref->stride,
+                                  seq->ref->raster + 3 * (size_t)y * seq->ref->stride,
+                                  seq->ref->raster + 3 * (size_t)below * seq->ref->stride};
+        uint8_t *out = energy_row(seq->base, y);
+
+        int dirty = 0;
+        for (int x = 0; x < width; x++) {
+            int left = (x == 0) ? width - 1 : x - 1;
+            int right = (x == width - 1) ? 0 : x + 1;
+            dirty += up[x] | down[x] | mid[left] | mid[x] | mid[right];
+        }
+        if (dirty == 0) continue;
+        recomputed += dirty;
+        if (dirty > width / 4) {  // Cheaper as one kernel call
+            kernel(rows[0], rows[1], rows[2], width, out);
+            continue;
+        }
+        for (int x = 0; x < width; x++) {
+            int left = (x == 0) ? width - 1 : x - 1;
+            int right = (x == width - 1) ? 0 : x + 1;
+            if (up[x] | down[x] | mid[left] | mid[x] | mid[right]) {
+                out[x] = energy_pixel_as(rows[0], rows[1], rows[2], width, x, seq->base->energy);
+            }
+        }
+    }
+    return recomputed;
+}
+
+// ----------------------------------------
+// Helper: copy_rows
+// ----------------------------------------
+static void copy_rows(const struct rgb_img *src, struct rgb_img *dst) {
+    for (size_t y = 0; y < src->height; y++) {
+        memcpy(dst->raster + 3 * y * dst->stride, src->raster + 3 * y * src->stride, 3 * src->width);
+    }
+}
+
+// ----------------------------------------
+// Function: seam_sequence_frame
+// ----------------------------------------
+/*
+   Keyframes reset the reference to the frame and its energy map to a
+   full energy pass, then carve with carve_seam. Tracked frames update the
+   map with mark_changes and update_base, hand a copy of it to the
+   context, and carve each seam with seam_band_find around the previous
+   frame's seam of the same index.
+*/
+int seam_sequence_frame(struct seam_sequence *seq, struct rgb_img *frame, struct rgb_img **out) {
+    size_t height = seq->height, width = seq->width;
+    int key;
+
+    *out = NULL;
+    if (frame->height != height || frame->width != width) {
+        destroy_image(frame);
+        return -1;
+    }
+
+    key = !seq->started || (seq->keyframe > 0 && seq->frames % seq->keyframe == 0);
+    if (!key) {
+        size_t changed = mark_changes(seq, frame);
+        key = changed * SEQUENCE_SCENE_CUT > height * width;  // Scene cut
+        if (!key) {
+            seq->changed_pixels += changed;
+            seq->energy_pixels += update_base(seq);
+        }
+    }
+
+    if (key) {
+        copy_rows(frame, seq->ref);
+        refill_energy(seq->ref, seq->base, seq->ctx.pool);
+    }
+    if (!seq->started) {
+        carve_init_opts(&seq->ctx, frame, &seq->opts);
+        seq->started = 1;
+    } else {
+        carve_reset_energy(&seq->ctx, frame, seq->base);
+    }
+
+    struct carve_ctx *ctx = &seq->ctx;
+    for (int i = 0; i < seq->seams; i++) {
+        int *previous = seq->paths + (size_t)i * height;
+        if (key) {
+            carve_seam(ctx);
+        } else {
+            uint32_t cost = seam_band_find(&seq->near, ctx->grad, previous, ctx->path);
+            carve_remove_seam(ctx, ctx->path, cost);
+        }
+        if (seq->frames > 0) {  // Jitter against the previous frame's seam
+            for (size_t y = 0; y < height; y++) seq->shift += abs(ctx->path[y] - previous[y]);
+            seq->shift_rows += height;
+        }
+        memcpy(previous, ctx->path, sizeof(int) * height);
+    }
+
+    struct rgb_img *carved = carve_image(ctx);
+    create_img(out, carved->height, carved->width);
+    copy_rows(carved, *out);
+    seq->frames++;
+    seq->keyframes += key;
+    return key;
+}
+
+// ----------------------------------------
+// Struct: frame_queue
+// ----------------------------------------
+/*
+   A bounded queue of numbered frames between two pipeline stages. pop
+   returns 0 once the queue is closed and empty.
+*/
+#define QUEUE_DEPTH 2           // Frames in flight between two stages
+
+struct frame_queue {
+    struct rgb_img *frames[QUEUE_DEPTH];
+    int numbers[QUEUE_DEPTH];
+    int head;
+    int count;
+    int closed;
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+};
+
+static void queue_init(struct frame_queue *q) {
+    q->head = 0;
+    q->count = 0;
+    q->closed = 0;
+    pthread_mutex_init(&q->lock, NULL);
+    pthread_cond_init(&q->changed, NULL);
+}
+
+static void queue_destroy(struct frame_queue *q) {
+    pthread_mutex_destroy(&q->lock);
+    pthread_cond_destroy(&q->changed);
+}
+
+static void queue_push(struct frame_queue *q, struct rgb_img *frame, int number) {
+    pthread_mutex_lock(&q->lock);
+    while (q->count == QUEUE_DEPTH) pthread_cond_wait(&q->changed, &q->lock);
+    int slot = (q->head + q->count) % QUEUE_DEPTH;
+    q->frames[slot] = frame;
+    q->numbers[slot] = number;
+    q->count++;
+    pthread_cond_broadcast(&q->changed);
+    pthread_mutex_unlock(&q->lock);
+}
+
+static void queue_close(struct frame_queue *q) {
+    pthread_mutex_lock(&q->lock);
+    q->closed = 1;
+    pthread_cond_broadcast(&q->changed);
+    pthread_mutex_unlock(&q->lock);
+}
+
+static int queue_pop(struct frame_queue *q, struct rgb_img **frame, int *number) {
+    pthread_mutex_lock(&q->lock);
+    while (q->count == 0 && !q->closed) pthread_cond_wait(&q->changed, &q->lock);
+    int got = (q->count > 0);
+    if (got) {
+        *frame = q->frames[q->head];
+        *number = q->numbers[q->head];
+        q->head = (q->head + 1) % QUEUE_DEPTH;
+        q->count--;
+        pthread_cond_broadcast(&q->changed);
+    }
+    pthread_mutex_unlock(&q->lock);
+    return got;
+}
+
+// ----------------------------------------
+// Struct: sequence_io
+// ----------------------------------------
+/*
+   What the read and write threads share with the carving thread.
+
+   Fields:
+     pattern  - file name pattern of the stage (input or output)
+     first    - number of the first frame to read
+     queue    - frames read (reader) or carved (writer)
+     failures - frames the writer could not write
+*/
+struct sequence_io {
+    const char *pattern;
+    int first;
+    struct frame_queue queue;
+    int failures;
+};
+
+static void *reader_thread(void *arg) {
+    struct sequence_io *io = (struct sequence_io *)arg;
+    char name[512];
+
+    for (int number = io->first;; number++) {
+        struct rgb_img *frame;
+        snprintf(name, sizeof(name), io->pattern, number);
+        if (read_in_img(&frame, name) != 0) break;  // End of the sequence
+        queue_push(&io->queue, frame, number);
+    }
+    queue_close(&io->queue);
+    return NULL;
+}
+
+static void *writer_thread(void *arg) {
+    struct sequence_io *io = (struct sequence_io *)arg;
+    struct rgb_img *frame;
+    int number;
+    char name[512];
+
+    while (queue_pop(&io->queue, &frame, &number)) {
+        snprintf(name, sizeof(name), io->pattern, number);
+        if (write_img(frame, name) != 0) io->failures++;
+        destroy_image(frame);
+    }
+    return NULL;
+}
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+// ----------------------------------------
+// Function: seam_sequence_run
+// ----------------------------------------
+int seam_sequence_run(const char *in_pattern, const char *out_pattern, int first, int seams, int band,
+                      int threshold, int keyframe, const struct carve_opts *opts, FILE *report) {
+    struct sequence_io in, out;
+    struct seam_sequence seq;
+    pthread_t reader, writer;
+    struct rgb_img *frame, *carved;
+    int number, failures = 0;
+
+    memset(&in, 0, sizeof(in));
+    memset(&out, 0, sizeof(out));
+    in.pattern = in_pattern;
+    out.pattern = out_pattern;
+    in.first = out.first = first;
+    queue_init(&in.queue);
+    queue_init(&out.queue);
+    double start = now_ms();
+    pthread_create(&reader, NULL, reader_thread, &in);
+    if (!queue_pop(&in.queue, &frame, &number)) {
+        pthread_join(reader, NULL);
+        queue_destroy(&in.queue);
+        queue_destroy(&out.queue);
+        return -1;
+    }
+    seam_sequence_init(&seq, frame->height, frame->width, seams, band, threshold, keyframe, opts);
+    pthread_create(&writer, NULL, writer_thread, &out);
+
+    double carving = 0;
+    do {
+        double t0 = now_ms();
+        int key = seam_sequence_frame(&seq, frame, &carved);
+        double ms = now_ms() - t0;
+        carving += ms;
+        if (key < 0) {
+            fprintf(report, "frame %d: size differs from the first frame, skipped\n", number);
+            failures++;
+            continue;
+        }
+        fprintf(report, "frame %d: %s  %.2f ms\n", number, key ? "keyframe" : "tracked", ms);
+        queue_push(&out.queue, carved, number);
+    } while (queue_pop(&in.queue, &frame, &number));
+    queue_close(&out.queue);
+    pthread_join(reader, NULL);
+    pthread_join(writer, NULL);
+    double seconds = (now_ms() - start) / 1e3;
+
+    size_t pixels = seq.height * seq.width;
+    int tracked = seq.frames - seq.keyframes;
+    fprintf(report, "%d frames (%d keyframes) in %.3f s: %.2f frames/s, carving %.2f ms/frame\n", seq.frames,
+            seq.keyframes, seconds, seconds > 0 ? seq.frames / seconds : 0.0,
+            seq.frames ? carving / seq.frames : 0.0);
+    if (tracked > 0) {
+        fprintf(report, "tracked frames: %.1f%% of pixels changed, %.1f%% of energy recomputed\n",
+                100.0 * seq.changed_pixels / ((double)pixels * tracked),
+                100.0 * seq.energy_pixels / ((double)pixels * tracked));
+    }
+    if (seq.shift_rows > 0) {
+        fprintf(report, "seams moved %.3f columns per row between frames\n", (double)seq.shift / seq.shift_rows);
+    }
+
+    seam_sequence_free(&seq);
+    queue_destroy(&in.queue);
+    queue_destroy(&out.queue);
+    return failures + out.failures;
+}
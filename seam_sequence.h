@@ -0,0 +1,123 @@
+/*
+Frame Sequence Header File
+Author: Tannaz Chowdhury
+GitHub: TannazC
+Date: 2025
+
+Declares temporally coherent carving of video frames stored as a numbered
+series of .bin files. Every frame loses the same number of columns. A
+keyframe (the first frame, a scene cut, or every `keyframe` frames) is
+carved exactly; every other frame starts from the previous one:
+  - energy: the energy map of a reference frame is kept, and only the
+    pixels next to a pixel that changed by more than `threshold` (in any
+    channel) since then are updated and recomputed;
+  - seams: seam i is searched only within `band` columns of the previous
+    frame's seam i (seam_band_find), which also keeps the seams from
+    jumping around between frames.
+With threshold 0 the energy is exact, and with a band as wide as the
+frame the seams are those of the exact carve.
+
+seam_sequence_run streams the files through three threads: one reads
+frame n + 1 while the caller carves frame n and a third writes frame n - 1.
+*/
+
+#ifndef SEAM_SEQUENCE_H         // Include guard - prevents multiple includes
+#define SEAM_SEQUENCE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "c_img.h"              // Required for struct rgb_img definitions
+#include "seamcarving.h"        // Carving context the frames go through
+#include "seam_pyramid.h"       // Banded DP around the previous seams
+#include "seam_arena.h"         // Its working memory
+
+#define SEQUENCE_SCENE_CUT 4    // A frame with over 1/4 of its pixels changed is a keyframe
+
+// ----------------------------------------
+// Struct: seam_sequence
+// ----------------------------------------
+/*
+   State carried from frame to frame.
+
+   Fields:
+     height, width - frame size (every frame must match the first)
+     seams         - columns removed from each frame
+     band, threshold, keyframe - see above (keyframe 0 = only scene cuts)
+     opts          - carving options for the context (threads, planar,
+                     the pyramid band of keyframe seams, and the energy;
+                     forward energy has no map to track, so it becomes
+                     the dual-gradient)
+     ctx           - carving context, reset with each frame
+     started       - whether ctx has been set up (on the first frame)
+     ref, base     - reference frame and its exact energy map
+     changed       - per-pixel flags of the frame being compared
+     paths         - the previous frame's seams, in removal order
+     near, arena   - banded DP working memory
+     frames, keyframes - frames carved, and how many of them were keyframes
+     changed_pixels, energy_pixels - pixels changed beyond the threshold,
+                     and energy values recomputed, over the tracked frames
+     shift, shift_rows - total |column change| of every frame's seams
+                     against the previous frame's, over that many seam rows
+*/
+struct seam_sequence {
+    size_t height;
+    size_t width;
+    int seams;
+    int band;
+    int threshold;
+    int keyframe;
+    struct carve_opts opts;
+    struct carve_ctx ctx;
+    int started;
+    struct rgb_img *ref;
+    struct energy_map *base;
+    uint8_t *changed;
+    int *paths;
+    struct seam_pyramid near;
+    struct seam_arena arena;
+    int frames;
+    int keyframes;
+    uint64_t changed_pixels;
+    uint64_t energy_pixels;
+    uint64_t shift;
+    uint64_t shift_rows;
+};
+
+// ----------------------------------------
+// Function: seam_sequence_init / seam_sequence_free
+// ----------------------------------------
+/*
+   Sets up a sequence of height x width frames losing `seams` columns each
+   (opts may be NULL for the defaults; band is at least 1). Nothing is
+   allocated per frame after the first.
+*/
+void seam_sequence_init(struct seam_sequence *seq, size_t height, size_t width, int seams, int band,
+                        int threshold, int keyframe, const struct carve_opts *opts);
+void seam_sequence_free(struct seam_sequence *seq);
+
+// ----------------------------------------
+// Function: seam_sequence_frame
+// ----------------------------------------
+/*
+   Carves the next frame (taking ownership of it) into a new image *out.
+   Returns 1 for a keyframe, 0 for a tracked frame, or -1 (and *out NULL)
+   if the frame's size differs from the sequence's.
+*/
+int seam_sequence_frame(struct seam_sequence *seq, struct rgb_img *frame, struct rgb_img **out);
+
+// ----------------------------------------
+// Function: seam_sequence_run
+// ----------------------------------------
+/*
+   Carves the files named by in_pattern (a printf pattern with one int,
+   e.g. "frame%04d.bin") numbered from `first` until one is missing,
+   writing each to out_pattern with the same number. The sequence is set
+   up from the first frame with the given parameters. One line per frame
+   and a summary (frames/s, keyframes, share of energy recomputed, mean
+   seam shift) go to report. Returns the number of frames that could not
+   be carved or written, or -1 if there is no first frame.
+*/
+int seam_sequence_run(const char *in_pattern, const char *out_pattern, int first, int seams, int band,
+                      int threshold, int keyframe, const struct carve_opts *opts, FILE *report);
+
+#endif  // End of include guard for SEAM_SEQUENCE_H
@@ -0,0 +1,588 @@
+/*
+Carving Service Implementation
+Author: Tannaz Chowdhury
+GitHub: TannazC
+Date: 2025
+
+The cache and the socket loop of the carving daemon. Cache entries sit in
+a doubly linked list in LRU order and are found by a linear scan (a
+daemon caches tens of images, not thousands). Requests are answered one
+connection at a time on the calling thread, so the cache needs no lock;
+building an order map still uses the option's threads.
+*/
+
+#define _POSIX_C_SOURCE 200809L  // For clock_gettime, fdopen, st_mtim under -std=c99
+
+#include <stdio.h>            // Required for file IO
+#include <stdlib.h>           // Required for malloc, free, qsort
+#include <string.h>           // Required for memcpy, strcmp, strncmp
+#include <errno.h>            // Required for errno
+#include <signal.h>           // Required for ignoring SIGPIPE
+#include <time.h>             // Required for clock_gettime
+#include <unistd.h>           // Required for close, dup, unlink
+#include <sys/socket.h>       // Required for sockets
+#include <sys/stat.h>         // Required for stat
+#include <sys/un.h>           // Required for struct sockaddr_un
+#include "seam_service.h"     // Header for the service declarations
+#include "seam_order.h"       // Removal orders the cache keeps
+#include "seam_insert.h"      // Widening for targets above the image's width
+
+// ----------------------------------------
+// Struct: service_entry
+// ----------------------------------------
+/*
+   One cached image and its removal order.
+
+   Fields:
+     path        - image file
+     width       - 0 for the source image; otherwise the width it was
+                   column-carved to, and the entry holds row orders
+     stamp       - file size and modification time when it was read
+     im          - the raster (column-carved for a row entry)
+     order       - removal order of im's pixels by column seams, or for a
+                   row entry by row seams (NULL order.order until built).
+                   A row order is built on the transpose but stored laid
+                   out like im; its height, width and min_width stay those
+                   of the transpose
+     bytes       - memory held by im and order
+     prev, next  - neighbours in the LRU list
+*/
+struct service_entry {
+    char *path;
+    size_t width;
+    uint64_t stamp[2];
+    struct rgb_img *im;
+    struct seam_order order;
+    size_t bytes;
+    struct service_entry *prev;
+    struct service_entry *next;
+};
+
+static uint64_t now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+// ----------------------------------------
+// Helper: entry_bytes
+// ----------------------------------------
+static size_t entry_bytes(const struct service_entry *e) {
+    size_t pixels = e->im->height * e->im->width;
+    return 3 * pixels + (e->order.order != NULL ? sizeof(uint16_t) * pixels : 0);
+}
+
+// ----------------------------------------
+// Helpers: unlink_entry / push_front / drop_entry
+// ----------------------------------------
+static void unlink_entry(struct seam_service *svc, struct service_entry *e) {
+    if (e->prev != NULL) e->prev->next = e->next;
+    else svc->head = e->next;
+    if (e->next != NULL) e->next->prev = e->prev;
+    else svc->tail = e->prev;
+}
+
+static void push_front(struct seam_service *svc, struct service_entry *e) {
+    e->prev = NULL;
+    e->next = svc->head;
+    if (svc->head != NULL) svc->head->prev = e;
+    else svc->tail = e;
+    svc->head = e;
+}
+
+static void drop_entry(struct seam_service *svc, struct service_entry *e) {
+    unlink_entry(svc, e);
+    svc->used -= e->bytes;
+    svc->entries--;
+    seam_order_free(&e->order);
+    destroy_image(e->im);
+    free(e->path);
+    free(e);
+}
+
+// ----------------------------------------
+// Helper: add_entry
+// ----------------------------------------
+/*
+   Caches im (taking ownership) under (path, width) at the front of the
+   LRU list. The budget is enforced by trim once the request is answered.
+*/
+static struct service_entry *add_entry(struct seam_service *svc, const char *path, size_t width,
+                                       const uint64_t *stamp, struct rgb_img *im) {
+    struct service_entry *e = (struct service_entry *)malloc(sizeof(struct service_entry));
+    size_t len = strlen(path);
+
+    e->path = (char *)malloc(len + 1);
+    memcpy(e->path, path, len + 1);
+    e->width = width;
+    e->stamp[0] = stamp[0];
+    e->stamp[1] = stamp[1];
+    e->im = im;
+    e->order.order = NULL;
+    e->bytes = entry_bytes(e);
+    svc->used += e->bytes;
+    svc->entries++;
+    push_front(svc, e);
+    return e;
+}
+
+// ----------------------------------------
+// Helper: drop_stale / trim
+// ----------------------------------------
+/*
+   drop_stale forgets every entry of an image read before its file last
+   changed (stamp differs from the file's); trim evicts from the back of
+   the LRU list until the cache fits its budget.
+*/
+static void drop_stale(struct seam_service *svc, const char *path, const uint64_t *stamp) {
+    struct service_entry *e = svc->head;
+    while (e != NULL) {
+        struct service_entry *next = e->next;
+        if (strcmp(e->path, path) == 0 && (e->stamp[0] != stamp[0] || e->stamp[1] != stamp[1])) {
+            drop_entry(svc, e);
+            svc->evictions++;
+        }
+        e = next;
+    }
+}
+
+static void trim(struct seam_service *svc) {
+    while (svc->used > svc->budget && svc->tail != NULL) {
+        drop_entry(svc, svc->tail);
+        svc->evictions++;
+    }
+}
+
+// ----------------------------------------
+// Helper: lookup
+// ----------------------------------------
+/*
+   Finds the entry for (path, width) and moves it to the front of the LRU
+   list. Returns NULL if it is not cached, or if it was read from an older
+   version of the file (stamp differs), in which case every stale entry of
+   the file is dropped. Row entries are checked as well as the source: the
+   source may have been evicted before the file changed.
+*/
+static struct service_entry *lookup(struct seam_service *svc, const char *path, size_t width,
+                                    const uint64_t *stamp) {
+    for (struct service_entry *e = svc->head; e != NULL; e = e->next) {
+        if (e->width == width && strcmp(e->path, path) == 0) {
+            if (e->stamp[0] != stamp[0] || e->stamp[1] != stamp[1]) {
+                drop_stale(svc, path, stamp);  // The file changed: its orders are stale too
+                return NULL;
+            }
+            unlink_entry(svc, e);
+            push_front(svc, e);
+            return e;
+        }
+    }
+    return NULL;
+}
+
+// ----------------------------------------
+// Helper: transpose
+// ----------------------------------------
+static struct rgb_img *transpose(const struct rgb_img *im) {
+    struct rgb_img *out;
+    create_img(&out, im->width, im->height);
+    for (size_t y = 0; y < im->height; y++) {
+        const uint8_t *from = im->raster + 3 * y * im->stride;
+        for (size_t x = 0; x < im->width; x++) {
+            memcpy(out->raster + 3 * (x * out->stride + y), from + 3 * x, 3);
+        }
+    }
+    return out;
+}
+
+// ----------------------------------------
+// Helper: retarget_rows
+// ----------------------------------------
+/*
+   seam_order_retarget for rows, on a row order laid out like im: every
+   column keeps its pixels whose order is at least the number of rows
+   removed, moved up to fill the gaps, in one row-major pass.
+*/
+static void retarget_rows(const struct rgb_img *im, const uint16_t *order, size_t height, struct rgb_img **out) {
+    size_t width = im->width;
+    uint16_t removed = (uint16_t)(im->height - height);  // Keep order >= removed
+    size_t *next = (size_t *)calloc(width, sizeof(size_t));  // Next output row of each column
+
+    create_img(out, height, width);
+    for (size_t y = 0; y < im->height; y++) {
+        const uint16_t *row_order = order + y * width;
+        const uint8_t *from = im->raster + 3 * y * im->stride;
+        for (size_t x = 0; x < width; x++) {
+            if (row_order[x] < removed) continue;
+            memcpy((*out)->raster + 3 * (next[x]++ * (*out)->stride + x), from + 3 * x, 3);
+        }
+    }
+    free(next);
+}
+
+// ----------------------------------------
+// Helper: ensure_order
+// ----------------------------------------
+/*
+   Makes sure e's removal order reaches down to target columns (rows for a
+   row entry). A rebuild goes at least twice as deep as the order it
+   replaces, so a client asking for ever smaller sizes pays for O(log)
+   builds, not one per size. Returns 1 if the order was built, 0 if the
+   cached one covers target, or -1 if it cannot be built.
+*/
+static int ensure_order(struct seam_service *svc, struct service_entry *e, size_t target) {
+    size_t width = (e->width != 0) ? e->im->height : e->im->width;  // Seams removable
+
+    if (e->order.order != NULL && e->order.min_width <= target) return 0;
+
+    size_t min_width = target;
+    if (e->order.order != NULL) {
+        size_t deeper = 2 * (width - e->order.min_width);
+        if (deeper < width && width - deeper < min_width) min_width = width - deeper;
+        seam_order_free(&e->order);
+    }
+    svc->used -= e->bytes;
+    int failed;
+    if (e->width == 0) {
+        failed = seam_order_build(e->im, min_width, &svc->opts, &e->order);
+    } else {                                  // Row seams: vertical seams of the transpose
+        struct rgb_img *turned = transpose(e->im);
+        failed = seam_order_build(turned, min_width, &svc->opts, &e->order);
+        destroy_image(turned);
+        if (!failed) {
+            size_t rows = e->im->height, cols = e->im->width;
+            uint16_t *laid = (uint16_t *)malloc(sizeof(uint16_t) * rows * cols);
+            for (size_t x = 0; x < cols; x++) {
+                for (size_t y = 0; y < rows; y++) laid[y * cols + x] = e->order.order[x * rows + y];
+            }
+            free(e->order.order);
+            e->order.order = laid;
+        }
+    }
+    if (failed) e->order.order = NULL;
+    e->bytes = entry_bytes(e);
+    svc->used += e->bytes;
+    return failed ? -1 : 1;
+}
+
+// ----------------------------------------
+// Function: service_init / service_free
+// ----------------------------------------
+void service_init(struct seam_service *svc, size_t cache_bytes, const struct carve_opts *opts) {
+    memset(svc, 0, sizeof(*svc));
+    if (opts != NULL) svc->opts = *opts;
+    else carve_opts_default(&svc->opts);
+    svc->budget = cache_bytes;
+    svc->listen_fd = -1;
+}
+
+void service_free(struct seam_service *svc) {
+    while (svc->head != NULL) drop_entry(svc, svc->head);
+    if (svc->listen_fd >= 0) close(svc->listen_fd);
+    svc->listen_fd = -1;
+}
+
+// ----------------------------------------
+// Function: service_carve
+// ----------------------------------------
+/*
+   Columns come from the source entry's order map (or seam insertion when
+   widening, which is not cached); rows come from the row order of the
+   (image, width) entry, which holds the column-carved image. Both order
+   maps give exactly what carving seam by seam would.
+*/
+int service_carve(struct seam_service *svc, const char *path, size_t width, size_t height,
+                  struct rgb_img **out, int *kind) {
+    struct stat st;
+    uint64_t stamp[2];
+
+    *out = NULL;
+    *kind = SERVICE_HIT;
+    if (stat(path, &st) != 0) return -1;
+    stamp[0] = (uint64_t)st.st_size;
+    stamp[1] = (uint64_t)st.st_mtim.tv_sec * 1000000000u + st.st_mtim.tv_nsec;
+
+    struct service_entry *src = lookup(svc, path, 0, stamp);
+    if (src == NULL) {
+        struct rgb_img *im;
+        if (read_in_img(&im, (char *)path) != 0) return -1;
+        if (im->height == 0 || im->width == 0) {   // Nothing to carve or widen
+            destroy_image(im);
+            return -1;
+        }
+        src = add_entry(svc, path, 0, stamp, im);
+        *kind = SERVICE_MISS;
+    }
+
+    struct rgb_img *im = src->im;
+    if (width == 0) width = im->width;
+    if (height == 0 || height > im->height) height = im->height;  // Rows are only removed
+
+    struct service_entry *rows = (height < im->height) ? lookup(svc, path, width, stamp) : NULL;
+    struct rgb_img *cols = im;             // The image carved (or widened) to width
+    if (rows != NULL) {
+        // Its column-carved image is cached with the row order
+    } else if (width > im->width) {
+        seam_insert(im, (int)(width - im->width), NULL, &cols);
+    } else if (width < im->width) {
+        int built = ensure_order(svc, src, width);
+        if (built < 0) {
+            trim(svc);
+            return -1;
+        }
+        if (built && *kind == SERVICE_HIT) *kind = SERVICE_BUILD;
+        seam_order_retarget(im, &src->order, width, &cols);
+    }
+
+    int built = 0;
+    if (height == im->height) {
+        *out = (cols == im) ? copy_img(im) : cols;
+    } else {
+        if (rows == NULL) {
+            rows = add_entry(svc, path, width, stamp, (cols == im) ? copy_img(im) : cols);
+            cols = im;                     // Owned by the entry now
+            if (*kind == SERVICE_HIT) *kind = SERVICE_BUILD;
+        }
+        built = ensure_order(svc, rows, height);
+        if (built > 0 && *kind == SERVICE_HIT) *kind = SERVICE_BUILD;
+        if (built >= 0) retarget_rows(rows->im, rows->order.order, height, out);
+    }
+    trim(svc);
+    return (built < 0) ? -1 : 0;
+}
+
+static int compare_u32(const void *a, const void *b) {
+    uint32_t ua = *(const uint32_t *)a, ub = *(const uint32_t *)b;
+    return (ua > ub) - (ua < ub);
+}
+
+// ----------------------------------------
+// Function: service_write_stats
+// ----------------------------------------
+/*
+   Percentiles are nearest-rank, as in manifest_run's summary.
+*/
+void service_write_stats(const struct seam_service *svc, FILE *fp) {
+    static const char *names[3] = {"hit", "build", "miss"};
+    int count = (svc->requests < SERVICE_LATENCIES) ? (int)svc->requests : SERVICE_LATENCIES;
+    uint32_t *sorted = (uint32_t *)malloc(sizeof(uint32_t) * (count > 0 ? count : 1));
+
+    memcpy(sorted, svc->latency_us, sizeof(uint32_t) * count);
+    qsort(sorted, count, sizeof(uint32_t), compare_u32);
+
+    fprintf(fp, "{\"requests\": %llu, \"hits\": %llu, \"builds\": %llu, \"misses\": %llu, \"errors\": %llu, ",
+            (unsigned long long)svc->requests, (unsigned long long)svc->kinds[SERVICE_HIT],
+            (unsigned long long)svc->kinds[SERVICE_BUILD], (unsigned long long)svc->kinds[SERVICE_MISS],
+            (unsigned long long)svc->errors);
+    fprintf(fp, "\"hit_rate\": %.3f, \"entries\": %d, \"cache_bytes\": %zu, \"budget\": %zu, \"evictions\": %llu",
+            svc->requests ? (double)svc->kinds[SERVICE_HIT] / svc->requests : 0.0, svc->entries, svc->used,
+            svc->budget, (unsigned long long)svc->evictions);
+    for (int k = 0; k < 3; k++) {
+        fprintf(fp, ", \"mean_us_%s\": %.0f", names[k],
+                svc->kinds[k] ? (double)svc->total_us[k] / svc->kinds[k] : 0.0);
+    }
+    if (count > 0) {
+        fprintf(fp, ", \"p50_us\": %u, \"p90_us\": %u, \"p99_us\": %u, \"max_us\": %u", sorted[count / 2],
+                sorted[(count * 9 + 9) / 10 - 1], sorted[(count * 99 + 99) / 100 - 1], sorted[count - 1]);
+    }
+    fprintf(fp, "}\n");
+    free(sorted);
+}
+
+// ----------------------------------------
+// Function: service_listen
+// ----------------------------------------
+int service_listen(struct seam_service *svc, const char *socket_path) {
+    struct sockaddr_un addr;
+    struct stat st;
+
+    if (strlen(socket_path) >= sizeof(addr.sun_path)) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    if (stat(socket_path, &st) == 0) {  // Only ever replace a socket
+        if (!S_ISSOCK(st.st_mode)) {
+            errno = EEXIST;
+            return -1;
+        }
+        unlink(socket_path);
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, socket_path);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(fd, 16) != 0) {
+        int saved = errno;
+        close(fd);
+        errno = saved;
+        return -1;
+    }
+    svc->listen_fd = fd;
+    return 0;
+}
+
+// ----------------------------------------
+// Helper: answer_carve
+// ----------------------------------------
+/*
+   Parses "WxH path", carves, and sends the status line and the image in
+   .bin format. The latency recorded runs from the request line to the
+   last byte sent; the one in the status line stops before sending.
+*/
+static void answer_carve(struct seam_service *svc, char *args, FILE *out, uint64_t start) {
+    size_t width, height;
+    int used = 0;
+    struct rgb_img *im;
+    int kind;
+
+    if (sscanf(args, "%zux%zu %n", &width, &height, &used) != 2 || args[used] == '\0') {
+        fprintf(out, "ERR expected CARVE WxH path\n");
+        svc->errors++;
+        return;
+    }
+    if (service_carve(svc, args + used, width, height, &im, &kind) != 0) {
+        fprintf(out, "ERR cannot read %s\n", args + used);
+        svc->errors++;
+        return;
+    }
+
+    struct img_header hdr = {1, im->height, im->width, im->width, 0, 4, 0};  // As write_img lays it out
+    if (im->height > IMG_V1_MAX || im->width > IMG_V1_MAX) img_v2_header(&hdr, im->height, im->width, 0);
+    size_t bytes = img_row_offset(&hdr, im->height);
+    fprintf(out, "OK %zu %zu %s %llu %zu\n", im->width, im->height,
+            kind == SERVICE_HIT ? "hit" : (kind == SERVICE_BUILD ? "build" : "miss"),
+            (unsigned long long)(now_us() - start), bytes);
+    write_img_header(out, &hdr);
+    write_img_rows(out, &hdr, 0, im->raster, im->height, im->stride);
+    fflush(out);
+    destroy_image(im);
+
+    uint64_t us = now_us() - start;
+    svc->latency_us[svc->requests % SERVICE_LATENCIES] = (uint32_t)us;
+    svc->total_us[kind] += us;
+    svc->kinds[kind]++;
+    svc->requests++;
+}
+
+// ----------------------------------------
+// Helper: serve_connection
+// ----------------------------------------
+/*
+   Answers the requests of one connection until it closes. Returns 1 if
+   one of them was SHUTDOWN.
+*/
+static int serve_connection(struct seam_service *svc, int fd) {
+    FILE *in = fdopen(fd, "r");
+    FILE *out = fdopen(dup(fd), "w");
+    char line[4096];
+    int stop = 0;
+
+    if (in == NULL || out == NULL) {
+        if (in != NULL) fclose(in);
+        else close(fd);
+        if (out != NULL) fclose(out);
+        return 0;
+    }
+    while (!stop && fgets(line, sizeof(line), in) != NULL) {
+        uint64_t start = now_us();
+        size_t len = strcspn(line, "\r\n");
+        line[len] = '\0';
+
+        if (strncmp(line, "CARVE ", 6) == 0) {
+            answer_carve(svc, line + 6, out, start);
+        } else if (strcmp(line, "STATS") == 0) {
+            fprintf(out, "OK\n");
+            service_write_stats(svc, out);
+        } else if (strcmp(line, "SHUTDOWN") == 0) {
+            fprintf(out, "OK\n");
+            stop = 1;
+        } else {
+            fprintf(out, "ERR unknown request\n");
+            svc->errors++;
+        }
+        fflush(out);
+    }
+    fclose(out);
+    fclose(in);
+    return stop;
+}
+
+// ----------------------------------------
+// Function: service_run
+// ----------------------------------------
+int service_run(struct seam_service *svc, const char *socket_path) {
+    signal(SIGPIPE, SIG_IGN);  // A client hanging up must not kill the daemon
+
+    for (;;) {
+        int fd = accept(svc->listen_fd, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            return -1;
+        }
+        if (serve_connection(svc, fd)) break;
+    }
+    close(svc->listen_fd);
+    svc->listen_fd = -1;
+    unlink(socket_path);
+    return 0;
+}
+
+// ----------------------------------------
+// Function: service_request
+// ----------------------------------------
+int service_request(const char *socket_path, const char *request, char *status, size_t size, FILE *payload) {
+    struct sockaddr_un addr;
+
+    status[0] = '\0';
+    if (strlen(socket_path) >= sizeof(addr.sun_path)) return -1;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, socket_path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    FILE *in = fdopen(fd, "r");
+    FILE *out = fdopen(dup(fd), "w");
+    if (in == NULL || out == NULL) {
+        if (in != NULL) fclose(in);
+        else close(fd);
+        if (out != NULL) fclose(out);
+        return -1;
+    }
+
+    fprintf(out, "%s\n", request);
+    fflush(out);
+    int failed = (fgets(status, size, in) == NULL || strncmp(status, "OK", 2) != 0);
+    status[strcspn(status, "\r\n")] = '\0';
+
+    size_t width, height, bytes;
+    unsigned long long us;
+    char kind[16];
+    if (!failed && sscanf(status, "OK %zu %zu %15s %llu %zu", &width, &height, kind, &us, &bytes) == 5) {
+        char buffer[65536];  // The carved image follows
+        while (bytes > 0) {
+            size_t chunk = (bytes < sizeof(buffer)) ? bytes : sizeof(buffer);
+            if (fread(buffer, 1, chunk, in) != chunk) {
+                failed = 1;
+                break;
+            }
+            if (payload != NULL && fwrite(buffer, 1, chunk, payload) != chunk) failed = 1;
+            bytes -= chunk;
+        }
+    } else if (!failed && strcmp(request, "STATS") == 0) {
+        size_t len = strlen(status);
+        if (len + 1 < size) {
+            status[len] = ' ';
+            if (fgets(status + len + 1, size - len - 1, in) == NULL) failed = 1;
+            status[strcspn(status, "\r\n")] = '\0';
+        }
+    }
+    fclose(out);
+    fclose(in);
+    return failed ? -1 : 0;
+}
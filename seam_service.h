@@ -0,0 +1,146 @@
+/*
+Carving Service Header File
+Author: Tannaz Chowdhury
+GitHub: TannazC
+Date: 2025
+
+Declares the carving daemon: a long-running process that listens on a
+Unix domain socket and answers carve requests from a cache instead of
+starting, parsing and computing energy from scratch every time.
+
+The cache holds, per source image, its raster and its column removal
+order (seam_order.h), and per (image, width) the column-carved image and
+its row removal order. An order map answers every size down to the width
+(or height) it was built to with one pass over the raster, so a repeated
+or smaller-but-covered request does no energy or DP work at all. Entries
+are kept in least-recently-used order and evicted once the cache is over
+its byte budget. Images are re-read when their file changes.
+
+Requests are single lines; replies start with one status line:
+    CARVE WxH path    -> OK w h hit|build|miss us bytes, then `bytes`
+                         bytes of the carved image in .bin format
+    STATS             -> OK followed by one line of JSON
+    SHUTDOWN          -> OK, and the daemon exits after this connection
+    (errors)          -> ERR message
+W or H may be 0 to keep that dimension. Columns are carved before rows
+(like --width followed by --height), and a width above the image's is
+reached by seam insertion. A connection may send any number of requests.
+*/
+
+#ifndef SEAM_SERVICE_H          // Include guard - prevents multiple includes
+#define SEAM_SERVICE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "c_img.h"              // Required for struct rgb_img definitions
+#include "seamcarving.h"        // Carving options
+
+#define SERVICE_LATENCIES 4096  // Most recent request latencies kept for percentiles
+
+// Where a carve request's result came from
+#define SERVICE_HIT   0         // Raster and order maps all cached
+#define SERVICE_BUILD 1         // Raster cached, an order map had to be (re)built
+#define SERVICE_MISS  2         // Image read from disk
+
+struct service_entry;           // Defined in seam_service.c
+
+// ----------------------------------------
+// Struct: seam_service
+// ----------------------------------------
+/*
+   The cache and counters of one daemon.
+
+   Fields:
+     opts        - carving options used to build order maps
+     budget      - most bytes of rasters and order maps to keep cached
+     used        - bytes cached now
+     entries     - cached entries
+     head, tail  - LRU list, most recently used first
+     listen_fd   - listening socket (-1 until service_listen)
+     requests    - carve requests answered (errors not included)
+     kinds       - of those, how many were hits, builds and misses
+     errors      - requests answered with ERR
+     evictions   - entries dropped for the budget or a changed file
+     latency_us  - the last SERVICE_LATENCIES carve latencies, a ring
+     total_us    - sum of all carve latencies, per kind
+*/
+struct seam_service {
+    struct carve_opts opts;
+    size_t budget;
+    size_t used;
+    int entries;
+    struct service_entry *head;
+    struct service_entry *tail;
+    int listen_fd;
+    uint64_t requests;
+    uint64_t kinds[3];
+    uint64_t errors;
+    uint64_t evictions;
+    uint32_t latency_us[SERVICE_LATENCIES];
+    uint64_t total_us[3];
+};
+
+// ----------------------------------------
+// Function: service_init / service_free
+// ----------------------------------------
+/*
+   Sets up an empty cache of at most cache_bytes (opts may be NULL for
+   the defaults), and frees it, closing the socket if one is open.
+*/
+void service_init(struct seam_service *svc, size_t cache_bytes, const struct carve_opts *opts);
+void service_free(struct seam_service *svc);
+
+// ----------------------------------------
+// Function: service_carve
+// ----------------------------------------
+/*
+   Carves the image at path to width x height (0 keeps a dimension)
+   through the cache; the request behind CARVE, without the socket.
+
+   Parameters:
+     path          - .bin image
+     width, height - target size
+     out           - pointer to the address of the new image to allocate
+     kind          - output: SERVICE_HIT, SERVICE_BUILD or SERVICE_MISS
+
+   Returns 0, or -1 if the image cannot be read or has no pixels (*out is
+   then NULL).
+*/
+int service_carve(struct seam_service *svc, const char *path, size_t width, size_t height,
+                  struct rgb_img **out, int *kind);
+
+// ----------------------------------------
+// Function: service_write_stats
+// ----------------------------------------
+/*
+   Writes the counters as one line of JSON: requests, hit rate, cache use
+   and latency percentiles (over the last SERVICE_LATENCIES requests).
+*/
+void service_write_stats(const struct seam_service *svc, FILE *fp);
+
+// ----------------------------------------
+// Function: service_listen / service_run
+// ----------------------------------------
+/*
+   service_listen binds and listens on the socket path (replacing a stale
+   socket file). Returns 0, or -1 with errno set.
+   service_run answers connections one at a time until a SHUTDOWN
+   request, then removes the socket file. Returns 0, or -1 if accept
+   fails.
+*/
+int service_listen(struct seam_service *svc, const char *socket_path);
+int service_run(struct seam_service *svc, const char *socket_path);
+
+// ----------------------------------------
+// Function: service_request
+// ----------------------------------------
+/*
+   Client side: connects to the daemon, sends one request line and reads
+   the status line into status (at most size bytes, newline removed). A
+   CARVE payload is copied to payload (may be NULL to discard it), and
+   the JSON line of STATS is appended to status.
+   Returns 0 for an OK reply, or -1 for ERR or a connection failure.
+*/
+int service_request(const char *socket_path, const char *request, char *status, size_t size, FILE *payload);
+
+#endif  // End of include guard for SEAM_SERVICE_H
@@ -1,231 +1,1110 @@
-/*
-Seam Carving Algorithm Implementation - Main File 
-Author: Tannaz Chowdhury  
-GitHub: TannazC  
-Date: 2025  
-*/
-
-#include <stdio.h>            // Required for printf and file IO
-#include <stdlib.h>           // Required for malloc, free
-#include <math.h>             // Required for sqrt
-#include <float.h>            // For DBL_MAX constant
-#include "c_img.h"            // Custom header to work with image pixel structs
-#include "seamcarving.h"     // Header for seam carving function declarations
-
-// ----------------------------------------
-// Helper: Compute Gradient Component
-// ----------------------------------------
-/*
-   This function calculates the difference in pixel values along either
-   the x-axis or y-axis for a particular color channel (R, G, or B).
-   It handles edge pixels using wrap-around logic.
-*/
-static int compute_gradient_component(const struct rgb_img *im, int y, int x, int color, char axis) {
-    int width = im->width;     // Get image width
-    int height = im->height;   // Get image height
-    int delta = 0;             // Initialize delta (difference) to zero
-
-    if (axis == 'x') {
-        int left = (x == 0) ? width - 1 : x - 1;          // Wrap to last column if x == 0
-        int right = (x == width - 1) ? 0 : x + 1;         // Wrap to first column if x is last
-        delta = get_pixel((struct rgb_img *)im, y, right, color) - get_pixel((struct rgb_img *)im, y, left, color);  // Compute difference in x direction
-    } else if (axis == 'y') {
-        int top = (y == 0) ? height - 1 : y - 1;          // Wrap to last row if y == 0
-        int bottom = (y == height - 1) ? 0 : y + 1;       // Wrap to first row if y is last
-        delta = get_pixel((struct rgb_img *)im, bottom, x, color) - get_pixel((struct rgb_img *)im, top, x, color);  // Compute difference in y direction
-    }
-    return delta;  // Return the computed difference
-}
-
-// ----------------------------------------
-// Function: calc_energy
-// ----------------------------------------
-/*
-   This function calculates the energy of each pixel in the image.
-   Energy is computed based on color gradients (change in color values).
-   The energy is then scaled and saved as grayscale in the gradient image.
-*/
-void calc_energy(struct rgb_img *im, struct rgb_img **grad) {
-    int width = im->width;    // Get image width
-    int height = im->height;  // Get image height
-
-    create_img(grad, height, width);  // Create a new grayscale image for energy values
-
-    for (int y = 0; y < height; y++) {  // Loop through each row
-        for (int x = 0; x < width; x++) {  // Loop through each column
-            // Get gradients in both directions for all color channels
-            int r_x = compute_gradient_component(im, y, x, 0, 'x');
-            int g_x = compute_gradient_component(im, y, x, 1, 'x');
-            int b_x = compute_gradient_component(im, y, x, 2, 'x');
-            int r_y = compute_gradient_component(im, y, x, 0, 'y');
-            int g_y = compute_gradient_component(im, y, x, 1, 'y');
-            int b_y = compute_gradient_component(im, y, x, 2, 'y');
-
-            // Total energy in x and y directions
-            int delta_x = r_x * r_x + g_x * g_x + b_x * b_x;
-            int delta_y = r_y * r_y + g_y * g_y + b_y * b_y;
-
-            double energy = sqrt(delta_x + delta_y);  // Total energy using Euclidean distance
-            uint8_t scaled = (uint8_t)(energy / 10);  // Scale down to fit into uint8_t
-
-            set_pixel(*grad, y, x, scaled, scaled, scaled);  // Set grayscale energy value
-        }
-    }
-}
-
-// ----------------------------------------
-// Function: dynamic_seam
-// ----------------------------------------
-/*
-   Builds a 1D array where each cell holds the minimum energy to reach that pixel
-   from the top of the image.
-*/
-static double min_neighbors(double *best_arr, int prev_row, int col, int width) {
-    double min_val = DBL_MAX;  // Initialize to max possible double
-
-    // Compare left, center, and right neighbors from the row above
-    if (col > 0 && best_arr[prev_row * width + col - 1] < min_val)
-        min_val = best_arr[prev_row * width + col - 1];
-
-    if (best_arr[prev_row * width + col] < min_val)
-        min_val = best_arr[prev_row * width + col];
-
-    if (col < width - 1 && best_arr[prev_row * width + col + 1] < min_val)
-        min_val = best_arr[prev_row * width + col + 1];
-
-    return min_val;  // Return the smallest neighbor value
-}
-
-void dynamic_seam(struct rgb_img *grad, double **best_arr) {
-    int width = grad->width;
-    int height = grad->height;
-    *best_arr = (double *)malloc(sizeof(double) * height * width);  // Allocate 1D array for cost matrix
-
-    // Initialize the top row directly from energy image
-    for (int j = 0; j < width; j++) {
-        (*best_arr)[j] = get_pixel(grad, 0, j, 0);  // Only need one channel, since grayscale
-    }
-
-    // Fill out the rest of best_arr using dynamic programming
-    for (int i = 1; i < height; i++) {
-        for (int j = 0; j < width; j++) {
-            double energy = get_pixel(grad, i, j, 0);  // Current energy value
-            double min_cost = min_neighbors(*best_arr, i - 1, j, width);  // Best from top 3 neighbors
-            (*best_arr)[i * width + j] = energy + min_cost;  // Accumulate cost
-        }
-    }
-}
-
-// ----------------------------------------
-// Function: recover_path
-// ----------------------------------------
-/*
-   Backtracks from the bottom row of best_arr to recover the seam
-   with minimum total energy.
-*/
-static int find_best_neighbor(double *best_arr, int row, int center, int width) {
-    int best_col = center;  // Start at current column
-    double min_val = best_arr[row * width + center];
-
-    // Check left neighbor
-    if (center > 0 && best_arr[row * width + center - 1] < min_val) {
-        best_col = center - 1;
-        min_val = best_arr[row * width + center - 1];
-    }
-
-    // Check right neighbor
-    if (center < width - 1 && best_arr[row * width + center + 1] < min_val) {
-        best_col = center + 1;
-    }
-
-    return best_col;  // Return best neighbor column index
-}
-
-void recover_path(double *best, int height, int width, int **path) {
-    *path = (int *)malloc(sizeof(int) * height);  // Allocate array to store path (one col per row)
-
-    // Start from the minimum value in the last row
-    int min_index = 0;
-    double min_cost = best[(height - 1) * width];
-
-    for (int j = 1; j < width; j++) {
-        double cost = best[(height - 1) * width + j];
-        if (cost < min_cost) {
-            min_cost = cost;
-            min_index = j;
-        }
-    }
-
-    (*path)[height - 1] = min_index;  // Set last element in path
-
-    // Backtrack up the rows to find the full seam
-    for (int i = height - 2; i >= 0; i--) {
-        int prev_index = (*path)[i + 1];
-        (*path)[i] = find_best_neighbor(best, i, prev_index, width);
-    }
-}
-
-// ----------------------------------------
-// Function: remove_seam
-// ----------------------------------------
-/*
-   Removes one vertical seam from the source image by skipping
-   the pixel in the path and copying others to a new image.
-*/
-void remove_seam(struct rgb_img *src, struct rgb_img **dest, int *path) {
-    int height = src->height;
-    int width = src->width;
-    create_img(dest, height, width - 1);  // Allocate image with one less column
-
-    for (int i = 0; i < height; i++) {
-        int seam_col = path[i];  // Column to be skipped in this row
-        for (int j = 0, new_j = 0; j < width; j++) {
-            if (j == seam_col) continue;  // Skip the seam pixel
-
-            // Get RGB values from source image
-            uint8_t r = get_pixel(src, i, j, 0);
-            uint8_t g = get_pixel(src, i, j, 1);
-            uint8_t b = get_pixel(src, i, j, 2);
-
-            set_pixel(*dest, i, new_j, r, g, b);  // Copy to destination
-            new_j++;  // Move to next destination column
-        }
-    }
-}
-
-// ----------------------------------------
-// Main Function: Seam Carving Execution
-// ----------------------------------------
-/*
-   Carves out 5 seams from an image, writing each step to disk.
-*/
-int main() {
-    struct rgb_img *im;       // Input image pointer
-    struct rgb_img *cur_im;   // Updated image after removing seam
-    struct rgb_img *grad;     // Energy map
-    double *best;             // Best path cost table
-    int *path;                // Path array of seam columns
-
-    read_in_img(&im, "HJoceanSmall.bin");  // Read image from binary file
-
-    for (int i = 0; i < 5; i++) {
-        printf("i = %d\n", i);                        // Output current step
-        calc_energy(im, &grad);                       // Step 1: compute energy
-        dynamic_seam(grad, &best);                    // Step 2: compute best seam costs
-        recover_path(best, grad->height, grad->width, &path); // Step 3: backtrack to find seam path
-        remove_seam(im, &cur_im, path);               // Step 4: create new image with seam removed
-
-        char filename[200];
-        sprintf(filename, "img%d.bin", i);            // Construct output filename
-        write_img(cur_im, filename);                  // Save the new image
-
-        destroy_image(im);                            // Free old image
-        destroy_image(grad);                          // Free energy image
-        free(best);                                   // Free best cost array
-        free(path);                                   // Free seam path array
-        im = cur_im;                                  // Continue using updated image
-    }
-
-    destroy_image(im);  // Final cleanup
-    return 0;
-}
+/*
+Seam Carving Algorithm Implementation
+Author: Tannaz Chowdhury  
+GitHub: TannazC  
+Date: 2025  
+
+The carving library: energy maps, seam search and removal, and the
+carving context. The command-line program is in seamcarving_cli.c.
+*/
+
+#include <stdio.h>            // Required for printf
+#include <stdlib.h>           // Required for malloc, free
+#include <math.h>             // Required for sqrt
+#include <float.h>            // For DBL_MAX constant
+#include <string.h>           // For memmove, memcpy
+#include "c_img.h"            // Custom header to work with image pixel structs
+#include "seamcarving.h"     // Header for seam carving function declarations
+#include "energy_map.h"       // Single-plane energy maps
+#include "seam_dp.h"          // Compact DP used by the carving context
+#include "energy_simd.h"      // Row kernels for the energy pass
+#include "thread_pool.h"      // Worker threads for the energy and DP passes
+#include "seam_batch.h"       // Several disjoint seams per DP pass
+#include "seam_arena.h"       // One block for the context's working memory
+#include "planar_img.h"       // Planar working copy for the planar option
+#include "seam_pyramid.h"     // Coarse-to-fine search for the pyramid option
+#include "carve_stats.h"      // Stage timers and counters
+
+// ----------------------------------------
+// Helper: Gradient Components
+// ----------------------------------------
+/*
+   These functions calculate the difference in pixel values along the
+   x-axis or the y-axis for a particular color channel (R, G, or B).
+   They handle edge pixels using wrap-around logic. There is one function
+   per axis, so no call decides the axis at runtime.
+*/
+static int gradient_x(const struct rgb_img *im, int y, int x, int color) {
+    int width = im->width;                            // Get image width
+    int left = (x == 0) ? width - 1 : x - 1;          // Wrap to last column if x == 0
+    int right = (x == width - 1) ? 0 : x + 1;         // Wrap to first column if x is last
+    return get_pixel((struct rgb_img *)im, y, right, color) - get_pixel((struct rgb_img *)im, y, left, color);
+}
+
+static int gradient_y(const struct rgb_img *im, int y, int x, int color) {
+    int height = im->height;                          // Get image height
+    int top = (y == 0) ? height - 1 : y - 1;          // Wrap to last row if y == 0
+    int bottom = (y == height - 1) ? 0 : y + 1;       // Wrap to first row if y is last
+    return get_pixel((struct rgb_img *)im, bottom, x, color) - get_pixel((struct rgb_img *)im, top, x, color);
+}
+
+// ----------------------------------------
+// Helper: Pixel Energy
+// ----------------------------------------
+/*
+   Computes the scaled energy of a single pixel through get_pixel. This
+   is the reference the row kernels in energy_simd.c are checked against
+   (--check-kernels).
+*/
+uint8_t pixel_energy(const struct rgb_img *im, int y, int x) {
+    return pixel_energy_as(im, y, x, ENERGY_DUAL);
+}
+
+uint8_t pixel_energy_as(const struct rgb_img *im, int y, int x, int energy) {
+    int delta_x = 0;   // Sum over R, G and B of dx^2 (dual) or |dx| (L1)
+    int delta_y = 0;
+
+    for (int color = 0; color < 3; color++) {
+        int dx = gradient_x(im, y, x, color);
+        int dy = gradient_y(im, y, x, color);
+        delta_x += (energy == ENERGY_L1) ? abs(dx) : dx * dx;
+        delta_y += (energy == ENERGY_L1) ? abs(dy) : dy * dy;
+    }
+
+    if (energy == ENERGY_L1) return (uint8_t)((delta_x + delta_y) / 16);
+    double total = sqrt(delta_x + delta_y);  // Total energy using Euclidean distance
+    return (uint8_t)(total / 10);            // Scale down to fit into uint8_t
+}
+
+// Returns a pointer to row y of an image, wrapping y around the top and bottom
+static const uint8_t *wrapped_row(const struct rgb_img *im, int y) {
+    int height = im->height;
+    if (y < 0) y += height;
+    else if (y >= height) y -= height;
+    return im->raster + 3 * (size_t)y * im->stride;
+}
+
+// Fills rows[c] with row y of each plane, wrapping y like wrapped_row
+static void wrapped_planes(const struct planar_img *pl, int y, const uint8_t *rows[3]) {
+    int height = pl->height;
+    if (y < 0) y += height;
+    else if (y >= height) y -= height;
+    for (int c = 0; c < 3; c++) rows[c] = planar_row(pl, c, y);
+}
+
+// ----------------------------------------
+// Function: calc_energy
+// ----------------------------------------
+/*
+   This function calculates the energy of each pixel in the image.
+   Energy is computed based on color gradients (change in color values).
+   The energy is then scaled and saved in a single-plane energy map.
+   Each row is computed by the fastest row kernel the CPU supports
+   (see energy_simd.c), straight into the map. refill_energy and
+   update_energy compute whichever energy the map holds.
+*/
+void calc_energy(struct rgb_img *im, struct energy_map **grad) {
+    calc_energy_threads(im, grad, NULL);
+}
+
+// The image an energy pass reads: interleaved (im) or planar (pl)
+struct energy_src {
+    const struct rgb_img *im;
+    const struct planar_img *pl;
+};
+
+struct energy_job {
+    struct energy_src src;
+    struct energy_map *grad;
+};
+
+// Computes one contiguous band of rows of the energy map
+static void energy_worker(void *arg, int id, int count) {
+    struct energy_job *job = (struct energy_job *)arg;
+    int width = job->grad->width;
+    int first, last;
+    pool_split(job->grad->height, id, count, &first, &last);
+
+    if (job->src.pl != NULL) {
+        energy_planar_fn kernel = energy_kernel_planar_as(job->grad->energy);
+        for (int y = first; y < last; y++) {
+            const uint8_t *up[3], *mid[3], *down[3];
+            wrapped_planes(job->src.pl, y - 1, up);
+            wrapped_planes(job->src.pl, y, mid);
+            wrapped_planes(job->src.pl, y + 1, down);
+            kernel(up, mid, down, width, energy_row(job->grad, y));
+        }
+        return;
+    }
+
+    energy_row_fn kernel = energy_kernel_as(job->grad->energy);  // Looked up once per band
+    const struct rgb_img *im = job->src.im;
+    for (int y = first; y < last; y++) {  // Loop through this thread's rows
+        kernel(wrapped_row(im, y - 1), wrapped_row(im, y), wrapped_row(im, y + 1), width,
+               energy_row(job->grad, y));
+    }
+}
+
+// Runs the energy pass over all rows of src (none for forward energy)
+static void fill_energy(struct energy_src src, size_t height, size_t width, struct energy_map *grad,
+                        struct thread_pool *pool) {
+    grad->height = height;
+    grad->width = width;
+    if (grad->energy == ENERGY_FORWARD) return;
+
+    STATS_START(timer);
+    struct energy_job job = {src, grad};
+    if (pool == NULL) {
+        energy_worker(&job, 0, 1);
+    } else {
+        pool_run(pool, energy_worker, &job);
+    }
+    STATS_STOP(timer, STAGE_ENERGY, height * width);
+}
+
+// ----------------------------------------
+// Function: calc_energy_threads
+// ----------------------------------------
+/*
+   calc_energy with the rows split into one band per thread of the pool.
+   Every row is independent, so the result does not depend on the number
+   of threads. A NULL pool computes all rows on the calling thread.
+*/
+void calc_energy_threads(struct rgb_img *im, struct energy_map **grad, struct thread_pool *pool) {
+    create_energy_map(grad, im->height, im->width);  // One byte per pixel
+    refill_energy(im, *grad, pool);
+}
+
+// ----------------------------------------
+// Function: refill_energy
+// ----------------------------------------
+/*
+   Recomputes an existing energy map from scratch for the image's current
+   size, keeping the map's stride (no allocation of the map itself).
+*/
+void refill_energy(struct rgb_img *im, struct energy_map *grad, struct thread_pool *pool) {
+    struct energy_src src = {im, NULL};
+    fill_energy(src, im->height, im->width, grad, pool);
+}
+
+void refill_energy_planar(struct planar_img *pl, struct energy_map *grad, struct thread_pool *pool) {
+    struct energy_src src = {NULL, pl};
+    fill_energy(src, pl->height, pl->width, grad, pool);
+}
+
+// ----------------------------------------
+// Function: update_energy
+// ----------------------------------------
+/*
+   Brings an energy map up to date after a seam was removed from the image.
+   The seam column is dropped from every row of the map (the map keeps its
+   stride, like an image carved with remove_seam_inplace), then only the
+   pixels whose neighbours changed are recomputed:
+     - the two pixels that became horizontally adjacent across the seam
+       (wrapping at the row ends), and
+     - the columns where this row and the row above/below shifted by a
+       different amount, i.e. between path[y] and path[y +/- 1].
+   For interior rows that is at most four pixels. Rows 0 and height - 1 are
+   vertical neighbours through the wrap-around, and their seam positions may
+   be far apart, so the span between them is recomputed as a range.
+*/
+static void refresh_energy(const struct energy_src *src, struct energy_map *grad, int y, int x) {
+    if (src->pl != NULL) {
+        const uint8_t *up[3], *mid[3], *down[3];
+        wrapped_planes(src->pl, y - 1, up);
+        wrapped_planes(src->pl, y, mid);
+        wrapped_planes(src->pl, y + 1, down);
+        energy_row(grad, y)[x] = energy_pixel_planar_as(up, mid, down, src->pl->width, x, grad->energy);
+    } else {
+        const struct rgb_img *im = src->im;
+        energy_row(grad, y)[x] = energy_pixel_as(wrapped_row(im, y - 1), wrapped_row(im, y),
+                                                 wrapped_row(im, y + 1), im->width, x, grad->energy);
+    }
+    STATS_PIXELS(STAGE_ENERGY, 1);
+}
+
+// Recomputes the columns in [min(a, b), max(a, b)) of row y
+static void refresh_energy_span(const struct energy_src *src, struct energy_map *grad, int y, int a, int b) {
+    int lo = (a < b) ? a : b;
+    int hi = (a < b) ? b : a;
+    for (int x = lo; x < hi; x++) {
+        refresh_energy(src, grad, y, x);
+    }
+}
+
+static void update_rows(const struct energy_src *src, struct energy_map *grad, int *path) {
+    if (grad->energy == ENERGY_FORWARD) {  // No values, only the size
+        grad->width--;
+        return;
+    }
+    STATS_START(timer);
+    int height = grad->height;
+    int width = grad->width - 1;  // Width after the seam was removed
+
+    // Drop the seam column from each row by shifting the row's tail left
+    for (int y = 0; y < height; y++) {
+        uint8_t *row = energy_row(grad, y);
+        int seam_col = path[y];
+        memmove(row + seam_col, row + seam_col + 1, (size_t)(width - seam_col));
+        STATS_ADD(bytes_copied, width - seam_col);
+    }
+    grad->width = width;
+
+    if (width == 0) {  // Nothing left to recompute
+        STATS_STOP(timer, STAGE_ENERGY, 0);
+        return;
+    }
+
+    for (int y = 0; y < height; y++) {
+        int seam_col = path[y];
+        int above = (y == 0) ? height - 1 : y - 1;   // Wrap to last row if y == 0
+        int below = (y == height - 1) ? 0 : y + 1;   // Wrap to first row if y is last
+
+        // Pixels that are now horizontal neighbours across the seam
+        refresh_energy(src, grad, y, (seam_col - 1 + width) % width);
+        refresh_energy(src, grad, y, seam_col % width);
+
+        // Pixels whose vertical neighbour is a different pixel than before
+        refresh_energy_span(src, grad, y, seam_col, path[above]);
+        refresh_energy_span(src, grad, y, seam_col, path[below]);
+    }
+    STATS_STOP(timer, STAGE_ENERGY, 0);  // Pixels are counted by refresh_energy
+}
+
+void update_energy(struct rgb_img *im, struct energy_map *grad, int *path) {
+    struct energy_src src = {im, NULL};
+    update_rows(&src, grad, path);
+}
+
+void update_energy_planar(struct planar_img *pl, struct energy_map *grad, int *path) {
+    struct energy_src src = {NULL, pl};
+    update_rows(&src, grad, path);
+}
+
+// ----------------------------------------
+// Function: update_energy_h
+// ----------------------------------------
+/*
+   The horizontal-seam version of update_energy: the seam is dropped from
+   the map with remove_hseam_inplace, then in each column the two pixels
+   that became vertically adjacent (wrapping at the top and bottom) and the
+   rows between path[x] and path[x +/- 1] (whose left/right neighbour is a
+   different pixel now) are recomputed.
+*/
+// Recomputes the rows in [min(a, b), max(a, b)) of column x
+static void refresh_energy_column(const struct energy_src *src, struct energy_map *grad, int x, int a, int b) {
+    int lo = (a < b) ? a : b;
+    int hi = (a < b) ? b : a;
+    for (int y = lo; y < hi; y++) {
+        refresh_energy(src, grad, y, x);
+    }
+}
+
+static void drop_hseam(uint8_t *raster, size_t pitch, size_t bytes, int height, int width, int *path);
+
+static void update_columns(const struct energy_src *src, struct energy_map *grad, int *path) {
+    if (grad->energy == ENERGY_FORWARD) {
+        grad->height--;
+        return;
+    }
+    STATS_START(timer);
+    int width = grad->width;
+
+    drop_hseam(grad->data, grad->stride, 1, grad->height, width, path);
+    int height = --grad->height;  // Height after the seam was removed
+    if (height == 0) {          // Nothing left to recompute
+        STATS_STOP(timer, STAGE_ENERGY, 0);
+        return;
+    }
+
+    for (int x = 0; x < width; x++) {
+        int seam_row = path[x];
+        int left = (x == 0) ? width - 1 : x - 1;    // Wrap to last column if x == 0
+        int right = (x == width - 1) ? 0 : x + 1;   // Wrap to first column if x is last
+
+        // Pixels that are now vertical neighbours across the seam
+        refresh_energy(src, grad, (seam_row - 1 + height) % height, x);
+        refresh_energy(src, grad, seam_row % height, x);
+
+        // Pixels whose horizontal neighbour is a different pixel than before
+        refresh_energy_column(src, grad, x, seam_row, path[left]);
+        refresh_energy_column(src, grad, x, seam_row, path[right]);
+    }
+    STATS_STOP(timer, STAGE_ENERGY, 0);
+}
+
+void update_energy_h(struct rgb_img *im, struct energy_map *grad, int *path) {
+    struct energy_src src = {im, NULL};
+    update_columns(&src, grad, path);
+}
+
+void update_energy_h_planar(struct planar_img *pl, struct energy_map *grad, int *path) {
+    struct energy_src src = {NULL, pl};
+    update_columns(&src, grad, path);
+}
+
+// ----------------------------------------
+// Function: dynamic_seam
+// ----------------------------------------
+/*
+   Builds a 1D array where each cell holds the minimum energy to reach that pixel
+   from the top of the image.
+*/
+static double min_neighbors(double *best_arr, int prev_row, int col, int width) {
+    double min_val = DBL_MAX;  // Initialize to max possible double
+
+    // Compare left, center, and right neighbors from the row above
+    if (col > 0 && best_arr[prev_row * width + col - 1] < min_val)
+        min_val = best_arr[prev_row * width + col - 1];
+
+    if (best_arr[prev_row * width + col] < min_val)
+        min_val = best_arr[prev_row * width + col];
+
+    if (col < width - 1 && best_arr[prev_row * width + col + 1] < min_val)
+        min_val = best_arr[prev_row * width + col + 1];
+
+    return min_val;  // Return the smallest neighbor value
+}
+
+void dynamic_seam(struct energy_map *grad, double **best_arr) {
+    *best_arr = (double *)malloc(sizeof(double) * grad->height * grad->width);  // Allocate 1D array for cost matrix
+    STATS_ADD(bytes_allocated, sizeof(double) * grad->height * grad->width);
+    dynamic_seam_into(grad, *best_arr);
+}
+
+void dynamic_seam_into(struct energy_map *grad, double *best_arr) {
+    STATS_START(timer);
+    int width = grad->width;
+    int height = grad->height;
+
+    // Initialize the top row directly from energy image
+    for (int j = 0; j < width; j++) {
+        best_arr[j] = get_energy(grad, 0, j);  // Energy of the top row
+    }
+
+    // Fill out the rest of best_arr using dynamic programming
+    for (int i = 1; i < height; i++) {
+        for (int j = 0; j < width; j++) {
+            double energy = get_energy(grad, i, j);  // Current energy value
+            double min_cost = min_neighbors(best_arr, i - 1, j, width);  // Best from top 3 neighbors
+            best_arr[i * width + j] = energy + min_cost;  // Accumulate cost
+        }
+    }
+    STATS_STOP(timer, STAGE_DP, (size_t)height * width);
+}
+
+// ----------------------------------------
+// Function: recover_path
+// ----------------------------------------
+/*
+   Backtracks from the bottom row of best_arr to recover the seam
+   with minimum total energy.
+*/
+static int find_best_neighbor(double *best_arr, int row, int center, int width) {
+    int best_col = center;  // Start at current column
+    double min_val = best_arr[row * width + center];
+
+    // Check left neighbor
+    if (center > 0 && best_arr[row * width + center - 1] < min_val) {
+        best_col = center - 1;
+        min_val = best_arr[row * width + center - 1];
+    }
+
+    // Check right neighbor
+    if (center < width - 1 && best_arr[row * width + center + 1] < min_val) {
+        best_col = center + 1;
+    }
+
+    return best_col;  // Return best neighbor column index
+}
+
+void recover_path(double *best, int height, int width, int **path) {
+    *path = (int *)malloc(sizeof(int) * height);  // Allocate array to store path (one col per row)
+    recover_path_into(best, height, width, *path);
+}
+
+void recover_path_into(double *best, int height, int width, int *path) {
+    STATS_START(timer);
+
+    // Start from the minimum value in the last row
+    int min_index = 0;
+    double min_cost = best[(height - 1) * width];
+
+    for (int j = 1; j < width; j++) {
+        double cost = best[(height - 1) * width + j];
+        if (cost < min_cost) {
+            min_cost = cost;
+            min_index = j;
+        }
+    }
+
+    path[height - 1] = min_index;  // Set last element in path
+
+    // Backtrack up the rows to find the full seam
+    for (int i = height - 2; i >= 0; i--) {
+        int prev_index = path[i + 1];
+        path[i] = find_best_neighbor(best, i, prev_index, width);
+    }
+    STATS_STOP(timer, STAGE_TRACE, height);
+}
+
+// ----------------------------------------
+// Function: remove_seam
+// ----------------------------------------
+/*
+   Removes one vertical seam from the source image by copying the parts
+   of each row on either side of the seam pixel to a new image.
+*/
+void remove_seam(struct rgb_img *src, struct rgb_img **dest, int *path) {
+    create_img(dest, src->height, src->width - 1);  // Allocate image with one less column
+    remove_seam_into(src, *dest, path);
+}
+
+void remove_seam_into(struct rgb_img *src, struct rgb_img *dest, int *path) {
+    STATS_START(timer);
+    int height = src->height;
+    int width = src->width;
+    dest->height = height;
+    dest->width = width - 1;  // Stride stays the buffer's
+
+    for (int i = 0; i < height; i++) {
+        int seam_col = path[i];  // Column to be skipped in this row
+        uint8_t *from = src->raster + 3 * (size_t)i * src->stride;
+        uint8_t *to = dest->raster + 3 * (size_t)i * dest->stride;
+
+        memcpy(to, from, 3 * (size_t)seam_col);                         // Pixels left of the seam
+        memcpy(to + 3 * seam_col, from + 3 * (seam_col + 1),
+               3 * (size_t)(width - 1 - seam_col));                    // Pixels right of the seam
+    }
+    STATS_ADD(bytes_copied, 3 * (size_t)height * (width - 1));
+    STATS_STOP(timer, STAGE_REMOVE, height);
+}
+
+// ----------------------------------------
+// Function: remove_seam_inplace
+// ----------------------------------------
+/*
+   Removes one vertical seam without allocating: the part of each row to the
+   right of the seam is shifted one pixel left and the width shrinks by one.
+   The stride stays the same, so the raster keeps its original allocation.
+*/
+void remove_seam_inplace(struct rgb_img *im, int *path) {
+    STATS_START(timer);
+    int height = im->height;
+    int width = im->width;
+
+    for (int i = 0; i < height; i++) {
+        uint8_t *row = im->raster + 3 * (size_t)i * im->stride;
+        int seam_col = path[i];  // Column to be removed in this row
+        memmove(row + 3 * seam_col, row + 3 * (seam_col + 1), 3 * (size_t)(width - 1 - seam_col));
+        STATS_ADD(bytes_copied, 3 * (width - 1 - seam_col));
+    }
+    im->width = width - 1;
+    STATS_STOP(timer, STAGE_REMOVE, height);
+}
+
+// ----------------------------------------
+// Function: remove_hseam_inplace
+// ----------------------------------------
+/*
+   Removes one horizontal seam without allocating or transposing. Output
+   row y takes, in each column x, the pixel from row y (above the seam,
+   path[x] > y) or from row y + 1 (at or below it). Working top to bottom,
+   row y + 1 has not been overwritten yet when row y is written, and the
+   columns that change form runs, each copied with one memcpy. Rows are
+   visited in raster order, so the image is streamed once. drop_hseam works
+   on any plane with `bytes` bytes per pixel and `pitch` bytes per row, so
+   the energy map uses it too; the caller updates the height.
+*/
+static void drop_hseam(uint8_t *raster, size_t pitch, size_t bytes, int height, int width, int *path) {
+    for (int y = 0; y < height - 1; y++) {
+        uint8_t *row = raster + (size_t)y * pitch;
+        int x = 0;
+        while (x < width) {
+            while (x < width && path[x] > y) x++;    // Above the seam: stays
+            int run = x;
+            while (x < width && path[x] <= y) x++;   // At or below: pull up a row
+            memcpy(row + bytes * run, row + pitch + bytes * run, bytes * (size_t)(x - run));
+            STATS_ADD(bytes_copied, bytes * (x - run));
+        }
+    }
+}
+
+void remove_hseam_inplace(struct rgb_img *im, int *path) {
+    STATS_START(timer);
+    drop_hseam(im->raster, 3 * im->stride, 3, im->height, im->width, path);
+    im->height--;
+    STATS_STOP(timer, STAGE_REMOVE, im->width);
+}
+
+// ----------------------------------------
+// Function: remove_seam_planar / remove_hseam_planar
+// ----------------------------------------
+/*
+   The in-place removals on a planar image: the same moves as
+   remove_seam_inplace and remove_hseam_inplace, done on each plane with
+   one byte per pixel.
+*/
+void remove_seam_planar(struct planar_img *pl, int *path) {
+    STATS_START(timer);
+    int height = pl->height;
+    int width = pl->width;
+
+    for (int c = 0; c < 3; c++) {
+        for (int i = 0; i < height; i++) {
+            uint8_t *row = planar_row(pl, c, i);
+            int seam_col = path[i];
+            memmove(row + seam_col, row + seam_col + 1, (size_t)(width - 1 - seam_col));
+            STATS_ADD(bytes_copied, width - 1 - seam_col);
+        }
+    }
+    pl->width = width - 1;
+    STATS_STOP(timer, STAGE_REMOVE, height);
+}
+
+void remove_hseam_planar(struct planar_img *pl, int *path) {
+    STATS_START(timer);
+    for (int c = 0; c < 3; c++) {
+        drop_hseam(pl->plane[c], pl->stride, 1, pl->height, pl->width, path);
+    }
+    pl->height--;
+    STATS_STOP(timer, STAGE_REMOVE, pl->width);
+}
+
+// ----------------------------------------
+// Function: carve_opts_default
+// ----------------------------------------
+/*
+   Fills in the default carving options: everything on the calling thread,
+   one seam per DP pass.
+*/
+void carve_opts_default(struct carve_opts *opts) {
+    opts->threads = 1;
+    opts->batch = 1;
+    opts->planar = 0;
+    opts->pyramid = 0;
+    opts->energy = ENERGY_DUAL;
+}
+
+// ----------------------------------------
+// Function: carve_init
+// ----------------------------------------
+/*
+   Sets up a carving context around an image with the default options.
+*/
+void carve_init(struct carve_ctx *ctx, struct rgb_img *im) {
+    carve_init_opts(ctx, im, NULL);
+}
+
+// ----------------------------------------
+// Helper: scratch_bytes
+// ----------------------------------------
+/*
+   Size of the single arena carve_alloc sets up for images up to
+   height x width: energy map (no values for forward energy), DP tables,
+   seam paths and batch buffers.
+*/
+static size_t scratch_bytes(size_t height, size_t width, int parallel, int batch_size, int planar, int band,
+                            int forward) {
+    size_t bytes = arena_size(sizeof(struct energy_map));
+    if (!forward) bytes += arena_size(height * width);                                  // Energy map
+    bytes += seam_dp_bytes(height, width, parallel ? seam_dp_parallel_rows() : 2);
+    bytes += arena_size(sizeof(int) * height) + arena_size(sizeof(int) * width);         // path, hpath
+    if (batch_size > 1) {
+        bytes += seam_batch_bytes(height, width, batch_size);
+        bytes += arena_size(sizeof(int) * height * batch_size);                          // paths
+    }
+    if (planar) {
+        bytes += arena_size(sizeof(struct planar_img)) + arena_size(planar_bytes(height, width));
+    }
+    if (band > 0) bytes += seam_pyramid_bytes(height, width, band);
+    return bytes;
+}
+
+// ----------------------------------------
+// Function: carve_bytes
+// ----------------------------------------
+size_t carve_bytes(size_t height, size_t width, const struct carve_opts *opts) {
+    struct carve_opts defaults;
+    if (opts == NULL) {
+        carve_opts_default(&defaults);
+        opts = &defaults;
+    }
+    int forward = (opts->energy == ENERGY_FORWARD);
+    return scratch_bytes(height, width, opts->threads > 1, (opts->batch > 1 && !forward) ? opts->batch : 1,
+                         opts->planar, (opts->pyramid > 0 && !forward) ? opts->pyramid : 0, forward);
+}
+
+// ----------------------------------------
+// Helper: carve_alloc / carve_release
+// ----------------------------------------
+/*
+   Allocate and free the context's working memory (energy map, DP tables,
+   seam paths, batch buffers, planar copy, pyramid) for images up to height x width,
+   all in one arena block. use_planar says whether the planar copy is
+   wanted, so it survives reallocation in carve_reset.
+*/
+static void carve_alloc(struct carve_ctx *ctx, size_t height, size_t width, int use_planar) {
+    struct seam_arena *arena = &ctx->arena;
+    int forward = (ctx->energy == ENERGY_FORWARD);
+    arena_init(arena, scratch_bytes(height, width, ctx->pool != NULL, ctx->batch_size, use_planar,
+                                    ctx->pyramid_band, forward));
+
+    ctx->grad = (struct energy_map *)arena_alloc(arena, sizeof(struct energy_map));
+    init_energy_map(ctx->grad, forward ? NULL : (uint8_t *)arena_alloc(arena, height * width), height, width);
+    ctx->grad->energy = ctx->energy;
+    seam_dp_init_arena(&ctx->dp, height, width, (ctx->pool != NULL) ? seam_dp_parallel_rows() : 2, arena);
+    ctx->path = (int *)arena_alloc(arena, sizeof(int) * height);   // Last removed seam
+    ctx->hpath = (int *)arena_alloc(arena, sizeof(int) * width);   // Last removed horizontal seam
+
+    ctx->paths = ctx->path;  // A batch of one is just the last seam
+    if (ctx->batch_size > 1) {
+        seam_batch_init_arena(&ctx->batch, height, width, ctx->batch_size, arena);
+        ctx->paths = (int *)arena_alloc(arena, sizeof(int) * height * ctx->batch_size);
+    }
+    if (ctx->pyramid_band > 0) {
+        seam_pyramid_init_arena(&ctx->pyramid, height, width, ctx->pyramid_band, arena);
+    }
+    ctx->planar = NULL;
+    if (use_planar) {
+        ctx->planar = (struct planar_img *)arena_alloc(arena, sizeof(struct planar_img));
+        init_planar(ctx->planar, (uint8_t *)arena_alloc(arena, planar_bytes(height, width)), height, width);
+    }
+    ctx->cap_height = height;
+    ctx->cap_width = width;
+}
+
+static void carve_release(struct carve_ctx *ctx) {
+    arena_free(&ctx->arena);
+}
+
+// ----------------------------------------
+// Helper: ctx_refill / ctx_find_v / ctx_find_h / ctx_remove_v / ctx_remove_h
+// ----------------------------------------
+/*
+   The energy pass, the seam searches and the seam removals on whichever
+   layout the context carves. With forward energy the searches read the
+   pixels and the energy map only follows the image's size. In planar
+   mode ctx->im's dimensions are kept in step with the planar copy so the
+   rest of the context can keep reading them. A mask is carved with every
+   seam removed.
+*/
+static void ctx_refill(struct carve_ctx *ctx) {
+    if (ctx->planar != NULL) {
+        planar_from_rgb(ctx->im, ctx->planar);
+        refill_energy_planar(ctx->planar, ctx->grad, ctx->pool);
+    } else {
+        refill_energy(ctx->im, ctx->grad, ctx->pool);
+    }
+}
+
+// The pixels the forward-energy DP reads: the planar copy if there is one
+static void ctx_pixels(struct carve_ctx *ctx, struct seam_pixels *px) {
+    if (ctx->planar != NULL) seam_pixels_planar(px, ctx->planar);
+    else seam_pixels_rgb(px, ctx->im);
+}
+
+/*
+   The seam cost without the mask weights the DP added, and the mask
+   codes the seam crosses (all zero without a mask).
+*/
+static uint32_t ctx_unmask(struct carve_ctx *ctx, const int *path, int horizontal, uint32_t cost,
+                           size_t hits[MASK_CODES]) {
+    if (ctx->mask == NULL) {
+        memset(hits, 0, sizeof(size_t) * MASK_CODES);
+        return cost;
+    }
+    mask_tally(ctx->mask, path, horizontal, hits);
+    for (int c = 0; c < MASK_CODES; c++) cost -= (uint32_t)hits[c] * ctx->dp.mask_weight[c];
+    return cost;
+}
+
+// The cheapest vertical seam into ctx->path, by whichever search the context uses
+static uint32_t ctx_find_v(struct carve_ctx *ctx, size_t hits[MASK_CODES]) {
+    uint32_t cost;
+    if (ctx->energy == ENERGY_FORWARD) {
+        struct seam_pixels px;
+        ctx_pixels(ctx, &px);
+        if (ctx->pool != NULL) cost = seam_dp_find_forward_parallel(&ctx->dp, &px, ctx->path, ctx->pool);
+        else cost = seam_dp_find_forward(&ctx->dp, &px, ctx->path);
+    } else if (ctx->pyramid_band > 0 && ctx->mask == NULL) {
+        cost = seam_pyramid_find(&ctx->pyramid, &ctx->dp, ctx->grad, ctx->path);
+    } else if (ctx->pool != NULL) {
+        cost = seam_dp_find_parallel(&ctx->dp, ctx->grad, ctx->path, ctx->pool);
+    } else {
+        cost = seam_dp_find(&ctx->dp, ctx->grad, ctx->path);
+    }
+    return ctx_unmask(ctx, ctx->path, 0, cost, hits);
+}
+
+// The cheapest horizontal seam into ctx->hpath
+static uint32_t ctx_find_h(struct carve_ctx *ctx, size_t hits[MASK_CODES]) {
+    uint32_t cost;
+    if (ctx->energy == ENERGY_FORWARD) {
+        struct seam_pixels px;
+        ctx_pixels(ctx, &px);
+        cost = seam_dp_find_forward_h(&ctx->dp, &px, ctx->hpath);
+    } else {
+        cost = seam_dp_find_h(&ctx->dp, ctx->grad, ctx->hpath);
+    }
+    return ctx_unmask(ctx, ctx->hpath, 1, cost, hits);
+}
+
+static void ctx_remove_v(struct carve_ctx *ctx, int *path) {
+    if (ctx->mask != NULL) mask_remove_seam(ctx->mask, path);
+    if (ctx->planar != NULL) {
+        remove_seam_planar(ctx->planar, path);
+        ctx->im->width = ctx->planar->width;
+        update_energy_planar(ctx->planar, ctx->grad, path);
+    } else {
+        remove_seam_inplace(ctx->im, path);
+        update_energy(ctx->im, ctx->grad, path);
+    }
+}
+
+static void ctx_remove_h(struct carve_ctx *ctx, int *path) {
+    if (ctx->mask != NULL) mask_remove_hseam(ctx->mask, path);
+    if (ctx->planar != NULL) {
+        remove_hseam_planar(ctx->planar, path);
+        ctx->im->height = ctx->planar->height;
+        update_energy_h_planar(ctx->planar, ctx->grad, path);
+    } else {
+        remove_hseam_inplace(ctx->im, path);
+        update_energy_h(ctx->im, ctx->grad, path);
+    }
+}
+
+// ----------------------------------------
+// Function: carve_init_opts
+// ----------------------------------------
+/*
+   Sets up a carving context around an image. The context takes ownership of
+   the image and computes its energy map once; both are then carved in place.
+   All working memory (DP tables, seam path, worker threads) is set up here
+   for the starting dimensions, so carve_seam does not allocate.
+*/
+void carve_init_opts(struct carve_ctx *ctx, struct rgb_img *im, const struct carve_opts *opts) {
+    struct carve_opts defaults;
+    if (opts == NULL) {
+        carve_opts_default(&defaults);
+        opts = &defaults;
+    }
+
+    ctx->im = im;
+    ctx->pool = (opts->threads > 1) ? pool_create(opts->threads) : NULL;
+    ctx->energy = opts->energy;
+    int forward = (ctx->energy == ENERGY_FORWARD);    // One exact seam per DP
+    ctx->batch_size = (opts->batch > 1 && !forward) ? opts->batch : 1;
+    ctx->pyramid_band = (opts->pyramid > 0 && !forward) ? opts->pyramid : 0;
+    ctx->removed_energy = 0;
+    ctx->mask = NULL;
+    ctx->mask_direction = CARVE_VERTICAL;
+    carve_alloc(ctx, im->height, im->width, opts->planar);
+    ctx_refill(ctx);  // Energy map computed once
+}
+
+// ----------------------------------------
+// Function: carve_reset
+// ----------------------------------------
+/*
+   Moves a context on to a new image, keeping its working memory and
+   threads. The previous image is freed. Buffers are only reallocated when
+   the new image is taller or wider than any image the context has held,
+   and then grow to cover both, so a worker that carves many images of
+   similar sizes stops allocating after the first few.
+*/
+void carve_reset(struct carve_ctx *ctx, struct rgb_img *im) {
+    carve_reset_energy(ctx, im, NULL);
+}
+
+// ----------------------------------------
+// Function: carve_reset_energy
+// ----------------------------------------
+/*
+   carve_reset, with the energy pass replaced by a row-by-row copy of grad
+   when one is given. The planar copy is still made from the new image.
+*/
+void carve_reset_energy(struct carve_ctx *ctx, struct rgb_img *im, const struct energy_map *grad) {
+    destroy_image(ctx->im);
+    ctx->im = im;
+    ctx->removed_energy = 0;
+    carve_set_mask(ctx, NULL);  // The mask belonged to the old image
+
+    if (im->height > ctx->cap_height || im->width > ctx->cap_width) {
+        size_t height = (im->height > ctx->cap_height) ? im->height : ctx->cap_height;
+        size_t width = (im->width > ctx->cap_width) ? im->width : ctx->cap_width;
+        int use_planar = (ctx->planar != NULL);
+        carve_release(ctx);
+        carve_alloc(ctx, height, width, use_planar);
+    }
+    if (grad == NULL || ctx->energy == ENERGY_FORWARD) {
+        ctx_refill(ctx);  // The map's stride stays at the capacity
+        return;
+    }
+    if (ctx->planar != NULL) planar_from_rgb(ctx->im, ctx->planar);
+    ctx->grad->height = im->height;
+    ctx->grad->width = im->width;
+    for (size_t y = 0; y < im->height; y++) {
+        memcpy(energy_row(ctx->grad, y), energy_row(grad, y), im->width);
+    }
+}
+
+// ----------------------------------------
+// Function: carve_seam
+// ----------------------------------------
+/*
+   Finds the lowest-energy vertical seam of the context's image and removes
+   it from both the image and its energy map. The removed seam is left in
+   ctx->path. Returns 0, or -1 if the image is only one column wide.
+*/
+int carve_seam(struct carve_ctx *ctx) {
+    if (ctx->im->width <= 1) return -1;
+
+    size_t hits[MASK_CODES];
+    uint32_t cost = ctx_find_v(ctx, hits);              // Compact DP (or pyramid) + backtrack
+    ctx_remove_v(ctx, ctx->path);
+    ctx->removed_energy += cost;
+    STATS_ADD(seams, 1);
+    return 0;
+}
+
+// ----------------------------------------
+// Function: carve_remove_seam
+// ----------------------------------------
+int carve_remove_seam(struct carve_ctx *ctx, const int *path, uint32_t cost) {
+    if (ctx->im->width <= 1) return -1;
+
+    if (ctx->path != path) memcpy(ctx->path, path, sizeof(int) * ctx->im->height);
+    ctx_remove_v(ctx, ctx->path);
+    ctx->removed_energy += cost;
+    STATS_ADD(seams, 1);
+    return 0;
+}
+
+// ----------------------------------------
+// Function: carve_seams
+// ----------------------------------------
+/*
+   Removes up to n seams (at most the context's batch size) with a single
+   DP pass: the seams are extracted together with seam_batch_find, removed
+   in one compaction pass, and the energy map is recomputed once. With a
+   batch size of 1 this is carve_seam. Returns the number of seams removed
+   (0 once the image is one column wide). ctx->paths holds the removed
+   seams in the coordinates of the image before the batch.
+*/
+int carve_seams(struct carve_ctx *ctx, int n) {
+    if (ctx->im->width <= 1 || n <= 0) return 0;
+    if (ctx->batch_size == 1 || n == 1 || ctx->mask != NULL) {
+        carve_seam(ctx);
+        if (ctx->paths != ctx->path) memcpy(ctx->paths, ctx->path, sizeof(int) * ctx->im->height);
+        return 1;
+    }
+
+    const uint32_t *last = (ctx->pool != NULL) ? seam_dp_fill_parallel(&ctx->dp, ctx->grad, ctx->pool)
+                                               : seam_dp_fill(&ctx->dp, ctx->grad);
+    uint64_t energy;
+    int k = (n < ctx->batch_size) ? n : ctx->batch_size;
+    int found = seam_batch_find(&ctx->batch, &ctx->dp, last, ctx->grad, k, ctx->paths, &energy);
+
+    if (ctx->planar != NULL) {
+        seam_batch_remove_planar(&ctx->batch, ctx->planar, ctx->paths, found);
+        ctx->im->width = ctx->planar->width;
+        refill_energy_planar(ctx->planar, ctx->grad, ctx->pool);
+    } else {
+        seam_batch_remove(&ctx->batch, ctx->im, ctx->paths, found);
+        refill_energy(ctx->im, ctx->grad, ctx->pool);
+    }
+    ctx->removed_energy += energy;
+    STATS_ADD(seams, found);
+    return found;
+}
+
+// ----------------------------------------
+// Function: carve_seam_h
+// ----------------------------------------
+/*
+   Finds the lowest-energy horizontal seam and removes it from the image
+   and its energy map, all on the row-major raster. The removed seam is
+   left in ctx->hpath. Returns 0, or -1 if the image is only one row high.
+*/
+int carve_seam_h(struct carve_ctx *ctx) {
+    if (ctx->im->height <= 1) return -1;
+
+    size_t hits[MASK_CODES];
+    uint32_t cost = ctx_find_h(ctx, hits);
+    ctx_remove_h(ctx, ctx->hpath);
+    ctx->removed_energy += cost;
+    STATS_ADD(seams, 1);
+    return 0;
+}
+
+// ----------------------------------------
+// Function: carve_step
+// ----------------------------------------
+/*
+   One step towards target_width x target_height. When only one dimension
+   is too large, the seam comes from that direction. When both are, both
+   DPs are run and the seam with the lower energy per pixel wins
+   (cost_v / height against cost_h / width; vertical on ties), so the image
+   loses columns and rows in the order its content calls for. This greedy
+   choice needs two DPs per step but no transposed copy and no table over
+   all (rows, columns) orders. With a mask, the seam crossing fewer
+   protected pixels wins first, then the one crossing more removal pixels.
+*/
+int carve_step(struct carve_ctx *ctx, size_t target_width, size_t target_height) {
+    struct rgb_img *im = ctx->im;
+    int wide = im->width > target_width && im->width > 1;
+    int tall = im->height > target_height && im->height > 1;
+
+    if (!wide && !tall) return CARVE_DONE;
+    if (!tall) {
+        carve_seam(ctx);
+        return CARVE_VERTICAL;
+    }
+    if (!wide) {
+        carve_seam_h(ctx);
+        return CARVE_HORIZONTAL;
+    }
+
+    // Both: trace each seam before the next fill overwrites the parent codes
+    size_t hits_v[MASK_CODES], hits_h[MASK_CODES];
+    uint32_t cost_v = ctx_find_v(ctx, hits_v);
+    uint32_t cost_h = ctx_find_h(ctx, hits_h);
+
+    int vertical = (uint64_t)cost_v * im->width <= (uint64_t)cost_h * im->height;
+    if (hits_v[MASK_REMOVE] != hits_h[MASK_REMOVE]) vertical = hits_v[MASK_REMOVE] > hits_h[MASK_REMOVE];
+    if (hits_v[MASK_PROTECT] != hits_h[MASK_PROTECT]) vertical = hits_v[MASK_PROTECT] < hits_h[MASK_PROTECT];
+    if (vertical) {
+        ctx_remove_v(ctx, ctx->path);
+        ctx->removed_energy += cost_v;
+        STATS_ADD(seams, 1);
+        return CARVE_VERTICAL;
+    }
+    ctx_remove_h(ctx, ctx->hpath);
+    ctx->removed_energy += cost_h;
+    STATS_ADD(seams, 1);
+    return CARVE_HORIZONTAL;
+}
+
+// ----------------------------------------
+// Function: carve_set_mask
+// ----------------------------------------
+/*
+   Hands the mask to the DP working memory as well, and picks the
+   direction for object removal: vertical seams when the removal region
+   spans no more columns than rows.
+*/
+int carve_set_mask(struct carve_ctx *ctx, struct seam_mask *mask) {
+    if (mask != NULL && (mask->height != ctx->im->height || mask->width != ctx->im->width)) return -1;
+    ctx->mask = mask;
+    ctx->dp.mask = mask;
+    ctx->mask_direction = CARVE_VERTICAL;
+    if (mask != NULL && mask->count[MASK_REMOVE] > 0) {
+        size_t rows, columns;
+        mask_extent(mask, MASK_REMOVE, &rows, &columns);
+        if (columns > rows) ctx->mask_direction = CARVE_HORIZONTAL;
+    }
+    return 0;
+}
+
+// ----------------------------------------
+// Helper: ctx_find_pinned
+// ----------------------------------------
+/*
+   The cheapest seam in the removal direction that crosses a removal pixel
+   and no protected one, into ctx->path or ctx->hpath: the DP is pinned to
+   each row (vertical) or column (horizontal) holding removal pixels until
+   one gives such a seam. Returns 0 when none does.
+*/
+static int ctx_find_pinned(struct carve_ctx *ctx, uint32_t *cost) {
+    int vertical = (ctx->mask_direction == CARVE_VERTICAL);
+    int lines = vertical ? (int)ctx->mask->height : (int)ctx->mask->width;
+    int across = vertical ? (int)ctx->mask->width : (int)ctx->mask->height;
+    size_t hits[MASK_CODES];
+
+    for (int line = 0; line < lines; line++) {
+        int i = 0;
+        while (i < across && get_mask(ctx->mask, vertical ? line : i, vertical ? i : line) != MASK_REMOVE) i++;
+        if (i == across) continue;                           // Nothing to remove on this line
+
+        ctx->dp.pin = line;
+        *cost = vertical ? ctx_find_v(ctx, hits) : ctx_find_h(ctx, hits);
+        ctx->dp.pin = -1;
+        int at = vertical ? ctx->path[line] : ctx->hpath[line];
+        int code = vertical ? get_mask(ctx->mask, line, at) : get_mask(ctx->mask, at, line);
+        if (hits[MASK_PROTECT] == 0 && code == MASK_REMOVE) return 1;
+    }
+    return 0;
+}
+
+// ----------------------------------------
+// Function: carve_remove_step
+// ----------------------------------------
+/*
+   The seam is found first and only removed if it takes at least one
+   removal pixel with it, so a removal that cannot finish stops without
+   carving anything it does not need, and only if it keeps every
+   protected pixel. When the weighted seam misses, the pinned search
+   decides. When the removal direction has no seam left to
+   give (the image is down to one column or row, or every seam is
+   blocked), the other direction is tried and kept from then on.
+*/
+int carve_remove_step(struct carve_ctx *ctx) {
+    size_t hits[MASK_CODES];
+    uint32_t cost;
+    if (ctx->mask == NULL || ctx->mask->count[MASK_REMOVE] == 0) return CARVE_DONE;
+
+    for (int tries = 0; tries < 2; tries++) {
+        int vertical = (ctx->mask_direction == CARVE_VERTICAL);
+        if ((vertical ? ctx->im->width : ctx->im->height) > 1) {
+            cost = vertical ? ctx_find_v(ctx, hits) : ctx_find_h(ctx, hits);
+            if ((hits[MASK_REMOVE] > 0 && hits[MASK_PROTECT] == 0) || ctx_find_pinned(ctx, &cost)) {
+                if (vertical) ctx_remove_v(ctx, ctx->path);
+                else ctx_remove_h(ctx, ctx->hpath);
+                ctx->removed_energy += cost;
+                STATS_ADD(seams, 1);
+                return ctx->mask_direction;
+            }
+        }
+        ctx->mask_direction = vertical ? CARVE_HORIZONTAL : CARVE_VERTICAL;  // Try the other side
+    }
+    return CARVE_STUCK;
+}
+
+// ----------------------------------------
+// Function: carve_image
+// ----------------------------------------
+/*
+   Merges the planar copy back into the interleaved raster (whose stride
+   is the original width, so the carved rows always fit).
+*/
+struct rgb_img *carve_image(struct carve_ctx *ctx) {
+    if (ctx->planar != NULL) planar_to_rgb(ctx->planar, ctx->im);
+    return ctx->im;
+}
+
+// ----------------------------------------
+// Function: carve_free
+// ----------------------------------------
+/*
+   Frees the context's image, energy map and working memory.
+*/
+void carve_free(struct carve_ctx *ctx) {
+    destroy_image(ctx->im);
+    carve_release(ctx);
+    pool_destroy(ctx->pool);
+}
+
+// ----------------------------------------
+// Function: carve_detach
+// ----------------------------------------
+/*
+   Frees everything but the image, which is brought up to date and
+   handed to the caller.
+*/
+struct rgb_img *carve_detach(struct carve_ctx *ctx) {
+    struct rgb_img *im = carve_image(ctx);
+    carve_release(ctx);
+    pool_destroy(ctx->pool);
+    return im;
+}
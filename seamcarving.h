@@ -1,75 +1,453 @@
-/*
-Seam Carving Header File
-Author: Tannaz Chowdhury  
-GitHub: TannazC  
-Date: 2025  
-
-This header file declares the core seam carving functions used in
-seamcarving.c. It serves as an interface between files, allowing
-functions defined in one source file to be used in another.
-
-Each function here operates on image structures defined in c_img.h
-and contributes to the dynamic seam carving process.
-*/
-
-#ifndef SEAMCARVING_H           // Include guard - prevents multiple includes
-#define SEAMCARVING_H
-
-#include "c_img.h"              // Required for struct rgb_img definitions
-
-// ----------------------------------------
-// Function: calc_energy
-// ----------------------------------------
-/*
-   Calculates the dual-gradient energy for each pixel in the input image.
-   Stores grayscale energy values in a new output image.
-   
-   Parameters:
-     im   - pointer to the input image
-     grad - pointer to the address of the gradient image to allocate and populate
-*/
-void calc_energy(struct rgb_img *im, struct rgb_img **grad);
-
-// ----------------------------------------
-// Function: dynamic_seam
-// ----------------------------------------
-/*
-   Builds a dynamic programming cost array.
-   Each entry contains the minimum cumulative energy to reach that pixel.
-
-   Parameters:
-     grad     - grayscale energy image
-     best_arr - pointer to the address of the output 1D cost array
-*/
-void dynamic_seam(struct rgb_img *grad, double **best_arr);
-
-// ----------------------------------------
-// Function: recover_path
-// ----------------------------------------
-/*
-   Backtracks from the bottom of the best_arr to find a vertical seam
-   with the lowest energy. The seam is returned as an array of column indices.
-
-   Parameters:
-     best   - 1D cost array
-     height - image height
-     width  - image width
-     path   - pointer to array to store seam path (column indices per row)
-*/
-void recover_path(double *best, int height, int width, int **path);
-
-// ----------------------------------------
-// Function: remove_seam
-// ----------------------------------------
-/*
-   Removes a vertical seam from the input image, creating a new image
-   with one fewer column.
-
-   Parameters:
-     src   - original source image
-     dest  - pointer to the address of the new image with seam removed
-     path  - array of column indices indicating seam pixels to remove
-*/
-void remove_seam(struct rgb_img *src, struct rgb_img **dest, int *path);
-
-#endif  // End of include guard for SEAMCARVING_H
+/*
+Seam Carving Header File
+Author: Tannaz Chowdhury  
+GitHub: TannazC  
+Date: 2025  
+
+This header file declares the core seam carving functions used in
+seamcarving.c. It serves as an interface between files, allowing
+functions defined in one source file to be used in another.
+
+Each function here operates on image structures defined in c_img.h
+and contributes to the dynamic seam carving process.
+*/
+
+#ifndef SEAMCARVING_H           // Include guard - prevents multiple includes
+#define SEAMCARVING_H
+
+#include "c_img.h"              // Required for struct rgb_img definitions
+#include "seam_dp.h"            // Compact DP working memory
+#include "seam_batch.h"         // Multi-seam batch working memory
+#include "seam_arena.h"         // Block holding the working memory
+#include "energy_map.h"         // Single-plane energy maps
+#include "planar_img.h"         // Planar working copy of the image
+#include "seam_pyramid.h"       // Coarse-to-fine seam search
+#include "energy_simd.h"        // ENERGY_* values for carve_opts.energy
+#include "seam_mask.h"          // Protect / remove masks
+
+struct thread_pool;             // From thread_pool.h
+
+// Results of carve_step
+#define CARVE_DONE        0     // Already at the target size
+#define CARVE_VERTICAL    1     // Removed a column seam (ctx->path)
+#define CARVE_HORIZONTAL  2     // Removed a row seam (ctx->hpath)
+#define CARVE_STUCK      -1     // carve_remove_step: no seam reaches the pixels left to remove
+
+// ----------------------------------------
+// Struct: carve_opts
+// ----------------------------------------
+/*
+   Options for a carving context. Fill with carve_opts_default first, then
+   change what is needed.
+
+   Fields:
+     threads - threads for the energy and DP passes (1 = no thread pool)
+     batch   - most seams carve_seams removes per DP pass (1 = exact carving)
+     planar  - carve a planar copy of the image (see planar_img.h); call
+               carve_image before reading ctx->im's pixels
+     pyramid - band for the coarse-to-fine vertical seam search (see
+               seam_pyramid.h); 0 = exact DP. Horizontal seams and
+               batches of more than one seam always use the exact DP
+     energy  - ENERGY_DUAL (default), ENERGY_L1 (cheaper) or
+               ENERGY_FORWARD (see energy_simd.h). Forward energy is
+               computed inside the DP from the pixels, so there is no
+               energy map to keep up to date; it finds one exact seam per
+               DP, so batch and pyramid are ignored with it
+*/
+struct carve_opts {
+    int threads;
+    int batch;
+    int planar;
+    int pyramid;
+    int energy;
+};
+
+// ----------------------------------------
+// Struct: carve_ctx
+// ----------------------------------------
+/*
+   State for carving many seams from one image without reallocating it.
+   The image and its energy map keep the stride of the original image while
+   their width shrinks, so memory stays at one image (plus its energy map).
+
+   Fields:
+     im   - image being carved (owned by the context)
+     grad - energy map of im, maintained with update_energy
+     dp   - compact DP working memory, sized for the starting dimensions
+     path - the most recently removed seam (column index per row)
+     hpath - the most recently removed horizontal seam (row index per column)
+     pool - worker threads, created once per carve (NULL when single-threaded)
+     removed_energy - total energy of all pixels removed so far
+     batch_size     - seams per DP pass in carve_seams
+     batch          - batch working memory (only when batch_size > 1)
+     paths          - the seams removed by the last carve_seams call, in
+                      the coordinates before that call (same as path when
+                      batch_size is 1)
+     cap_height, cap_width - largest image the working memory fits
+     planar - planar copy the seams are removed from (NULL unless the
+              planar option is set); ctx->im's height and width follow it,
+              its pixels are only brought up to date by carve_image
+     pyramid_band - band of the pyramid search (0 = exact DP)
+     pyramid      - pyramid working memory (only when pyramid_band > 0)
+     energy - energy function (carve_opts.energy); grad holds it, and for
+              forward energy grad has no values, only the image's size
+     mask   - protect / remove mask carved along with the image (NULL =
+              none; owned by the caller, see carve_set_mask)
+     mask_direction - CARVE_VERTICAL or CARVE_HORIZONTAL: the seams
+              carve_remove_step uses on the mask's removal region (it
+              switches when that direction has no seam left)
+     arena - the one block grad, dp, path, hpath, batch, paths, planar and
+             pyramid live in (carve_bytes bytes)
+*/
+struct carve_ctx {
+    struct rgb_img *im;
+    struct energy_map *grad;
+    struct seam_dp dp;
+    int *path;
+    int *hpath;
+    struct thread_pool *pool;
+    uint64_t removed_energy;
+    int batch_size;
+    struct seam_batch batch;
+    int *paths;
+    size_t cap_height;
+    size_t cap_width;
+    struct planar_img *planar;
+    int pyramid_band;
+    struct seam_pyramid pyramid;
+    int energy;
+    struct seam_mask *mask;
+    int mask_direction;
+    struct seam_arena arena;
+};
+
+// ----------------------------------------
+// Function: calc_energy
+// ----------------------------------------
+/*
+   Calculates the dual-gradient energy for each pixel in the input image.
+   Stores the energy values (one byte per pixel) in a new energy map;
+   energy_map_to_img turns it into a grayscale image for debugging.
+   
+   Parameters:
+     im   - pointer to the input image
+     grad - pointer to the address of the energy map to allocate and populate
+*/
+void calc_energy(struct rgb_img *im, struct energy_map **grad);
+
+// ----------------------------------------
+// Function: pixel_energy
+// ----------------------------------------
+/*
+   The scaled dual-gradient energy of pixel (y, x), computed directly with
+   get_pixel. Slow; it is the reference the fast energy paths are checked
+   against. pixel_energy_as computes another map energy (ENERGY_DUAL or
+   ENERGY_L1).
+*/
+uint8_t pixel_energy(const struct rgb_img *im, int y, int x);
+uint8_t pixel_energy_as(const struct rgb_img *im, int y, int x, int energy);
+
+// ----------------------------------------
+// Function: calc_energy_threads
+// ----------------------------------------
+/*
+   Same as calc_energy, with the rows split across the threads of pool
+   (NULL runs everything on the calling thread). The result is identical
+   for any number of threads.
+*/
+void calc_energy_threads(struct rgb_img *im, struct energy_map **grad, struct thread_pool *pool);
+
+// ----------------------------------------
+// Function: refill_energy
+// ----------------------------------------
+/*
+   Recomputes an existing energy map for the image's current size, in
+   place: calc_energy into a caller's map (from calc_energy, or
+   init_energy_map on a buffer of at least height * width bytes). pool may
+   be NULL. The map keeps its energy function (grad->energy); a forward
+   energy map only takes the image's size.
+*/
+void refill_energy(struct rgb_img *im, struct energy_map *grad, struct thread_pool *pool);
+
+// ----------------------------------------
+// Function: update_energy
+// ----------------------------------------
+/*
+   Updates an energy map produced by calc_energy after a seam was removed,
+   instead of recomputing it from scratch. The seam is removed from the map
+   in place (its stride is kept) and only pixels adjacent to the removed seam
+   are recomputed, so the result is identical to calc_energy on the carved
+   image.
+
+   Parameters:
+     im   - image after the seam was removed (one column narrower than grad)
+     grad - energy map of the image before the seam was removed; updated in place
+     path - the seam that was removed (column index per row)
+*/
+void update_energy(struct rgb_img *im, struct energy_map *grad, int *path);
+
+// ----------------------------------------
+// Function: update_energy_h
+// ----------------------------------------
+/*
+   update_energy for a horizontal seam: im is one row shorter than grad,
+   path holds the removed row of every column.
+*/
+void update_energy_h(struct rgb_img *im, struct energy_map *grad, int *path);
+
+// ----------------------------------------
+// Function: refill_energy_planar / update_energy_planar / update_energy_h_planar
+// ----------------------------------------
+/*
+   refill_energy, update_energy and update_energy_h for a planar image.
+   The energy map is byte-for-byte the one the interleaved versions give.
+*/
+void refill_energy_planar(struct planar_img *pl, struct energy_map *grad, struct thread_pool *pool);
+void update_energy_planar(struct planar_img *pl, struct energy_map *grad, int *path);
+void update_energy_h_planar(struct planar_img *pl, struct energy_map *grad, int *path);
+
+// ----------------------------------------
+// Function: dynamic_seam
+// ----------------------------------------
+/*
+   Builds a dynamic programming cost array.
+   Each entry contains the minimum cumulative energy to reach that pixel.
+
+   Parameters:
+     grad     - energy map
+     best_arr - pointer to the address of the output 1D cost array
+*/
+void dynamic_seam(struct energy_map *grad, double **best_arr);
+void dynamic_seam_into(struct energy_map *grad, double *best_arr);
+
+// ----------------------------------------
+// Function: recover_path
+// ----------------------------------------
+/*
+   Backtracks from the bottom of the best_arr to find a vertical seam
+   with the lowest energy. The seam is returned as an array of column indices.
+
+   Parameters:
+     best   - 1D cost array
+     height - image height
+     width  - image width
+     path   - pointer to array to store seam path (column indices per row)
+*/
+void recover_path(double *best, int height, int width, int **path);
+void recover_path_into(double *best, int height, int width, int *path);
+
+// ----------------------------------------
+// Function: remove_seam
+// ----------------------------------------
+/*
+   Removes a vertical seam from the input image, creating a new image
+   with one fewer column.
+
+   Parameters:
+     src   - original source image
+     dest  - pointer to the address of the new image with seam removed
+     path  - array of column indices indicating seam pixels to remove
+*/
+void remove_seam(struct rgb_img *src, struct rgb_img **dest, int *path);
+
+// ----------------------------------------
+// Function: dynamic_seam_into / recover_path_into / remove_seam_into
+// ----------------------------------------
+/*
+   The same steps writing into buffers the caller provides instead of
+   allocating them, so a loop can size everything once (for example from
+   a seam_arena) and reuse it as the width shrinks:
+     dynamic_seam_into - best_arr holds at least height * width doubles
+     recover_path_into - path holds at least height ints
+     remove_seam_into  - dest's raster holds at least height rows of
+                         dest->stride >= src->width - 1 pixels; its height
+                         and width are set, its stride kept
+   Together with refill_energy (for calc_energy) they give results
+   identical to the allocating versions.
+*/
+void remove_seam_into(struct rgb_img *src, struct rgb_img *dest, int *path);
+
+// ----------------------------------------
+// Function: remove_seam_inplace
+// ----------------------------------------
+/*
+   Removes a vertical seam from an image in place: each row's pixels right of
+   the seam are moved one column left and the width shrinks by one. The
+   stride and the raster allocation are unchanged.
+
+   Parameters:
+     im   - image to carve
+     path - array of column indices indicating seam pixels to remove
+*/
+void remove_seam_inplace(struct rgb_img *im, int *path);
+
+// ----------------------------------------
+// Function: remove_hseam_inplace
+// ----------------------------------------
+/*
+   Removes a horizontal seam from an image in place: in each column the
+   pixels below the seam move up one row and the height shrinks by one.
+   The raster is processed row by row; no transposed copy is made.
+
+   Parameters:
+     im   - image to carve
+     path - array of row indices indicating seam pixels to remove (one per column)
+*/
+void remove_hseam_inplace(struct rgb_img *im, int *path);
+
+// ----------------------------------------
+// Function: remove_seam_planar / remove_hseam_planar
+// ----------------------------------------
+/*
+   remove_seam_inplace and remove_hseam_inplace for a planar image: each
+   plane is carved in place, its stride unchanged.
+*/
+void remove_seam_planar(struct planar_img *pl, int *path);
+void remove_hseam_planar(struct planar_img *pl, int *path);
+
+// ----------------------------------------
+// Function: carve_opts_default / carve_init_opts
+// ----------------------------------------
+/*
+   carve_opts_default fills in the default options. carve_init_opts is
+   carve_init with options (NULL means the defaults).
+*/
+void carve_opts_default(struct carve_opts *opts);
+void carve_init_opts(struct carve_ctx *ctx, struct rgb_img *im, const struct carve_opts *opts);
+
+// ----------------------------------------
+// Function: carve_bytes
+// ----------------------------------------
+/*
+   Bytes of working memory a context allocates for a height x width image
+   with the given options (NULL means the defaults), as one block at
+   carve_init. Carving allocates nothing after that, so a job's peak memory
+   is this plus the image (3 * height * width bytes) and the thread stacks.
+*/
+size_t carve_bytes(size_t height, size_t width, const struct carve_opts *opts);
+
+// ----------------------------------------
+// Function: carve_init / carve_seam / carve_free
+// ----------------------------------------
+/*
+   carve_init takes ownership of im and computes its energy map.
+   carve_seam removes the lowest-energy vertical seam from the image and
+   its energy map (with the pyramid option: the lowest within the band
+   around the coarse seam); returns 0, or -1 when the image is one column
+   wide.
+   carve_free releases the image, the energy map, the working memory and
+   the worker threads.
+*/
+void carve_init(struct carve_ctx *ctx, struct rgb_img *im);
+int carve_seam(struct carve_ctx *ctx);
+void carve_free(struct carve_ctx *ctx);
+
+// ----------------------------------------
+// Function: carve_reset
+// ----------------------------------------
+/*
+   Hands the context a new image (taking ownership and freeing the old
+   one) and computes its energy map, reusing the working memory and
+   threads. Memory only grows when the image exceeds the largest one seen.
+*/
+void carve_reset(struct carve_ctx *ctx, struct rgb_img *im);
+
+// ----------------------------------------
+// Function: carve_reset_energy / carve_remove_seam
+// ----------------------------------------
+/*
+   The pieces a caller with its own seam search needs. carve_reset_energy
+   is carve_reset with the new image's energy map supplied (copied in,
+   e.g. one updated incrementally from the previous frame) instead of
+   computed (a forward-energy context has no map and ignores grad).
+   carve_remove_seam removes a vertical seam found elsewhere
+   from the image and the energy map, copying it to ctx->path and adding
+   cost to ctx->removed_energy; it returns -1 if the image is one column
+   wide.
+*/
+void carve_reset_energy(struct carve_ctx *ctx, struct rgb_img *im, const struct energy_map *grad);
+int carve_remove_seam(struct carve_ctx *ctx, const int *path, uint32_t cost);
+
+// ----------------------------------------
+// Function: carve_seams
+// ----------------------------------------
+/*
+   Removes up to min(n, batch) pixel-disjoint seams with one energy pass,
+   one DP and one compaction pass (see seam_batch.h). Returns the number
+   removed; 0 when the image is one column wide. With batch 1 it is the
+   same as carve_seam.
+*/
+int carve_seams(struct carve_ctx *ctx, int n);
+
+// ----------------------------------------
+// Function: carve_seam_h / carve_step
+// ----------------------------------------
+/*
+   carve_seam_h is carve_seam for horizontal seams (returns -1 when the
+   image is one row high). carve_step removes one seam on the way to
+   target_width x target_height, choosing the direction with the cheaper
+   seam per pixel when both dimensions still need to shrink; it returns
+   CARVE_VERTICAL, CARVE_HORIZONTAL, or CARVE_DONE once the image fits.
+*/
+int carve_seam_h(struct carve_ctx *ctx);
+int carve_step(struct carve_ctx *ctx, size_t target_width, size_t target_height);
+
+// ----------------------------------------
+// Function: carve_set_mask
+// ----------------------------------------
+/*
+   Attaches a mask of the image's current size (see seam_mask.h), or
+   detaches it with NULL; returns -1 (and attaches nothing) if the sizes
+   differ. From then on every seam search weighs the mask inside its DP
+   and every removed seam is removed from the mask too, so the caller's
+   mask always matches the image. The caller keeps ownership; carve_reset
+   detaches it. Batches and the pyramid search are not used while a mask
+   is attached. The reported seam costs (removed_energy) leave the mask
+   weights out, and carve_step prefers the direction whose seam crosses
+   fewer protected pixels, then more removal pixels.
+*/
+int carve_set_mask(struct carve_ctx *ctx, struct seam_mask *mask);
+
+// ----------------------------------------
+// Function: carve_remove_step
+// ----------------------------------------
+/*
+   One step of object removal: removes the cheapest seam through the
+   mask's removal pixels, in the direction that crosses the region's
+   narrower side (decided when the mask is attached), so the object goes
+   in about as few seams as it is columns wide or rows high. Returns
+   CARVE_VERTICAL or CARVE_HORIZONTAL, CARVE_DONE as soon as no removal
+   pixel is left (or no mask is attached), or CARVE_STUCK, removing
+   nothing, when neither direction has a seam that reaches a removal
+   pixel without crossing a protected one (the object is walled in, or
+   the image is down to one column in one direction and one row in the
+   other). When the chosen direction runs out of seams the other one is
+   used from then on. On tall images the mask weights are only a preference
+   (see mask_weights); when the cheapest seam misses the object, the DP
+   is pinned (seam_dp.pin) to each line of the region in turn until a
+   seam through it clears the protected pixels.
+*/
+int carve_remove_step(struct carve_ctx *ctx);
+
+// ----------------------------------------
+// Function: carve_image
+// ----------------------------------------
+/*
+   The carved image. In planar mode the planes are merged back into
+   ctx->im first (once per call, so call it when carving is done);
+   otherwise ctx->im is returned as is. The context still owns the image.
+*/
+struct rgb_img *carve_image(struct carve_ctx *ctx);
+
+// ----------------------------------------
+// Function: carve_detach
+// ----------------------------------------
+/*
+   carve_free for a caller that keeps the carved image: returns it (as
+   carve_image does) and frees the rest of the context. The caller then
+   owns the image, so one whose raster it lent to carve_init (init_img)
+   never has to be destroyed by the library.
+*/
+struct rgb_img *carve_detach(struct carve_ctx *ctx);
+
+#endif  // End of include guard for SEAMCARVING_H
@@ -0,0 +1,2418 @@
+/*
+Seam Carving Command-Line Program
+Author: Tannaz Chowdhury
+GitHub: TannazC
+Date: 2025
+
+The seamcarving_compiled program: carves seams from a .bin image and
+writes the results, plus the self-check and timing modes used to verify
+the optimized paths of the library against the original algorithm.
+*/
+
+#define _POSIX_C_SOURCE 200809L  // For clock_gettime
+
+#include <stdio.h>            // Required for printf and file IO
+#include <stdlib.h>           // Required for malloc, free, atoi
+#include <string.h>           // For memcmp, strcmp
+#include <time.h>             // For clock_gettime in --time-threads
+#include <unistd.h>           // For sysconf (default --jobs), getpid
+#include <pthread.h>          // For the --check-service daemon thread
+#include <fcntl.h>            // For AT_FDCWD
+#include <sys/stat.h>         // For stat, utimensat (touching a replaced file)
+#include "c_img.h"            // Custom header to work with image pixel structs
+#include "seamcarving.h"      // Carving library
+#include "seam_dp.h"          // Compact DP, checked against dynamic_seam
+#include "energy_simd.h"      // Energy kernel selection
+#include "seam_order.h"       // Carve once, retarget to any width
+#include "seam_log.h"         // Seam log instead of per-step images
+#include "carve_stats.h"      // Stage timers and counters
+#include "seam_manifest.h"    // Batch mode over many images
+#include "seam_insert.h"      // Enlargement by seam insertion
+#include "thread_pool.h"      // Workers for --insert and widening --target
+#include "seam_batch.h"       // remove_columns for --check-insert
+#include "seam_service.h"     // Carving daemon
+#include "seam_sequence.h"    // Frame sequences
+#include "img_stream.h"       // Band-at-a-time image files
+
+// ----------------------------------------
+// Function: check_energy
+// ----------------------------------------
+/*
+   Test mode: carves `seams` seams while maintaining the energy map with
+   update_energy(), and after every seam compares it byte for byte against a
+   full recompute of the carved image. Runs once for each energy that has a
+   map (dual-gradient and L1). Returns the number of seams whose
+   incremental map differed from the full recompute.
+*/
+static int check_energy(struct rgb_img *im, int seams) {
+    struct carve_ctx ctx;     // Carving context with incrementally maintained energy
+    struct carve_opts opts;
+    struct energy_map *full;  // Reference energy map
+    int failures = 0;
+
+    carve_opts_default(&opts);
+    for (int energy = 0; energy < ENERGY_MAP_KINDS; energy++) {
+        opts.energy = energy;
+        carve_init_opts(&ctx, copy_img(im), &opts);
+        for (int i = 0; i < seams && carve_seam(&ctx) == 0; i++) {
+            create_energy_map(&full, ctx.im->height, ctx.im->width);
+            full->energy = energy;
+            refill_energy(ctx.im, full, NULL);
+            for (size_t y = 0; y < full->height; y++) {
+                if (memcmp(energy_row(ctx.grad, y), energy_row(full, y), full->width) != 0) {
+                    printf("%s seam %d: incremental energy differs from full recompute in row %zu\n",
+                           energy_name(energy), i, y);
+                    failures++;
+                    break;
+                }
+            }
+            destroy_energy_map(full);
+        }
+        carve_free(&ctx);
+    }
+
+    destroy_image(im);
+    return failures;
+}
+
+// ----------------------------------------
+// Function: check_kernels
+// ----------------------------------------
+/*
+   Test mode: computes the energy map of the image (and of `seams` narrower
+   crops of it, so every row tail length gets exercised) with every energy
+   kernel the CPU supports, for each energy with a map (dual-gradient and
+   L1), from the interleaved and from the planar layout, and compares each
+   against the per-pixel reference. Returns the number of mismatching maps.
+*/
+static int first_difference(const struct energy_map *grad, struct rgb_img *im, int energy, int *at_y, int *at_x) {
+    for (int y = 0; y < (int)im->height; y++) {
+        for (int x = 0; x < (int)im->width; x++) {
+            if (get_energy(grad, y, x) != pixel_energy_as(im, y, x, energy)) {
+                *at_y = y;
+                *at_x = x;
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+static int check_kernels(struct rgb_img *im, int seams) {
+    const char *names[] = {"scalar", "sse4.1", "avx2"};
+    int failures = 0;
+    size_t full_width = im->width;
+    struct planar_img *pl;
+
+    create_planar(&pl, im->height, im->width);
+
+    for (int n = 0; n < 3; n++) {
+        if (energy_use_kernel(names[n]) != 0) {
+            printf("%s: not supported here, skipped\n", names[n]);
+            continue;
+        }
+        for (int energy = 0; energy < ENERGY_MAP_KINDS; energy++) {
+            for (int i = 0; i <= seams && (size_t)i < full_width; i++) {
+                struct energy_map *grad;
+                int y, x;
+                im->width = full_width - i;  // Narrower view of the same rows
+                create_energy_map(&grad, im->height, im->width);
+                grad->energy = energy;
+                refill_energy(im, grad, NULL);
+                if (first_difference(grad, im, energy, &y, &x)) {  // One report per map
+                    printf("%s %s: width %zu differs at (%d, %d)\n", names[n], energy_name(energy), im->width, y, x);
+                    failures++;
+                }
+
+                planar_from_rgb(im, pl);  // Same map from the planar kernel
+                refill_energy_planar(pl, grad, NULL);
+                if (first_difference(grad, im, energy, &y, &x)) {
+                    printf("%s %s planar: width %zu differs at (%d, %d)\n", names[n], energy_name(energy),
+                           im->width, y, x);
+                    failures++;
+                }
+                destroy_energy_map(grad);
+            }
+        }
+    }
+
+    destroy_planar(pl);
+    im->width = full_width;
+    energy_use_kernel("auto");
+    destroy_image(im);
+    return failures;
+}
+
+// ----------------------------------------
+// Function: check_dp
+// ----------------------------------------
+/*
+   Test mode: carves `seams` seams and, before each one, runs both the
+   original dynamic_seam + recover_path and the compact seam_dp_find on the
+   same energy map. Returns the number of seams where the two engines chose
+   a different path or reported a different cost.
+*/
+static int check_dp(struct rgb_img *im, int seams) {
+    struct carve_ctx ctx;     // Carving context
+    double *best;             // Reference cost table
+    int *path;                // Reference seam
+    int failures = 0;
+
+    carve_init(&ctx, im);
+    int height = im->height;
+    int *compact = (int *)malloc(sizeof(int) * height);
+
+    for (int i = 0; i < seams && ctx.im->width > 1; i++) {
+        int width = ctx.grad->width;
+        dynamic_seam(ctx.grad, &best);
+        recover_path(best, height, width, &path);
+        uint32_t cost = seam_dp_find(&ctx.dp, ctx.grad, compact);
+
+        double ref_cost = best[(height - 1) * width + path[height - 1]];
+        if (memcmp(path, compact, sizeof(int) * height) != 0 || ref_cost != (double)cost) {
+            printf("seam %d: compact DP found a different seam\n", i);
+            failures++;
+        }
+
+        free(best);
+        free(path);
+        carve_seam(&ctx);
+    }
+
+    free(compact);
+    carve_free(&ctx);
+    return failures;
+}
+
+// ----------------------------------------
+// Function: check_threads
+// ----------------------------------------
+/*
+   Test mode: carves the image twice side by side, once serially and once
+   with `check_thread_count` threads, and compares the energy maps and the
+   seams after every step. Returns the number of seams that differed.
+*/
+static int check_thread_count = 4;
+
+static int check_threads(struct rgb_img *im, int seams) {
+    struct carve_ctx serial, parallel;
+    struct carve_opts opts;
+    struct rgb_img *copy;
+    int failures = 0;
+
+    copy = copy_img(im);
+    carve_init(&serial, im);
+    carve_opts_default(&opts);
+    opts.threads = check_thread_count;
+    carve_init_opts(&parallel, copy, &opts);
+
+    for (int i = 0; i < seams; i++) {
+        for (size_t y = 0; y < serial.grad->height; y++) {
+            if (memcmp(energy_row(serial.grad, y), energy_row(parallel.grad, y), serial.grad->width) != 0) {
+                printf("seam %d: energy maps differ in row %zu\n", i, y);
+                failures++;
+                break;
+            }
+        }
+
+        int done = carve_seam(&serial);
+        if (carve_seam(&parallel) != done) {
+            failures++;
+            break;
+        }
+        if (done != 0) break;
+        if (memcmp(serial.path, parallel.path, sizeof(int) * serial.im->height) != 0) {
+            printf("seam %d: parallel DP found a different seam\n", i);
+            failures++;
+        }
+    }
+
+    carve_free(&serial);
+    carve_free(&parallel);
+    return failures;
+}
+
+// ----------------------------------------
+// Function: time_threads
+// ----------------------------------------
+/*
+   Timing mode: carves `seams` seams from a fresh copy of the image with
+   1, 2, ... check_thread_count threads (energy pass included) and prints
+   the time per seam and the speedup over one thread.
+*/
+static int time_threads(struct rgb_img *im, int seams) {
+    double base_ms = 0;
+
+    printf("%zux%zu, %d seams, energy kernel %s\n", im->width, im->height, seams, energy_kernel_name());
+    for (int threads = 1; threads <= check_thread_count; threads++) {
+        struct carve_ctx ctx;
+        struct carve_opts opts;
+        struct rgb_img *copy;
+        struct timespec start, end;
+
+        copy = copy_img(im);
+        carve_opts_default(&opts);
+        opts.threads = threads;
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        carve_init_opts(&ctx, copy, &opts);
+        int done = 0;
+        while (done < seams && carve_seam(&ctx) == 0) done++;
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        carve_free(&ctx);
+
+        double ms = (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6;
+        if (threads == 1) base_ms = ms;
+        printf("threads %2d: %9.2f ms total, %8.3f ms/seam, speedup %.2fx\n",
+               threads, ms, done ? ms / done : 0.0, base_ms / ms);
+    }
+
+    destroy_image(im);
+    return 0;
+}
+
+// ----------------------------------------
+// Function: compare_batch
+// ----------------------------------------
+/*
+   Quality mode: removes `seams` seams from two copies of the image, one
+   seam per pass and compare_batch_size seams per pass, and prints the
+   total energy removed and the time taken by each.
+*/
+static int compare_batch_size = 8;
+
+static double carve_timed(struct rgb_img *im, const struct carve_opts *opts, int seams, uint64_t *energy) {
+    struct carve_ctx ctx;
+    struct rgb_img *copy;
+    struct timespec start, end;
+
+    copy = copy_img(im);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    carve_init_opts(&ctx, copy, opts);
+    for (int done = 0, n; done < seams && (n = carve_seams(&ctx, seams - done)) > 0; done += n) {
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    *energy = ctx.removed_energy;
+    carve_free(&ctx);
+    return (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6;
+}
+
+static int compare_batch(struct rgb_img *im, int seams) {
+    struct carve_opts opts;
+    uint64_t exact_energy, batch_energy;
+
+    carve_opts_default(&opts);
+    opts.threads = check_thread_count;
+    double exact_ms = carve_timed(im, &opts, seams, &exact_energy);
+    opts.batch = compare_batch_size;
+    double batch_ms = carve_timed(im, &opts, seams, &batch_energy);
+
+    printf("%zux%zu, %d seams\n", im->width, im->height, seams);
+    printf("exact    : energy removed %10llu, %9.2f ms\n", (unsigned long long)exact_energy, exact_ms);
+    printf("batch %3d: energy removed %10llu, %9.2f ms (%.3fx energy, %.2fx faster)\n",
+           compare_batch_size, (unsigned long long)batch_energy, batch_ms,
+           exact_energy ? (double)batch_energy / exact_energy : 1.0, exact_ms / batch_ms);
+
+    destroy_image(im);
+    return 0;
+}
+
+// ----------------------------------------
+// Function: compare_pyramid
+// ----------------------------------------
+/*
+   Quality mode: carves `seams` seams exactly and with the pyramid search
+   (band compare_pyramid_band) and prints the total energy removed and the
+   time taken by each. A third carve with the pyramid also runs the exact
+   DP on the same energy map before every seam and reports how far the
+   pyramid seam's cost is from the optimum: seams that matched it, and the
+   mean and largest excess. Returns the number of pyramid seams cheaper
+   than the exact one (there should be none).
+*/
+static int compare_pyramid_band = 8;
+
+static int compare_pyramid(struct rgb_img *im, int seams) {
+    struct carve_opts opts;
+    struct carve_ctx ctx;
+    struct rgb_img *copy;
+    uint64_t exact_energy, pyramid_energy;
+    int *exact_path = (int *)malloc(sizeof(int) * im->height);
+    int failures = 0;
+
+    carve_opts_default(&opts);
+    double exact_ms = carve_timed(im, &opts, seams, &exact_energy);
+    opts.pyramid = compare_pyramid_band;
+    double pyramid_ms = carve_timed(im, &opts, seams, &pyramid_energy);
+
+    copy = copy_img(im);
+    carve_init_opts(&ctx, copy, &opts);
+    int done = 0, matched = 0;
+    double excess_sum = 0, excess_max = 0;  // Pyramid cost over exact cost, in percent
+    for (; done < seams && ctx.im->width > 1; done++) {
+        uint32_t best = seam_dp_find(&ctx.dp, ctx.grad, exact_path);
+        uint64_t before = ctx.removed_energy;
+        carve_seam(&ctx);
+        uint32_t found = (uint32_t)(ctx.removed_energy - before);
+
+        if (found < best) {
+            printf("seam %d: pyramid cost %u below the exact %u\n", done, found, best);
+            failures++;
+        }
+        double excess = best ? 100.0 * ((double)found - best) / best : 0.0;
+        matched += (found == best);
+        excess_sum += excess;
+        if (excess > excess_max) excess_max = excess;
+    }
+    carve_free(&ctx);
+
+    printf("%zux%zu, %d seams, %d pyramid levels\n", im->width, im->height, seams,
+           seam_pyramid_levels(im->height, im->width));
+    printf("exact      : energy removed %10llu, %9.2f ms\n", (unsigned long long)exact_energy, exact_ms);
+    printf("pyramid %3d: energy removed %10llu, %9.2f ms (%.3fx energy, %.2fx faster)\n",
+           compare_pyramid_band, (unsigned long long)pyramid_energy, pyramid_ms,
+           exact_energy ? (double)pyramid_energy / exact_energy : 1.0, exact_ms / pyramid_ms);
+    printf("per seam   : %d of %d optimal, cost over exact %.2f%% mean, %.2f%% max\n", matched, done,
+           done ? excess_sum / done : 0.0, excess_max);
+
+    free(exact_path);
+    destroy_image(im);
+    return failures;
+}
+
+// ----------------------------------------
+// Function: build_order / retarget / check_order
+// ----------------------------------------
+/*
+   --build-order carves the image down to `seams` columns (default 1) and
+   saves the removal order of every pixel next to it (image.order).
+   --retarget W loads the image and its .order file and writes the image at
+   width W (image_wW.bin) with a single pass over the raster.
+   --check-order builds the order in memory and checks that retargeting to
+   every width down to `seams` fewer columns matches carving seam by seam,
+   that the order survives a round trip through a file, and that damaged
+   order files are refused.
+*/
+static char *order_image;          // Input file name, for the .order file
+static struct carve_opts *order_opts;
+static int retarget_width;
+
+static int build_order(struct rgb_img *im, int min_width) {
+    struct seam_order order;
+    char name[512];
+    struct timespec start, end;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (seam_order_build(im, min_width, order_opts, &order) != 0) {
+        fprintf(stderr, "%s is too wide for a 16-bit seam order\n", order_image);
+        destroy_image(im);
+        return 1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    seam_order_filename(order_image, name, sizeof(name));
+    int failed = seam_order_write(&order, name);
+    printf("%s: %zu seams in %.2f ms, written to %s%s\n", order_image, order.width - order.min_width,
+           (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6, name,
+           failed ? " (write failed)" : "");
+
+    seam_order_free(&order);
+    destroy_image(im);
+    return failed ? 1 : 0;
+}
+
+static int retarget(struct rgb_img *im, int unused) {
+    struct seam_order order;
+    struct rgb_img *out;
+    char name[512];
+    (void)unused;
+
+    seam_order_filename(order_image, name, sizeof(name));
+    if (seam_order_read(&order, name) != 0 || order.height != im->height || order.width != im->width) {
+        fprintf(stderr, "%s is missing or does not match %s (run --build-order)\n", name, order_image);
+        destroy_image(im);
+        return 1;
+    }
+    if (seam_order_retarget(im, &order, retarget_width, &out) != 0) {
+        fprintf(stderr, "width %d is outside %zu .. %zu\n", retarget_width, order.min_width, order.width);
+        seam_order_free(&order);
+        destroy_image(im);
+        return 1;
+    }
+
+    size_t len = strlen(order_image);
+    if (len >= 4 && strcmp(order_image + len - 4, ".bin") == 0) len -= 4;
+    snprintf(name, sizeof(name), "%.*s_w%d.bin", (int)len, order_image, retarget_width);
+    int failed = write_img(out, name);
+    if (failed) fprintf(stderr, "cannot write %s\n", name);
+    else printf("wrote %s\n", name);
+
+    destroy_image(out);
+    seam_order_free(&order);
+    destroy_image(im);
+    return failed ? 1 : 0;
+}
+
+// Writes order to name; 1 if seam_order_read accepts it
+static int check_bad_order(const char *name, const struct seam_order *order, const char *what) {
+    struct seam_order got;
+    if (seam_order_write(order, name) != 0) return 1;
+    if (seam_order_read(&got, name) != 0) return 0;
+    seam_order_free(&got);
+    printf("damaged order file (%s) was read\n", what);
+    return 1;
+}
+
+static int check_order(struct rgb_img *im, int seams) {
+    struct seam_order order;
+    struct carve_ctx ctx;
+    struct rgb_img *copy;
+    int failures = 0;
+
+    if (seams > (int)im->width - 1) seams = im->width - 1;
+    seam_order_build(im, im->width - seams, NULL, &order);
+    copy = copy_img(im);
+    carve_init(&ctx, copy);
+
+    for (int i = 1; i <= seams; i++) {
+        struct rgb_img *out;
+        carve_seam(&ctx);
+        seam_order_retarget(im, &order, ctx.im->width, &out);
+        for (size_t y = 0; y < out->height; y++) {
+            if (memcmp(out->raster + 3 * y * out->stride, ctx.im->raster + 3 * y * ctx.im->stride,
+                       3 * out->width) != 0) {
+                printf("%d seams: retargeted image differs in row %zu\n", i, y);
+                failures++;
+                break;
+            }
+        }
+        destroy_image(out);
+    }
+
+    struct seam_order got;
+    char name[80];
+    size_t count = order.height * order.width;
+    snprintf(name, sizeof(name), "/tmp/seam_order_%d.order", (int)getpid());
+    if (seam_order_write(&order, name) != 0 || seam_order_read(&got, name) != 0) {
+        printf("order file round trip failed\n");
+        failures++;
+    } else {
+        if (got.min_width != order.min_width || memcmp(got.order, order.order, 2 * count) != 0) {
+            printf("order file read back differs\n");
+            failures++;
+        }
+        seam_order_free(&got);
+    }
+    if (seams > 0) {
+        int bad = 0;
+        size_t first = 0, kept = 0;            // Row 0's first seam pixel and a kept one
+        for (size_t x = 0; x < order.width; x++) {
+            if (order.order[x] == 0) first = x;
+            if (order.order[x] == SEAM_ORDER_KEPT) kept = x;
+        }
+        order.order[first] = (uint16_t)order.width;         // Past the widths the order covers
+        bad += check_bad_order(name, &order, "order past the width");
+        order.order[first] = 0;
+        order.order[kept] = 0;                              // Seam 0 takes two pixels of row 0
+        bad += check_bad_order(name, &order, "two pixels in one seam");
+        order.order[kept] = SEAM_ORDER_KEPT;
+        order.min_width = order.width + 1;
+        bad += check_bad_order(name, &order, "min width above the width");
+        order.min_width = order.width - seams;
+        printf("damaged order files: %s\n", bad ? "FAILED" : "all refused");
+        failures += bad;
+    }
+    remove(name);
+
+    seam_order_free(&order);
+    carve_free(&ctx);
+    destroy_image(im);
+    return failures;
+}
+
+// ----------------------------------------
+// Function: compare_energy
+// ----------------------------------------
+/*
+   Speed mode: carves `seams` seams with each energy function (with the
+   command line's other options) and prints the time taken by each next
+   to the dual-gradient's. Costs are in each energy's own units, so only
+   times are compared.
+*/
+static int compare_energy(struct rgb_img *im, int seams) {
+    struct carve_opts opts = *order_opts;
+    uint64_t energy;
+    double dual_ms = 0;
+
+    printf("%zux%zu, %d seams, energy kernel %s\n", im->width, im->height, seams, energy_kernel_name());
+    for (int kind = ENERGY_DUAL; kind <= ENERGY_FORWARD; kind++) {
+        opts.energy = kind;
+        double ms = carve_timed(im, &opts, seams, &energy);
+        if (kind == ENERGY_DUAL) dual_ms = ms;
+        printf("%-8s: %9.2f ms (%.2fx the dual-gradient's speed)\n", energy_name(kind), ms, dual_ms / ms);
+    }
+
+    destroy_image(im);
+    return 0;
+}
+
+// ----------------------------------------
+// Function: check_horizontal / carve_target
+// ----------------------------------------
+/*
+   --check-horizontal carves `seams` horizontal seams and, in lockstep,
+   the same number of vertical seams from a transposed copy. Each step the
+   two seams must match, the incrementally updated energy map must match a
+   full calc_energy, and at the end the images must be transposes of each
+   other. Returns the number of mismatching steps.
+   --target WxH carves the image down to W x H with carve_step and writes
+   image_WxH.bin, steered by the --mask image if there is one.
+*/
+static size_t target_width, target_height;
+static char *log_name;             // --log: seam log to write (NULL = none)
+
+// --stats NAME: NAME.csv gets a row per step, NAME.json the run totals
+static char *stats_name;
+static FILE *stats_csv;
+static struct carve_stats stats_prev;  // Counters at the previous CSV row
+
+static void stats_step(int step, struct rgb_img *im) {
+    if (stats_csv != NULL) stats_csv_row(stats_csv, step, im->width, im->height, &stats_prev);
+}
+
+static int stats_begin(void) {
+    char name[512];
+    stats_reset();
+    stats_prev = carve_stats;
+    if (stats_name == NULL) return 0;
+    snprintf(name, sizeof(name), "%s.csv", stats_name);
+    stats_csv = fopen(name, "w");
+    if (stats_csv == NULL) {
+        fprintf(stderr, "cannot write %s\n", name);
+        return -1;
+    }
+    stats_csv_header(stats_csv);
+    return 0;
+}
+
+// Writes NAME.json and closes NAME.csv; passes the exit code through
+static int stats_end(const char *label, int status) {
+    char name[512];
+    if (stats_csv == NULL) return status;
+    fclose(stats_csv);
+    stats_csv = NULL;
+    snprintf(name, sizeof(name), "%s.json", stats_name);
+    FILE *fp = fopen(name, "w");
+    if (fp == NULL) {
+        fprintf(stderr, "cannot write %s\n", name);
+        return 1;
+    }
+    stats_write_json(fp, label);
+    fclose(fp);
+    return status;
+}
+
+static struct rgb_img *transpose_img(struct rgb_img *im) {
+    struct rgb_img *out;
+    create_img(&out, im->width, im->height);
+    for (size_t y = 0; y < im->height; y++) {
+        for (size_t x = 0; x < im->width; x++) {
+            memcpy(out->raster + 3 * (x * out->stride + y), im->raster + 3 * (y * im->stride + x), 3);
+        }
+    }
+    return out;
+}
+
+static int check_horizontal(struct rgb_img *im, int seams) {
+    struct carve_ctx rows, cols;   // Horizontal carve, and vertical carve of the transpose
+    struct energy_map *full;
+    int failures = 0;
+
+    if (seams > (int)im->height - 1) seams = im->height - 1;
+    carve_init(&cols, transpose_img(im));
+    carve_init(&rows, im);
+
+    for (int i = 0; i < seams; i++) {
+        int bad = 0;
+        carve_seam_h(&rows);
+        carve_seam(&cols);
+        bad |= memcmp(rows.hpath, cols.path, sizeof(int) * rows.im->width) != 0;
+
+        calc_energy(rows.im, &full);
+        for (size_t y = 0; y < full->height && !bad; y++) {
+            bad |= memcmp(energy_row(full, y), energy_row(rows.grad, y), full->width) != 0;
+        }
+        destroy_energy_map(full);
+        if (bad) printf("horizontal seam %d differs\n", i);
+        failures += bad;
+    }
+
+    struct rgb_img *back = transpose_img(cols.im);
+    for (size_t y = 0; y < back->height; y++) {
+        if (back->width != rows.im->width ||
+            memcmp(back->raster + 3 * y * back->stride, rows.im->raster + 3 * y * rows.im->stride,
+                   3 * back->width) != 0) {
+            printf("final image differs in row %zu\n", y);
+            failures++;
+            break;
+        }
+    }
+
+    destroy_image(back);
+    carve_free(&rows);
+    carve_free(&cols);
+    return failures;
+}
+
+static struct seam_mask *carve_mask;  // --mask: protect / remove mask of the input (NULL = none)
+
+// The output name for a carved image: image_WxH.bin
+static void sized_name(char *name, size_t size, const struct rgb_img *im) {
+    size_t len = strlen(order_image);
+    if (len >= 4 && strcmp(order_image + len - 4, ".bin") == 0) len -= 4;
+    snprintf(name, size, "%.*s_%zux%zu.bin", (int)len, order_image, im->width, im->height);
+}
+
+static int carve_target(struct rgb_img *im, int unused) {
+    struct carve_ctx ctx;
+    struct seam_log log;
+    FILE *log_fp = NULL;
+    char name[512];
+    int columns = 0, lines = 0;
+    int failed = 0;
+    (void)unused;
+
+    if (log_name != NULL && (log_fp = fopen(log_name, "wb")) == NULL) {
+        fprintf(stderr, "cannot write %s\n", log_name);
+        destroy_image(im);
+        return 1;
+    }
+    if (log_fp != NULL) seam_log_begin(&log, log_fp, im->height, im->width);
+
+    if (target_width > im->width && carve_mask != NULL) {
+        fprintf(stderr, "--mask cannot be combined with widening\n");
+        destroy_image(im);
+        return 1;
+    }
+    if (target_width > im->width) {  // Widen first, in one pass; then carve rows if needed
+        struct rgb_img *wide;
+        struct thread_pool *pool = (order_opts->threads > 1) ? pool_create(order_opts->threads) : NULL;
+        columns = -seam_insert(im, (int)(target_width - im->width), pool, &wide);
+        pool_destroy(pool);
+        if (wide == NULL) {
+            fprintf(stderr, "cannot widen a %zux%zu image\n", im->width, im->height);
+            destroy_image(im);
+            if (log_fp != NULL) {
+                fclose(log_fp);
+                remove(log_name);
+            }
+            return 1;
+        }
+        destroy_image(im);
+        im = wide;
+    }
+    carve_init_opts(&ctx, im, order_opts);
+    carve_set_mask(&ctx, carve_mask);
+    for (;;) {
+        int step = carve_step(&ctx, target_width, target_height);
+        if (step == CARVE_DONE) break;
+        if (step == CARVE_VERTICAL) columns++;
+        else lines++;
+        stats_step(columns + lines, ctx.im);
+        if (log_fp == NULL) continue;
+        if (step == CARVE_VERTICAL) seam_log_vertical(&log, ctx.path);
+        else seam_log_horizontal(&log, ctx.hpath);
+    }
+    if (log_fp != NULL) {
+        failed |= seam_log_end(&log);
+        failed |= fclose(log_fp);
+    }
+
+    sized_name(name, sizeof(name), ctx.im);
+    failed |= write_img(carve_image(&ctx), name);
+    if (columns < 0) {
+        printf("inserted %d columns and removed %d rows, wrote %s%s\n", -columns, lines, name,
+               failed ? " (write failed)" : "");
+    } else {
+        printf("removed %d columns and %d rows, wrote %s%s\n", columns, lines, name,
+               failed ? " (write failed)" : "");
+    }
+
+    carve_free(&ctx);
+    return failed ? 1 : 0;
+}
+
+// ----------------------------------------
+// Function: dump_energy
+// ----------------------------------------
+/*
+   --dump-energy writes the energy map of the image as a grayscale image,
+   image_energy.bin, for inspection (energy_map_to_img).
+*/
+static int dump_energy(struct rgb_img *im, int unused) {
+    struct energy_map *grad;
+    struct rgb_img *gray;
+    char name[512];
+    (void)unused;
+
+    calc_energy(im, &grad);
+    energy_map_to_img(grad, &gray);
+    size_t len = strlen(order_image);
+    if (len >= 4 && strcmp(order_image + len - 4, ".bin") == 0) len -= 4;
+    snprintf(name, sizeof(name), "%.*s_energy.bin", (int)len, order_image);
+    int failed = write_img(gray, name);
+    printf("wrote %s%s\n", name, failed ? " (write failed)" : "");
+
+    destroy_image(gray);
+    destroy_energy_map(grad);
+    destroy_image(im);
+    return failed ? 1 : 0;
+}
+
+// ----------------------------------------
+// Function: insert_columns / check_insert
+// ----------------------------------------
+/*
+   --insert N widens the image by N columns with seam_insert on --threads
+   threads, writes image_wW.bin, and prints the time it took.
+   --check-insert selects N seams the way seam_insert's first round does
+   (N at most the width),
+   widens with widen_img, and checks that seam_insert gives the same image,
+   that every inserted pixel is the average of the seam pixel and its right
+   neighbour, and that removing the inserted columns gives back the
+   original. An image with no rows or no columns must be refused instead.
+   Returns the number of mismatching rows.
+*/
+static double elapsed_ms(const struct timespec *start, const struct timespec *end) {
+    return (end->tv_sec - start->tv_sec) * 1e3 + (end->tv_nsec - start->tv_nsec) / 1e6;
+}
+
+static int insert_count;             // --insert: columns to add
+
+static int insert_columns(struct rgb_img *im, int unused) {
+    int threads = (order_opts->threads > 1) ? order_opts->threads : 1;
+    struct thread_pool *pool = (threads > 1) ? pool_create(threads) : NULL;
+    struct rgb_img *wide;
+    struct timespec start, end;
+    char name[512];
+    (void)unused;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int added = seam_insert(im, insert_count, pool, &wide);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    pool_destroy(pool);
+    if (added < 0) {
+        fprintf(stderr, "cannot widen a %zux%zu image\n", im->width, im->height);
+        destroy_image(im);
+        return 1;
+    }
+
+    size_t len = strlen(order_image);
+    if (len >= 4 && strcmp(order_image + len - 4, ".bin") == 0) len -= 4;
+    snprintf(name, sizeof(name), "%.*s_w%zu.bin", (int)len, order_image, wide->width);
+    int failed = write_img(wide, name);
+    printf("inserted %d columns in %.2f ms on %d thread%s, wrote %s%s\n", added, elapsed_ms(&start, &end),
+           threads, (threads > 1) ? "s" : "", name, failed ? " (write failed)" : "");
+
+    destroy_image(wide);
+    destroy_image(im);
+    return failed ? 1 : 0;
+}
+
+static int check_insert(struct rgb_img *im, int seams) {
+    int height = im->height, width = im->width;
+    struct energy_map *grad;
+    struct seam_dp dp;
+    struct rgb_img *wide, *ref;
+    int failures = 0;
+
+    if (width == 0 || height == 0) {    // Nothing to widen: seam_insert must refuse it
+        struct rgb_img *none;
+        int bad = seam_insert(im, seams, NULL, &none) != -1 || none != NULL;
+        printf("empty image: %s\n", bad ? "widened (FAIL)" : "refused");
+        destroy_image(im);
+        return bad;
+    }
+    if (seams > width) seams = width;
+    if (seams < 1) {
+        destroy_image(im);
+        return 0;
+    }
+    int *paths = (int *)malloc(sizeof(int) * height * seams);
+    int *inserted = (int *)malloc(sizeof(int) * height * seams);  // Same seams, in wide's columns
+    int *scratch = (int *)malloc(sizeof(int) * 2 * seams);
+    uint64_t *keys = (uint64_t *)malloc(sizeof(uint64_t) * width);
+
+    calc_energy(im, &grad);
+    seam_dp_init(&dp, height, width);
+    int found = seam_insert_select(&dp, seam_dp_fill(&dp, grad), grad, seams, keys, paths);
+    create_img(&wide, height, width + found);
+    widen_img(im, paths, found, scratch, wide);
+
+    seam_insert(im, found, NULL, &ref);
+    for (int y = 0; y < height; y++) {
+        int bad = ref->width != wide->width ||
+                  memcmp(ref->raster + 3 * y * ref->stride, wide->raster + 3 * y * wide->stride, 3 * wide->width);
+        const uint8_t *row = im->raster + 3 * (size_t)y * im->stride;
+        for (int s = 0; s < found; s++) {
+            int col = paths[(size_t)s * height + y];
+            int left = 0;  // Seams inserted left of this one
+            for (int t = 0; t < found; t++) left += paths[(size_t)t * height + y] < col;
+            int at = col + left + 1;
+            inserted[(size_t)s * height + y] = at;
+            int right = (col + 1 < width) ? col + 1 : col;
+            for (int c = 0; c < 3; c++) {
+                bad |= get_pixel(wide, y, at, c) != (row[3 * col + c] + row[3 * right + c] + 1) / 2;
+            }
+        }
+        if (bad) printf("row %d: widened pixels differ\n", y);
+        failures += bad;
+    }
+
+    remove_columns(wide->raster, 3 * wide->stride, 3, height, wide->width, inserted, found, scratch);
+    for (int y = 0; y < height; y++) {
+        if (memcmp(wide->raster + 3 * y * wide->stride, im->raster + 3 * y * im->stride, 3 * width) != 0) {
+            printf("row %d: removing the inserted seams does not give the original\n", y);
+            failures++;
+        }
+    }
+    printf("%d seams inserted\n", found);
+
+    free(keys);
+    free(scratch);
+    free(inserted);
+    free(paths);
+    seam_dp_free(&dp);
+    destroy_energy_map(grad);
+    destroy_image(ref);
+    destroy_image(wide);
+    destroy_image(im);
+    return failures;
+}
+
+// ----------------------------------------
+// Function: check_service / run_client
+// ----------------------------------------
+/*
+   --check-service starts the carving daemon (seam_service.h) on a thread,
+   sends it CARVE requests for the input image (`seams` fewer columns and
+   up to seams / 2 fewer rows, some of them repeated), and checks every
+   reply against carving the columns and then the rows seam by seam, and
+   its hit/build/miss tag against what the cache should hold by then.
+   Files that cannot be carved (missing, a v2 header with overflowing
+   sides, an image 0 pixels wide) must get ERR replies from a daemon that
+   goes on to answer the next request. It then carves on a cache too
+   small for the image, which must evict, and on one that keeps only the
+   row entry: when the file is then replaced, that entry must not answer
+   for the new contents. Returns the number of failed requests.
+   --client SOCKET sends one request to a running --serve daemon: "stats",
+   "shutdown", or WxH image.bin [out.bin] (default image_WxH.bin).
+*/
+static char check_socket[64];        // Socket of the --check-service daemon
+
+static void *service_thread(void *arg) {
+    service_run((struct seam_service *)arg, check_socket);
+    return NULL;
+}
+
+static struct rgb_img *carve_reference(struct rgb_img *im, size_t width, size_t height) {
+    struct carve_ctx ctx;
+    struct rgb_img *copy, *out;
+
+    copy = copy_img(im);
+    carve_init(&ctx, copy);
+    while (ctx.im->width > width) carve_seam(&ctx);
+    while (ctx.im->height > height) carve_seam_h(&ctx);
+    create_img(&out, ctx.im->height, ctx.im->width);
+    for (size_t y = 0; y < out->height; y++) {
+        memcpy(out->raster + 3 * y * out->width, ctx.im->raster + 3 * y * ctx.im->stride, 3 * out->width);
+    }
+    carve_free(&ctx);
+    return out;
+}
+
+static int check_service(struct rgb_img *im, int seams) {
+    struct seam_service svc;
+    pthread_t thread;
+    char status[1024], request[600], payload[96];
+    int failures = 0;
+
+    if (seams < 2) seams = 2;
+    if (seams > (int)im->width - 1) seams = im->width - 1;
+    if (seams > 2 * ((int)im->height - 1)) seams = 2 * ((int)im->height - 1);
+    size_t w0 = im->width, h0 = im->height;
+    if (seams < 2 || h0 < 3) {   // Needs two column sizes and two row sizes below the image's
+        printf("%zux%zu is too small for the request schedule; skipped\n", w0, h0);
+        destroy_image(im);
+        return 0;
+    }
+    // Every size must differ, and remove something, for its tag to be right
+    size_t cols = (size_t)seams, half = cols / 2, rows = (seams / 4 > 1) ? (size_t)seams / 4 : 1;
+    if (2 * rows > h0 - 1) rows = (h0 - 1) / 2;
+    struct {
+        size_t width, height;
+        const char *kind;
+    } steps[] = {
+        {w0 - cols, h0, "miss"},                    // Reads the image, builds the column order
+        {w0 - cols, h0, "hit"},
+        {w0 - half, h0 - 2 * rows, "build"},        // Column order covers it; new row order
+        {w0 - half, h0 - 2 * rows, "hit"},
+        {w0 - cols, h0 - rows, "build"},
+        {w0 - cols, h0 - 2 * rows, "build"},        // Rebuilt twice as deep...
+        {w0 - cols, h0 - 3 * rows / 2, "hit"},      // ...so this one is covered
+        {w0, h0 - 2 * rows, "build"},
+    };
+    int count = (int)(sizeof(steps) / sizeof(steps[0]));
+
+    snprintf(check_socket, sizeof(check_socket), "/tmp/seam_check_%d.sock", (int)getpid());
+    snprintf(payload, sizeof(payload), "/tmp/seam_check_%d.bin", (int)getpid());
+    service_init(&svc, (size_t)256 << 20, NULL);
+    if (service_listen(&svc, check_socket) != 0 || pthread_create(&thread, NULL, service_thread, &svc) != 0) {
+        fprintf(stderr, "cannot listen on %s\n", check_socket);
+        service_free(&svc);
+        destroy_image(im);
+        return 1;
+    }
+
+    for (int i = 0; i < count; i++) {
+        struct rgb_img *got = NULL, *ref = carve_reference(im, steps[i].width, steps[i].height);
+        FILE *fp = fopen(payload, "wb");
+        snprintf(request, sizeof(request), "CARVE %zux%zu %s", steps[i].width, steps[i].height, order_image);
+        int bad = (fp == NULL || service_request(check_socket, request, status, sizeof(status), fp) != 0);
+        if (fp != NULL) fclose(fp);
+        bad = bad || read_in_img(&got, payload) != 0 || got->width != ref->width || got->height != ref->height ||
+              memcmp(got->raster, ref->raster, 3 * ref->height * ref->width) != 0;
+        char kind[16] = "";
+        sscanf(status, "OK %*u %*u %15s", kind);
+        if (bad || strcmp(kind, steps[i].kind) != 0) {
+            printf("%s -> '%s' (expected an exact image, %s)\n", request, status, steps[i].kind);
+            failures++;
+        }
+        if (got != NULL) destroy_image(got);
+        destroy_image(ref);
+    }
+
+    // Bad files: each gets an ERR, and the daemon still answers afterwards
+    static const uint8_t overflowing[IMG_V2_HEADER] = {0, 0, 'S', 'C', 0, 2, 0, IMG_V2_HEADER,
+                                                       0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xC0,
+                                                       0xFF, 0xFF, 0xFF, 0xC0};
+    static const uint8_t empty[4] = {0, 5, 0, 0};  // v1, 5 rows of 0 pixels
+    const char *bad_files[3] = {"/nonexistent.bin", payload, payload};
+    for (int i = 0; i < 3; i++) {
+        FILE *fp = (i > 0) ? fopen(payload, "wb") : NULL;
+        if (fp != NULL) {
+            if (i == 1) fwrite(overflowing, 1, sizeof(overflowing), fp);
+            else fwrite(empty, 1, sizeof(empty), fp);
+            fclose(fp);
+        }
+        snprintf(request, sizeof(request), "CARVE 10x10 %s", bad_files[i]);
+        int bad = service_request(check_socket, request, status, sizeof(status), NULL) == 0;
+        snprintf(request, sizeof(request), "CARVE %zux%zu %s", w0 - seams, h0, order_image);
+        bad |= service_request(check_socket, request, status, sizeof(status), NULL) != 0;
+        if (bad) printf("bad file %d: not an ERR, or the daemon stopped answering ('%s')\n", i, status);
+        failures += bad;
+    }
+    service_request(check_socket, "STATS", status, sizeof(status), NULL);
+    printf("%s\n", status);
+    service_request(check_socket, "SHUTDOWN", status, sizeof(status), NULL);
+    pthread_join(thread, NULL);
+    remove(payload);
+    if (svc.kinds[SERVICE_HIT] != 6 || svc.errors != 3) failures++;
+    service_free(&svc);
+
+    // A budget below the image's raster plus order map: nothing can stay
+    struct rgb_img *out;
+    int kind;
+    service_init(&svc, 4 * w0 * h0, NULL);
+    for (int i = 0; i < 2; i++) {
+        if (service_carve(&svc, order_image, w0 - seams, h0, &out, &kind) != 0 || kind != SERVICE_MISS) failures++;
+        else destroy_image(out);
+    }
+    if (svc.evictions != 2 || svc.used > svc.budget) {
+        printf("small cache: %llu evictions, %zu of %zu bytes used\n", (unsigned long long)svc.evictions, svc.used,
+               svc.budget);
+        failures++;
+    }
+    service_free(&svc);
+
+    // Room for just the row entry (raster and 16-bit orders): the source is evicted, then the file replaced
+    struct rgb_img *changed = copy_img(im), *ref;
+    struct stat st;
+    snprintf(payload, sizeof(payload), "/tmp/seam_check_%d_src.bin", (int)getpid());
+    service_init(&svc, 5 * (w0 - seams) * h0, NULL);
+    if (write_img(im, payload) != 0 || service_carve(&svc, payload, w0 - seams, h0 - rows, &out, &kind) != 0) {
+        failures++;
+    } else {
+        destroy_image(out);
+        if (svc.entries != 1) {
+            printf("cache for the row entry only: %d entries kept\n", svc.entries);
+            failures++;
+        }
+        for (size_t y = 0; y < h0; y++) {
+            uint8_t *row = changed->raster + 3 * y * changed->stride;
+            for (size_t x = 0; x < 3 * w0; x++) row[x] = (uint8_t)(255 - row[x]);
+        }
+        struct timespec later[2] = {{0, UTIME_OMIT}, {0, 0}};
+        int moved = write_img(changed, payload) == 0 && stat(payload, &st) == 0;
+        later[1].tv_sec = st.st_mtim.tv_sec + 2;      // Same size: only the time tells the versions apart
+        moved = moved && utimensat(AT_FDCWD, payload, later, 0) == 0;
+        ref = carve_reference(changed, w0 - seams, h0 - rows);
+        int bad = !moved || service_carve(&svc, payload, w0 - seams, h0 - rows, &out, &kind) != 0;
+        if (!bad) {
+            bad = kind != SERVICE_MISS || memcmp(out->raster, ref->raster, 3 * ref->height * ref->width) != 0;
+            destroy_image(out);
+        }
+        if (bad) printf("replaced file: answered from the stale row entry\n");
+        failures += bad;
+        destroy_image(ref);
+    }
+    service_free(&svc);
+    remove(payload);
+    destroy_image(changed);
+
+    destroy_image(im);
+    return failures;
+}
+
+static int run_client(const char *socket_path, int argc, char **argv) {
+    char request[600], status[1024], name[512];
+    FILE *fp = NULL;
+
+    if (argc == 1 && strcmp(argv[0], "stats") == 0) {
+        snprintf(request, sizeof(request), "STATS");
+    } else if (argc == 1 && strcmp(argv[0], "shutdown") == 0) {
+        snprintf(request, sizeof(request), "SHUTDOWN");
+    } else if (argc == 2 || argc == 3) {
+        size_t len = strlen(argv[1]);
+        if (len >= 4 && strcmp(argv[1] + len - 4, ".bin") == 0) len -= 4;
+        if (argc == 3) snprintf(name, sizeof(name), "%s", argv[2]);
+        else snprintf(name, sizeof(name), "%.*s_%s.bin", (int)len, argv[1], argv[0]);
+        snprintf(request, sizeof(request), "CARVE %s %s", argv[0], argv[1]);
+        if ((fp = fopen(name, "wb")) == NULL) {
+            fprintf(stderr, "cannot write %s\n", name);
+            return 1;
+        }
+    } else {
+        fprintf(stderr, "--client expects stats, shutdown, or WxH image.bin [out.bin]\n");
+        return 1;
+    }
+
+    int failed = service_request(socket_path, request, status, sizeof(status), fp);
+    if (fp != NULL) failed |= (fclose(fp) != 0);
+    if (status[0] == '\0') {
+        fprintf(stderr, "no reply from %s\n", socket_path);
+    } else {
+        printf("%s%s%s\n", status, (fp != NULL && !failed) ? ", wrote " : "", (fp != NULL && !failed) ? name : "");
+    }
+    if (failed && fp != NULL) remove(name);
+    return failed ? 1 : 0;
+}
+
+// ----------------------------------------
+// Function: check_sequence
+// ----------------------------------------
+/*
+   --check-sequence makes a short clip from the input image (a block of
+   inverted pixels moving across it) and carves `seams` columns from every
+   frame. With threshold 0 and a band as wide as the frame, every frame's
+   kept energy map must equal calc_energy of the frame and every output
+   the exact carve, both in memory and through the file pipeline of
+   seam_sequence_run. It then times the pipeline with the default band and
+   threshold against carving each frame from scratch. Returns the number of
+   mismatching frames.
+*/
+#define CHECK_FRAMES 8
+
+static int sequence_band = 8;        // --band: columns searched around the previous seams
+static int sequence_threshold = 4;   // --threshold: change that counts as a changed pixel
+static int sequence_keyframe = 30;   // --keyframe: exact carve every N frames (0 = scene cuts only)
+
+static struct rgb_img *clip_frame(const struct rgb_img *im, int t) {
+    struct rgb_img *frame = copy_img(im);
+    size_t side = im->width / 8 + 1;
+    for (size_t y = im->height / 4; y < im->height / 4 + side && y < im->height; y++) {
+        for (size_t x = 3 * t; x < 3 * t + side && x < im->width; x++) {
+            uint8_t *p = frame->raster + 3 * (y * frame->width + x);
+            for (int c = 0; c < 3; c++) p[c] = 255 - p[c];
+        }
+    }
+    return frame;
+}
+
+static int check_sequence(struct rgb_img *im, int seams) {
+    struct seam_sequence seq;
+    struct rgb_img *ref[CHECK_FRAMES];
+    char in_pattern[64], out_pattern[64], name[80];
+    int failures = 0;
+
+    if (seams > (int)im->width - 1) seams = im->width - 1;
+    snprintf(in_pattern, sizeof(in_pattern), "/tmp/seam_seq_%d_%%d.bin", (int)getpid());
+    snprintf(out_pattern, sizeof(out_pattern), "/tmp/seam_seq_%d_out%%d.bin", (int)getpid());
+
+    // Exact references, and the clip on disk
+    double scratch_ms = 0;
+    for (int t = 0; t < CHECK_FRAMES; t++) {
+        struct carve_ctx ctx;
+        struct timespec start, end;
+        struct rgb_img *frame = clip_frame(im, t);
+        snprintf(name, sizeof(name), in_pattern, t);
+        if (write_img(frame, name) != 0) {
+            printf("frame %d: cannot write %s\n", t, name);
+            failures++;
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        carve_init(&ctx, frame);
+        for (int i = 0; i < seams; i++) carve_seam(&ctx);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        scratch_ms += elapsed_ms(&start, &end);
+        create_img(&ref[t], ctx.im->height, ctx.im->width);
+        for (size_t y = 0; y < ctx.im->height; y++) {
+            memcpy(ref[t]->raster + 3 * y * ref[t]->width, ctx.im->raster + 3 * y * ctx.im->stride, 3 * ctx.im->width);
+        }
+        carve_free(&ctx);
+    }
+
+    // In memory: exact energy maps and seams
+    seam_sequence_init(&seq, im->height, im->width, seams, im->width, 0, 0, NULL);
+    for (int t = 0; t < CHECK_FRAMES; t++) {
+        struct rgb_img *frame = clip_frame(im, t), *out;
+        struct energy_map *full;
+        calc_energy(frame, &full);
+        int key = seam_sequence_frame(&seq, frame, &out);
+        int bad = (key != (t == 0)) || memcmp(out->raster, ref[t]->raster, 3 * out->height * out->width) != 0;
+        for (size_t y = 0; y < full->height; y++) {
+            bad |= memcmp(energy_row(full, y), energy_row(seq.base, y), full->width) != 0;
+        }
+        if (bad) printf("frame %d differs from the exact carve\n", t);
+        failures += bad;
+        destroy_energy_map(full);
+        destroy_image(out);
+    }
+    printf("in memory: %.1f%% of energy recomputed on tracked frames\n",
+           100.0 * seq.energy_pixels / ((double)im->height * im->width * (CHECK_FRAMES - 1)));
+    seam_sequence_free(&seq);
+
+    // Through the pipeline, then timed with the default band and threshold
+    FILE *quiet = fopen("/dev/null", "w");
+    if (seam_sequence_run(in_pattern, out_pattern, 0, seams, im->width, 0, 0, NULL, quiet) != 0) failures++;
+    fclose(quiet);
+    for (int t = 0; t < CHECK_FRAMES; t++) {
+        struct rgb_img *got;
+        snprintf(name, sizeof(name), out_pattern, t);
+        if (read_in_img(&got, name) != 0 || got->width != ref[t]->width ||
+            memcmp(got->raster, ref[t]->raster, 3 * got->height * got->width) != 0) {
+            printf("pipeline frame %d differs from the exact carve\n", t);
+            failures++;
+        }
+        if (got != NULL) destroy_image(got);
+    }
+    printf("from scratch: %.2f ms/frame; band %d, threshold %d:\n", scratch_ms / CHECK_FRAMES, sequence_band,
+           sequence_threshold);
+    seam_sequence_run(in_pattern, out_pattern, 0, seams, sequence_band, sequence_threshold, 0, NULL, stdout);
+
+    for (int t = 0; t < CHECK_FRAMES; t++) {
+        snprintf(name, sizeof(name), in_pattern, t);
+        remove(name);
+        snprintf(name, sizeof(name), out_pattern, t);
+        remove(name);
+        destroy_image(ref[t]);
+    }
+    destroy_image(im);
+    return failures;
+}
+
+// ----------------------------------------
+// Function: convert_image / stream_energy_file
+// ----------------------------------------
+/*
+   --convert OUT writes the image to OUT in the v2 layout (c_img.h), in
+   bands of --band-rows rows (default 0: not chunked).
+   --stream-energy IN writes the energy map of IN as a grayscale v2 image,
+   IN_energy.bin, without loading IN: rows are read, turned into energy
+   and written one band (--band-rows, default the file's) at a time.
+*/
+static size_t band_rows;             // --band-rows: rows per band (0 = default)
+static char *convert_name;           // --convert: v2 file to write
+
+static int convert_image(struct rgb_img *im, int unused) {
+    struct img_header hdr;
+    (void)unused;
+
+    img_v2_header(&hdr, im->height, im->width, band_rows);
+    int failed = write_img_v2(im, convert_name, band_rows);
+    printf("wrote %s: %zux%zu v2, stride %zu pixels, ", convert_name, im->width, im->height, hdr.stride);
+    if (band_rows > 0) printf("bands of %zu rows%s\n", band_rows, failed ? " (write failed)" : "");
+    else printf("not chunked%s\n", failed ? " (write failed)" : "");
+    destroy_image(im);
+    return failed ? 1 : 0;
+}
+
+// Passes each band of energy to a writer as grayscale rows
+struct gray_sink {
+    struct img_writer writer;
+    uint8_t *rows;
+    size_t capacity;
+};
+
+static int write_gray_band(void *arg, size_t y, size_t count, const uint8_t *energy, size_t stride) {
+    struct gray_sink *sink = (struct gray_sink *)arg;
+    size_t width = sink->writer.hdr.width;
+    (void)y;
+
+    if (sink->capacity < count) {
+        free(sink->rows);
+        sink->rows = (uint8_t *)malloc(3 * count * width);
+        sink->capacity = count;
+    }
+    for (size_t i = 0; i < count; i++) {
+        for (size_t x = 0; x < width; x++) {
+            memset(sink->rows + 3 * (i * width + x), energy[i * stride + x], 3);
+        }
+    }
+    return img_writer_rows(&sink->writer, sink->rows, count, width);
+}
+
+static int stream_energy_file(const char *input) {
+    struct img_reader reader;
+    struct gray_sink sink = {0};
+    struct timespec start, end;
+    char name[512];
+
+    if (img_reader_open(&reader, input) != 0) {
+        fprintf(stderr, "cannot read %s\n", input);
+        return 1;
+    }
+    struct img_header hdr = reader.hdr;
+    img_reader_close(&reader);
+
+    size_t len = strlen(input);
+    if (len >= 4 && strcmp(input + len - 4, ".bin") == 0) len -= 4;
+    snprintf(name, sizeof(name), "%.*s_energy.bin", (int)len, input);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int failed = img_writer_open(&sink.writer, name, hdr.height, hdr.width, hdr.band_rows) != 0;
+    failed = failed || stream_energy(input, band_rows, write_gray_band, &sink) != 0;
+    failed |= img_writer_close(&sink.writer) != 0;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    free(sink.rows);
+
+    printf("streamed the energy of %zux%zu in %.1f ms holding %.1f KB (the raster is %.1f KB), wrote %s%s\n",
+           hdr.width, hdr.height, elapsed_ms(&start, &end), stream_energy_bytes(&hdr, band_rows) / 1024.0,
+           3.0 * hdr.width * hdr.height / 1024.0, name, failed ? " (failed)" : "");
+    return failed ? 1 : 0;
+}
+
+// ----------------------------------------
+// Function: check_container
+// ----------------------------------------
+/*
+   --check-container writes the image as v1, as unchunked v2 and as v2 in
+   bands of 1, 7 and 64 rows (the last also row by row through
+   img_writer), and checks that each reads back with the same pixels (v2
+   rows 64-byte aligned), and that stream_energy over each file, in bands
+   of 1, 5 and the default, equals calc_energy. Then it checks an image
+   wider than a v1 header allows, and that carving `seams` seams from the
+   padded v2 raster gives the same image as from a packed one. Last,
+   truncated v2 files and v2 headers whose sides overflow or run past the
+   end of the file must be turned down by read_in_img and img_reader_open
+   without reading a byte of raster. Returns the number of failed checks.
+*/
+static int same_pixels(const struct rgb_img *a, const struct rgb_img *b) {
+    if (a->height != b->height || a->width != b->width) return 0;
+    for (size_t y = 0; y < a->height; y++) {
+        if (memcmp(a->raster + 3 * y * a->stride, b->raster + 3 * y * b->stride, 3 * a->width) != 0) return 0;
+    }
+    return 1;
+}
+
+// Copies each band of energy into a whole map
+static int keep_band(void *arg, size_t y, size_t count, const uint8_t *energy, size_t stride) {
+    struct energy_map *map = (struct energy_map *)arg;
+    for (size_t i = 0; i < count; i++) memcpy(energy_row(map, y + i), energy + i * stride, map->width);
+    return 0;
+}
+
+static int check_streamed(const char *name, const struct energy_map *full) {
+    const size_t bands[] = {1, 5, 0};
+    struct energy_map *map;
+    int failures = 0;
+
+    create_energy_map(&map, full->height, full->width);
+    for (int b = 0; b < 3; b++) {
+        memset(map->data, 0, map->height * map->stride);
+        int bad = stream_energy(name, bands[b], keep_band, map) != 0;
+        for (size_t y = 0; y < full->height && !bad; y++) {
+            bad = memcmp(energy_row(map, y), energy_row(full, y), full->width) != 0;
+        }
+        if (bad) printf("%s: energy streamed in bands of %zu differs from calc_energy\n", name, bands[b]);
+        failures += bad;
+    }
+    destroy_energy_map(map);
+    return failures;
+}
+
+static int check_file(const char *name, const struct rgb_img *im, const struct energy_map *full, int version) {
+    struct img_reader reader;
+    struct rgb_img *got;
+    int failures = 0;
+
+    if (img_reader_open(&reader, name) != 0 || reader.hdr.version != version) {
+        printf("%s: not a v%d file\n", name, version);
+        failures++;
+    }
+    img_reader_close(&reader);
+    if (read_in_img(&got, (char *)name) != 0 || !same_pixels(got, im)) {
+        printf("%s: pixels differ after reading back\n", name);
+        failures++;
+    } else if (version == 2 && ((uintptr_t)got->raster % 64 != 0 || (3 * got->stride) % 64 != 0)) {
+        printf("%s: rows are not 64-byte aligned\n", name);
+        failures++;
+    }
+    if (got != NULL) destroy_image(got);
+    return failures + check_streamed(name, full);
+}
+
+// Writes the first `keep` bytes of a v2 file with its height, width,
+// stride and band rows replaced, and checks that both readers refuse it
+static int check_bad_header(const char *name, const uint8_t *file, size_t keep, const uint32_t fields[4],
+                            const char *what) {
+    uint8_t header[IMG_V2_HEADER];
+    struct img_reader reader;
+    struct rgb_img *got = NULL;
+
+    memcpy(header, file, IMG_V2_HEADER);
+    for (int f = 0; f < 4; f++) {
+        for (int i = 0; i < 4; i++) header[8 + 4 * f + i] = (uint8_t)(fields[f] >> (24 - 8 * i));
+    }
+    FILE *fp = fopen(name, "wb");
+    if (fp == NULL) return 1;
+    fwrite(header, 1, keep < IMG_V2_HEADER ? keep : IMG_V2_HEADER, fp);
+    if (keep > IMG_V2_HEADER) fwrite(file + IMG_V2_HEADER, 1, keep - IMG_V2_HEADER, fp);
+    fclose(fp);
+
+    int bad = read_in_img(&got, (char *)name) == 0 || got != NULL;
+    bad |= img_reader_open(&reader, name) == 0;
+    img_reader_close(&reader);
+    if (got != NULL) destroy_image(got);
+    if (bad) printf("malformed v2 file (%s) was read\n", what);
+    return bad;
+}
+
+static int check_container(struct rgb_img *im, int seams) {
+    const size_t bands[] = {0, 1, 7, 64};
+    struct energy_map *full;
+    struct img_writer writer;
+    char name[80], other[80];
+    int failures = 0;
+
+    calc_energy(im, &full);
+    snprintf(name, sizeof(name), "/tmp/seam_container_%d.bin", (int)getpid());
+    snprintf(other, sizeof(other), "/tmp/seam_container_%d_rows.bin", (int)getpid());
+    failures += (write_img(im, name) != 0) + check_file(name, im, full, 1);
+    for (int b = 0; b < 4; b++) {
+        failures += (write_img_v2(im, name, bands[b]) != 0) + check_file(name, im, full, 2);
+    }
+
+    // The same file row by row through a writer
+    int bad = img_writer_open(&writer, other, im->height, im->width, 64) != 0;
+    for (size_t y = 0; y < im->height; y++) bad |= img_writer_rows(&writer, im->raster + 3 * y * im->stride, 1, im->stride);
+    bad |= img_writer_close(&writer) != 0;
+    FILE *a = fopen(name, "rb"), *b = fopen(other, "rb");
+    for (int ca = 0, cb = 0; !bad && a != NULL && b != NULL && (ca != EOF || cb != EOF);) {
+        ca = fgetc(a);
+        cb = fgetc(b);
+        bad = ca != cb;
+    }
+    if (a != NULL) fclose(a);
+    if (b != NULL) fclose(b);
+    if (bad) printf("img_writer output differs from write_img_v2\n");
+    failures += bad;
+    printf("v1, v2 and chunked v2 (bands of 1, 7, 64) read back and stream their energy%s\n",
+           failures ? " with errors" : " correctly");
+    destroy_energy_map(full);
+
+    // Wider than a v1 header allows: write_img must switch to v2
+    struct rgb_img *wide;
+    create_img(&wide, 3, IMG_V1_MAX + 1000);
+    for (size_t y = 0; y < wide->height; y++) {
+        for (size_t x = 0; x < wide->width; x++) {
+            memcpy(wide->raster + 3 * (y * wide->width + x), im->raster + 3 * ((y % im->height) * im->stride + x % im->width), 3);
+        }
+    }
+    calc_energy(wide, &full);
+    bad = (write_img(wide, name) != 0) + check_file(name, wide, full, 2);
+    printf("%zux%zu image: %s\n", wide->width, wide->height, bad ? "FAILED" : "written as v2 and read back");
+    failures += bad;
+    destroy_energy_map(full);
+    destroy_image(wide);
+
+    // Carving the padded raster of a mapped v2 file
+    struct rgb_img *padded, *packed = copy_img(im);
+    struct carve_ctx from_padded, from_packed;
+    write_img_v2(im, name, 0);
+    if (read_in_img(&padded, name) == 0) {
+        carve_init_opts(&from_padded, padded, order_opts);
+        carve_init_opts(&from_packed, packed, order_opts);
+        for (int i = 0; i < seams && from_packed.im->width > 1; i++) {
+            carve_seam(&from_padded);
+            carve_seam(&from_packed);
+        }
+        bad = !same_pixels(carve_image(&from_padded), carve_image(&from_packed));
+        printf("%d seams from the stride-%zu v2 raster: %s\n", seams, padded->stride, bad ? "DIFFER" : "same image");
+        failures += bad;
+        carve_free(&from_padded);
+        carve_free(&from_packed);
+    } else {
+        destroy_image(packed);
+        failures++;
+    }
+
+    // Malformed files: the readers must refuse them rather than trust the header
+    struct img_header hdr;
+    img_v2_header(&hdr, im->height, im->width, 0);
+    size_t len = img_row_offset(&hdr, im->height - 1) + 3 * hdr.stride;
+    uint8_t *file = (uint8_t *)malloc(len);
+    FILE *fp = fopen(name, "rb");
+    bad = fp == NULL || fread(file, 1, len, fp) != len;
+    if (fp != NULL) fclose(fp);
+    if (!bad) {
+        uint32_t h = (uint32_t)hdr.height, w = (uint32_t)hdr.width, st = (uint32_t)hdr.stride;
+        const uint32_t same[4] = {h, w, st, 0}, taller[4] = {h + 1, w, st, 0}, huge[4] = {0x7FFFFFFF, w, st, 0};
+        const uint32_t wrap[4] = {0xFFFFFFFF, 0xFFFFFFC0, 0xFFFFFFC0, 0};
+        const uint32_t band[4] = {h, w, 0xFFFFFFC0, 0xFFFFFFFF};
+        bad += check_bad_header(name, file, len - 1, same, "last byte missing");
+        bad += check_bad_header(name, file, IMG_V2_HEADER / 2, same, "header cut short");
+        bad += check_bad_header(name, file, len, taller, "one row more than the file holds");
+        bad += check_bad_header(name, file, len, huge, "height 2^31 - 1");
+        bad += check_bad_header(name, file, len, wrap, "raster size wraps");
+        bad += check_bad_header(name, file, len, band, "band size wraps");
+    }
+    printf("truncated and oversized v2 headers: %s\n", bad ? "FAILED" : "all refused");
+    failures += bad;
+    free(file);
+
+    remove(name);
+    remove(other);
+    destroy_image(im);
+    return failures;
+}
+
+// ----------------------------------------
+// Function: check_planar
+// ----------------------------------------
+/*
+   Test mode: carves the image with an interleaved and a planar context
+   side by side (honouring --threads and --batch), alternating vertical and
+   horizontal seams when batching is off. After every step the seams and
+   the energy maps must match, and at the end the planar context's merged
+   image must equal the interleaved one. Returns the number of mismatching
+   steps.
+*/
+static int check_planar(struct rgb_img *im, int seams) {
+    struct carve_ctx plain, planar;
+    struct carve_opts opts = *order_opts;
+    struct rgb_img *copy;
+    int failures = 0;
+
+    copy = copy_img(im);
+    opts.planar = 0;
+    carve_init_opts(&plain, copy, &opts);
+    opts.planar = 1;
+    carve_init_opts(&planar, im, &opts);
+
+    for (int i = 0; i < seams; i++) {
+        int bad = 0;
+        if (opts.batch > 1) {
+            int removed = carve_seams(&plain, seams - i);
+            if (removed == 0) break;
+            bad |= carve_seams(&planar, seams - i) != removed;
+            bad |= memcmp(plain.paths, planar.paths, sizeof(int) * removed * plain.im->height) != 0;
+            i += removed - 1;
+        } else if (i % 2 == 0) {
+            if (carve_seam(&plain) != 0) break;
+            bad |= carve_seam(&planar) != 0;
+            bad |= memcmp(plain.path, planar.path, sizeof(int) * plain.im->height) != 0;
+        } else {
+            if (carve_seam_h(&plain) != 0) break;
+            bad |= carve_seam_h(&planar) != 0;
+            bad |= memcmp(plain.hpath, planar.hpath, sizeof(int) * plain.im->width) != 0;
+        }
+
+        bad |= plain.grad->height != planar.grad->height || plain.grad->width != planar.grad->width;
+        for (size_t y = 0; y < plain.grad->height && !bad && opts.energy != ENERGY_FORWARD; y++) {
+            bad |= memcmp(energy_row(plain.grad, y), energy_row(planar.grad, y), plain.grad->width) != 0;
+        }
+        if (bad) printf("planar step %d differs\n", i);
+        failures += bad;
+    }
+
+    struct rgb_img *merged = carve_image(&planar);
+    int bad = merged->height != plain.im->height || merged->width != plain.im->width;
+    for (size_t y = 0; y < merged->height && !bad; y++) {
+        bad |= memcmp(merged->raster + 3 * y * merged->stride, plain.im->raster + 3 * y * plain.im->stride,
+                      3 * merged->width) != 0;
+    }
+    if (bad) printf("planar final image differs\n");
+    failures += bad;
+
+    carve_free(&plain);
+    carve_free(&planar);
+    return failures;
+}
+
+// ----------------------------------------
+// Function: check_forward
+// ----------------------------------------
+/*
+   Test mode: carves `seams` seams with forward energy and, before each
+   one, finds the seam with a plain reference: a full table of cumulative
+   costs built through get_pixel (plus mask weights, for check_mask), and
+   a backtrack that re-derives every move. The context's seam and its cost must match. Planar, threaded
+   (check_thread_count threads) and horizontal-on-the-transpose forward
+   carves run alongside and must remove the same seams and end with the
+   same image. Returns the number of mismatching seams.
+*/
+static int rgb_diff(struct rgb_img *im, int y1, int x1, int y2, int x2) {
+    int sum = 0;
+    for (int c = 0; c < 3; c++) {
+        sum += abs(get_pixel(im, y1, x1, c) - get_pixel(im, y2, x2, c));
+    }
+    return sum;
+}
+
+// Cost of reaching (y, x) from column x + dir of the row above, or -1 without that parent
+static long forward_move(struct rgb_img *im, int y, int x, int dir) {
+    int width = im->width;
+    if (x + dir < 0 || x + dir >= width) return -1;
+    long join = (x > 0 && x < width - 1) ? rgb_diff(im, y, x - 1, y, x + 1) : 0;
+    if (dir == 0 || y == 0) return join;
+    return join + rgb_diff(im, y - 1, x, y, x + dir);
+}
+
+// Mask weight of (y, x) when the mask is kept as codes in channel 0 of an image (0 without one)
+static uint32_t reference_bias(struct rgb_img *codes, const uint32_t *weight, int y, int x) {
+    return (codes != NULL) ? weight[get_pixel(codes, y, x, 0)] : 0;
+}
+
+static uint32_t forward_reference(struct rgb_img *im, struct rgb_img *codes, int *path) {
+    const int dirs[3] = {0, -1, 1};   // Tie order: up, up-left, up-right
+    int height = im->height, width = im->width;
+    uint32_t *cost = (uint32_t *)calloc((size_t)height * width, sizeof(uint32_t));
+    uint32_t weight[MASK_CODES];
+    mask_weights(height, MASK_MAX_FORWARD, weight);
+
+    for (int x = 0; x < width; x++) {
+        cost[x] = (uint32_t)forward_move(im, 0, x, 0) + reference_bias(codes, weight, 0, x);
+    }
+    for (int y = 1; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            uint32_t best = UINT32_MAX;
+            for (int d = 0; d < 3; d++) {
+                long move = forward_move(im, y, x, dirs[d]);
+                if (move >= 0 && cost[(y - 1) * width + x + dirs[d]] + move < best) {
+                    best = cost[(y - 1) * width + x + dirs[d]] + (uint32_t)move;
+                }
+            }
+            cost[y * width + x] = best + reference_bias(codes, weight, y, x);
+        }
+    }
+
+    int col = 0;
+    for (int x = 1; x < width; x++) {
+        if (cost[(height - 1) * width + x] < cost[(height - 1) * width + col]) col = x;
+    }
+    uint32_t total = cost[(height - 1) * width + col];
+    path[height - 1] = col;
+    for (int y = height - 1; y > 0; y--) {   // First move in tie order that explains the cost
+        uint32_t here = cost[y * width + col] - reference_bias(codes, weight, y, col);
+        for (int d = 0; d < 3; d++) {
+            long move = forward_move(im, y, col, dirs[d]);
+            if (move >= 0 && cost[(y - 1) * width + col + dirs[d]] + move == here) {
+                col += dirs[d];
+                break;
+            }
+        }
+        path[y - 1] = col;
+    }
+    for (int y = 0; y < height; y++) total -= reference_bias(codes, weight, y, path[y]);  // Energy only
+    free(cost);
+    return total;
+}
+
+static int check_forward(struct rgb_img *im, int seams) {
+    struct carve_ctx plain, planar, threaded, rows;
+    struct carve_opts opts;
+    int *path = (int *)malloc(sizeof(int) * im->height);
+    int failures = 0;
+
+    if (seams > (int)im->width - 1) seams = im->width - 1;
+    carve_opts_default(&opts);
+    opts.energy = ENERGY_FORWARD;
+    carve_init_opts(&plain, copy_img(im), &opts);
+    carve_init_opts(&rows, transpose_img(im), &opts);
+    opts.planar = 1;
+    carve_init_opts(&planar, copy_img(im), &opts);
+    opts.planar = 0;
+    opts.threads = check_thread_count;
+    carve_init_opts(&threaded, copy_img(im), &opts);
+
+    for (int i = 0; i < seams; i++) {
+        uint32_t cost = forward_reference(im, NULL, path);
+        uint64_t before = plain.removed_energy;
+        size_t height = im->height;
+        carve_seam(&plain);
+        carve_seam(&planar);
+        carve_seam(&threaded);
+        carve_seam_h(&rows);
+        remove_seam_inplace(im, path);
+
+        int bad = memcmp(path, plain.path, sizeof(int) * height) != 0 || plain.removed_energy - before != cost;
+        bad |= memcmp(plain.path, planar.path, sizeof(int) * height) != 0;
+        bad |= memcmp(plain.path, threaded.path, sizeof(int) * height) != 0;
+        bad |= memcmp(plain.path, rows.hpath, sizeof(int) * height) != 0;
+        if (bad) printf("forward seam %d differs\n", i);
+        failures += bad;
+    }
+
+    struct rgb_img *back = transpose_img(rows.im);
+    int bad = !same_pixels(plain.im, im) || !same_pixels(carve_image(&planar), im) ||
+              !same_pixels(threaded.im, im) || !same_pixels(back, im);
+    if (bad) printf("forward final images differ\n");
+    failures += bad;
+
+    destroy_image(back);
+    carve_free(&plain);
+    carve_free(&planar);
+    carve_free(&threaded);
+    carve_free(&rows);
+    free(path);
+    destroy_image(im);
+    return failures;
+}
+
+// ----------------------------------------
+// Function: check_mask / remove_object
+// ----------------------------------------
+/*
+   --remove-object removes the --mask image's removal region with
+   carve_remove_step, stopping as soon as it is gone, writes
+   image_WxH.bin (and --log LOG) and reports the seams and time taken.
+
+   --check-mask is a test mode for seam masks, in four parts:
+     - a random mask is carved along `seams` seams, alternately vertical
+       and horizontal, on dual-gradient, threaded and forward-energy
+       contexts. Before each vertical seam a full-table reference DP over
+       energy plus mask weight (map_reference, forward_reference) must
+       find the same seam and cost, the contexts must agree, and after
+       every seam each mask must equal a copy of it kept as an image and
+       carved with remove_seam_inplace / remove_hseam_inplace, counts
+       included;
+     - carving to a smaller WxH with an all-neutral mask must remove the
+       same seams as carving without one;
+     - a painted removal block next to a protected one must be removed
+       completely with carve_remove_step, without losing a protected
+       pixel, in no more seams than the block is wide (or, on a one-row or
+       one-column image where only the other direction is left, high);
+       a one-pixel image has no seam to give and must be STUCK;
+     - a 4x6 object on 2400 rows of noise, where the mask weights cannot
+       outbid a cheap flat strip, must still be removed in at most 4
+       seams (dual, threaded and forward energy), and once walled in by
+       protected pixels must stop at CARVE_STUCK without carving.
+   Returns the number of mismatches.
+*/
+static int remove_object(struct rgb_img *im, int unused) {
+    struct carve_ctx ctx;
+    struct seam_log log;
+    struct timespec start, end;
+    FILE *log_fp = NULL;
+    char name[512];
+    int seams = 0, step, failed = 0;
+    (void)unused;
+
+    if (carve_mask == NULL) {
+        fprintf(stderr, "--remove-object needs --mask MASK.bin\n");
+        destroy_image(im);
+        return 1;
+    }
+    if (log_name != NULL && (log_fp = fopen(log_name, "wb")) == NULL) {
+        fprintf(stderr, "cannot write %s\n", log_name);
+        destroy_image(im);
+        return 1;
+    }
+    if (log_fp != NULL) seam_log_begin(&log, log_fp, im->height, im->width);
+
+    size_t pixels = carve_mask->count[MASK_REMOVE];
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    carve_init_opts(&ctx, im, order_opts);
+    carve_set_mask(&ctx, carve_mask);
+    while ((step = carve_remove_step(&ctx)) != CARVE_DONE && step != CARVE_STUCK) {
+        stats_step(++seams, ctx.im);
+        if (log_fp == NULL) continue;
+        if (step == CARVE_VERTICAL) seam_log_vertical(&log, ctx.path);
+        else seam_log_horizontal(&log, ctx.hpath);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    if (log_fp != NULL) {
+        failed |= seam_log_end(&log);
+        failed |= fclose(log_fp);
+    }
+
+    sized_name(name, sizeof(name), ctx.im);
+    failed |= write_img(carve_image(&ctx), name);
+    printf("removed %zu of %zu masked pixels with %d %s seams in %.1f ms, wrote %s%s\n",
+           pixels - carve_mask->count[MASK_REMOVE], pixels, seams,
+           (ctx.mask_direction == CARVE_VERTICAL) ? "vertical" : "horizontal", elapsed_ms(&start, &end), name,
+           failed ? " (write failed)" : "");
+    if (step == CARVE_STUCK) printf("stopped: no seam reaches the %zu pixels left\n", carve_mask->count[MASK_REMOVE]);
+
+    carve_free(&ctx);
+    return (failed || step == CARVE_STUCK) ? 1 : 0;
+}
+
+static uint32_t map_reference(struct energy_map *grad, struct rgb_img *codes, int *path) {
+    const int dirs[3] = {0, -1, 1};   // Tie order: up, up-left, up-right
+    int height = grad->height, width = grad->width;
+    uint64_t *cost = (uint64_t *)malloc(sizeof(uint64_t) * height * width);
+    uint32_t weight[MASK_CODES];
+    mask_weights(height, MASK_MAX_ENERGY, weight);
+
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            uint64_t best = 0;
+            for (int d = 0; d < 3 && y > 0; d++) {
+                int from = x + dirs[d];
+                if (from < 0 || from >= width) continue;
+                if (d == 0 || cost[(y - 1) * width + from] < best) best = cost[(y - 1) * width + from];
+            }
+            cost[y * width + x] = best + get_energy(grad, y, x) + reference_bias(codes, weight, y, x);
+        }
+    }
+
+    int col = 0;
+    for (int x = 1; x < width; x++) {
+        if (cost[(height - 1) * width + x] < cost[(height - 1) * width + col]) col = x;
+    }
+    path[height - 1] = col;
+    for (int y = height - 1; y > 0; y--) {
+        uint64_t parent = cost[y * width + col] - get_energy(grad, y, col) - reference_bias(codes, weight, y, col);
+        for (int d = 0; d < 3; d++) {
+            int from = col + dirs[d];
+            if (from >= 0 && from < width && cost[(y - 1) * width + from] == parent) {
+                col = from;
+                break;
+            }
+        }
+        path[y - 1] = col;
+    }
+    uint32_t total = 0;
+    for (int y = 0; y < height; y++) total += get_energy(grad, y, path[y]);
+    free(cost);
+    return total;
+}
+
+// Whether a mask equals the codes image, counts included
+static int same_mask(const struct seam_mask *mask, struct rgb_img *codes) {
+    size_t count[MASK_CODES] = {0};
+    if (mask->height != codes->height || mask->width != codes->width) return 0;
+    for (size_t y = 0; y < mask->height; y++) {
+        for (size_t x = 0; x < mask->width; x++) {
+            int code = get_mask(mask, (int)y, (int)x);
+            if (code != get_pixel(codes, (int)y, (int)x, 0)) return 0;
+            count[code]++;
+        }
+    }
+    return memcmp(count, mask->count, sizeof(count)) == 0;
+}
+
+static int check_mask(struct rgb_img *im, int seams) {
+    struct carve_ctx plain, threaded, forward, bare, masked;
+    struct carve_opts opts;
+    struct seam_mask *masks[3], *neutral;
+    struct rgb_img *codes, *fcodes;
+    int *path = (int *)malloc(sizeof(int) * (im->height + im->width));
+    int failures = 0;
+    uint32_t seed = 12345;
+
+    // Part 1: a random mask, carved with the image
+    create_img(&codes, im->height, im->width);
+    for (size_t y = 0; y < im->height; y++) {
+        for (size_t x = 0; x < im->width; x++) {
+            seed = seed * 1103515245u + 12345u;
+            int code = (seed >> 16) % 8;             // Mostly neutral
+            code = (code < 3) ? code : MASK_NEUTRAL;
+            set_pixel(codes, (int)y, (int)x, code, code, code);
+        }
+    }
+    for (int m = 0; m < 3; m++) create_mask(&masks[m], im->height, im->width);
+    for (size_t y = 0; y < im->height; y++) {
+        for (size_t x = 0; x < im->width; x++) {
+            for (int m = 0; m < 3; m++) set_mask(masks[m], (int)y, (int)x, get_pixel(codes, (int)y, (int)x, 0));
+        }
+    }
+    fcodes = copy_img(codes);
+    if (seams > (int)im->width - 1) seams = im->width - 1;
+    if (seams > 2 * ((int)im->height - 1)) seams = 2 * ((int)im->height - 1);
+
+    carve_opts_default(&opts);
+    carve_init_opts(&plain, copy_img(im), &opts);
+    opts.threads = check_thread_count;
+    carve_init_opts(&threaded, copy_img(im), &opts);
+    opts.threads = 1;
+    opts.energy = ENERGY_FORWARD;
+    carve_init_opts(&forward, copy_img(im), &opts);
+    carve_set_mask(&plain, masks[0]);
+    carve_set_mask(&threaded, masks[1]);
+    carve_set_mask(&forward, masks[2]);
+
+    for (int i = 0; i < seams; i++) {
+        int bad = 0;
+        size_t rows = plain.im->height;
+        if (i % 2 == 0) {
+            uint64_t before = plain.removed_energy, fbefore = forward.removed_energy;
+            uint32_t cost = map_reference(plain.grad, codes, path);
+            carve_seam(&plain);
+            carve_seam(&threaded);
+            bad |= memcmp(path, plain.path, sizeof(int) * rows) != 0 || plain.removed_energy - before != cost;
+            bad |= memcmp(plain.path, threaded.path, sizeof(int) * rows) != 0;
+            remove_seam_inplace(codes, plain.path);
+
+            cost = forward_reference(forward.im, fcodes, path);
+            carve_seam(&forward);
+            bad |= memcmp(path, forward.path, sizeof(int) * rows) != 0 ||
+                   forward.removed_energy - fbefore != cost;
+            remove_seam_inplace(fcodes, forward.path);
+        } else {
+            carve_seam_h(&plain);
+            carve_seam_h(&threaded);
+            carve_seam_h(&forward);
+            bad |= memcmp(plain.hpath, threaded.hpath, sizeof(int) * plain.im->width) != 0;
+            remove_hseam_inplace(codes, plain.hpath);
+            remove_hseam_inplace(fcodes, forward.hpath);
+        }
+        bad |= !same_mask(masks[0], codes) || !same_mask(masks[1], codes) || !same_mask(masks[2], fcodes);
+        if (bad) printf("masked seam %d differs\n", i);
+        failures += bad;
+    }
+    carve_free(&plain);
+    carve_free(&threaded);
+    carve_free(&forward);
+    for (int m = 0; m < 3; m++) destroy_mask(masks[m]);
+    destroy_image(codes);
+    destroy_image(fcodes);
+
+    // Part 2: an all-neutral mask changes nothing
+    size_t width = im->width - im->width / 8, height = im->height - im->height / 8;
+    create_mask(&neutral, im->height, im->width);
+    carve_init(&bare, copy_img(im));
+    carve_init(&masked, copy_img(im));
+    carve_set_mask(&masked, neutral);
+    for (;;) {
+        int step = carve_step(&bare, width, height);
+        int bad = carve_step(&masked, width, height) != step || bare.removed_energy != masked.removed_energy;
+        if (step == CARVE_VERTICAL) bad |= memcmp(bare.path, masked.path, sizeof(int) * bare.im->height) != 0;
+        if (step == CARVE_HORIZONTAL) bad |= memcmp(bare.hpath, masked.hpath, sizeof(int) * bare.im->width) != 0;
+        if (bad) printf("neutral mask changed a seam at %zux%zu\n", bare.im->width, bare.im->height);
+        failures += bad;
+        if (step == CARVE_DONE || bad) break;
+    }
+    failures += !same_pixels(bare.im, masked.im);
+    carve_free(&bare);
+    carve_free(&masked);
+    destroy_mask(neutral);
+
+    // Part 3: remove a block beside a protected one
+    struct seam_mask *paint;
+    int block = (im->width >= 16) ? (int)im->width / 8 : 1;
+    int x0 = (int)im->width / 2, y0 = (int)im->height / 4, y1 = (int)im->height - (int)im->height / 4;
+    create_mask(&paint, im->height, im->width);
+    for (int y = y0; y < y1; y++) {
+        for (int x = x0; x < x0 + block; x++) set_mask(paint, y, x, MASK_REMOVE);
+        for (int x = (x0 >= block) ? x0 - block : 0; x < x0; x++) set_mask(paint, y, x, MASK_PROTECT);  // Right next to it
+    }
+    size_t protect = paint->count[MASK_PROTECT];
+    int steps = 0, rows = 0, step;        // Vertical and horizontal seams taken
+    carve_init(&masked, copy_img(im));
+    carve_set_mask(&masked, paint);
+    while ((step = carve_remove_step(&masked)) != CARVE_DONE && step != CARVE_STUCK) {
+        if (step == CARVE_VERTICAL) steps++;
+        else rows++;
+    }
+    int bad;
+    if (im->width <= 1 && im->height <= 1) {   // One pixel: no seam in either direction
+        bad = step != CARVE_STUCK || steps + rows != 0;
+    } else {
+        bad = step != CARVE_DONE || paint->count[MASK_REMOVE] != 0 || paint->count[MASK_PROTECT] != protect ||
+              steps > block || rows > ((im->width <= 1) ? y1 - y0 : 0) || masked.im->width != im->width - steps ||
+              masked.im->height != im->height - rows;
+    }
+    const char *note = (im->width <= 1 && im->height <= 1) ? " (one pixel: no seam, stuck)"
+                       : rows                              ? " (rows: one column left)"
+                                                           : "";
+    printf("object of %d columns removed in %d seams%s%s\n", block, steps + rows, note, bad ? " (FAIL)" : "");
+    failures += bad;
+    carve_free(&masked);
+    destroy_mask(paint);
+
+    // Part 4: a small object on noise too tall for the weights to force a
+    // seam through it (a flat strip is far cheaper), then walled in
+    const char *kinds[3] = {"dual", "threaded", "forward"};
+    int tall_h = 2400, tall_w = 128;
+    struct rgb_img *tall;
+    create_img(&tall, tall_h, tall_w);
+    for (int y = 0; y < tall_h; y++) {
+        for (int x = 0; x < tall_w; x++) {
+            seed = seed * 1103515245u + 12345u;
+            if (x >= 4 && x < 7) set_pixel(tall, y, x, 90, 90, 90);
+            else set_pixel(tall, y, x, (seed >> 8) & 255, (seed >> 16) & 255, seed >> 24);
+        }
+    }
+    for (int walled = 0; walled < 2; walled++) {
+        for (int k = 0; k < 3; k++) {
+            create_mask(&paint, tall_h, tall_w);
+            for (int y = 1196; y < 1204; y++) {
+                for (int x = 99; x < 105; x++) {
+                    int inside = y > 1196 && y < 1203 && x > 99 && x < 104;  // 6 rows x 4 columns
+                    if (inside) set_mask(paint, y, x, MASK_REMOVE);
+                    else if (walled) set_mask(paint, y, x, MASK_PROTECT);
+                }
+            }
+            protect = paint->count[MASK_PROTECT];
+            carve_opts_default(&opts);
+            opts.threads = (k == 1) ? check_thread_count : 1;
+            opts.energy = (k == 2) ? ENERGY_FORWARD : ENERGY_DUAL;
+            carve_init_opts(&masked, copy_img(tall), &opts);
+            carve_set_mask(&masked, paint);
+            steps = 0;
+            while ((step = carve_remove_step(&masked)) != CARVE_DONE && step != CARVE_STUCK) steps++;
+            if (walled) bad = step != CARVE_STUCK || steps != 0 || paint->count[MASK_REMOVE] != 24;
+            else bad = step != CARVE_DONE || paint->count[MASK_REMOVE] != 0 || steps > 4;
+            bad |= paint->count[MASK_PROTECT] != protect || masked.im->width != (size_t)(tall_w - steps);
+            printf("%dx%d object on %d rows (%s%s): %d seams%s\n", 4, 6, tall_h, kinds[k],
+                   walled ? ", walled in" : "", steps, bad ? " (FAIL)" : "");
+            failures += bad;
+            carve_free(&masked);
+            destroy_mask(paint);
+        }
+    }
+    destroy_image(tall);
+
+    free(path);
+    destroy_image(im);
+    return failures;
+}
+
+// ----------------------------------------
+// Function: check_log / replay_log
+// ----------------------------------------
+/*
+   --check-log carves `seams` seams (honouring --batch) while logging them
+   to a temporary file, and after every carve_seams call replays the whole
+   log onto a fresh copy of the image and compares it with the carved one.
+   --replay LOG rebuilds the image after `seams` seams from the input and
+   its log, and writes it under the name the step-by-step mode would have
+   used (img<seams - 1>.bin).
+*/
+static int check_log(struct rgb_img *im, int seams) {
+    struct carve_ctx ctx;
+    struct seam_log log;
+    struct rgb_img *copy;
+    int failures = 0;
+    FILE *fp = tmpfile();
+
+    if (fp == NULL) return 1;
+    copy = copy_img(im);
+    seam_log_begin(&log, fp, im->height, im->width);
+    carve_init_opts(&ctx, copy, order_opts);
+
+    for (int i = 0; i < seams; ) {
+        int removed = carve_seams(&ctx, seams - i);
+        if (removed == 0) break;
+        seam_log_batch(&log, ctx.paths, removed);
+        fflush(fp);
+        i += removed;
+
+        struct rgb_img *replayed;
+        replayed = copy_img(im);
+        rewind(fp);
+        int count = seam_log_replay(replayed, fp, -1);
+        struct rgb_img *carved = carve_image(&ctx);
+        int bad = (count != i || replayed->width != carved->width);
+        for (size_t y = 0; y < replayed->height && !bad; y++) {
+            bad |= memcmp(replayed->raster + 3 * y * replayed->stride, carved->raster + 3 * y * carved->stride,
+                          3 * replayed->width) != 0;
+        }
+        if (bad) printf("replay of %d seams differs\n", i);
+        failures += bad;
+        destroy_image(replayed);
+        fseek(fp, 0, SEEK_END);  // Back to appending
+    }
+
+    failures += (seam_log_end(&log) != 0);
+    fclose(fp);
+    carve_free(&ctx);
+    destroy_image(im);
+    return failures;
+}
+
+static int replay_log(struct rgb_img *im, int seams) {
+    char name[200];
+    FILE *fp = fopen(log_name, "rb");
+    int replayed = (fp != NULL) ? seam_log_replay(im, fp, seams) : -1;
+
+    if (fp != NULL) fclose(fp);
+    if (replayed < 0) {
+        fprintf(stderr, "%s is missing, corrupt or not a log of this image\n", log_name);
+        destroy_image(im);
+        return 1;
+    }
+
+    sprintf(name, "img%d.bin", replayed - 1);
+    int failed = write_img(im, name);
+    printf("replayed %d seams, wrote %s%s\n", replayed, name, failed ? " (write failed)" : "");
+    destroy_image(im);
+    return failed ? 1 : 0;
+}
+
+// ----------------------------------------
+// Main Function: Seam Carving Execution
+// ----------------------------------------
+/*
+   Carves out seams from an image, writing each step to disk.
+   The energy map is computed once and then updated incrementally.
+
+   Usage: seamcarving [--kernel NAME] [--energy E] [--threads N] [--batch K]
+                      [--check-energy | --check-dp | --check-kernels |
+                       --check-threads | --time-threads | --compare-batch |
+                       --check-order | --build-order | --retarget W |
+                       --check-horizontal | --target WxH | --dump-energy |
+                       --check-log | --replay LOG | --check-planar |
+                       --compare-pyramid | --insert N | --check-insert |
+                       --check-service | --check-sequence |
+                       --check-container | --convert OUT | --check-forward |
+                       --compare-energy | --check-mask | --remove-object]
+                      [--mask MASK.bin] [--log LOG]
+                      [--stats NAME] [--planar] [--pyramid B] [--band-rows N]
+                      [image.bin] [seams]
+         seamcarving --manifest FILE [--jobs N] [--energy E] [--threads N]
+                     [--batch K] [--planar] [--pyramid B]
+         seamcarving --serve SOCKET [--cache-mb MB] [--threads N] [--batch K]
+         seamcarving --client SOCKET (stats | shutdown | WxH image.bin [out.bin])
+         seamcarving --sequence IN OUT [--first N] [--band B] [--threshold T]
+                     [--keyframe K] [seams]
+         seamcarving --stream-energy IN [--band-rows N]
+   Defaults to 5 seams from HJoceanSmall.bin. --kernel forces an energy row
+   kernel (auto, scalar, sse4.1, avx2); --energy picks the energy function:
+   dual (dual-gradient, the default), l1 (L1 gradient, cheaper) or forward
+   (forward energy, computed inside the DP); --threads runs the energy and DP
+   passes on N threads; --batch removes up to K disjoint seams per DP pass
+   (an image is written after each pass). The --check-* modes write no files:
+   --check-energy verifies the incremental energy map after every seam,
+   --check-dp compares the compact DP against dynamic_seam,
+   --check-kernels compares every energy kernel against the reference,
+   --check-forward compares forward-energy seams against a reference DP, and
+   --check-threads compares a serial and an N-thread carve (default 4).
+   --time-threads times the carve with 1 .. N threads (default 4).
+   --compare-batch reports energy removed and time for exact carving
+   versus --batch K (default 8). --compare-energy times each energy.
+   --build-order saves the removal order of every pixel (carving down to
+   `seams` columns, default 1) to image.order; --retarget W then writes
+   image_wW.bin from it in one pass. --check-order verifies retargeting.
+   --target WxH removes columns and rows (cheapest seam per pixel first)
+   until the image is W x H and writes image_WxH.bin; a W above the width
+   inserts seams instead (rows can only be removed). --check-horizontal
+   compares horizontal carving against vertical carving of the transpose.
+   --dump-energy writes the energy map as a grayscale image_energy.bin.
+   --log LOG writes only the final image plus a seam log (2 bytes per row
+   per seam) instead of an image per step; --replay LOG image.bin N
+   rebuilds the image after N seams (default: all) from it. --check-log
+   verifies replay. --stats NAME writes per-step stage timings and byte
+   counts to NAME.csv and the run totals to NAME.json.
+   --planar carves a planar (one plane per channel) copy of the image;
+   --check-planar compares it against the interleaved carve.
+   --pyramid B finds vertical seams coarse to fine, searching B columns
+   either side of the coarse seam at each level; --compare-pyramid reports
+   its time and its cost against the exact DP (default B 8).
+   --insert N widens the image by N columns by duplicating its N cheapest
+   seams, written to image_wW.bin; --target WxH with W above the width
+   widens the same way before removing rows. --check-insert verifies the
+   widening.
+   --manifest FILE carves every "input WxH output" line of FILE on N
+   worker threads (default: one per CPU), reporting each image's latency
+   and the overall throughput; --energy, --threads (per image), --batch,
+   --planar and --pyramid apply to every image (see seam_manifest.h).
+   --serve SOCKET runs the carving daemon on a Unix socket with a cache of
+   MB megabytes (default 256) of images and removal orders, until a client
+   sends shutdown; --client talks to it, and --check-service verifies its
+   replies and cache behaviour (see seam_service.h).
+   --sequence IN OUT carves `seams` columns from every frame of a numbered
+   series (printf patterns such as frame%04d.bin, from --first, default 0),
+   following the previous frame's seams within B columns (default 8) and
+   recomputing energy only around pixels that changed by more than T
+   (default 4), with an exact keyframe every K frames (default 30, 0 =
+   scene cuts only); --check-sequence verifies it (see seam_sequence.h).
+   --convert OUT writes the image in the v2 layout (32-bit sides, rows
+   padded to 64 bytes), in bands of N rows with --band-rows N (default:
+   not chunked); every mode reads v1 and v2 alike (see c_img.h).
+   --stream-energy IN writes IN_energy.bin without loading IN, one band
+   of rows at a time; --check-container verifies both layouts.
+   --mask MASK.bin steers the seams of the plain carve and of --target
+   with an image of the same size: red pixels are removed first, green
+   ones are protected (see seam_mask.h). --remove-object carves seams
+   only until the red region is gone and writes image_WxH.bin;
+   --check-mask verifies masked seams, mask carving and object removal.
+*/
+int main(int argc, char **argv) {
+    struct rgb_img *im;       // Input image pointer
+    struct carve_ctx ctx;     // Image and energy map, carved in place
+    struct carve_opts opts;   // Carving options from the command line
+    int (*check)(struct rgb_img *, int) = NULL;  // Self-check to run instead
+    char *input = "HJoceanSmall.bin";  // Image to carve
+    int seams = -1;           // Seams to carve (default 5; --build-order: 1 column left)
+    char *manifest_name = NULL;  // --manifest: batch of images instead of one
+    int jobs = (int)sysconf(_SC_NPROCESSORS_ONLN);  // Manifest workers
+    char *serve_socket = NULL;   // --serve: run the carving daemon on this socket
+    char *client_socket = NULL;  // --client: send one request to a daemon
+    int cache_mb = 256;          // --cache-mb: daemon cache budget
+    char *sequence_in = NULL;    // --sequence: frame file patterns
+    char *sequence_out = NULL;
+    int sequence_first = 0;      // --first: number of the first frame
+    char *stream_name = NULL;    // --stream-energy: file to stream
+    char *mask_name = NULL;      // --mask: protect / remove mask image
+
+    carve_opts_default(&opts);
+    int arg = 1;
+    for (; arg < argc && strncmp(argv[arg], "--", 2) == 0; arg++) {
+        if (strcmp(argv[arg], "--check-energy") == 0) {
+            check = check_energy;
+        } else if (strcmp(argv[arg], "--check-dp") == 0) {
+            check = check_dp;
+        } else if (strcmp(argv[arg], "--check-kernels") == 0) {
+            check = check_kernels;
+        } else if (strcmp(argv[arg], "--check-threads") == 0) {
+            check = check_threads;
+        } else if (strcmp(argv[arg], "--time-threads") == 0) {
+            check = time_threads;
+        } else if (strcmp(argv[arg], "--compare-batch") == 0) {
+            check = compare_batch;
+        } else if (strcmp(argv[arg], "--build-order") == 0) {
+            check = build_order;
+        } else if (strcmp(argv[arg], "--check-order") == 0) {
+            check = check_order;
+        } else if (strcmp(argv[arg], "--retarget") == 0 && arg + 1 < argc) {
+            check = retarget;
+            retarget_width = atoi(argv[++arg]);
+        } else if (strcmp(argv[arg], "--stats") == 0 && arg + 1 < argc) {
+            stats_name = argv[++arg];
+        } else if (strcmp(argv[arg], "--log") == 0 && arg + 1 < argc) {
+            log_name = argv[++arg];
+        } else if (strcmp(argv[arg], "--replay") == 0 && arg + 1 < argc) {
+            check = replay_log;
+            log_name = argv[++arg];
+        } else if (strcmp(argv[arg], "--check-log") == 0) {
+            check = check_log;
+        } else if (strcmp(argv[arg], "--dump-energy") == 0) {
+            check = dump_energy;
+        } else if (strcmp(argv[arg], "--check-planar") == 0) {
+            check = check_planar;
+        } else if (strcmp(argv[arg], "--check-forward") == 0) {
+            check = check_forward;
+        } else if (strcmp(argv[arg], "--compare-energy") == 0) {
+            check = compare_energy;
+        } else if (strcmp(argv[arg], "--check-mask") == 0) {
+            check = check_mask;
+        } else if (strcmp(argv[arg], "--remove-object") == 0) {
+            check = remove_object;
+        } else if (strcmp(argv[arg], "--mask") == 0 && arg + 1 < argc) {
+            mask_name = argv[++arg];
+        } else if (strcmp(argv[arg], "--energy") == 0 && arg + 1 < argc) {
+            opts.energy = energy_parse(argv[++arg]);
+            if (opts.energy < 0) {
+                fprintf(stderr, "unknown energy '%s' (dual, l1 or forward)\n", argv[arg]);
+                return 1;
+            }
+        } else if (strcmp(argv[arg], "--planar") == 0) {
+            opts.planar = 1;
+        } else if (strcmp(argv[arg], "--insert") == 0 && arg + 1 < argc) {
+            check = insert_columns;
+            insert_count = atoi(argv[++arg]);
+        } else if (strcmp(argv[arg], "--check-insert") == 0) {
+            check = check_insert;
+        } else if (strcmp(argv[arg], "--check-service") == 0) {
+            check = check_service;
+        } else if (strcmp(argv[arg], "--check-container") == 0) {
+            check = check_container;
+        } else if (strcmp(argv[arg], "--convert") == 0 && arg + 1 < argc) {
+            check = convert_image;
+            convert_name = argv[++arg];
+        } else if (strcmp(argv[arg], "--band-rows") == 0 && arg + 1 < argc) {
+            int rows = atoi(argv[++arg]);
+            band_rows = (rows > 0) ? (size_t)rows : 0;
+        } else if (strcmp(argv[arg], "--stream-energy") == 0 && arg + 1 < argc) {
+            stream_name = argv[++arg];
+        } else if (strcmp(argv[arg], "--check-sequence") == 0) {
+            check = check_sequence;
+        } else if (strcmp(argv[arg], "--sequence") == 0 && arg + 2 < argc) {
+            sequence_in = argv[++arg];
+            sequence_out = argv[++arg];
+        } else if (strcmp(argv[arg], "--first") == 0 && arg + 1 < argc) {
+            sequence_first = atoi(argv[++arg]);
+        } else if (strcmp(argv[arg], "--band") == 0 && arg + 1 < argc) {
+            sequence_band = atoi(argv[++arg]);
+        } else if (strcmp(argv[arg], "--threshold") == 0 && arg + 1 < argc) {
+            sequence_threshold = atoi(argv[++arg]);
+        } else if (strcmp(argv[arg], "--keyframe") == 0 && arg + 1 < argc) {
+            sequence_keyframe = atoi(argv[++arg]);
+        } else if (strcmp(argv[arg], "--serve") == 0 && arg + 1 < argc) {
+            serve_socket = argv[++arg];
+        } else if (strcmp(argv[arg], "--cache-mb") == 0 && arg + 1 < argc) {
+            cache_mb = atoi(argv[++arg]);
+        } else if (strcmp(argv[arg], "--client") == 0 && arg + 1 < argc) {
+            client_socket = argv[++arg];
+        } else if (strcmp(argv[arg], "--compare-pyramid") == 0) {
+            check = compare_pyramid;
+        } else if (strcmp(argv[arg], "--pyramid") == 0 && arg + 1 < argc) {
+            opts.pyramid = atoi(argv[++arg]);
+            if (opts.pyramid > 0) compare_pyramid_band = opts.pyramid;
+        } else if (strcmp(argv[arg], "--check-horizontal") == 0) {
+            check = check_horizontal;
+        } else if (strcmp(argv[arg], "--target") == 0 && arg + 1 < argc) {
+            check = carve_target;
+            if (sscanf(argv[++arg], "%zux%zu", &target_width, &target_height) != 2) {
+                fprintf(stderr, "--target expects WxH, got %s\n", argv[arg]);
+                return 1;
+            }
+        } else if (strcmp(argv[arg], "--manifest") == 0 && arg + 1 < argc) {
+            manifest_name = argv[++arg];
+        } else if (strcmp(argv[arg], "--jobs") == 0 && arg + 1 < argc) {
+            jobs = atoi(argv[++arg]);
+        } else if (strcmp(argv[arg], "--batch") == 0 && arg + 1 < argc) {
+            opts.batch = atoi(argv[++arg]);
+            compare_batch_size = opts.batch;
+        } else if (strcmp(argv[arg], "--threads") == 0 && arg + 1 < argc) {
+            opts.threads = atoi(argv[++arg]);
+            check_thread_count = opts.threads;
+        } else if (strcmp(argv[arg], "--kernel") == 0 && arg + 1 < argc) {
+            if (energy_use_kernel(argv[++arg]) != 0) {
+                fprintf(stderr, "energy kernel '%s' is not available\n", argv[arg]);
+                return 1;
+            }
+        } else {
+            fprintf(stderr, "unknown option %s\n", argv[arg]);
+            return 1;
+        }
+    }
+    if (manifest_name != NULL) {
+        struct manifest m;
+        if (manifest_read(&m, manifest_name) != 0) {
+            fprintf(stderr, "cannot read manifest %s\n", manifest_name);
+            return 1;
+        }
+        int failures = manifest_run(&m, jobs > 0 ? jobs : 1, &opts, stdout);
+        manifest_free(&m);
+        return failures ? 1 : 0;
+    }
+    if (serve_socket != NULL) {
+        struct seam_service svc;
+        service_init(&svc, (size_t)(cache_mb > 0 ? cache_mb : 0) << 20, &opts);
+        if (service_listen(&svc, serve_socket) != 0) {
+            perror(serve_socket);
+            return 1;
+        }
+        printf("serving on %s with a %d MB cache\n", serve_socket, cache_mb);
+        fflush(stdout);
+        int failed = service_run(&svc, serve_socket);
+        service_free(&svc);
+        return failed ? 1 : 0;
+    }
+    if (client_socket != NULL) return run_client(client_socket, argc - arg, argv + arg);
+    if (sequence_in != NULL) {
+        int columns = (arg < argc) ? atoi(argv[arg]) : 5;
+        int failures = seam_sequence_run(sequence_in, sequence_out, sequence_first, columns, sequence_band,
+                                         sequence_threshold, sequence_keyframe, &opts, stdout);
+        if (failures < 0) fprintf(stderr, "cannot read the first frame of %s\n", sequence_in);
+        return failures ? 1 : 0;
+    }
+    if (stream_name != NULL) return stream_energy_file(stream_name);
+    if (arg < argc) input = argv[arg++];
+    if (arg < argc) seams = atoi(argv[arg++]);
+    if (seams < 0 && check != replay_log) seams = (check == build_order) ? 1 : 5;  // Replay: whole log
+    order_image = input;
+    order_opts = &opts;
+
+    if (stats_begin() != 0) return 1;
+    if (read_in_img(&im, input) != 0) {  // Read image from binary file
+        fprintf(stderr, "cannot read %s\n", input);
+        return stats_end(input, 1);
+    }
+    if (mask_name != NULL) {
+        struct rgb_img *painted = NULL;
+        if (read_in_img(&painted, mask_name) == 0 && painted->height == im->height && painted->width == im->width) {
+            mask_from_img(painted, &carve_mask);
+        }
+        if (painted != NULL) destroy_image(painted);
+        if (carve_mask == NULL) {
+            fprintf(stderr, "cannot read %s, or it is not the size of %s\n", mask_name, input);
+            destroy_image(im);
+            return stats_end(input, 1);
+        }
+    }
+
+    if (check) {
+        int failures = check(im, seams);
+        destroy_mask(carve_mask);
+        if (check == build_order || check == retarget || check == carve_target || check == replay_log ||
+            check == dump_energy || check == insert_columns || check == convert_image || check == remove_object) {
+            return stats_end(input, failures);  // Not a self-check
+        }
+        if (check == time_threads || check == compare_batch || check == compare_energy) {
+            return stats_end(input, 0);  // Nothing to verify
+        }
+        printf("%s: %d of %d seams mismatched\n", failures ? "FAIL" : "OK", failures, seams);
+        return stats_end(input, failures ? 1 : 0);
+    }
+
+    struct seam_log log;      // --log: seams removed, instead of per-step images
+    FILE *log_fp = NULL;
+    if (log_name != NULL) {
+        log_fp = fopen(log_name, "wb");
+        if (log_fp == NULL) {
+            fprintf(stderr, "cannot write %s\n", log_name);
+            destroy_image(im);
+            return 1;
+        }
+        seam_log_begin(&log, log_fp, im->height, im->width);
+    }
+
+    carve_init_opts(&ctx, im, &opts);                 // Step 1: compute energy once
+    carve_set_mask(&ctx, carve_mask);
+
+    int failed = 0;
+    char filename[200];
+    for (int i = 0; i < seams; ) {
+        printf("i = %d\n", i);                        // Output current step
+        int removed = carve_seams(&ctx, seams - i);   // Step 2: find and remove the best seam(s)
+        if (removed == 0) break;
+        i += removed;
+
+        sprintf(filename, "img%d.bin", i - 1);        // Construct output filename
+        if (log_fp != NULL) {
+            failed |= seam_log_batch(&log, ctx.paths, removed);  // Log the seams only
+            if (i < seams && ctx.im->width > 1) {               // Image written at the end
+                stats_step(i, ctx.im);
+                continue;
+            }
+        }
+        failed |= write_img(carve_image(&ctx), filename);  // Save the new image
+        stats_step(i, ctx.im);
+    }
+
+    if (log_fp != NULL) {
+        failed |= seam_log_end(&log);
+        failed |= fclose(log_fp);
+    }
+    if (failed) fprintf(stderr, "writing the output failed\n");
+    carve_free(&ctx);  // Final cleanup
+    destroy_mask(carve_mask);
+    return stats_end(input, failed ? 1 : 0);
+}
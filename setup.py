@@ -0,0 +1,40 @@
+'''
+Python Extension Build Script
+Author: Tannaz Chowdhury
+GitHub: TannazC
+Date: 2025
+
+Builds the `seamcarving` extension module (seam_python.c) together with
+the library sources listed in the Makefile:
+
+    python3 setup.py build_ext --inplace     # or: make python
+'''
+
+import re                                           # To read LIB_SRCS out of the Makefile
+from setuptools import setup, Extension
+
+# ----------------------------------------
+# Function: library_sources
+# ----------------------------------------
+'''
+Returns the library's .c files, as the Makefile's LIB_SRCS lists them, so
+the two builds never drift apart.
+'''
+def library_sources():
+    with open("Makefile") as f:
+        text = f.read().replace("\\\n", " ")          # Join continued lines
+    match = re.search(r"^LIB_SRCS\s*=\s*(.*)$", text, re.MULTILINE)
+    return match.group(1).split()
+
+setup(
+    name="seamcarving",
+    version="1.0",
+    description="Seam carving on RGB buffers, without copies",
+    ext_modules=[Extension(
+        "seamcarving",
+        sources=["seam_python.c"] + library_sources(),
+        extra_compile_args=["-std=c99", "-O2"],
+        extra_link_args=["-pthread"],
+        libraries=["m"],
+    )],
+)
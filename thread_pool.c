@@ -0,0 +1,189 @@
+/*
+Thread Pool Implementation
+Author: Tannaz Chowdhury
+GitHub: TannazC
+Date: 2025
+
+Workers sleep on a condition variable until pool_run publishes a new job
+(a new generation number), run it, and report back. The barrier is a
+counting barrier with a generation number so it can be reused
+immediately.
+*/
+
+#include <stdlib.h>           // Required for malloc, free
+#include <pthread.h>          // Required for threads, mutexes, condition variables
+#include "thread_pool.h"      // Header for the thread pool declarations
+
+struct thread_pool {
+    int threads;              // Threads per job, including the caller
+    pthread_t *workers;       // threads - 1 worker threads
+
+    pthread_mutex_t lock;     // Protects everything below
+    pthread_cond_t wake;      // Signalled when a job is published or on shutdown
+    pthread_cond_t done;      // Signalled when the last worker finishes a job
+    pool_job_fn fn;           // Current job
+    void *arg;
+    unsigned long job_gen;    // Incremented for every job
+    int running;              // Workers still busy with the current job
+    int shutdown;
+
+    pthread_mutex_t bar_lock; // Barrier state
+    pthread_cond_t bar_cond;
+    int bar_waiting;
+    unsigned long bar_gen;
+};
+
+struct worker_arg {
+    struct thread_pool *pool;
+    int id;
+};
+
+// ----------------------------------------
+// Helper: Worker Loop
+// ----------------------------------------
+/*
+   Waits for each new job generation, runs the job, and signals the
+   caller when the last worker is done.
+*/
+static void *worker_main(void *p) {
+    struct worker_arg *wa = (struct worker_arg *)p;
+    struct thread_pool *pool = wa->pool;
+    int id = wa->id;
+    unsigned long seen = 0;
+    free(wa);
+
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (!pool->shutdown && pool->job_gen == seen) {
+            pthread_cond_wait(&pool->wake, &pool->lock);
+        }
+        if (pool->shutdown) break;
+        seen = pool->job_gen;
+        pool_job_fn fn = pool->fn;
+        void *arg = pool->arg;
+        pthread_mutex_unlock(&pool->lock);
+
+        fn(arg, id, pool->threads);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->running == 0) pthread_cond_signal(&pool->done);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+// ----------------------------------------
+// Function: pool_create
+// ----------------------------------------
+struct thread_pool *pool_create(int threads) {
+    if (threads < 1) threads = 1;
+    struct thread_pool *pool = (struct thread_pool *)calloc(1, sizeof(struct thread_pool));
+    pool->threads = threads;
+    pool->workers = (pthread_t *)malloc(sizeof(pthread_t) * threads);
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+    pthread_cond_init(&pool->done, NULL);
+    pthread_mutex_init(&pool->bar_lock, NULL);
+    pthread_cond_init(&pool->bar_cond, NULL);
+
+    for (int i = 1; i < threads; i++) {
+        struct worker_arg *wa = (struct worker_arg *)malloc(sizeof(struct worker_arg));
+        wa->pool = pool;
+        wa->id = i;
+        if (pthread_create(&pool->workers[i], NULL, worker_main, wa) != 0) {
+            free(wa);
+            pool->threads = i;  // Join the ones that did start, then give up
+            pool_destroy(pool);
+            return NULL;
+        }
+    }
+    return pool;
+}
+
+// ----------------------------------------
+// Function: pool_destroy
+// ----------------------------------------
+void pool_destroy(struct thread_pool *pool) {
+    if (pool == NULL) return;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = 1;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+    for (int i = 1; i < pool->threads; i++) {
+        pthread_join(pool->workers[i], NULL);
+    }
+
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->wake);
+    pthread_cond_destroy(&pool->done);
+    pthread_mutex_destroy(&pool->bar_lock);
+    pthread_cond_destroy(&pool->bar_cond);
+    free(pool->workers);
+    free(pool);
+}
+
+// ----------------------------------------
+// Function: pool_size
+// ----------------------------------------
+int pool_size(struct thread_pool *pool) {
+    return pool ? pool->threads : 1;
+}
+
+// ----------------------------------------
+// Function: pool_run
+// ----------------------------------------
+/*
+   Publishes the job, runs share 0 on the calling thread, then waits for
+   the workers.
+*/
+void pool_run(struct thread_pool *pool, pool_job_fn fn, void *arg) {
+    if (pool->threads == 1) {  // Nothing to hand out
+        fn(arg, 0, 1);
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->fn = fn;
+    pool->arg = arg;
+    pool->running = pool->threads - 1;
+    pool->job_gen++;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+
+    fn(arg, 0, pool->threads);
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->running > 0) {
+        pthread_cond_wait(&pool->done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+// ----------------------------------------
+// Function: pool_barrier
+// ----------------------------------------
+void pool_barrier(struct thread_pool *pool) {
+    if (pool->threads == 1) return;
+
+    pthread_mutex_lock(&pool->bar_lock);
+    unsigned long gen = pool->bar_gen;
+    if (++pool->bar_waiting == pool->threads) {  // Last one in releases everybody
+        pool->bar_waiting = 0;
+        pool->bar_gen++;
+        pthread_cond_broadcast(&pool->bar_cond);
+    } else {
+        while (gen == pool->bar_gen) {
+            pthread_cond_wait(&pool->bar_cond, &pool->bar_lock);
+        }
+    }
+    pthread_mutex_unlock(&pool->bar_lock);
+}
+
+// ----------------------------------------
+// Function: pool_split
+// ----------------------------------------
+void pool_split(int n, int id, int count, int *begin, int *end) {
+    *begin = (int)((long long)n * id / count);
+    *end = (int)((long long)n * (id + 1) / count);
+}
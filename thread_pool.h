@@ -0,0 +1,72 @@
+/*
+Thread Pool Header File
+Author: Tannaz Chowdhury
+GitHub: TannazC
+Date: 2025
+
+A minimal fixed-size pthread pool for the parallel energy and DP passes.
+It is created once per carve and runs one job at a time on all of its
+threads (the calling thread takes part as thread 0). Inside a job, the
+threads can synchronise with pool_barrier.
+*/
+
+#ifndef THREAD_POOL_H           // Include guard - prevents multiple includes
+#define THREAD_POOL_H
+
+struct thread_pool;             // Opaque; defined in thread_pool.c
+
+// ----------------------------------------
+// Type: pool_job_fn
+// ----------------------------------------
+/*
+   A job run by every thread of the pool.
+
+   Parameters:
+     arg   - the pointer passed to pool_run
+     id    - this thread's index, 0 .. count - 1 (0 is the caller)
+     count - number of threads running the job
+*/
+typedef void (*pool_job_fn)(void *arg, int id, int count);
+
+// ----------------------------------------
+// Function: pool_create / pool_destroy / pool_size
+// ----------------------------------------
+/*
+   pool_create starts threads - 1 worker threads (the caller is the last
+   one). Returns NULL if the threads could not be started.
+   pool_destroy stops and joins the workers. pool_size returns the number
+   of threads a job runs on.
+*/
+struct thread_pool *pool_create(int threads);
+void pool_destroy(struct thread_pool *pool);
+int pool_size(struct thread_pool *pool);
+
+// ----------------------------------------
+// Function: pool_run
+// ----------------------------------------
+/*
+   Runs fn(arg, id, count) on every thread of the pool and returns when
+   all of them have finished.
+*/
+void pool_run(struct thread_pool *pool, pool_job_fn fn, void *arg);
+
+// ----------------------------------------
+// Function: pool_barrier
+// ----------------------------------------
+/*
+   Called from inside a job: blocks until every thread of the pool has
+   reached the barrier. Writes made before the barrier are visible to all
+   threads after it.
+*/
+void pool_barrier(struct thread_pool *pool);
+
+// ----------------------------------------
+// Function: pool_split
+// ----------------------------------------
+/*
+   Splits [0, n) into count nearly equal contiguous parts and stores part
+   id in [*begin, *end).
+*/
+void pool_split(int n, int id, int count, int *begin, int *end);
+
+#endif  // End of include guard for THREAD_POOL_H
@@ -6,7 +6,7 @@ Date: 2025
 
 This script converts a PNG image to a binary (.bin) format suitable for use
 with the seam carving C implementation. It then reads the binary file
-back and displays both images to visually confirm correctness.
+back and checks that its pixels match the PNG's.
 '''
 
 import png2bin               # Import custom module to handle binary image format
@@ -20,4 +20,5 @@ if __name__ == '__main__':
     png2bin.write_image(im2, "HJoceanSmall.bin") # Convert PNG to .bin format for use in seam carving C program
 
     im = png2bin.read_image("HJoceanSmall.bin") # Read back the binary image to check for conversion integrity
-    im.show()                                   # Display the image read from the .bin file to visually confirm match
+    same = im.tobytes() == im2.convert("RGB").tobytes()  # Compare the pixels instead of a second viewer
+    print("HJoceanSmall.bin matches the PNG" if same else "HJoceanSmall.bin differs from the PNG")